@@ -1,1346 +1,4422 @@
-/**************************************************************************************************
-  Filename:       zcl_openevse.c
-
-  Description:    Zigbee Cluster Library - device application for OpenEVSE.
-
-
-  Copyright 2006-2014 Texas Instruments Incorporated. All rights reserved.
-  Copyright 2015 Ryan Press
-
-  IMPORTANT: Your use of this Software is limited to those specific rights
-  granted under the terms of a software license agreement between the user
-  who downloaded the software, his/her employer (which must be your employer)
-  and Texas Instruments Incorporated (the "License").  You may not use this
-  Software unless you agree to abide by the terms of the License. The License
-  limits your use, and you acknowledge, that the Software may not be modified,
-  copied or distributed unless embedded on a Texas Instruments microcontroller
-  or used solely and exclusively in conjunction with a Texas Instruments radio
-  frequency transceiver, which is integrated into your product.  Other than for
-  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
-  works of, modify, distribute, perform, display or sell this Software and/or
-  its documentation for any purpose.
-
-  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
-  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
-  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
-  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
-  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
-  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
-  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
-  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
-  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
-  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
-  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
-
-  Should you have any questions regarding your right to use this Software,
-  contact Texas Instruments Incorporated at www.TI.com.
-**************************************************************************************************/
-
-/*********************************************************************
- * INCLUDES
- */
-#include <string.h>
-#include <stdlib.h>
-#include <stdarg.h>
-#include <stdio.h>
-
-#include "ZComDef.h"
-#include "OSAL.h"
-#include "AF.h"
-#include "ZDApp.h"
-#include "ZDObject.h"
-#include "MT_SYS.h"
-
-#include "nwk_util.h"
-
-#include "zcl.h"
-#include "zcl_general.h"
-#include "zcl_ha.h"
-#include "zcl_ezmode.h"
-#include "zcl_diagnostic.h"
-#include "zcl_electrical_measurement.h"
-#include "zcl_openevse.h"
-
-#include "onboard.h"
-
-/* HAL */
-#include "hal_lcd.h"
-#include "hal_led.h"
-#include "hal_key.h"
-#include "hal_flash.h"
-
-#if ( defined (ZGP_DEVICE_TARGET) || defined (ZGP_DEVICE_TARGETPLUS) \
-      || defined (ZGP_DEVICE_COMBO) || defined (ZGP_DEVICE_COMBO_MIN) )
-#include "zgp_translationtable.h"
-  #if (SUPPORTED_S_FEATURE(SUPP_ZGP_FEATURE_TRANSLATION_TABLE))
-    #define ZGP_AUTO_TT
-  #endif
-#endif
-
-#if (defined HAL_BOARD_ZLIGHT) || (defined HAL_PWM)
-#include "math.h"
-#include "hal_timer.h"
-#endif
-
-#include "NLMEDE.h"
-
-/*********************************************************************
- * MACROS
- */
-
-/*********************************************************************
- * CONSTANTS
- */
-
-enum evseCmd { EVSE_CMD_NONE, EVSE_CMD_STATE, EVSE_CMD_WIFI, EVSE_CMD_SLEEP, EVSE_CMD_ENABLE,
-                  EVSE_CMD_LCDOFF, EVSE_CMD_LCDRGB, EVSE_CMD_LCDTEAL, EVSE_CMD_GETPOWER,
-                  EVSE_CMD_GETTEMP, EVSE_CMD_GETENERGY, EVSE_CMD_GETSTATE, EVSE_CMD_GETSETTINGS,
-                  EVSE_CMD_SETLIMIT, EVSE_CMD_SETCURRENT };
-
-const char * evseCode[] = { "", "ST", "WF", "FS", "FE",
-                            "FB 0", "S0 1", "FB 6", "GG",
-                            "GP", "GU", "GS", "GE",
-                            "SH", "SC" };
-
-#define POLL_EVSE_PERIOD 200
-#define OPENEVSE_BL_NV 0x0401
-#define OPENEVSE_LIMIT_NV 0x0402
-#define OPENEVSE_L2_VOLTS 2400
-#define OPENEVSE_L1_VOLTS 1200
-
-#define OPENEVSE_CMD_TIMEOUT 1500 // expect response in 1500ms
-
-/*********************************************************************
- * TYPEDEFS
- */
-
-/*********************************************************************
- * GLOBAL VARIABLES
- */
-byte zclOpenEvse_TaskID;
-uint8 zclOpenEvse_seqNum = 0;
-
-/*********************************************************************
- * GLOBAL FUNCTIONS
- */
-
-/*********************************************************************
- * LOCAL VARIABLES
- */
-afAddrType_t zclOpenEvse_DstAddr;
-
-uint16 bindingInClusters[] =
-{
-  ZCL_CLUSTER_ID_GEN_ON_OFF
-};
-#define zclOpenEvse_BINDINGLIST (sizeof(bindingInClusters) / sizeof(bindingInClusters[0]))
-
-uint8 gPermitDuration = 0;    // permit joining default to disabled
-
-devStates_t zclOpenEvse_NwkState = DEV_INIT;
-
-uint8 zclOpenEvse_evseResendCtr = 0;
-uint8 zclOpenEvse_evseCmd = EVSE_CMD_NONE;
-uint8 zclOpenEvse_lastOnOff = FALSE;
-
-uint8 zclOpenEvse_powerLevel = 0;
-
-uint32 zclOpenEvse_reportPowerMin =  2000; // 2 seconds
-uint32 zclOpenEvse_reportPowerMax =  60000; // 1 minute
-uint32 zclOpenEvse_reportTempMax =   120000; // 2 minutes
-uint32 zclOpenEvse_reportEnergyMax = 180000; // 3 minutes
-
-uint32 zclOpenEvse_reportPowerChangedVolts = 5 * 10.0; // 5 volts
-uint32 zclOpenEvse_reportPowerChangedAmps =  1 * 10.0; // 1 amp
-uint32 zclOpenEvse_reportPowerChangedWatts = 200 / 10.0; // 200 watts
-
-zclReportCmd_t * zclOpenEvse_reportCmdVolts;
-zclReportCmd_t * zclOpenEvse_reportCmdAmps;
-zclReportCmd_t * zclOpenEvse_reportCmdWatts;
-zclReportCmd_t * zclOpenEvse_reportCmdTemp;
-zclReportCmd_t * zclOpenEvse_reportCmdEnergySum;
-zclReportCmd_t * zclOpenEvse_reportCmdEnergyDemand;
-zclReportCmd_t * zclOpenEvse_reportCmdState;
-
-/*********************************************************************
- * LOCAL FUNCTIONS
- */
-static void zclOpenEvse_BasicResetCB(void);
-static void zclOpenEvse_OnOffCB(uint8 cmd);
-static void zclOpenEvse_Identify(void);
-
-static void zclOpenEvse_sendPower(void);
-static void zclOpenEvse_sendTemp(void);
-static void zclOpenEvse_sendEnergy(void);
-static void zclOpenEvse_sendState(void);
-static void zclOpenEvse_zigbeeReset(void);
-static void zclOpenEvse_EVSESetLimit(uint32 limit);
-static void zclOpenEvse_EVSEWriteCmd(uint8 command, uint8 numArgs, ...);
-static void zclOpenEvse_EVSEResend(void);
-static void zclOpenEvse_UARTInit(void);
-static void zclOpenEvse_UARTCallback(uint8 port, uint8 event);
-static void zclOpenEvse_UARTParse(char * rxData);
-static uint8 zclOpenEvse_nibbletohex(uint8 value);
-static uint8 zclOpenEvse_hextonibble(uint8 value);
-static uint16 zclOpenEvse_u8tohex(uint8 value);
-static uint8 zclOpenEvse_hextou8(uint16 value);
-
-// Functions to process ZCL Foundation incoming Command/Response messages
-static void zclOpenEvse_ProcessIncomingMsg( zclIncomingMsg_t *msg );
-#ifdef ZCL_READ
-static uint8 zclOpenEvse_ProcessInReadRspCmd( zclIncomingMsg_t *pInMsg );
-#endif
-#ifdef ZCL_WRITE
-static uint8 zclOpenEvse_ProcessInWriteRspCmd( zclIncomingMsg_t *pInMsg );
-#endif
-static uint8 zclOpenEvse_ProcessInDefaultRspCmd( zclIncomingMsg_t *pInMsg );
-#ifdef ZCL_DISCOVER
-static uint8 zclOpenEvse_ProcessInDiscCmdsRspCmd( zclIncomingMsg_t *pInMsg );
-static uint8 zclOpenEvse_ProcessInDiscAttrsRspCmd( zclIncomingMsg_t *pInMsg );
-static uint8 zclOpenEvse_ProcessInDiscAttrsExtRspCmd( zclIncomingMsg_t *pInMsg );
-#endif
-
-/*********************************************************************
- * STATUS STRINGS
- */
-/*********************************************************************
- * ZCL General Profile Callback table
- */
-static zclGeneral_AppCallbacks_t zclOpenEvse_CmdCallbacks =
-{
-  zclOpenEvse_BasicResetCB,               // Basic Cluster Reset command
-  NULL,                                   // Identify command
-#ifdef ZCL_EZMODE
-  NULL,                                   // Identify EZ-Mode Invoke command
-  NULL,                                   // Identify Update Commission State command
-#endif
-  NULL,                                   // Identify Trigger Effect command
-  NULL,                                   // Identify Query Response command
-  zclOpenEvse_OnOffCB,                    // On/Off cluster commands
-  NULL,                                   // On/Off cluster enhanced command Off with Effect
-  NULL,                                   // On/Off cluster enhanced command On with Recall Global Scene
-  NULL,                                   // On/Off cluster enhanced command On with Timed Off
-#ifdef ZCL_LEVEL_CTRL
-  NULL,                                   // Level Control Move to Level command
-  NULL,                                   // Level Control Move command
-  NULL,                                   // Level Control Step command
-  NULL,                                   // Level Control Stop command
-#endif
-#ifdef ZCL_GROUPS
-  NULL,                                   // Group Response commands
-#endif
-#ifdef ZCL_SCENES
-  NULL,                                   // Scene Store Request command
-  NULL,                                   // Scene Recall Request command
-  NULL,                                   // Scene Response command
-#endif
-#ifdef ZCL_ALARMS
-  NULL,                                   // Alarm (Response) commands
-#endif
-#ifdef SE_UK_EXT
-  NULL,                                   // Get Event Log command
-  NULL,                                   // Publish Event Log command
-#endif
-  NULL,                                   // RSSI Location command
-  NULL                                    // RSSI Location Response command
-};
-
-/*********************************************************************
- * @fn          zclOpenEvse_Init
- *
- * @brief       Initialization function for the zclGeneral layer.
- *
- * @param       none
- *
- * @return      none
- */
-void zclOpenEvse_Init( byte task_id )
-{
-  zclOpenEvse_UARTInit();
-
-  zclOpenEvse_TaskID = task_id;
-
-  // Set destination address to indirect
-  zclOpenEvse_DstAddr.addrMode = (afAddrMode_t)AddrNotPresent;
-  zclOpenEvse_DstAddr.endPoint = 0;
-  zclOpenEvse_DstAddr.addr.shortAddr = 0;
-
-  // This app is part of the Home Automation Profile
-  zclHA_Init( &zclOpenEvse_SimpleDesc );
-  zclHA_Init( &zclOpenEvse_BlSimpleDesc );
-
-  // Register the ZCL General Cluster Library callback functions
-  zclGeneral_RegisterCmdCallbacks( OPENEVSE_ENDPOINT, &zclOpenEvse_CmdCallbacks );
-
-  // Register the backlight callback functions
-  zclGeneral_RegisterCmdCallbacks( OPENEVSE_ENDPOINT+1, &zclOpenEvse_CmdCallbacks );
-
-  // Register the application's attribute list
-  zcl_registerAttrList( OPENEVSE_ENDPOINT, zclOpenEvse_NumAttributes, zclOpenEvse_Attrs );
-
-    // Register the backlight attribute list
-  zcl_registerAttrList( OPENEVSE_ENDPOINT+1, zclOpenEvse_BlNumAttributes, zclOpenEvse_BlAttrs );
-
-  // Register the Application to receive the unprocessed Foundation command/response messages
-  zcl_registerForMsg( zclOpenEvse_TaskID );
-  
-#ifdef ZCL_DISCOVER
-  // Register the application's command list
-  zcl_registerCmdList( OPENEVSE_ENDPOINT, zclCmdsArraySize, zclOpenEvse_Cmds );
-#endif
-
-  // Register for all key events - This app will handle all key events
-  //RegisterForKeys( zclOpenEvse_TaskID );
-
-#ifdef ZGP_AUTO_TT
-  zgpTranslationTable_RegisterEP ( &zclOpenEvse_SimpleDesc );
-#endif
-
-  // Create the Voltage report command
-  zclOpenEvse_reportCmdVolts = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdVolts != NULL )
-  {
-    zclOpenEvse_reportCmdVolts->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdVolts->attrList[0].attrID = ATTRID_ELECTRICAL_MEASUREMENT_RMS_VOLTAGE;
-    zclOpenEvse_reportCmdVolts->attrList[0].dataType = ZCL_DATATYPE_UINT16;
-    zclOpenEvse_reportCmdVolts->attrList[0].attrData = (uint8 *)&zclOpenEvse_voltsScaled;
-  }
-
-  // Create the Amperage report command
-  zclOpenEvse_reportCmdAmps = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdAmps != NULL )
-  {
-    zclOpenEvse_reportCmdAmps->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdAmps->attrList[0].attrID = ATTRID_ELECTRICAL_MEASUREMENT_RMS_CURRENT;
-    zclOpenEvse_reportCmdAmps->attrList[0].dataType = ZCL_DATATYPE_UINT16;
-    zclOpenEvse_reportCmdAmps->attrList[0].attrData = (uint8 *)&zclOpenEvse_ampsScaled;
-  }
-
-  // Create the Watts report command
-  zclOpenEvse_reportCmdWatts = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdWatts != NULL )
-  {
-    zclOpenEvse_reportCmdWatts->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdWatts->attrList[0].attrID = ATTRID_ELECTRICAL_MEASUREMENT_ACTIVE_POWER;
-    zclOpenEvse_reportCmdWatts->attrList[0].dataType = ZCL_DATATYPE_INT16;
-    zclOpenEvse_reportCmdWatts->attrList[0].attrData = (uint8 *)&zclOpenEvse_wattsScaled;
-  }
-
-  // Create the Temperature report command
-  zclOpenEvse_reportCmdTemp = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdTemp != NULL )
-  {
-    zclOpenEvse_reportCmdTemp->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdTemp->attrList[0].attrID = ATTRID_DEV_TEMP_CURRENT;
-    zclOpenEvse_reportCmdTemp->attrList[0].dataType = ZCL_DATATYPE_INT16;
-    zclOpenEvse_reportCmdTemp->attrList[0].attrData = (uint8 *)&zclOpenEvse_temperature;
-  }
-
-    // Create the Energy Sum report command
-  zclOpenEvse_reportCmdEnergySum = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdEnergySum != NULL )
-  {
-    zclOpenEvse_reportCmdEnergySum->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdEnergySum->attrList[0].attrID = ATTRID_CURRENT_SUM_DELIVERED;
-    zclOpenEvse_reportCmdEnergySum->attrList[0].dataType = ZCL_DATATYPE_UINT48;
-    zclOpenEvse_reportCmdEnergySum->attrList[0].attrData = (uint8 *)&zclOpenEvse_energySum;
-  }
-  
-  // Create the Energy Demand report command
-  zclOpenEvse_reportCmdEnergyDemand = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdEnergyDemand != NULL )
-  {
-    zclOpenEvse_reportCmdEnergyDemand->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdEnergyDemand->attrList[0].attrID = ATTRID_CURRENT_DEMAND_DELIVERED;
-    zclOpenEvse_reportCmdEnergyDemand->attrList[0].dataType = ZCL_DATATYPE_UINT24;
-    zclOpenEvse_reportCmdEnergyDemand->attrList[0].attrData = (uint8 *)&zclOpenEvse_energyDemand;
-  }
-
-  // Create the State report command
-  zclOpenEvse_reportCmdState = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
-                 ( 1 * sizeof( zclReport_t ) ) );
-  if ( zclOpenEvse_reportCmdState != NULL )
-  {
-    zclOpenEvse_reportCmdState->numAttr = 1;
-
-    // Set up the first attribute
-    zclOpenEvse_reportCmdState->attrList[0].attrID = ATTRID_IOV_BASIC_PRESENT_VALUE;
-    zclOpenEvse_reportCmdState->attrList[0].dataType = ZCL_DATATYPE_UINT16;
-    zclOpenEvse_reportCmdState->attrList[0].attrData = (uint8 *)&zclOpenEvse_state;
-  }
-
-  // Restore backlight setting
-  zcl_nv_item_init( OPENEVSE_BL_NV, sizeof(zclOpenEvse_backlight), &zclOpenEvse_backlight );
-  zcl_nv_read( OPENEVSE_BL_NV, 0, sizeof(zclOpenEvse_backlight), &zclOpenEvse_backlight );
-  zcl_nv_item_init( OPENEVSE_LIMIT_NV, sizeof(zclOpenEvse_energyLimit), &zclOpenEvse_energyLimit );
-  zcl_nv_read( OPENEVSE_LIMIT_NV, 0, sizeof(zclOpenEvse_energyLimit), &zclOpenEvse_energyLimit );
-
-  osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_EVSE_EVT, 6000 ); // 6 seconds for EVSE to boot and detect level
-}
-
-
-/*********************************************************************
- * @fn          zclOpenEvse_event_loop
- *
- * @brief       Event Loop Processor for zclGeneral.
- *
- * @param       none
- *
- * @return      none
- */
-uint16 zclOpenEvse_event_loop( uint8 task_id, uint16 events )
-{
-  afIncomingMSGPacket_t *MSGpkt;
-
-  static uint16 lastVolts = 0, lastAmps = 0;
-  static int16 lastWatts = 0;
-  
-  (void)task_id;  // Intentionally unreferenced parameter
-
-  if ( events & SYS_EVENT_MSG )
-  {
-    while ( (MSGpkt = (afIncomingMSGPacket_t *)osal_msg_receive( zclOpenEvse_TaskID )) )
-    {
-      switch ( MSGpkt->hdr.event )
-      {
-        case ZCL_INCOMING_MSG:
-          // Incoming ZCL Foundation command/response messages
-          zclOpenEvse_ProcessIncomingMsg( (zclIncomingMsg_t *)MSGpkt );
-          break;
-
-        case KEY_CHANGE:
-          break;
-
-        case ZDO_STATE_CHANGE:
-          zclOpenEvse_NwkState = (devStates_t)(MSGpkt->hdr.status);
-
-          // now on the network
-          if ( (zclOpenEvse_NwkState == DEV_ZB_COORD) ||
-               (zclOpenEvse_NwkState == DEV_ROUTER)   ||
-               (zclOpenEvse_NwkState == DEV_END_DEVICE) )
-          {
-            zclOpenEvse_Identify();
-          }
-          break;
-
-        default:
-          break;
-      }
-
-      // Release the memory
-      osal_msg_deallocate( (uint8 *)MSGpkt );
-    }
-
-    // return unprocessed events
-    return (events ^ SYS_EVENT_MSG);
-  }
-  
-  if ( (events & OPENEVSE_CMD_TIMEOUT_EVT) )
-  {
-    if (zclOpenEvse_evseCmd != EVSE_CMD_NONE)
-    {
-      zclOpenEvse_EVSEResend();  // Resend if command didn't get a response
-    }
-    return (events ^ OPENEVSE_CMD_TIMEOUT_EVT);
-  }
-
-  if ( (events & OPENEVSE_IDENTIFY_EVT) )
-  {
-    static uint8 identState = 0;
-
-    if (zclOpenEvse_evseCmd != EVSE_CMD_NONE)
-    {
-      return events; // If last command not complete, postpone this
-    }
-
-    if (zclOpenEvse_IdentifyTime == 0)
-    {
-      if (zclOpenEvse_backlight == LIGHT_ON)
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDRGB, 0);
-      }
-      else
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDOFF, 0);
-      }
-    }
-    else
-    {
-      if (identState & 1) // On odd counts turn LED on
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDOFF, 0);
-        zclOpenEvse_IdentifyTime--;
-      }
-      else
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDTEAL, 0);
-      }
-      identState = !identState;
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_IDENTIFY_EVT, 500 );
-    }
-    return ( events ^ OPENEVSE_IDENTIFY_EVT );
-  }
-  
-  if (events & OPENEVSE_POLL_EVSE_EVT)
-  {
-    static uint8 pollNumber = 0;
-    static uint8 firstTime = TRUE;
-    static uint8 lastBacklight = TRUE;
-    static uint32 lastLimit = 0;
-
-    if (zclOpenEvse_evseCmd != EVSE_CMD_NONE)
-    {
-      return events; // If last command not complete, postpone this
-    }
-
-    if (zclOpenEvse_OnOff != zclOpenEvse_lastOnOff)
-    {
-      zclOpenEvse_lastOnOff = zclOpenEvse_OnOff;
-      if (zclOpenEvse_OnOff == LIGHT_ON)
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_ENABLE, 0);
-      }
-      else
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_SLEEP, 0);
-      }
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
-      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
-    }
-
-    if (zclOpenEvse_backlight != lastBacklight)
-    {
-      lastBacklight = zclOpenEvse_backlight;
-      if (zclOpenEvse_backlight == LIGHT_ON)
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDRGB, 0);
-      }
-      else
-      {
-        zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDOFF, 0);
-      }
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
-      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
-    }
-
-    switch (pollNumber++)
-    {
-    case 0: // State 0-9 initialization
-      zclOpenEvse_EVSEWriteCmd(EVSE_CMD_GETSETTINGS, 0);
-      break;
-    case 1:
-      zclOpenEvse_EVSEWriteCmd(EVSE_CMD_GETSTATE, 0);
-      pollNumber = 10; // Go to main loop state
-      break;
-      
-    case 10:// State 10-19 main loop
-      zclOpenEvse_EVSEWriteCmd(EVSE_CMD_GETPOWER, 0);
-      break;
-    case 11:
-      zclOpenEvse_EVSEWriteCmd(EVSE_CMD_GETTEMP, 0);
-      break;
-    case 12:
-      zclOpenEvse_EVSEWriteCmd(EVSE_CMD_GETENERGY, 0);
-      if (zclOpenEvse_NwkState != DEV_ROUTER)
-      {
-        firstTime = TRUE;
-      }
-      if (lastLimit != zclOpenEvse_energyLimit)
-      {
-        pollNumber = 40; // Go to set limit state
-        break;
-      }
-      else if (firstTime)
-      {
-        pollNumber = 20; // Go to network init state
-        break;
-      }
-      pollNumber = 10;
-      break;
-
-    case 20: // State 20-39 network connected
-      if (zclOpenEvse_NwkState != DEV_ROUTER)
-      {
-        pollNumber = 10; // Return to main loop state
-        break;
-      }
-      break;
-      // States 21-29 are a delay after network join
-    case 30:
-      zclOpenEvse_sendEnergy();
-      break;
-    case 31:
-      lastVolts = zclOpenEvse_voltsScaled;
-      lastAmps = zclOpenEvse_ampsScaled;
-      lastWatts = zclOpenEvse_wattsScaled;
-      zclOpenEvse_sendPower();
-      break;
-    case 32:
-      zclOpenEvse_sendTemp();
-      break;
-    case 33:
-      zclOpenEvse_sendState();
-      firstTime = FALSE;
-      // Network is configured so start report timers
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETPOWER_MIN_EVT, zclOpenEvse_reportPowerMin );
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETPOWER_MAX_EVT, zclOpenEvse_reportPowerMax );
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETTEMP_MAX_EVT, zclOpenEvse_reportTempMax );
-      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETENERGY_MAX_EVT, zclOpenEvse_reportEnergyMax );
-      pollNumber = 10;
-      break;
-
-    case 40:
-      zclOpenEvse_EVSESetLimit(zclOpenEvse_energyLimit);
-      // Save to NVRAM
-      zcl_nv_write( OPENEVSE_LIMIT_NV, 0, sizeof(zclOpenEvse_energyLimit), &zclOpenEvse_energyLimit );
-      lastLimit = zclOpenEvse_energyLimit;
-      pollNumber = 10;
-      break;
-    }
-    
-    osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
-    return ( events ^ OPENEVSE_POLL_EVSE_EVT );
-  }
-  if (events & OPENEVSE_BACKLIGHT_OFF_EVT)
-  {
-    if (zclOpenEvse_evseCmd != EVSE_CMD_NONE)
-    {
-      return events; // If last command not complete, postpone this
-    }
- 
-    zclOpenEvse_EVSEWriteCmd(EVSE_CMD_LCDOFF, 0);
-
-    return ( events ^ OPENEVSE_BACKLIGHT_OFF_EVT );
-  }
-  if ( events & OPENEVSE_GETPOWER_MIN_EVT)
-  {
-    if ( (abs(lastVolts - zclOpenEvse_voltsScaled) > zclOpenEvse_reportPowerChangedVolts) ||
-         (abs(lastAmps - zclOpenEvse_ampsScaled) > zclOpenEvse_reportPowerChangedAmps) ||
-         (abs(lastWatts - zclOpenEvse_wattsScaled) > zclOpenEvse_reportPowerChangedWatts) )
-    {
-      lastVolts = zclOpenEvse_voltsScaled;
-      lastAmps = zclOpenEvse_ampsScaled;
-      lastWatts = zclOpenEvse_wattsScaled;
-
-      zclOpenEvse_sendPower();
-    }      
-    osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETPOWER_MIN_EVT, zclOpenEvse_reportPowerMin );
-    return ( events ^ OPENEVSE_GETPOWER_MIN_EVT );
-  }
-  if ( events & OPENEVSE_GETPOWER_MAX_EVT)
-  {
-    zclOpenEvse_sendPower(); // This restarts the timer
-    return ( events ^ OPENEVSE_GETPOWER_MAX_EVT );
-  }
-
-  if ( events & OPENEVSE_GETTEMP_MAX_EVT)
-  {
-    zclOpenEvse_sendTemp(); // This restarts the timer
-    return ( events ^ OPENEVSE_GETTEMP_MAX_EVT );
-  }
-
-  if ( events & OPENEVSE_GETENERGY_MAX_EVT)
-  {
-    zclOpenEvse_sendEnergy();
-    osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETENERGY_MAX_EVT, zclOpenEvse_reportEnergyMax );
-    return ( events ^ OPENEVSE_GETENERGY_MAX_EVT );
-  }
-
-  // Discard unknown events
-  return 0;
-}
-
-
-/*********************************************************************
- * @fn      zclOpenEvse_BasicResetCB
- *
- * @brief   Callback from the ZCL General Cluster Library
- *          to set all the Basic Cluster attributes to default values.
- *
- * @param   none
- *
- * @return  none
- */
-static void zclOpenEvse_BasicResetCB( void )
-{
-  NLME_LeaveReq_t leaveReq;
-  // Set every field to 0
-  osal_memset( &leaveReq, 0, sizeof( NLME_LeaveReq_t ) );
-
-  // This will enable the device to rejoin the network after reset.
-  leaveReq.rejoin = TRUE;
-
-  // Set the NV startup option to force a "new" join.
-  zgWriteStartupOptions( ZG_STARTUP_SET, ZCD_STARTOPT_DEFAULT_NETWORK_STATE );
-
-  // Leave the network, and reset afterwards
-  if ( NLME_LeaveReq( &leaveReq ) != ZSuccess )
-  {
-    // Couldn't send out leave; prepare to reset anyway
-    ZDApp_LeaveReset( FALSE );
-  }
-}
-
-/*********************************************************************
- * @fn      zclOpenEvse_OnOffCB
- *
- * @brief   Callback from the ZCL General Cluster Library when
- *          it received an On/Off Command for this application.
- *
- * @param   cmd - COMMAND_ON, COMMAND_OFF or COMMAND_TOGGLE
- *
- * @return  none
- */
-static void zclOpenEvse_OnOffCB( uint8 cmd )
-{
-  afIncomingMSGPacket_t *pPtr = zcl_getRawAFMsg();
-
-  if (pPtr->endPoint == OPENEVSE_ENDPOINT)
-  {
-    // Turn on the power
-    if ( cmd == COMMAND_ON )
-    {
-      zclOpenEvse_OnOff = LIGHT_ON;
-    }
-    // Turn off the power
-    else if ( cmd == COMMAND_OFF )
-    {
-      zclOpenEvse_OnOff = LIGHT_OFF;
-    }
-    // Toggle the power
-    else if ( cmd == COMMAND_TOGGLE )
-    {
-      if ( zclOpenEvse_OnOff == LIGHT_OFF )
-      {
-        zclOpenEvse_OnOff = LIGHT_ON;
-      }
-      else
-      {
-        zclOpenEvse_OnOff = LIGHT_OFF;
-      }
-    }
-  }
-  else
-  {
-    // Turn on the backlight
-    if ( cmd == COMMAND_ON )
-    {
-      zclOpenEvse_backlight = LIGHT_ON;
-    }
-    // Turn off the backlight
-    else if ( cmd == COMMAND_OFF )
-    {
-      zclOpenEvse_backlight = LIGHT_OFF;
-    }
-    // Toggle the backlight
-    else if ( cmd == COMMAND_TOGGLE )
-    {
-      if ( zclOpenEvse_backlight == LIGHT_OFF )
-      {
-        zclOpenEvse_backlight = LIGHT_ON;
-      }
-      else
-      {
-        zclOpenEvse_backlight = LIGHT_OFF;
-      }
-    }
-    
-    // save to NVRAM
-    zcl_nv_write( OPENEVSE_BL_NV, 0, sizeof(zclOpenEvse_backlight), &zclOpenEvse_backlight );
-  }
-}
-
-void zclOpenEvse_Identify(void)
-{
-  zclOpenEvse_IdentifyTime = 5;
-  osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_IDENTIFY_EVT, 500 );
-}
-
-/******************************************************************************
- *
- *  Functions for processing ZCL Foundation incoming Command/Response messages
- *
- *****************************************************************************/
-
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessIncomingMsg
- *
- * @brief   Process ZCL Foundation incoming message
- *
- * @param   pInMsg - pointer to the received message
- *
- * @return  none
- */
-static void zclOpenEvse_ProcessIncomingMsg( zclIncomingMsg_t *pInMsg )
-{
-  switch ( pInMsg->zclHdr.commandID )
-  {
-#ifdef ZCL_READ
-    case ZCL_CMD_READ_RSP:
-      zclOpenEvse_ProcessInReadRspCmd( pInMsg );
-      break;
-#endif
-#ifdef ZCL_WRITE
-    case ZCL_CMD_WRITE_RSP:
-      zclOpenEvse_ProcessInWriteRspCmd( pInMsg );
-      break;
-#endif
-#ifdef ZCL_REPORT
-    // Attribute Reporting implementation should be added here
-    case ZCL_CMD_CONFIG_REPORT:
-      // zclOpenEvse_ProcessInConfigReportCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_CONFIG_REPORT_RSP:
-      // zclOpenEvse_ProcessInConfigReportRspCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_READ_REPORT_CFG:
-      // zclOpenEvse_ProcessInReadReportCfgCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_READ_REPORT_CFG_RSP:
-      // zclOpenEvse_ProcessInReadReportCfgRspCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_REPORT:
-      // zclOpenEvse_ProcessInReportCmd( pInMsg );
-      break;
-#endif
-    case ZCL_CMD_DEFAULT_RSP:
-      zclOpenEvse_ProcessInDefaultRspCmd( pInMsg );
-      break;
-#ifdef ZCL_DISCOVER
-    case ZCL_CMD_DISCOVER_CMDS_RECEIVED_RSP:
-      zclOpenEvse_ProcessInDiscCmdsRspCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_DISCOVER_CMDS_GEN_RSP:
-      zclOpenEvse_ProcessInDiscCmdsRspCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_DISCOVER_ATTRS_RSP:
-      zclOpenEvse_ProcessInDiscAttrsRspCmd( pInMsg );
-      break;
-
-    case ZCL_CMD_DISCOVER_ATTRS_EXT_RSP:
-      zclOpenEvse_ProcessInDiscAttrsExtRspCmd( pInMsg );
-      break;
-#endif
-    default:
-      break;
-  }
-
-  if ( pInMsg->attrCmd )
-    osal_mem_free( pInMsg->attrCmd );
-}
-
-#ifdef ZCL_READ
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessInReadRspCmd
- *
- * @brief   Process the "Profile" Read Response Command
- *
- * @param   pInMsg - incoming message to process
- *
- * @return  none
- */
-static uint8 zclOpenEvse_ProcessInReadRspCmd( zclIncomingMsg_t *pInMsg )
-{
-  zclReadRspCmd_t *readRspCmd;
-  uint8 i;
-
-  readRspCmd = (zclReadRspCmd_t *)pInMsg->attrCmd;
-  for (i = 0; i < readRspCmd->numAttr; i++)
-  {
-    // Notify the originator of the results of the original read attributes
-    // attempt and, for each successfull request, the value of the requested
-    // attribute
-  }
-
-  return ( TRUE );
-}
-#endif // ZCL_READ
-
-#ifdef ZCL_WRITE
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessInWriteRspCmd
- *
- * @brief   Process the "Profile" Write Response Command
- *
- * @param   pInMsg - incoming message to process
- *
- * @return  none
- */
-static uint8 zclOpenEvse_ProcessInWriteRspCmd( zclIncomingMsg_t *pInMsg )
-{
-  zclWriteRspCmd_t *writeRspCmd;
-  uint8 i;
-
-  writeRspCmd = (zclWriteRspCmd_t *)pInMsg->attrCmd;
-  for ( i = 0; i < writeRspCmd->numAttr; i++ )
-  {
-    // Notify the device of the results of the its original write attributes
-    // command.
-  }
-
-  return ( TRUE );
-}
-#endif // ZCL_WRITE
-
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessInDefaultRspCmd
- *
- * @brief   Process the "Profile" Default Response Command
- *
- * @param   pInMsg - incoming message to process
- *
- * @return  none
- */
-static uint8 zclOpenEvse_ProcessInDefaultRspCmd( zclIncomingMsg_t *pInMsg )
-{
-  // zclDefaultRspCmd_t *defaultRspCmd = (zclDefaultRspCmd_t *)pInMsg->attrCmd;
-
-  // Device is notified of the Default Response command.
-  (void)pInMsg;
-
-  return ( TRUE );
-}
-
-#ifdef ZCL_DISCOVER
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessInDiscCmdsRspCmd
- *
- * @brief   Process the Discover Commands Response Command
- *
- * @param   pInMsg - incoming message to process
- *
- * @return  none
- */
-static uint8 zclOpenEvse_ProcessInDiscCmdsRspCmd( zclIncomingMsg_t *pInMsg )
-{
-  zclDiscoverCmdsCmdRsp_t *discoverRspCmd;
-  uint8 i;
-
-  discoverRspCmd = (zclDiscoverCmdsCmdRsp_t *)pInMsg->attrCmd;
-  for ( i = 0; i < discoverRspCmd->numCmd; i++ )
-  {
-    // Device is notified of the result of its attribute discovery command.
-  }
-
-  return ( TRUE );
-}
-
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessInDiscAttrsRspCmd
- *
- * @brief   Process the "Profile" Discover Attributes Response Command
- *
- * @param   pInMsg - incoming message to process
- *
- * @return  none
- */
-static uint8 zclOpenEvse_ProcessInDiscAttrsRspCmd( zclIncomingMsg_t *pInMsg )
-{
-  zclDiscoverAttrsRspCmd_t *discoverRspCmd;
-  uint8 i;
-
-  discoverRspCmd = (zclDiscoverAttrsRspCmd_t *)pInMsg->attrCmd;
-  for ( i = 0; i < discoverRspCmd->numAttr; i++ )
-  {
-    // Device is notified of the result of its attribute discovery command.
-  }
-
-  return ( TRUE );
-}
-
-/*********************************************************************
- * @fn      zclOpenEvse_ProcessInDiscAttrsExtRspCmd
- *
- * @brief   Process the "Profile" Discover Attributes Extended Response Command
- *
- * @param   pInMsg - incoming message to process
- *
- * @return  none
- */
-static uint8 zclOpenEvse_ProcessInDiscAttrsExtRspCmd( zclIncomingMsg_t *pInMsg )
-{
-  zclDiscoverAttrsExtRsp_t *discoverRspCmd;
-  uint8 i;
-
-  discoverRspCmd = (zclDiscoverAttrsExtRsp_t *)pInMsg->attrCmd;
-  for ( i = 0; i < discoverRspCmd->numAttr; i++ )
-  {
-    // Device is notified of the result of its attribute discovery command.
-  }
-
-  return ( TRUE );
-}
-#endif // ZCL_DISCOVER
-
-
-void zclOpenEvse_sendPower(void)
-{
-  // Restart max timer because we just sent
-  osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETPOWER_MAX_EVT, zclOpenEvse_reportPowerMax );
-
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT, zclOpenEvse_reportCmdVolts,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT, zclOpenEvse_reportCmdAmps,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT, zclOpenEvse_reportCmdWatts,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-}
-
-void zclOpenEvse_sendTemp(void)
-{
-  osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETTEMP_MAX_EVT, zclOpenEvse_reportTempMax );
-
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG, zclOpenEvse_reportCmdTemp,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-}
-
-void zclOpenEvse_sendEnergy(void)
-{
-  osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_GETENERGY_MAX_EVT, zclOpenEvse_reportEnergyMax );
-  
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_SE_METERING, zclOpenEvse_reportCmdEnergySum,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_SE_METERING, zclOpenEvse_reportCmdEnergyDemand,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-}
-
-void zclOpenEvse_sendState(void)
-{
-  zcl_SendReportCmd( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr,
-                     ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC, zclOpenEvse_reportCmdState,
-                     ZCL_FRAME_SERVER_CLIENT_DIR, 0, zclOpenEvse_seqNum++ ); 
-}
-
-void zclOpenEvse_zigbeeReset(void)
-{
-  int i;
-  
-  for (i = HAL_NV_PAGE_BEG; i <= (HAL_NV_PAGE_BEG + HAL_NV_PAGE_CNT); i++)
-  {
-    HalFlashErase(i);
-  }
-  Onboard_soft_reset();
-}
-
-void zclOpenEvse_EVSESetLimit(uint32 limit)
-{
-  if (limit == 0xFFFFFF)
-  {
-    limit = 0;
-  }
-  zclOpenEvse_EVSEWriteCmd(EVSE_CMD_SETLIMIT, 1, (int32)limit);
-}
-
-void zclOpenEvse_EVSEWriteCmd(uint8 command, uint8 numArgs, ...)
-{
-  static char string[16+5] = "$";
-  int strLen = 4;
-  unsigned char chk = 0;
-  va_list valist;
-  int i;
-
-  zclOpenEvse_evseCmd = command;
-  
-  strcpy(&string[1], (const char *)evseCode[command]);
-
-  va_start(valist, numArgs);
-
-  for (i = 0; i < numArgs && i < 3; i++)
-  {
-    sprintf(string + strlen(string), " %ld", va_arg(valist, int32));
-  }
-
-  va_end(valist);
-
-  for (strLen = 0; strLen < strlen(string); strLen ++)
-  {
-    chk ^= string[strLen];
-  }
-  string[strLen++] = '^';
-  *((uint16 *)(&string[strLen++])) = zclOpenEvse_u8tohex(chk);
-  strLen++;
-  string[strLen++] = '\r';
-  string[strLen++] = 0;
-  
-  HalUARTWrite(HAL_UART_PORT_0, (uint8 *)string, strLen);
-  osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_CMD_TIMEOUT_EVT, OPENEVSE_CMD_TIMEOUT );
-}
-
-inline void zclOpenEvse_EVSEResend(void)
-{
-  if (zclOpenEvse_evseResendCtr++ > 3)
-  {
-    zclOpenEvse_evseCmd = EVSE_CMD_NONE;
-    zclOpenEvse_evseResendCtr = 0;
-    return;
-  }
-
-  HalUARTWrite(HAL_UART_PORT_0, (uint8 *)"\r", 1);
-  zclOpenEvse_EVSEWriteCmd(zclOpenEvse_evseCmd, 0);
-}
-
-void zclOpenEvse_UARTInit(void)
-{
-  halUARTCfg_t uartConfig;
-
-  /* UART Configuration */
-  uartConfig.configured           = TRUE;
-  uartConfig.baudRate             = HAL_UART_BR_115200;
-  uartConfig.flowControl          = HAL_UART_FLOW_OFF;
-  uartConfig.flowControlThreshold = HAL_UART_DMA_RX_MAX >> 1;
-  uartConfig.rx.maxBufSize        = HAL_UART_DMA_RX_MAX;
-  uartConfig.tx.maxBufSize        = HAL_UART_DMA_RX_MAX;
-  uartConfig.idleTimeout          = 50;
-  uartConfig.intEnable            = TRUE;
-  uartConfig.callBackFunc         = zclOpenEvse_UARTCallback;
-
-  /* Start UART */
-  HalUARTOpen(HAL_UART_PORT_0, &uartConfig);
-}
-
-int8 rxIndex = -1;
-uint8 rxData[34];
-
-void zclOpenEvse_UARTCallback(uint8 port, uint8 event)
-{
-  static uint8 waitSoc = TRUE;
-
-  uint8 ch;
-  while (Hal_UART_RxBufLen(port))
-  {
-    HalUARTRead (port, &ch, 1);
-    switch (ch)
-    {
-    case '$':
-      rxIndex = 0;
-      waitSoc = FALSE;
-      break;
-    case '\r':
-      if (waitSoc)
-      {
-        break;
-      }
-      rxData[rxIndex] = 0;
-      waitSoc = TRUE;
-      zclOpenEvse_UARTParse((char *)rxData);
-      break;
-    default:
-      if (waitSoc || rxIndex >= 64)
-      {
-        break;
-      }
-      rxData[rxIndex++] = ch;
-      break;
-    }
-  }
-}
-
-
-void zclOpenEvse_UARTParse(char * rxData)
-{
-  unsigned char chk = '$', i;
-
-  for (i = 0; i < strlen(rxData)-3; i ++)
-  {
-    chk ^= (uint8)rxData[i];
-  }
-
-  if (chk != zclOpenEvse_hextou8(*((uint16 *)&rxData[i+1]))) // If bad checksum, resend
-  {
-    zclOpenEvse_EVSEResend();
-    return;
-  }
-
-  if (!strncmp((const char *)rxData, evseCode[EVSE_CMD_STATE], 2)) // Asynchronous state update
-  {
-    char * valid = NULL;
-    uint8 state = strtol((const char *)&rxData[3], &valid, 16);
-    if (valid)
-    {
-      if (zclOpenEvse_backlight == LIGHT_OFF) // Turn backlight back off after change of state
-      {
-        osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_BACKLIGHT_OFF_EVT, 5000 );
-      }
-      if (state == 0xFE)
-      {
-        zclOpenEvse_OnOff = LIGHT_OFF;
-      }
-      else
-      {
-        zclOpenEvse_OnOff = LIGHT_ON;
-      }
-      zclOpenEvse_lastOnOff = zclOpenEvse_OnOff;
-      zclOpenEvse_state = state;
-      zclOpenEvse_sendState();
-    }
-    return;
-  }
-  else if (!strncmp((const char *)rxData, evseCode[EVSE_CMD_WIFI], 2)) // Asynchronous wifi update
-  {
-    zclOpenEvse_zigbeeReset();
-    return;
-  } else if (strncmp((const char *)rxData, "OK", 2)) // If not OK resend
-  {
-    zclOpenEvse_EVSEResend();
-    return;
-  }
-  
-  switch (zclOpenEvse_evseCmd)
-  {
-  case EVSE_CMD_GETPOWER:
-    {
-      char * amps = strtok(&rxData[3], " ");
-      char * volts = strtok(NULL, " ");
-      if (!amps || !volts)
-      {
-        zclOpenEvse_EVSEResend();
-        return;
-      }
-      if (atol(volts) != -1)
-      {
-        zclOpenEvse_voltsScaled = (uint16) (atol(volts) * 0.01);
-      }
-      else
-      {
-        zclOpenEvse_voltsScaled = (zclOpenEvse_powerLevel == 2) ? OPENEVSE_L2_VOLTS : OPENEVSE_L1_VOLTS;
-      }
-
-      if (atol(amps) != -1)
-      {
-        zclOpenEvse_ampsScaled = (uint16) (atol(amps) * 0.01);
-      }
-      zclOpenEvse_wattsScaled = (int16) ((float)zclOpenEvse_voltsScaled * (float)zclOpenEvse_ampsScaled * 0.001);
-    }
-    break;
-  case EVSE_CMD_GETTEMP:
-    {
-      char * ds3231 = strtok(&rxData[3], " ");
-      char * mcp9808 = strtok(NULL, " ");
-      char * tmp007 = strtok(NULL, " ");
-      if (!ds3231 || !mcp9808 || !tmp007)
-      {
-        zclOpenEvse_EVSEResend();
-        return;
-      }
-      zclOpenEvse_temperature = (int16) (atoi(ds3231) * (1.0 / 10)); // Tenths of degree C to degrees C
-    }
-    break;
-  case EVSE_CMD_GETENERGY:
-    {
-      char * wattSecs = strtok(&rxData[3], " ");
-      char * wattAcc = strtok(NULL, " ");
-      if (!wattSecs || !wattAcc)
-      {
-        zclOpenEvse_EVSEResend();
-        return;
-      }
-      zclOpenEvse_energyDemand = (uint32) (atol(wattSecs) * (1.0 / 3600)); // Convert watt-seconds to watt-hours
-      *((uint32 *)&zclOpenEvse_energySum) = (uint32) atol(wattAcc); // Already in watt-hours
-    }
-    break;
-  case EVSE_CMD_GETSTATE:
-    {
-      char * valid = NULL;
-      uint8 state = strtol((const char *)&rxData[3], &valid, 10);
-      if (valid)
-      {
-        zclOpenEvse_state = state;
-      }
-    }
-    break;
-  case EVSE_CMD_GETSETTINGS:
-    {
-      char * amps = strtok(&rxData[3], " ");
-      char * flags = strtok(NULL, " ");
-      if (!amps || !flags)
-      {
-        zclOpenEvse_EVSEResend();
-        return;
-      }
-      
-      zclOpenEvse_powerLevel = (atoi(flags) & 1) ? 2 : 1; // If bit 0 is set, power level is 2
-    }
-    break;
-  }
-
-  zclOpenEvse_evseCmd = EVSE_CMD_NONE;
-  zclOpenEvse_evseResendCtr = 0;
-  osal_stop_timerEx( zclOpenEvse_TaskID, OPENEVSE_CMD_TIMEOUT_EVT );
-}
-
-// converts 4-bit nibble to ascii hex
-uint8 zclOpenEvse_nibbletohex(uint8 value)
-{
-    if (value >= 10) return value - 10 + 'A';
-    return value + '0';
-}
-
-// converts ascii character to 4-bit nibble
-uint8 zclOpenEvse_hextonibble(uint8 value)
-{
-    if (value >= 'A') return value + 10 - 'A';
-    return value - '0';
-}
-
-// returns value as 2 ascii characters in a 16-bit int
-uint16 zclOpenEvse_u8tohex(uint8 value)
-{
-    uint16 hexdigits;
-
-    uint8 lodigit = (value >> 4);
-    uint8 hidigit = (value & 0x0F);
-    hexdigits = zclOpenEvse_nibbletohex(lodigit);
-    hexdigits |= (zclOpenEvse_nibbletohex(hidigit) << 8);
-
-    return hexdigits;
-}
-
-// value is 2 ascii characters in a 16-bit int
-uint8 zclOpenEvse_hextou8(uint16 value)
-{
-  uint8 chk;
-  uint8 lodigit = zclOpenEvse_hextonibble(value >> 8);
-  uint8 hidigit = zclOpenEvse_hextonibble(value & 0xFF);
-
-  chk = lodigit;
-  chk |= (hidigit << 4);
-
-  return chk;
-}
-/****************************************************************************
-****************************************************************************/
-
-
+/**************************************************************************************************
+  Filename:       zcl_openevse.c
+
+  Description:    Zigbee Cluster Library - device application for OpenEVSE.
+
+
+  Copyright 2006-2014 Texas Instruments Incorporated. All rights reserved.
+  Copyright 2015 Ryan Press
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "AF.h"
+#include "ZDApp.h"
+#include "ZDObject.h"
+#include "MT_SYS.h"
+
+#include "nwk_util.h"
+#include "AssocList.h"
+
+#include "zcl.h"
+#include "zcl_general.h"
+#include "zcl_ha.h"
+#include "zcl_ezmode.h"
+#include "zcl_diagnostic.h"
+#include "zcl_electrical_measurement.h"
+#if defined OPENEVSE_SLEEPY
+#include "zcl_poll_control.h"
+#include "OSAL_PwrMgr.h"
+#endif
+#include "zcl_openevse.h"
+#if defined OPENEVSE_OTA
+#include "zcl_openevse_ota.h"
+#endif
+
+#include "onboard.h"
+
+/* HAL */
+#include "hal_lcd.h"
+#include "hal_led.h"
+#include "hal_key.h"
+#include "hal_flash.h"
+
+#if ( defined (ZGP_DEVICE_TARGET) || defined (ZGP_DEVICE_TARGETPLUS) \
+      || defined (ZGP_DEVICE_COMBO) || defined (ZGP_DEVICE_COMBO_MIN) )
+#include "zgp_translationtable.h"
+  #if (SUPPORTED_S_FEATURE(SUPP_ZGP_FEATURE_TRANSLATION_TABLE))
+    #define ZGP_AUTO_TT
+  #endif
+#endif
+
+#if (defined HAL_BOARD_ZLIGHT) || (defined HAL_PWM)
+#include "math.h"
+#include "hal_timer.h"
+#endif
+
+#include "NLMEDE.h"
+
+/*********************************************************************
+ * MACROS
+ */
+#if OPENEVSE_TRACE_ENTRIES
+#define OPENEVSE_TRACE(evse, id, len, result, resends, latency) \
+  zclOpenEvse_Trace( (evse), (id), (len), (result), (resends), (latency) )
+#else
+// Nothing is evaluated but the result, which may be a local kept only for the trace
+#define OPENEVSE_TRACE(evse, id, len, result, resends, latency) ((void)(result))
+#endif
+
+#if defined OPENEVSE_SLEEPY
+// Sleep suspends the UART receiver (HalUARTSuspendDMA), so a charger keeps
+// the module awake from sending a command until its reply is in
+#define OPENEVSE_POWER(evse, state) osal_pwrmgr_task_state( (evse)->taskId, (state) )
+#define OPENEVSE_NWK_JOINED DEV_END_DEVICE
+#else
+#define OPENEVSE_POWER(evse, state)
+#define OPENEVSE_NWK_JOINED DEV_ROUTER
+#endif
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+const char * evseCode[] = { "", "ST", "WF", "FS", "FE",
+                            "FB 0", "S0 1", "FB 6", "GG",
+                            "GP", "GU", "GS", "GE",
+                            "SH", "SC", "FB 2", "GT" };
+
+#if defined OPENEVSE_SLEEPY
+#define POLL_EVSE_PERIOD 500 // each poll wakes the module
+#else
+#define POLL_EVSE_PERIOD 200
+#endif
+#define OPENEVSE_BL_NV 0x0401
+#define OPENEVSE_LIMIT_NV 0x0402
+#define OPENEVSE_TOU_NV 0x0403
+#define OPENEVSE_ENERGY_NV 0x0404
+#define OPENEVSE_THERMAL_NV 0x0405
+#define OPENEVSE_ENERGY_NV_STEP 1000      // Wh between writes of the energy total to NV
+#define OPENEVSE_ENERGY_WRAP_MAX 0x10000000UL // Wh; a lower count less than this on, modulo 2^32, is a wrap
+// NV items of charger n are at the IDs above plus n << 4
+#define OPENEVSE_EVSE_NV(evse, id) ((id) + ((uint16)((evse) - zclOpenEvse_evse) << 4))
+#define OPENEVSE_L2_VOLTS 2400
+#define OPENEVSE_L1_VOLTS 1200
+
+// Pilot current the EVSE takes with $SC; Level Control ramps step at most once a second
+#define OPENEVSE_AMPS_MIN 6
+#define OPENEVSE_AMPS_MAX 80
+#define OPENEVSE_LEVEL_STEP_MS 1000
+
+// Schedule engine
+#define OPENEVSE_TOU_UNKNOWN 0xFE // Window not looked at yet, the next run acts on it
+#define OPENEVSE_DAY_MINUTES 1440
+#define OPENEVSE_DAY_SECS 86400UL
+
+#define OPENEVSE_CMD_TIMEOUT 1500 // expect response in 1500ms
+
+// Identify runs in the background of the poll loop: at most one LCD command
+// per two telemetry ticks, holding the RAPI slot for no more than 100ms
+#define OPENEVSE_IDENTIFY_SHARE 2
+#define OPENEVSE_IDENTIFY_SLOT 100
+#define OPENEVSE_IDENTIFY_PHASE 500
+
+// Resend a failed command up to 4 times, backing off 20, 40, 80, 160ms
+#define OPENEVSE_CMD_RETRIES 4
+#define OPENEVSE_RETRY_BACKOFF 20
+#define OPENEVSE_RETRY_BACKOFF_MAX 1000
+
+// CurrentDemandLimit, in kWh; the EVSE takes 0-255 and 0xFFFFFF means no limit
+#define OPENEVSE_LIMIT_NONE 0xFFFFFF
+#define OPENEVSE_LIMIT_MAX 255
+
+// Airtime budget for outbound reports, enforced by a token bucket
+#define OPENEVSE_BUDGET_DEPTH 4000    // bucket holds this many ms of budget
+#define OPENEVSE_REPORT_OVERHEAD 40   // MAC, NWK (secured) and APS header bytes per frame
+
+// Report back-off on a poor mesh link. Each power or temperature report
+// takes one step of zclOpenEvse_reportStretch (periods doubled per step)
+// up while the parent link is weak or sends fail, down once it is good
+// again, and holds in between.
+#define OPENEVSE_LQI_WEAK 60          // parent link LQI below this is weak
+#define OPENEVSE_LQI_GOOD 90          // and above this has recovered
+#define OPENEVSE_FAIL_BUSY 64         // send failure rate, in 256ths, that counts as busy
+#define OPENEVSE_FAIL_CLEAR 16        // and below which it has cleared
+#define OPENEVSE_STRETCH_LIMIT 6      // cap on the writable stretch maximum, 64x
+
+// Delivery policy: classes in zclOpenEvse_reportAcked go with APS acks,
+// which the stack retries, and are queued again up to twice more when
+// the confirm still says they didn't arrive. The rest are fire and
+// forget. Up to 8 frames are matched to their data confirms.
+#define OPENEVSE_REPORT_RETRIES 2
+#define OPENEVSE_REPORT_INFLIGHT 8
+
+// Reports share the charger endpoints with the ZCL's frames (Read and
+// Write Responses, Get Alerts responses, the OTA client), which take AF
+// transaction IDs from the ZCL's own counter. The module follows that
+// counter from the data confirms of those frames: one up to 64 IDs on from
+// the ZCL's next is the ZCL's. Reports take IDs 128 to 239 on from it,
+// which the ZCL doesn't reach before their confirms are back.
+#define OPENEVSE_ZCL_TRANSID_AHEAD 64
+#define OPENEVSE_REPORT_TRANSID_MIN 128
+#define OPENEVSE_REPORT_TRANSID_MAX 240
+#define OPENEVSE_REPORT_FRAME_MAX (3 + 1 + 3 * OPENEVSE_ALERTS) // ZCL header, every alert in a notification
+
+// Report classes; they go out in the order of zclOpenEvse_reportOrder
+enum reportClass { REPORT_STATE, REPORT_POWER, REPORT_ENERGY, REPORT_TEMP, REPORT_LEVEL, REPORT_THERMAL,
+                   REPORT_ALERT, REPORT_EVENT, REPORT_CLASSES };
+
+// Alerts. The EVSE's error states raise the first ones, state 4 at bit 0
+// and up; the EVSE latches its faults itself, so they are sent as soon as
+// they are seen. The module's sensor alerts are raised by readings that
+// hold for a while. Each alert is cleared once its condition has been
+// gone for its own time, and the hot alert once the temperature is
+// OPENEVSE_ALERT_TEMP_HYSTERESIS under its threshold.
+#define OPENEVSE_ALERT_STATE_FIRST 0x04
+#define OPENEVSE_ALERT_STATES 8
+#define OPENEVSE_ALERT_HOT 8          // bit of the hottest sensor at zclOpenEvse_alertTemp
+#define OPENEVSE_ALERT_OVERDRAW 9     // bit of the current over the pilot
+#define OPENEVSE_ALERT_TEMP_HYSTERESIS 30
+
+#if OPENEVSE_NUM_EVSE > 1 && !(HAL_UART_ISR == 2 || HAL_UART_DMA == 2)
+#error "Gateway build needs a driver on USART1: HAL_UART_ISR=2 or HAL_UART_DMA=2"
+#endif
+
+#if OPENEVSE_TRACE_ENTRIES & (OPENEVSE_TRACE_ENTRIES - 1)
+#error "OPENEVSE_TRACE_ENTRIES must be a power of two"
+#endif
+
+#if defined OPENEVSE_PROFILE && !OSALMEM_METRICS
+#error "OPENEVSE_PROFILE reads the heap high-water mark, build with OSALMEM_METRICS=TRUE"
+#endif
+
+#if defined OPENEVSE_SLEEPY && !defined POWER_SAVING
+#error "OPENEVSE_SLEEPY is the end device build, it needs POWER_SAVING to sleep"
+#endif
+
+#if defined OPENEVSE_SLEEPY
+// Poll Control, in quarter seconds. A frame from the hub opens a short
+// fast poll window for whatever follows it; a check-in fast polls this
+// long for its response.
+#define OPENEVSE_COMMAND_FAST_POLL 8
+#define OPENEVSE_CHECK_IN_WAIT 8
+#define OPENEVSE_POLL_INTERVAL_MAX 0x6E0000UL
+#define OPENEVSE_LONG_POLL_MIN 4
+#endif
+
+// Readiness probe: $GS until the EVSE is through its power-on self test,
+// waiting 250ms for each reply and backing off 100, 200, 400ms up to 1s
+#define OPENEVSE_PROBE_TIMEOUT 250
+#define OPENEVSE_PROBE_BACKOFF 100
+#define OPENEVSE_PROBE_BACKOFF_MAX 1000
+
+// Per-device phase jitter so a fleet booting together does not report in lockstep
+#if !defined OPENEVSE_STARTUP_JITTER
+#define OPENEVSE_STARTUP_JITTER 4000  // up to 4 seconds before the first probe
+#endif
+#if !defined OPENEVSE_REPORT_JITTER
+#define OPENEVSE_REPORT_JITTER 10000  // up to 10 seconds of report timer phase / re-sync delay
+#endif
+
+// A thermal step is lifted no sooner than this after the last change,
+// so a current the EVSE only just settles under doesn't cycle
+#if !defined OPENEVSE_THERMAL_HOLD
+#define OPENEVSE_THERMAL_HOLD 300000UL
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+enum
+{
+  LIMIT_WRITE_IDLE,
+  LIMIT_WRITE_QUEUED, // Waiting for the command slot
+  LIMIT_WRITE_SENT    // $SH on the wire
+};
+
+typedef struct
+{
+  uint16 clusterId;
+  uint16 attrId;
+  uint8 dataType;
+  uint8 offset;         // of the attribute in zclOpenEvse_evse_t
+} zclOpenEvse_reportFrame_t;
+
+// One alert: its ID, category, and how long its condition must hold
+// before the alert is raised and be gone before it is cleared
+typedef struct
+{
+  uint8 id;
+  uint8 category;
+  uint16 raiseMs;
+  uint16 clearMs;
+} zclOpenEvse_alert_t;
+
+// A report frame waiting for its data confirm
+typedef struct
+{
+  uint8 transID;
+  uint8 charger;        // 0xFF for a free slot
+  uint8 reportClass;
+} zclOpenEvse_inflight_t;
+
+#if OPENEVSE_TRACE_ENTRIES
+// One RAPI transaction or report class transmission
+typedef struct
+{
+  uint32 time;
+  uint16 latency;
+  uint8 id;
+  uint8 len;
+  uint8 result;
+  uint8 info;           // charger << 4 | resends
+} zclOpenEvse_traceEntry_t;
+#endif
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+byte zclOpenEvse_TaskID; // First charger's task, which also runs the report budget
+uint8 zclOpenEvse_seqNum = 0;
+
+/*********************************************************************
+ * GLOBAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+afAddrType_t zclOpenEvse_DstAddr;
+
+uint16 bindingInClusters[] =
+{
+  ZCL_CLUSTER_ID_GEN_ON_OFF
+};
+#define zclOpenEvse_BINDINGLIST (sizeof(bindingInClusters) / sizeof(bindingInClusters[0]))
+
+uint8 gPermitDuration = 0;    // permit joining default to disabled
+
+devStates_t zclOpenEvse_NwkState = DEV_INIT;
+
+uint8 zclOpenEvse_numEvse = 0; // chargers initialized so far
+
+uint32 zclOpenEvse_reportPowerMin =  2000; // 2 seconds
+uint32 zclOpenEvse_reportPowerMax =  60000; // 1 minute
+uint32 zclOpenEvse_reportTempMax =   120000; // 2 minutes
+uint32 zclOpenEvse_reportEnergyMax = 180000; // 3 minutes
+
+uint16 zclOpenEvse_startupJitter = OPENEVSE_STARTUP_JITTER;
+uint16 zclOpenEvse_reportJitter = OPENEVSE_REPORT_JITTER;
+uint16 zclOpenEvse_jitterSeed = 0;
+
+uint32 zclOpenEvse_reportPowerChangedVolts = 5 * 10.0; // 5 volts
+uint32 zclOpenEvse_reportPowerChangedAmps =  1 * 10.0; // 1 amp
+uint32 zclOpenEvse_reportPowerChangedWatts = 200 / 10.0; // 200 watts
+
+// Frames sent for each report class. Each charger has a report command per
+// frame, pointing at its live attribute, so a deferred report always
+// carries the newest value.
+static CONST zclOpenEvse_reportFrame_t zclOpenEvse_reportFrames[OPENEVSE_REPORT_CMDS] =
+{
+  { ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC, ATTRID_IOV_BASIC_PRESENT_VALUE,                // REPORT_STATE
+    ZCL_DATATYPE_UINT16, offsetof( zclOpenEvse_evse_t, state ) },
+  { ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT, ATTRID_ELECTRICAL_MEASUREMENT_RMS_VOLTAGE,      // REPORT_POWER
+    ZCL_DATATYPE_UINT16, offsetof( zclOpenEvse_evse_t, voltsScaled ) },
+  { ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT, ATTRID_ELECTRICAL_MEASUREMENT_RMS_CURRENT,
+    ZCL_DATATYPE_UINT16, offsetof( zclOpenEvse_evse_t, ampsScaled ) },
+  { ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT, ATTRID_ELECTRICAL_MEASUREMENT_ACTIVE_POWER,
+    ZCL_DATATYPE_INT16, offsetof( zclOpenEvse_evse_t, wattsScaled ) },
+  { ZCL_CLUSTER_ID_SE_METERING, ATTRID_CURRENT_SUM_DELIVERED,                                 // REPORT_ENERGY
+    ZCL_DATATYPE_UINT48, offsetof( zclOpenEvse_evse_t, energySum ) },
+  { ZCL_CLUSTER_ID_SE_METERING, ATTRID_CURRENT_DEMAND_DELIVERED,
+    ZCL_DATATYPE_UINT24, offsetof( zclOpenEvse_evse_t, energyDemand ) },
+  { ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG, ATTRID_DEV_TEMP_CURRENT,                           // REPORT_TEMP
+    ZCL_DATATYPE_INT16, offsetof( zclOpenEvse_evse_t, temperature ) },
+  { ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL,                             // REPORT_LEVEL
+    ZCL_DATATYPE_UINT8, offsetof( zclOpenEvse_evse_t, pilotAmps ) },
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_THERMAL_STEP,                              // REPORT_THERMAL
+    ZCL_DATATYPE_UINT8, offsetof( zclOpenEvse_evse_t, thermalStep ) },
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_THERMAL_TEMP,
+    ZCL_DATATYPE_INT16, offsetof( zclOpenEvse_evse_t, tempMax ) }
+};
+// Frames from OPENEVSE_REPORT_CMDS on are the Alerts Notification and
+// Event Notification commands, built when they go out
+static CONST uint8 zclOpenEvse_reportFirst[REPORT_CLASSES+1] = { 0, 1, 4, 6, 7, 8, 10, 11, 12 };
+
+// Alerts and events go first, and never wait for budget
+static CONST uint8 zclOpenEvse_reportOrder[REPORT_CLASSES] =
+{
+  REPORT_ALERT, REPORT_EVENT, REPORT_STATE, REPORT_POWER, REPORT_ENERGY, REPORT_TEMP, REPORT_LEVEL, REPORT_THERMAL
+};
+
+static CONST zclOpenEvse_alert_t zclOpenEvse_alertTable[OPENEVSE_ALERTS] =
+{
+  { 0x04, OPENEVSE_ALERT_WARNING, 0, 2000 },     // vent required
+  { 0x05, OPENEVSE_ALERT_FAILURE, 0, 2000 },     // diode check failed
+  { 0x06, OPENEVSE_ALERT_DANGER, 0, 2000 },      // GFCI fault
+  { 0x07, OPENEVSE_ALERT_DANGER, 0, 2000 },      // no ground
+  { 0x08, OPENEVSE_ALERT_DANGER, 0, 2000 },      // stuck relay
+  { 0x09, OPENEVSE_ALERT_FAILURE, 0, 2000 },     // GFI self test failed
+  { 0x0A, OPENEVSE_ALERT_DANGER, 0, 2000 },      // over temperature shutdown
+  { 0x0B, OPENEVSE_ALERT_DANGER, 0, 2000 },      // over current shutdown
+  { 0x20, OPENEVSE_ALERT_WARNING, 5000, 30000 }, // OPENEVSE_ALERT_HOT
+  { 0x21, OPENEVSE_ALERT_WARNING, 3000, 10000 }  // OPENEVSE_ALERT_OVERDRAW
+};
+
+static zclOpenEvse_inflight_t zclOpenEvse_inflight[OPENEVSE_REPORT_INFLIGHT];
+static uint8 zclOpenEvse_inflightNext = 0;
+static uint8 zclOpenEvse_transID = OPENEVSE_REPORT_TRANSID_MIN;
+static uint8 zclOpenEvse_zclTransID = 0;  // the ZCL's next, as far as its confirms tell
+
+#if OPENEVSE_TRACE_ENTRIES
+static zclOpenEvse_traceEntry_t zclOpenEvse_trace[OPENEVSE_TRACE_ENTRIES];
+#endif
+
+uint32 zclOpenEvse_budgetFrameTokens = 0; // thousandths of a frame
+uint32 zclOpenEvse_budgetByteTokens = 0;  // thousandths of a byte
+uint32 zclOpenEvse_budgetLastRefill = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static zclOpenEvse_evse_t *zclOpenEvse_EVSEByTask(byte task_id);
+static zclOpenEvse_evse_t *zclOpenEvse_EVSEByEndpoint(uint8 endpoint);
+static zclOpenEvse_evse_t *zclOpenEvse_EVSEByPort(uint8 port);
+static CONST zclAttrRec_t *zclOpenEvse_EVSEAttrs(zclOpenEvse_evse_t *evse, CONST zclAttrRec_t *attrs,
+                                                 uint8 numAttrs);
+static void zclOpenEvse_BasicResetCB(void);
+static void zclOpenEvse_OnOffCB(uint8 cmd);
+#ifdef ZCL_LEVEL_CTRL
+static void zclOpenEvse_LevelMoveToLevelCB(zclLCMoveToLevel_t *pCmd);
+static void zclOpenEvse_LevelMoveCB(zclLCMove_t *pCmd);
+static void zclOpenEvse_LevelStepCB(zclLCStep_t *pCmd);
+static void zclOpenEvse_LevelStopCB(void);
+static void zclOpenEvse_LevelCommand(zclOpenEvse_evse_t *evse, uint8 level, uint16 transitionTime,
+                                     uint8 turnOn);
+#endif
+static uint8 zclOpenEvse_GroupRestore(zclOpenEvse_evse_t *evse, uint8 raise);
+static void zclOpenEvse_LevelRamp(zclOpenEvse_evse_t *evse, uint8 level, uint16 transitionTime);
+static void zclOpenEvse_LevelStop(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_Identify(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_IdentifyCB(zclIdentify_t *pCmd);
+static void zclOpenEvse_IdentifyTriggerEffectCB(zclIdentifyTriggerEffect_t *pCmd);
+static ZStatus_t zclOpenEvse_ReadWriteCB(uint16 clusterId, uint16 attrId, uint8 oper,
+                                         uint8 *pValue, uint16 *pLen);
+static uint8 zclOpenEvse_ProcessAFMsg(zclOpenEvse_evse_t *evse, afIncomingMSGPacket_t *pkt);
+static ZStatus_t zclOpenEvse_LimitWrite(zclOpenEvse_evse_t *evse, uint32 limit,
+                                        afIncomingMSGPacket_t *pkt, uint8 seqNum);
+static void zclOpenEvse_LimitWriteDone(zclOpenEvse_evse_t *evse, ZStatus_t status);
+
+static void zclOpenEvse_sendPower(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_sendTemp(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_sendEnergy(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_sendState(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_sendLevel(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_sendThermal(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_Thermal(zclOpenEvse_evse_t *evse);
+static uint8 zclOpenEvse_ThermalCap(zclOpenEvse_evse_t *evse, uint8 amps);
+static void zclOpenEvse_ThermalSave(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_Alerts(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_Settings(zclOpenEvse_evse_t *evse, uint8 level, uint8 amps);
+static void zclOpenEvse_Energy(zclOpenEvse_evse_t *evse, uint32 acc);
+static void zclOpenEvse_EnergySum(zclOpenEvse_evse_t *evse);
+static uint8 zclOpenEvse_AlertList(zclOpenEvse_evse_t *evse, uint16 cleared, uint8 *buf);
+static uint8 zclOpenEvse_GetAlerts(zclOpenEvse_evse_t *evse, afIncomingMSGPacket_t *pkt);
+static void zclOpenEvse_Event(zclOpenEvse_evse_t *evse, uint8 eventId);
+static void zclOpenEvse_ReportRequest(zclOpenEvse_evse_t *evse, uint8 reportClass);
+static void zclOpenEvse_ReportFlush(void);
+static ZStatus_t zclOpenEvse_SendReport(zclOpenEvse_evse_t *evse, uint8 reportClass, uint8 frame);
+static void zclOpenEvse_ReportConfirm(afDataConfirm_t *cnf);
+static uint16 zclOpenEvse_ReportBytes(uint8 reportClass);
+static void zclOpenEvse_BudgetRefill(void);
+static void zclOpenEvse_MeshConfirm(uint8 status);
+static uint8 zclOpenEvse_MeshStretch(void);
+static void zclOpenEvse_zigbeeReset(void);
+static void zclOpenEvse_JitterInit(void);
+static uint16 zclOpenEvse_Jitter(uint16 range);
+static void zclOpenEvse_SyncDelay(zclOpenEvse_evse_t *evse);
+static UTCTime zclOpenEvse_LocalTime(void);
+static void zclOpenEvse_TimeSet(UTCTime utc, uint8 source);
+static uint8 zclOpenEvse_RtcTime(zclOpenEvse_evse_t *evse, char * rxData);
+static uint8 zclOpenEvse_TouWindow(zclOpenEvse_evse_t *evse, UTCTime local);
+static void zclOpenEvse_TouRun(zclOpenEvse_evse_t *evse);
+static ZStatus_t zclOpenEvse_TimeReadWrite(uint16 attrId, uint8 oper, uint8 *pValue, uint16 *pLen);
+static ZStatus_t zclOpenEvse_TouReadWrite(zclOpenEvse_evse_t *evse, uint8 oper, uint8 *pValue, uint16 *pLen);
+static ZStatus_t zclOpenEvse_CmdStatsRead(zclOpenEvse_evse_t *evse, uint16 attrId, uint8 oper,
+                                          uint8 *pValue, uint16 *pLen);
+#if defined OPENEVSE_SLEEPY
+static void zclOpenEvse_FastPoll(uint16 quarterSecs);
+static void zclOpenEvse_FastPollStop(void);
+static void zclOpenEvse_CheckIn(void);
+static ZStatus_t zclOpenEvse_CheckInRspCB(zclPollControlCheckInRsp_t *pCmd);
+static ZStatus_t zclOpenEvse_FastPollStopCB(zclPollControlFastPollStop_t *pCmd);
+static ZStatus_t zclOpenEvse_SetLongPollIntervalCB(zclPollControlSetLongPollInterval_t *pCmd);
+static ZStatus_t zclOpenEvse_SetShortPollIntervalCB(zclPollControlSetShortPollInterval_t *pCmd);
+static ZStatus_t zclOpenEvse_PollControlReadWrite(uint16 attrId, uint8 oper, uint8 *pValue, uint16 *pLen);
+#endif
+static void zclOpenEvse_EVSESetLimit(zclOpenEvse_evse_t *evse, uint32 limit);
+static void zclOpenEvse_EVSEState(zclOpenEvse_evse_t *evse, uint8 state);
+static void zclOpenEvse_EVSEWriteCmd(zclOpenEvse_evse_t *evse, uint8 command, uint8 numArgs, ...);
+static void zclOpenEvse_EVSESendFrame(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_EVSEResend(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_LinkRtt(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_UARTInit(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_UARTCallback(uint8 port, uint8 event);
+static void zclOpenEvse_UARTOverrun(zclOpenEvse_evse_t *evse);
+static void zclOpenEvse_UARTParse(zclOpenEvse_evse_t *evse, char * rxData);
+static uint8 zclOpenEvse_nibbletohex(uint8 value);
+static uint8 zclOpenEvse_hextonibble(uint8 value);
+static uint16 zclOpenEvse_u8tohex(uint8 value);
+static uint8 zclOpenEvse_hextou8(uint16 value);
+#if OPENEVSE_TRACE_ENTRIES
+static void zclOpenEvse_Trace(zclOpenEvse_evse_t *evse, uint8 id, uint8 len, uint8 result,
+                              uint8 resends, uint32 latency);
+static ZStatus_t zclOpenEvse_TraceRead(uint8 oper, uint8 *pValue, uint16 *pLen);
+#endif
+#if defined OPENEVSE_PROFILE
+static uint16 zclOpenEvse_ProcessEvent(uint8 task_id, uint16 events);
+static uint32 zclOpenEvse_ProfileTicks(void);
+static ZStatus_t zclOpenEvse_ProfileRead(uint16 attrId, uint8 oper, uint8 *pValue, uint16 *pLen);
+#endif
+
+// Functions to process ZCL Foundation incoming Command/Response messages
+static void zclOpenEvse_ProcessIncomingMsg( zclIncomingMsg_t *msg );
+#ifdef ZCL_READ
+static uint8 zclOpenEvse_ProcessInReadRspCmd( zclIncomingMsg_t *pInMsg );
+#endif
+#ifdef ZCL_WRITE
+static uint8 zclOpenEvse_ProcessInWriteRspCmd( zclIncomingMsg_t *pInMsg );
+#endif
+static uint8 zclOpenEvse_ProcessInDefaultRspCmd( zclIncomingMsg_t *pInMsg );
+#ifdef ZCL_DISCOVER
+static uint8 zclOpenEvse_ProcessInDiscCmdsRspCmd( zclIncomingMsg_t *pInMsg );
+static uint8 zclOpenEvse_ProcessInDiscAttrsRspCmd( zclIncomingMsg_t *pInMsg );
+static uint8 zclOpenEvse_ProcessInDiscAttrsExtRspCmd( zclIncomingMsg_t *pInMsg );
+#endif
+
+/*********************************************************************
+ * STATUS STRINGS
+ */
+/*********************************************************************
+ * ZCL General Profile Callback table
+ */
+static zclGeneral_AppCallbacks_t zclOpenEvse_CmdCallbacks =
+{
+  zclOpenEvse_BasicResetCB,               // Basic Cluster Reset command
+  zclOpenEvse_IdentifyCB,                 // Identify command
+#ifdef ZCL_EZMODE
+  NULL,                                   // Identify EZ-Mode Invoke command
+  NULL,                                   // Identify Update Commission State command
+#endif
+  zclOpenEvse_IdentifyTriggerEffectCB,    // Identify Trigger Effect command
+  NULL,                                   // Identify Query Response command
+  zclOpenEvse_OnOffCB,                    // On/Off cluster commands
+  NULL,                                   // On/Off cluster enhanced command Off with Effect
+  NULL,                                   // On/Off cluster enhanced command On with Recall Global Scene
+  NULL,                                   // On/Off cluster enhanced command On with Timed Off
+#ifdef ZCL_LEVEL_CTRL
+  zclOpenEvse_LevelMoveToLevelCB,         // Level Control Move to Level command
+  zclOpenEvse_LevelMoveCB,                // Level Control Move command
+  zclOpenEvse_LevelStepCB,                // Level Control Step command
+  zclOpenEvse_LevelStopCB,                // Level Control Stop command
+#endif
+#ifdef ZCL_GROUPS
+  NULL,                                   // Group Response commands
+#endif
+#ifdef ZCL_SCENES
+  NULL,                                   // Scene Store Request command
+  NULL,                                   // Scene Recall Request command
+  NULL,                                   // Scene Response command
+#endif
+#ifdef ZCL_ALARMS
+  NULL,                                   // Alarm (Response) commands
+#endif
+#ifdef SE_UK_EXT
+  NULL,                                   // Get Event Log command
+  NULL,                                   // Publish Event Log command
+#endif
+  NULL,                                   // RSSI Location command
+  NULL                                    // RSSI Location Response command
+};
+
+#if defined OPENEVSE_SLEEPY
+/*********************************************************************
+ * ZCL Poll Control Callback table
+ */
+static zclPollControl_AppCallbacks_t zclOpenEvse_PollControlCmdCallbacks =
+{
+  NULL,                                   // Check-in command, sent by this device
+  zclOpenEvse_CheckInRspCB,               // Check-in Response command
+  zclOpenEvse_FastPollStopCB,             // Fast Poll Stop command
+  zclOpenEvse_SetLongPollIntervalCB,      // Set Long Poll Interval command
+  zclOpenEvse_SetShortPollIntervalCB      // Set Short Poll Interval command
+};
+#endif
+
+/*********************************************************************
+ * @fn          zclOpenEvse_Init
+ *
+ * @brief       Initialization function for the zclGeneral layer. Called
+ *              once per charger, each with its own task.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+void zclOpenEvse_Init( byte task_id )
+{
+  zclOpenEvse_evse_t *evse = &zclOpenEvse_evse[zclOpenEvse_numEvse++];
+  endPointDesc_t *epDesc;
+  zclReportCmd_t *reportCmd;
+  uint8 i;
+
+  evse->taskId = task_id;
+  evse->endpoint = OPENEVSE_EVSE_ENDPOINT(evse - zclOpenEvse_evse);
+  evse->port = HAL_UART_PORT_0 + (evse - zclOpenEvse_evse);
+  evse->frame[0] = '$';
+  evse->rxIndex = -1;
+  evse->rxWaitSoc = TRUE;
+  evse->firstTime = TRUE;
+  evse->lastBacklight = TRUE;
+  evse->link.rttMin = 0xFFFF;
+
+  zclOpenEvse_UARTInit(evse);
+
+  if ( evse == zclOpenEvse_evse )
+  {
+    zclOpenEvse_TaskID = task_id;
+
+    // Set destination address to indirect
+    zclOpenEvse_DstAddr.addrMode = (afAddrMode_t)AddrNotPresent;
+    zclOpenEvse_DstAddr.endPoint = 0;
+    zclOpenEvse_DstAddr.addr.shortAddr = 0;
+
+    // Register the Application to receive the unprocessed Foundation command/response messages
+    zcl_registerForMsg( zclOpenEvse_TaskID );
+
+    // Start with a full airtime budget, shared by all chargers
+    zclOpenEvse_budgetLastRefill = osal_GetSystemClock();
+    zclOpenEvse_budgetFrameTokens = (uint32)zclOpenEvse_budgetFrames * OPENEVSE_BUDGET_DEPTH;
+    zclOpenEvse_budgetByteTokens = (uint32)zclOpenEvse_budgetBytes * OPENEVSE_BUDGET_DEPTH;
+
+    osal_memset( zclOpenEvse_inflight, 0xFF, sizeof(zclOpenEvse_inflight) );
+    zclOpenEvse_JitterInit();
+  }
+
+  // This app is part of the Home Automation Profile
+  zclHA_Init( &zclOpenEvse_SimpleDesc[evse - zclOpenEvse_evse] );
+  zclHA_Init( &zclOpenEvse_BlSimpleDesc[evse - zclOpenEvse_evse] );
+
+  // Take the charger endpoint's messages first, so a limit write can be
+  // answered once the EVSE has taken it; the rest go on to the ZCL. The
+  // backlight endpoint's go straight on, and both bring the data confirms
+  // of the ZCL's frames here to follow its transaction IDs.
+  epDesc = afFindEndPointDesc( evse->endpoint );
+  if ( epDesc != NULL )
+  {
+    epDesc->task_id = &evse->taskId;
+  }
+  epDesc = afFindEndPointDesc( evse->endpoint+1 );
+  if ( epDesc != NULL )
+  {
+    epDesc->task_id = &evse->taskId;
+  }
+
+  // Register the ZCL General Cluster Library callback functions
+  zclGeneral_RegisterCmdCallbacks( evse->endpoint, &zclOpenEvse_CmdCallbacks );
+
+  // Register the backlight callback functions
+  zclGeneral_RegisterCmdCallbacks( evse->endpoint+1, &zclOpenEvse_CmdCallbacks );
+
+#if defined OPENEVSE_SLEEPY
+  // Poll Control is the module's, on every charger endpoint
+  zclPollControl_RegisterCmdCallbacks( evse->endpoint, &zclOpenEvse_PollControlCmdCallbacks );
+#endif
+
+  // Register the application's attribute list
+  zcl_registerAttrList( evse->endpoint, zclOpenEvse_NumAttributes,
+                        zclOpenEvse_EVSEAttrs( evse, zclOpenEvse_Attrs, zclOpenEvse_NumAttributes ) );
+  zcl_registerReadWriteCB( evse->endpoint, zclOpenEvse_ReadWriteCB, NULL );
+
+    // Register the backlight attribute list
+  zcl_registerAttrList( evse->endpoint+1, zclOpenEvse_BlNumAttributes,
+                        zclOpenEvse_EVSEAttrs( evse, zclOpenEvse_BlAttrs, zclOpenEvse_BlNumAttributes ) );
+
+#ifdef ZCL_DISCOVER
+  // Register the application's command list
+  zcl_registerCmdList( evse->endpoint, zclCmdsArraySize, zclOpenEvse_Cmds );
+#endif
+
+  // Register for all key events - This app will handle all key events
+  //RegisterForKeys( zclOpenEvse_TaskID );
+
+#ifdef ZGP_AUTO_TT
+  zgpTranslationTable_RegisterEP ( &zclOpenEvse_SimpleDesc[evse - zclOpenEvse_evse] );
+#endif
+
+  // Create a report command for each frame, pointing at this charger's attribute
+  for ( i = 0; i < OPENEVSE_REPORT_CMDS; i++ )
+  {
+    reportCmd = (zclReportCmd_t *)osal_mem_alloc( sizeof( zclReportCmd_t ) +
+                   ( 1 * sizeof( zclReport_t ) ) );
+    if ( reportCmd != NULL )
+    {
+      reportCmd->numAttr = 1;
+
+      // Set up the first attribute
+      reportCmd->attrList[0].attrID = zclOpenEvse_reportFrames[i].attrId;
+      reportCmd->attrList[0].dataType = zclOpenEvse_reportFrames[i].dataType;
+      reportCmd->attrList[0].attrData = (uint8 *)evse + zclOpenEvse_reportFrames[i].offset;
+    }
+    evse->reportCmd[i] = reportCmd;
+  }
+
+  // Restore backlight setting
+  zcl_nv_item_init( OPENEVSE_EVSE_NV(evse, OPENEVSE_BL_NV), sizeof(evse->backlight), &evse->backlight );
+  zcl_nv_read( OPENEVSE_EVSE_NV(evse, OPENEVSE_BL_NV), 0, sizeof(evse->backlight), &evse->backlight );
+  zcl_nv_item_init( OPENEVSE_EVSE_NV(evse, OPENEVSE_LIMIT_NV), sizeof(evse->energyLimit), &evse->energyLimit );
+  zcl_nv_read( OPENEVSE_EVSE_NV(evse, OPENEVSE_LIMIT_NV), 0, sizeof(evse->energyLimit), &evse->energyLimit );
+
+  // Restore the energy total, which the EVSE's next count adds to
+  zcl_nv_item_init( OPENEVSE_EVSE_NV(evse, OPENEVSE_ENERGY_NV), sizeof(evse->energy), &evse->energy );
+  zcl_nv_read( OPENEVSE_EVSE_NV(evse, OPENEVSE_ENERGY_NV), 0, sizeof(evse->energy), &evse->energy );
+  evse->energySaved = evse->energy.totalLo;
+  zclOpenEvse_EnergySum(evse);
+
+  // Restore the charging schedule; it starts once the time and the EVSE's current are known
+  zcl_nv_item_init( OPENEVSE_EVSE_NV(evse, OPENEVSE_TOU_NV), sizeof(evse->tou), &evse->tou );
+  zcl_nv_read( OPENEVSE_EVSE_NV(evse, OPENEVSE_TOU_NV), 0, sizeof(evse->tou), &evse->tou );
+  evse->touActive = OPENEVSE_TOU_UNKNOWN;
+  osal_set_event( evse->taskId, OPENEVSE_TOU_EVT );
+  evse->tempMax = OPENEVSE_TEMP_INVALID;
+
+  // Restore the thermal step and the current asked for under it, which $GE can't give
+  zcl_nv_item_init( OPENEVSE_EVSE_NV(evse, OPENEVSE_THERMAL_NV), sizeof(evse->thermalSaved), &evse->thermalSaved );
+  zcl_nv_read( OPENEVSE_EVSE_NV(evse, OPENEVSE_THERMAL_NV), 0, sizeof(evse->thermalSaved), &evse->thermalSaved );
+  evse->thermalStep = evse->thermalSaved.step;
+  evse->wantAmps = evse->thermalSaved.wantAmps;
+
+  // Stagger the first poll so chargers sharing a power feed don't boot in lockstep
+  zclOpenEvse_SyncDelay(evse);
+  osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, zclOpenEvse_Jitter(zclOpenEvse_startupJitter) );
+}
+
+/*********************************************************************
+ * @fn          zclOpenEvse_EVSEByTask
+ *
+ * @brief       Find the charger a task, endpoint or UART belongs to.
+ *              Anything unknown maps to the last charger.
+ */
+static zclOpenEvse_evse_t *zclOpenEvse_EVSEByTask( byte task_id )
+{
+  uint8 i;
+
+  for ( i = 0; i < OPENEVSE_NUM_EVSE - 1; i++ )
+  {
+    if ( zclOpenEvse_evse[i].taskId == task_id )
+    {
+      break;
+    }
+  }
+  return &zclOpenEvse_evse[i];
+}
+
+static zclOpenEvse_evse_t *zclOpenEvse_EVSEByEndpoint( uint8 endpoint )
+{
+  uint8 i = (uint8)(endpoint - OPENEVSE_ENDPOINT) >> 1;
+
+  return &zclOpenEvse_evse[i < OPENEVSE_NUM_EVSE ? i : OPENEVSE_NUM_EVSE - 1];
+}
+
+static zclOpenEvse_evse_t *zclOpenEvse_EVSEByPort( uint8 port )
+{
+  uint8 i = port - HAL_UART_PORT_0;
+
+  return &zclOpenEvse_evse[i < OPENEVSE_NUM_EVSE ? i : OPENEVSE_NUM_EVSE - 1];
+}
+
+/*********************************************************************
+ * @fn          zclOpenEvse_EVSEAttrs
+ *
+ * @brief       Attribute table for a charger. The first charger uses the
+ *              table as it is; later ones get a copy from the heap with
+ *              every pointer into zclOpenEvse_evse[0] moved to their own
+ *              context.
+ *
+ * @param       evse - charger
+ * @param       attrs - table written for zclOpenEvse_evse[0]
+ * @param       numAttrs - records in the table
+ *
+ * @return      table to register
+ */
+static CONST zclAttrRec_t *zclOpenEvse_EVSEAttrs( zclOpenEvse_evse_t *evse, CONST zclAttrRec_t *attrs,
+                                                  uint8 numAttrs )
+{
+  uint8 *base = (uint8 *)&zclOpenEvse_evse[0];
+  uint8 *dataPtr;
+  zclAttrRec_t *copy;
+  uint8 i;
+
+  if ( evse == zclOpenEvse_evse )
+  {
+    return attrs;
+  }
+
+  copy = (zclAttrRec_t *)osal_mem_alloc( numAttrs * sizeof( zclAttrRec_t ) );
+  if ( copy == NULL )
+  {
+    return attrs; // Out of heap, the charger mirrors the first one
+  }
+  osal_memcpy( copy, attrs, numAttrs * sizeof( zclAttrRec_t ) );
+  for ( i = 0; i < numAttrs; i++ )
+  {
+    dataPtr = (uint8 *)copy[i].attr.dataPtr;
+    if ( dataPtr >= base && dataPtr < base + sizeof( zclOpenEvse_evse_t ) )
+    {
+      copy[i].attr.dataPtr = (uint8 *)evse + (dataPtr - base);
+    }
+  }
+  return copy;
+}
+
+/*********************************************************************
+ * @fn          zclOpenEvse_event_loop
+ *
+ * @brief       Event Loop Processor for zclGeneral.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+#if defined OPENEVSE_PROFILE
+uint16 zclOpenEvse_event_loop( uint8 task_id, uint16 events )
+{
+  uint32 start = zclOpenEvse_ProfileTicks();
+  uint16 left = zclOpenEvse_ProcessEvent( task_id, events );
+  uint32 elapsed = (zclOpenEvse_ProfileTicks() - start) & 0xFFFFFF;
+  uint16 handled = events & ~left;
+  uint16 ticks = elapsed > 0xFFFF ? 0xFFFF : (uint16)elapsed;
+  uint8 bit = 0;
+  uint8 bucket = 0;
+
+  if ( handled == 0 )
+  {
+    return left; // Postponed, nothing was done
+  }
+
+  // Each pass handles one event bit
+  while ( !(handled & 1) )
+  {
+    handled >>= 1;
+    bit++;
+  }
+  while ( ticks > 1 && bucket < OPENEVSE_PROFILE_BUCKETS - 1 )
+  {
+    ticks >>= 1;
+    bucket++;
+  }
+  zclOpenEvse_profile.calls[bit]++;
+  zclOpenEvse_profile.hist[bit][bucket]++;
+  return left;
+}
+
+/*********************************************************************
+ * @fn          zclOpenEvse_ProcessEvent
+ *
+ * @brief       Event Loop Processor, timed by zclOpenEvse_event_loop.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static uint16 zclOpenEvse_ProcessEvent( uint8 task_id, uint16 events )
+#else
+uint16 zclOpenEvse_event_loop( uint8 task_id, uint16 events )
+#endif
+{
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByTask( task_id );
+  afIncomingMSGPacket_t *MSGpkt;
+  uint32 backoff;
+
+  if ( events & SYS_EVENT_MSG )
+  {
+#if defined OPENEVSE_PROFILE
+    uint8 queued = 0;
+#endif
+    while ( (MSGpkt = (afIncomingMSGPacket_t *)osal_msg_receive( evse->taskId )) )
+    {
+#if defined OPENEVSE_PROFILE
+      queued++;
+#endif
+      switch ( MSGpkt->hdr.event )
+      {
+        case ZCL_INCOMING_MSG:
+          // Incoming ZCL Foundation command/response messages
+          zclOpenEvse_ProcessIncomingMsg( (zclIncomingMsg_t *)MSGpkt );
+          break;
+
+        case AF_INCOMING_MSG_CMD:
+#if defined OPENEVSE_SLEEPY
+          zclOpenEvse_FastPoll( OPENEVSE_COMMAND_FAST_POLL );
+#endif
+          // Charger endpoint traffic, anything not handled here is for the ZCL
+          if ( MSGpkt->endPoint != evse->endpoint || !zclOpenEvse_ProcessAFMsg( evse, MSGpkt ) )
+          {
+            zcl_ProcessMessageMSG( MSGpkt );
+          }
+          break;
+
+        case AF_DATA_CONFIRM_CMD:
+          // Reports and the ZCL's frames, APS or NWK result
+          zclOpenEvse_ReportConfirm( (afDataConfirm_t *)MSGpkt );
+          break;
+
+        case KEY_CHANGE:
+          break;
+
+        case ZDO_STATE_CHANGE:
+#if defined OPENEVSE_SLEEPY
+          if ( (devStates_t)(MSGpkt->hdr.status) == DEV_END_DEVICE &&
+               zclOpenEvse_NwkState != DEV_END_DEVICE )
+          {
+            // Joined: poll at our long poll interval and check in straight away
+            NLME_SetPollRate( zclOpenEvse_longPollInterval * 250 );
+            osal_set_event( zclOpenEvse_TaskID, OPENEVSE_CHECK_IN_EVT );
+          }
+#endif
+          zclOpenEvse_NwkState = (devStates_t)(MSGpkt->hdr.status);
+
+          // now on the network
+          if ( (zclOpenEvse_NwkState == DEV_ZB_COORD) ||
+               (zclOpenEvse_NwkState == DEV_ROUTER)   ||
+               (zclOpenEvse_NwkState == DEV_END_DEVICE) )
+          {
+            zclOpenEvse_Identify(evse);
+#if defined OPENEVSE_OTA
+            zclOpenEvseOta_NwkUp();
+#endif
+          }
+          break;
+
+        default:
+          break;
+      }
+
+      // Release the memory
+      osal_msg_deallocate( (uint8 *)MSGpkt );
+    }
+#if defined OPENEVSE_PROFILE
+    if ( queued > zclOpenEvse_profile.queueMax )
+    {
+      zclOpenEvse_profile.queueMax = queued;
+    }
+#endif
+
+    // return unprocessed events
+    return (events ^ SYS_EVENT_MSG);
+  }
+  
+  if ( (events & OPENEVSE_CMD_TIMEOUT_EVT) )
+  {
+    if (evse->cmd != EVSE_CMD_NONE)
+    {
+      if (evse->retryDue)
+      {
+        // Backoff is over, send the same frame again
+        evse->retryDue = FALSE;
+        evse->resendCtr++;
+        evse->retries[evse->cmd]++;
+        evse->link.resends++;
+        HalUARTWrite(evse->port, (uint8 *)"\r", 1); // Flush any partial line at the EVSE
+        zclOpenEvse_EVSESendFrame(evse);
+      }
+      else
+      {
+        zclOpenEvse_EVSEResend(evse);  // Resend if command didn't get a response
+      }
+    }
+    return (events ^ OPENEVSE_CMD_TIMEOUT_EVT);
+  }
+
+#if defined OPENEVSE_SLEEPY
+  if ( events & OPENEVSE_POLL_CONTROL_TIMEOUT_EVT )
+  {
+    // Fast poll window is over
+    NLME_SetPollRate( zclOpenEvse_longPollInterval * 250 );
+    return ( events ^ OPENEVSE_POLL_CONTROL_TIMEOUT_EVT );
+  }
+
+  if ( events & OPENEVSE_CHECK_IN_EVT )
+  {
+    zclOpenEvse_CheckIn();
+    return ( events ^ OPENEVSE_CHECK_IN_EVT );
+  }
+#endif
+
+  if ( events & OPENEVSE_REPORT_BUDGET_EVT )
+  {
+    zclOpenEvse_ReportFlush(); // Budget has refilled for deferred reports
+    return ( events ^ OPENEVSE_REPORT_BUDGET_EVT );
+  }
+
+  if ( events & OPENEVSE_LIMIT_WRITE_EVT )
+  {
+    if (evse->cmd != EVSE_CMD_NONE)
+    {
+      return events; // If last command not complete, postpone this
+    }
+
+    evse->limitWrite.state = LIMIT_WRITE_SENT;
+    zclOpenEvse_EVSESetLimit(evse, evse->limitWrite.value);
+    return ( events ^ OPENEVSE_LIMIT_WRITE_EVT );
+  }
+
+  if ( events & OPENEVSE_TOU_EVT )
+  {
+    zclOpenEvse_TouRun(evse);
+    return ( events ^ OPENEVSE_TOU_EVT );
+  }
+
+  if ( events & OPENEVSE_LEVEL_EVT )
+  {
+    if ( evse->levelSteps != 0 )
+    {
+      // Next step of the ramp; the poll loop sends whichever is newest
+      evse->levelStep++;
+      evse->setAmps = evse->levelFrom + (int16)(evse->levelTarget - evse->levelFrom) * evse->levelStep / evse->levelSteps;
+      if ( evse->levelStep < evse->levelSteps )
+      {
+        evse->levelRemaining = (uint16)((evse->levelSteps - evse->levelStep) * evse->levelStepMs / 100);
+        osal_start_timerEx( evse->taskId, OPENEVSE_LEVEL_EVT, evse->levelStepMs );
+      }
+      else
+      {
+        zclOpenEvse_LevelStop(evse);
+      }
+    }
+    return ( events ^ OPENEVSE_LEVEL_EVT );
+  }
+
+  if ( events & OPENEVSE_RESTORE_EVT )
+  {
+    // The random wait of a group restore is over
+    if ( evse->restoreOn )
+    {
+      evse->restoreOn = FALSE;
+      evse->OnOff = LIGHT_ON;
+    }
+    if ( evse->restoreLevel != 0 )
+    {
+      zclOpenEvse_LevelRamp( evse, evse->restoreLevel, evse->restoreTime );
+      evse->restoreLevel = 0;
+    }
+    return ( events ^ OPENEVSE_RESTORE_EVT );
+  }
+
+  if ( (events & OPENEVSE_IDENTIFY_EVT) )
+  {
+    // Only picks the LCD colour; the poll loop sends it when it has a slot
+    if (evse->identPhases == 0 && evse->IdentifyTime != 0)
+    {
+      evse->identColor = EVSE_CMD_LCDTEAL; // Identify mode, one blink per second
+      evse->identPhases = 2;
+      evse->IdentifyTime--;
+    }
+    if (evse->identPhases != 0)
+    {
+      evse->identPhases--;
+      evse->identLcd = (evse->identPhases & 1) ? evse->identColor : EVSE_CMD_LCDOFF;
+      osal_start_timerEx( evse->taskId, OPENEVSE_IDENTIFY_EVT, OPENEVSE_IDENTIFY_PHASE );
+    }
+    else
+    {
+      evse->identLcd = EVSE_CMD_NONE;
+      evse->lastBacklight = 0xFF; // Let the backlight sync put the user's setting back
+    }
+    return ( events ^ OPENEVSE_IDENTIFY_EVT );
+  }
+  
+  if (events & OPENEVSE_POLL_EVSE_EVT)
+  {
+    if (evse->cmd != EVSE_CMD_NONE)
+    {
+      return events; // If last command not complete, postpone this
+    }
+
+    // Conditions waiting out their debounce
+    if (evse->alertRaw != evse->alerts)
+    {
+      zclOpenEvse_Alerts(evse);
+    }
+
+    // Pilot current for a ramp step or schedule window, ahead of the enable it goes with
+    if (evse->ready && evse->setAmps != 0)
+    {
+      evse->wantAmps = evse->setAmps;
+      evse->sentAmps = zclOpenEvse_ThermalCap(evse, evse->setAmps);
+      evse->setAmps = 0;
+      // Only a setting that is to stay goes to the EVSE's EEPROM
+      evse->sentVolatile = (evse->levelSteps != 0 || evse->sentAmps != evse->wantAmps);
+      zclOpenEvse_ThermalSave(evse);
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_SETCURRENT, 1, (int32)evse->sentAmps);
+      osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
+      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+    }
+
+    if (evse->ready && evse->OnOff != evse->lastOnOff)
+    {
+      evse->lastOnOff = evse->OnOff;
+      if (evse->OnOff == LIGHT_ON)
+      {
+        zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_ENABLE, 0);
+      }
+      else
+      {
+        zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_SLEEP, 0);
+      }
+      osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
+      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+    }
+
+    if (evse->ready && evse->backlight != evse->lastBacklight)
+    {
+      evse->lastBacklight = evse->backlight;
+      if (evse->backlight == LIGHT_ON)
+      {
+        zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_LCDRGB, 0);
+      }
+      else
+      {
+        zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_LCDOFF, 0);
+      }
+      osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
+      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+    }
+
+    if (evse->ready && evse->touRtc)
+    {
+      evse->touRtc = FALSE;
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETTIME, 0);
+      evse->background = TRUE; // The schedule asks again later
+      osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
+      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+    }
+
+    // Re-sync, state first; a change found is reported as it would have been at the EVSE
+    if (evse->ready && evse->pollNumber >= 10 && evse->resync != 0)
+    {
+      zclOpenEvse_EVSEWriteCmd(evse, (evse->resync == 2) ? EVSE_CMD_GETSTATE : EVSE_CMD_GETSETTINGS, 0);
+      evse->resync--;
+      evse->background = TRUE; // The next re-sync asks again
+      osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
+      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+    }
+
+    if (evse->ready && evse->identLcd != EVSE_CMD_NONE && evse->identTicks >= OPENEVSE_IDENTIFY_SHARE)
+    {
+      zclOpenEvse_EVSEWriteCmd(evse, evse->identLcd, 0);
+      evse->background = TRUE; // A lost blink isn't worth a resend
+      osal_start_timerEx( evse->taskId, OPENEVSE_CMD_TIMEOUT_EVT, OPENEVSE_IDENTIFY_SLOT );
+      evse->identLcd = EVSE_CMD_NONE;
+      evse->identTicks = 0;
+      // Telemetry carries on once the slot is over, not a whole tick later
+      osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, OPENEVSE_IDENTIFY_SLOT );
+      return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+    }
+    if (evse->identTicks < OPENEVSE_IDENTIFY_SHARE)
+    {
+      evse->identTicks++;
+    }
+
+    switch (evse->pollNumber++)
+    {
+    case 0: // State 0-9 initialization
+      if (!evse->ready)
+      {
+        // Probe until the EVSE answers; a good reply runs this state again at once
+        zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETSTATE, 0);
+        backoff = (uint32)OPENEVSE_PROBE_BACKOFF << evse->probeCtr;
+        if (backoff < OPENEVSE_PROBE_BACKOFF_MAX)
+        {
+          evse->probeCtr++;
+        }
+        else
+        {
+          backoff = OPENEVSE_PROBE_BACKOFF_MAX;
+        }
+        evse->pollNumber = 0;
+        osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, OPENEVSE_PROBE_TIMEOUT + backoff );
+        return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+      }
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETSETTINGS, 0);
+      if (evse->energyLimit != 0)
+      {
+        zclOpenEvse_LimitWrite(evse, evse->energyLimit, NULL, 0); // Restore the saved limit
+      }
+      evse->pollNumber = 10; // Go to main loop state
+      break;
+      
+    case 10:// State 10-19 main loop
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETPOWER, 0);
+      break;
+    case 11:
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETTEMP, 0);
+#if defined OPENEVSE_SLEEPY
+      evse->pollNumber = 13;
+      break;
+    case 13: // A $ST the EVSE sent while the module slept is lost, ask for the state
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETSTATE, 0);
+      evse->pollNumber = 12;
+#endif
+      break;
+    case 12:
+      zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_GETENERGY, 0);
+      if (zclOpenEvse_resyncPeriod != 0 &&
+          osal_GetSystemClock() - evse->resyncLast >= (uint32)zclOpenEvse_resyncPeriod * 1000)
+      {
+        evse->resyncLast = osal_GetSystemClock();
+#if defined OPENEVSE_SLEEPY
+        evse->resync = 1; // Every poll has a $GS already
+#else
+        evse->resync = 2;
+#endif
+      }
+      if (zclOpenEvse_NwkState != OPENEVSE_NWK_JOINED)
+      {
+        if (!evse->firstTime)
+        {
+          zclOpenEvse_SyncDelay(evse); // Re-sync after rejoin at a random phase
+        }
+        evse->firstTime = TRUE;
+      }
+      else if (evse->firstTime) // Count the phase delay from the join, so a fleet doesn't report in step
+      {
+        if (evse->syncDelay == 0)
+        {
+          evse->pollNumber = 20; // Go to network init state
+          break;
+        }
+        evse->syncDelay--;
+      }
+      evse->pollNumber = 10;
+      break;
+
+    case 20: // State 20-29 network connected, initial reports
+      if (zclOpenEvse_NwkState != OPENEVSE_NWK_JOINED)
+      {
+        evse->pollNumber = 10; // Return to main loop state
+        break;
+      }
+      zclOpenEvse_sendEnergy(evse);
+      break;
+    case 21:
+      evse->lastVolts = evse->voltsScaled;
+      evse->lastAmps = evse->ampsScaled;
+      evse->lastWatts = evse->wattsScaled;
+      zclOpenEvse_sendPower(evse);
+      break;
+    case 22:
+      zclOpenEvse_sendTemp(evse);
+      break;
+    case 23:
+      zclOpenEvse_sendState(evse);
+      zclOpenEvse_sendLevel(evse);
+      evse->firstTime = FALSE;
+      // Network is configured so start report timers, each at its own random phase
+      osal_start_timerEx( evse->taskId, OPENEVSE_GETPOWER_MIN_EVT, zclOpenEvse_reportPowerMin );
+      osal_start_timerEx( evse->taskId, OPENEVSE_GETPOWER_MAX_EVT,
+                          zclOpenEvse_reportPowerMax + zclOpenEvse_Jitter(zclOpenEvse_reportJitter) );
+      osal_start_timerEx( evse->taskId, OPENEVSE_GETTEMP_MAX_EVT,
+                          zclOpenEvse_reportTempMax + zclOpenEvse_Jitter(zclOpenEvse_reportJitter) );
+      osal_start_timerEx( evse->taskId, OPENEVSE_GETENERGY_MAX_EVT,
+                          zclOpenEvse_reportEnergyMax + zclOpenEvse_Jitter(zclOpenEvse_reportJitter) );
+      evse->pollNumber = 10;
+      break;
+    }
+    
+    osal_start_timerEx( evse->taskId, OPENEVSE_POLL_EVSE_EVT, POLL_EVSE_PERIOD );
+    return ( events ^ OPENEVSE_POLL_EVSE_EVT );
+  }
+  if (events & OPENEVSE_BACKLIGHT_OFF_EVT)
+  {
+    if (evse->cmd != EVSE_CMD_NONE)
+    {
+      return events; // If last command not complete, postpone this
+    }
+ 
+    zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_LCDOFF, 0);
+
+    return ( events ^ OPENEVSE_BACKLIGHT_OFF_EVT );
+  }
+  if ( events & OPENEVSE_GETPOWER_MIN_EVT)
+  {
+    if ( (abs(evse->lastVolts - evse->voltsScaled) > zclOpenEvse_reportPowerChangedVolts) ||
+         (abs(evse->lastAmps - evse->ampsScaled) > zclOpenEvse_reportPowerChangedAmps) ||
+         (abs(evse->lastWatts - evse->wattsScaled) > zclOpenEvse_reportPowerChangedWatts) )
+    {
+      evse->lastVolts = evse->voltsScaled;
+      evse->lastAmps = evse->ampsScaled;
+      evse->lastWatts = evse->wattsScaled;
+
+      zclOpenEvse_sendPower(evse);
+    }      
+    osal_start_timerEx( evse->taskId, OPENEVSE_GETPOWER_MIN_EVT,
+                        zclOpenEvse_reportPowerMin << zclOpenEvse_reportStretch );
+    return ( events ^ OPENEVSE_GETPOWER_MIN_EVT );
+  }
+  if ( events & OPENEVSE_GETPOWER_MAX_EVT)
+  {
+    zclOpenEvse_sendPower(evse); // This restarts the timer
+    return ( events ^ OPENEVSE_GETPOWER_MAX_EVT );
+  }
+
+  if ( events & OPENEVSE_GETTEMP_MAX_EVT)
+  {
+    zclOpenEvse_sendTemp(evse); // This restarts the timer
+    return ( events ^ OPENEVSE_GETTEMP_MAX_EVT );
+  }
+
+  if ( events & OPENEVSE_GETENERGY_MAX_EVT)
+  {
+    zclOpenEvse_sendEnergy(evse);
+    osal_start_timerEx( evse->taskId, OPENEVSE_GETENERGY_MAX_EVT, zclOpenEvse_reportEnergyMax );
+    return ( events ^ OPENEVSE_GETENERGY_MAX_EVT );
+  }
+
+  // Discard unknown events
+  return 0;
+}
+
+
+/*********************************************************************
+ * @fn      zclOpenEvse_BasicResetCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library
+ *          to set all the Basic Cluster attributes to default values.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvse_BasicResetCB( void )
+{
+  NLME_LeaveReq_t leaveReq;
+  // Set every field to 0
+  osal_memset( &leaveReq, 0, sizeof( NLME_LeaveReq_t ) );
+
+  // This will enable the device to rejoin the network after reset.
+  leaveReq.rejoin = TRUE;
+
+  // Set the NV startup option to force a "new" join.
+  zgWriteStartupOptions( ZG_STARTUP_SET, ZCD_STARTOPT_DEFAULT_NETWORK_STATE );
+
+  // Leave the network, and reset afterwards
+  if ( NLME_LeaveReq( &leaveReq ) != ZSuccess )
+  {
+    // Couldn't send out leave; prepare to reset anyway
+    ZDApp_LeaveReset( FALSE );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_OnOffCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when
+ *          it received an On/Off Command for this application.
+ *
+ * @param   cmd - COMMAND_ON, COMMAND_OFF or COMMAND_TOGGLE
+ *
+ * @return  none
+ */
+static void zclOpenEvse_OnOffCB( uint8 cmd )
+{
+  afIncomingMSGPacket_t *pPtr = zcl_getRawAFMsg();
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( pPtr->endPoint );
+
+#if defined OPENEVSE_SLEEPY
+  zclOpenEvse_FastPoll( OPENEVSE_COMMAND_FAST_POLL ); // The backlight's don't pass the task
+#endif
+  if (pPtr->endPoint == evse->endpoint)
+  {
+    // Turning on from a group waits its turn
+    if ( zclOpenEvse_GroupRestore( evse, cmd != COMMAND_OFF && evse->OnOff == LIGHT_OFF ) )
+    {
+      evse->restoreOn = TRUE;
+      return;
+    }
+    evse->restoreOn = FALSE;
+
+    // Turn on the power
+    if ( cmd == COMMAND_ON )
+    {
+      evse->OnOff = LIGHT_ON;
+    }
+    // Turn off the power
+    else if ( cmd == COMMAND_OFF )
+    {
+      evse->OnOff = LIGHT_OFF;
+    }
+    // Toggle the power
+    else if ( cmd == COMMAND_TOGGLE )
+    {
+      if ( evse->OnOff == LIGHT_OFF )
+      {
+        evse->OnOff = LIGHT_ON;
+      }
+      else
+      {
+        evse->OnOff = LIGHT_OFF;
+      }
+    }
+  }
+  else
+  {
+    // Turn on the backlight
+    if ( cmd == COMMAND_ON )
+    {
+      evse->backlight = LIGHT_ON;
+    }
+    // Turn off the backlight
+    else if ( cmd == COMMAND_OFF )
+    {
+      evse->backlight = LIGHT_OFF;
+    }
+    // Toggle the backlight
+    else if ( cmd == COMMAND_TOGGLE )
+    {
+      if ( evse->backlight == LIGHT_OFF )
+      {
+        evse->backlight = LIGHT_ON;
+      }
+      else
+      {
+        evse->backlight = LIGHT_OFF;
+      }
+    }
+    
+    // save to NVRAM
+    zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_BL_NV), 0, sizeof(evse->backlight), &evse->backlight );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_GroupRestore
+ *
+ * @brief   Whether a command has to wait before it is applied. When a
+ *          site is shed with one command to a group or a broadcast, the
+ *          command that brings it back reaches every charger at once; each one waits
+ *          a random time up to zclOpenEvse_restoreJitter before drawing
+ *          more current, so the site doesn't come back in one step.
+ *          Commands that lower the load, and any sent to the charger
+ *          alone, don't wait.
+ *
+ * @param   evse - charger the command is for
+ * @param   raise - the command turns the charger on or raises its current
+ *
+ * @return  TRUE when the caller should keep the command for
+ *          OPENEVSE_RESTORE_EVT rather than apply it
+ */
+static uint8 zclOpenEvse_GroupRestore( zclOpenEvse_evse_t *evse, uint8 raise )
+{
+  afIncomingMSGPacket_t *pkt = zcl_getRawAFMsg();
+
+  if ( !raise || (pkt->groupId == 0 && !pkt->wasBroadcast) || zclOpenEvse_restoreJitter == 0 )
+  {
+    return FALSE;
+  }
+  // A second restore in the same wait, like On and then Move to Level,
+  // goes out with the first
+  if ( osal_get_timeoutEx( evse->taskId, OPENEVSE_RESTORE_EVT ) == 0 )
+  {
+    osal_start_timerEx( evse->taskId, OPENEVSE_RESTORE_EVT,
+                        1 + zclOpenEvse_Jitter(zclOpenEvse_restoreJitter) );
+  }
+  return TRUE;
+}
+
+#ifdef ZCL_LEVEL_CTRL
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelMoveToLevelCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when it
+ *          received a Move to Level command. The level is the pilot
+ *          current in amps, ramped over the transition time. The
+ *          with On/Off form also enables the charger, or at level 0
+ *          puts it to sleep and leaves the current where it is.
+ *
+ * @param   pCmd - level and transition time in tenths of a second
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelMoveToLevelCB( zclLCMoveToLevel_t *pCmd )
+{
+  afIncomingMSGPacket_t *pPtr = zcl_getRawAFMsg();
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( pPtr->endPoint );
+
+  if ( pPtr->endPoint != evse->endpoint )
+  {
+    return; // The backlight has no level
+  }
+  if ( pCmd->withOnOff && pCmd->level == 0 )
+  {
+    evse->OnOff = LIGHT_OFF;
+    evse->restoreOn = FALSE;
+    evse->restoreLevel = 0;
+    zclOpenEvse_LevelStop( evse );
+    return;
+  }
+  zclOpenEvse_LevelCommand( evse, pCmd->level, pCmd->transitionTime, pCmd->withOnOff );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelMoveCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when it
+ *          received a Move command: ramp towards the highest or lowest
+ *          current at the given amps per second.
+ *
+ * @param   pCmd - direction and rate, 0xFF for as fast as it goes
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelMoveCB( zclLCMove_t *pCmd )
+{
+  afIncomingMSGPacket_t *pPtr = zcl_getRawAFMsg();
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( pPtr->endPoint );
+  uint8 level = ( pCmd->moveMode == LEVEL_MOVE_UP ) ? OPENEVSE_AMPS_MAX : OPENEVSE_AMPS_MIN;
+  uint8 from = evse->setAmps ? evse->setAmps : evse->wantAmps;
+  uint16 transitionTime = 0;
+
+  if ( pPtr->endPoint != evse->endpoint )
+  {
+    return;
+  }
+  if ( pCmd->rate != 0 && pCmd->rate != 0xFF )
+  {
+    transitionTime = (uint16)(( level > from ? level - from : from - level ) * 10 / pCmd->rate);
+  }
+  zclOpenEvse_LevelCommand( evse, level, transitionTime,
+                            pCmd->withOnOff && pCmd->moveMode == LEVEL_MOVE_UP );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelStepCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when it
+ *          received a Step command: up or down by some amps.
+ *
+ * @param   pCmd - direction, amps and transition time
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelStepCB( zclLCStep_t *pCmd )
+{
+  afIncomingMSGPacket_t *pPtr = zcl_getRawAFMsg();
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( pPtr->endPoint );
+  int16 level = evse->setAmps ? evse->setAmps : evse->wantAmps;
+
+  if ( pPtr->endPoint != evse->endpoint )
+  {
+    return;
+  }
+  level += ( pCmd->stepMode == LEVEL_STEP_UP ) ? pCmd->amount : -(int16)pCmd->amount;
+  zclOpenEvse_LevelCommand( evse, (uint8)( level < 0 ? 0 : level > 0xFF ? 0xFF : level ),
+                            pCmd->transitionTime, pCmd->withOnOff && pCmd->stepMode == LEVEL_STEP_UP );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelStopCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when it
+ *          received a Stop command: hold the current the ramp is at.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelStopCB( void )
+{
+  afIncomingMSGPacket_t *pPtr = zcl_getRawAFMsg();
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( pPtr->endPoint );
+
+  if ( pPtr->endPoint == evse->endpoint )
+  {
+    evse->restoreLevel = 0;
+    zclOpenEvse_LevelStop( evse );
+  }
+}
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelCommand
+ *
+ * @brief   Apply a Level Control command, or keep it for the end of
+ *          the restore wait when it came to a group and raises the
+ *          current or turns the charger on.
+ *
+ * @param   evse - charger the command is for
+ * @param   level - pilot current in amps
+ * @param   transitionTime - tenths of a second, 0xFFFF for at once
+ * @param   turnOn - the with On/Off form going up
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelCommand( zclOpenEvse_evse_t *evse, uint8 level, uint16 transitionTime,
+                                      uint8 turnOn )
+{
+  uint8 from = evse->setAmps ? evse->setAmps : evse->wantAmps;
+
+#if defined OPENEVSE_SLEEPY
+  zclOpenEvse_FastPoll( OPENEVSE_COMMAND_FAST_POLL );
+#endif
+  if ( zclOpenEvse_GroupRestore( evse, level > from || ( turnOn && evse->OnOff == LIGHT_OFF ) ) )
+  {
+    evse->restoreOn |= turnOn;
+    evse->restoreLevel = level;
+    evse->restoreTime = transitionTime;
+    return;
+  }
+  evse->restoreLevel = 0;
+  if ( turnOn )
+  {
+    evse->restoreOn = FALSE;
+    evse->OnOff = LIGHT_ON;
+  }
+  zclOpenEvse_LevelRamp( evse, level, transitionTime );
+}
+#endif // ZCL_LEVEL_CTRL
+
+/*********************************************************************
+ * @fn      zclOpenEvse_Thermal
+ *
+ * @brief   Thermal throttling, run on each temperature reading. The
+ *          step goes up as soon as the hottest sensor is into its band
+ *          and comes down one band at a time with hysteresis and no
+ *          faster than OPENEVSE_THERMAL_HOLD, so the current doesn't
+ *          hunt around a threshold. Only a change of
+ *          step sends $SC and a report. With no sensor to go by the
+ *          step in force is kept.
+ *
+ * @param   evse - charger whose $GP just came back
+ *
+ * @return  none
+ */
+static void zclOpenEvse_Thermal( zclOpenEvse_evse_t *evse )
+{
+  uint8 step = evse->thermalStep;
+  int16 over = evse->tempMax - zclOpenEvse_thermalStart;
+
+  if ( zclOpenEvse_thermalAmps == 0 || zclOpenEvse_thermalBand == 0 )
+  {
+    step = 0;
+  }
+  else if ( evse->tempMax == OPENEVSE_TEMP_INVALID )
+  {
+    return;
+  }
+  else if ( over >= 0 && over / zclOpenEvse_thermalBand >= step )
+  {
+    step = ( over / zclOpenEvse_thermalBand < 0xFF ) ? (uint8)( over / zclOpenEvse_thermalBand + 1 ) : 0xFF;
+  }
+  else if ( step > 0 &&
+            over + (int16)zclOpenEvse_thermalHysteresis < (int16)( (step - 1) * zclOpenEvse_thermalBand ) &&
+            osal_GetSystemClock() - evse->thermalSince >= OPENEVSE_THERMAL_HOLD )
+  {
+    step--;
+  }
+  if ( step == evse->thermalStep )
+  {
+    return;
+  }
+  evse->thermalStep = step;
+  evse->thermalSince = osal_GetSystemClock();
+  zclOpenEvse_ThermalSave( evse );
+  zclOpenEvse_sendThermal( evse );
+
+  // Put the current through the new cut, unless a newer one is on its way
+  if ( evse->setAmps == 0 && evse->wantAmps != 0 &&
+       zclOpenEvse_ThermalCap( evse, evse->wantAmps ) != evse->pilotAmps )
+  {
+    evse->setAmps = evse->wantAmps;
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ThermalCap
+ *
+ * @brief   Pilot current for a wanted current under the thermal step
+ *          in force, no lower than the EVSE takes.
+ *
+ * @param   evse - charger
+ * @param   amps - current asked for
+ *
+ * @return  current to send with $SC
+ */
+static uint8 zclOpenEvse_ThermalCap( zclOpenEvse_evse_t *evse, uint8 amps )
+{
+  uint16 cut = (uint16)evse->thermalStep * zclOpenEvse_thermalAmps;
+
+  if ( amps >= OPENEVSE_AMPS_MIN + cut )
+  {
+    return amps - (uint8)cut;
+  }
+  return ( amps < OPENEVSE_AMPS_MIN ) ? amps : OPENEVSE_AMPS_MIN;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ThermalSave
+ *
+ * @brief   Write the thermal step and the current asked for under it
+ *          to NV when either has changed, so a restart while throttled
+ *          neither takes the cut current from $GE as the one asked for
+ *          nor loses the step.
+ *
+ * @param   evse - charger
+ *
+ * @return  none
+ */
+static void zclOpenEvse_ThermalSave( zclOpenEvse_evse_t *evse )
+{
+  uint8 want = ( evse->thermalStep != 0 ) ? evse->wantAmps : 0;
+
+  if ( evse->thermalSaved.step != evse->thermalStep || evse->thermalSaved.wantAmps != want )
+  {
+    evse->thermalSaved.step = evse->thermalStep;
+    evse->thermalSaved.wantAmps = want;
+    zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_THERMAL_NV), 0, sizeof(evse->thermalSaved), &evse->thermalSaved );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_Settings
+ *
+ * @brief   Take the service level and pilot current from a $GE. The
+ *          first one, at start-up, sets them up and starts the schedule;
+ *          under a thermal step kept from before a restart the current
+ *          asked for is the one kept, and the cut goes out again if the
+ *          EVSE has lost it.
+ *          A later one only acts on what was changed at the EVSE: a new
+ *          level puts in its voltage if there is no voltmeter and
+ *          reports the power, and a new current is reported as the
+ *          Level Control level. Under a thermal step, a current that
+ *          isn't the cut puts the cut back, as the EVSE doesn't save it
+ *          and drops it when it restarts. A current that differs while
+ *          a $SC or a ramp of ours is on its way is ours, not yet sent.
+ *
+ * @param   evse - charger
+ * @param   level - 1 or 2
+ * @param   amps - pilot current the EVSE has
+ *
+ * @return  none
+ */
+static void zclOpenEvse_Settings( zclOpenEvse_evse_t *evse, uint8 level, uint8 amps )
+{
+  if ( evse->powerLevel == 0 )
+  {
+    evse->powerLevel = level;
+    evse->pilotAmps = amps;
+    if ( evse->thermalStep == 0 || evse->wantAmps == 0 )
+    {
+      evse->wantAmps = amps; // While throttled it is the cut current
+    }
+    else if ( zclOpenEvse_ThermalCap( evse, evse->wantAmps ) != amps )
+    {
+      evse->setAmps = evse->wantAmps; // The EVSE restarted and lost the cut
+    }
+    osal_set_event( evse->taskId, OPENEVSE_TOU_EVT ); // Schedule can start now
+    return;
+  }
+
+  if ( level != evse->powerLevel )
+  {
+    evse->resyncChanges++;
+    evse->powerLevel = level;
+    if ( evse->noVoltmeter )
+    {
+      evse->voltsScaled = ( level == 2 ) ? OPENEVSE_L2_VOLTS : OPENEVSE_L1_VOLTS;
+      evse->wattsScaled = (int16) ((float)evse->voltsScaled * (float)evse->ampsScaled * 0.001);
+      evse->lastVolts = evse->voltsScaled;
+      evse->lastAmps = evse->ampsScaled;
+      evse->lastWatts = evse->wattsScaled;
+      zclOpenEvse_sendPower( evse );
+    }
+  }
+
+  if ( amps != evse->pilotAmps && evse->setAmps == 0 && evse->levelSteps == 0 )
+  {
+    evse->resyncChanges++;
+    evse->pilotAmps = amps;
+    if ( evse->thermalStep == 0 )
+    {
+      evse->wantAmps = amps; // While throttled it is the cut current
+    }
+    else if ( zclOpenEvse_ThermalCap( evse, evse->wantAmps ) != amps )
+    {
+      evse->setAmps = evse->wantAmps; // The EVSE restarted and lost the cut
+    }
+    zclOpenEvse_sendLevel( evse );
+    zclOpenEvse_Alerts( evse );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_Energy
+ *
+ * @brief   Add what the EVSE's energy count has gone up by to the total.
+ *          A count lower than the last is a wrap if it is a small step
+ *          on, modulo 2^32, and otherwise the count starting again from
+ *          0, once the next reading agrees; a single bad reading is
+ *          left out. The total goes to NV every OPENEVSE_ENERGY_NV_STEP
+ *          and at a reset, so a module restart loses none of it and an
+ *          EVSE reset while the module was off loses less than a step.
+ *
+ * @param   evse - charger
+ * @param   acc - EVSE's count from $GU, Wh
+ *
+ * @return  none
+ */
+static void zclOpenEvse_Energy( zclOpenEvse_evse_t *evse, uint32 acc )
+{
+  uint32 step = acc - evse->energy.evseAcc; // Right across a wrap
+  uint8 save = FALSE;
+
+  if ( acc < evse->energy.evseAcc )
+  {
+    if ( step >= OPENEVSE_ENERGY_WRAP_MAX )
+    {
+      if ( !evse->energyDrop )
+      {
+        evse->energyDrop = TRUE;
+        return;
+      }
+      step = acc; // Counted up from 0 since the reset
+    }
+    evse->energyResets++;
+    save = TRUE;
+  }
+  evse->energyDrop = FALSE;
+  evse->energy.evseAcc = acc;
+
+  if ( evse->energy.totalLo + step < evse->energy.totalLo )
+  {
+    evse->energy.totalHi++;
+  }
+  evse->energy.totalLo += step;
+  zclOpenEvse_EnergySum( evse );
+
+  if ( save || evse->energy.totalLo - evse->energySaved >= OPENEVSE_ENERGY_NV_STEP )
+  {
+    evse->energySaved = evse->energy.totalLo;
+    zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_ENERGY_NV), 0, sizeof(evse->energy), &evse->energy );
+  }
+}
+
+// Put the energy total in the CurrentSummationDelivered attribute, little endian as sent
+static void zclOpenEvse_EnergySum( zclOpenEvse_evse_t *evse )
+{
+  evse->energySum[0] = BREAK_UINT32( evse->energy.totalLo, 0 );
+  evse->energySum[1] = BREAK_UINT32( evse->energy.totalLo, 1 );
+  evse->energySum[2] = BREAK_UINT32( evse->energy.totalLo, 2 );
+  evse->energySum[3] = BREAK_UINT32( evse->energy.totalLo, 3 );
+  evse->energySum[4] = LO_UINT16( evse->energy.totalHi );
+  evse->energySum[5] = HI_UINT16( evse->energy.totalHi );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_Alerts
+ *
+ * @brief   Look at the alert conditions after a new state, power or
+ *          temperature reading, and on the poll tick while one is
+ *          waiting out its time in zclOpenEvse_alertTable. A condition
+ *          that comes and goes within its time, like a single bad
+ *          temperature sample, never gets to the hub. Raised and
+ *          cleared alerts go out together in an Alerts Notification.
+ *
+ * @param   evse - charger
+ *
+ * @return  none
+ */
+static void zclOpenEvse_Alerts( zclOpenEvse_evse_t *evse )
+{
+  uint16 now = (uint16)osal_GetSystemClock();
+  uint16 raw = 0;
+  uint16 flipped = 0;
+  uint16 bit;
+  uint8 i;
+
+  if ( evse->state >= OPENEVSE_ALERT_STATE_FIRST &&
+       evse->state < OPENEVSE_ALERT_STATE_FIRST + OPENEVSE_ALERT_STATES )
+  {
+    raw |= BV( evse->state - OPENEVSE_ALERT_STATE_FIRST );
+  }
+  if ( zclOpenEvse_alertTemp != 0 )
+  {
+    if ( evse->tempMax == OPENEVSE_TEMP_INVALID )
+    {
+      raw |= evse->alertRaw & BV( OPENEVSE_ALERT_HOT ); // No sensor to go by
+    }
+    else if ( evse->tempMax >= zclOpenEvse_alertTemp ||
+              ( (evse->alertRaw & BV( OPENEVSE_ALERT_HOT )) &&
+                evse->tempMax > zclOpenEvse_alertTemp - OPENEVSE_ALERT_TEMP_HYSTERESIS ) )
+    {
+      raw |= BV( OPENEVSE_ALERT_HOT );
+    }
+  }
+  if ( zclOpenEvse_alertAmps != 0 && evse->pilotAmps != 0 && evse->state == 0x03 &&
+       evse->ampsScaled > (uint16)( evse->pilotAmps + zclOpenEvse_alertAmps ) * 10 )
+  {
+    raw |= BV( OPENEVSE_ALERT_OVERDRAW );
+  }
+
+  for ( i = 0; i < OPENEVSE_ALERTS; i++ )
+  {
+    bit = BV( i );
+    if ( (raw ^ evse->alertRaw) & bit )
+    {
+      evse->alertSince[i] = now;
+    }
+    if ( ((raw ^ evse->alerts) & bit) &&
+         (uint16)( now - evse->alertSince[i] ) >= ( (raw & bit) ? zclOpenEvse_alertTable[i].raiseMs
+                                                                : zclOpenEvse_alertTable[i].clearMs ) )
+    {
+      flipped |= bit;
+    }
+  }
+  evse->alertRaw = raw;
+  if ( flipped == 0 )
+  {
+    return;
+  }
+
+  evse->alerts ^= flipped;
+  evse->alertsCleared = (evse->alertsCleared | (flipped & ~evse->alerts)) & ~evse->alerts;
+  zclOpenEvse_ReportRequest( evse, REPORT_ALERT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_AlertList
+ *
+ * @brief   Write the alert count and an alert structure for each alert
+ *          in force, then one for each alert in a set of cleared ones.
+ *
+ * @param   evse - charger
+ * @param   cleared - alerts to list as recovered
+ * @param   buf - room for 1 + 3 * OPENEVSE_ALERTS bytes
+ *
+ * @return  bytes written
+ */
+static uint8 zclOpenEvse_AlertList( zclOpenEvse_evse_t *evse, uint16 cleared, uint8 *buf )
+{
+  uint8 len = 1;
+  uint8 i;
+
+  for ( i = 0; i < OPENEVSE_ALERTS; i++ )
+  {
+    if ( (evse->alerts | cleared) & BV( i ) )
+    {
+      buf[len++] = zclOpenEvse_alertTable[i].id;
+      buf[len++] = zclOpenEvse_alertTable[i].category |
+                   ( (evse->alerts & BV( i )) ? 0 : OPENEVSE_ALERT_RECOVERY );
+      buf[len++] = 0;
+    }
+  }
+  buf[0] = (len - 1) / 3; // Unstructured alerts, count in the low nibble
+  return len;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_Event
+ *
+ * @brief   Queue an Event Notification. One not yet sent is replaced.
+ *
+ * @param   evse - charger
+ * @param   eventId - OPENEVSE_EVENT_...
+ *
+ * @return  none
+ */
+static void zclOpenEvse_Event( zclOpenEvse_evse_t *evse, uint8 eventId )
+{
+  evse->event = eventId;
+  zclOpenEvse_ReportRequest( evse, REPORT_EVENT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelRamp
+ *
+ * @brief   Start a ramp of the pilot current from where it is to a new
+ *          level. A transition is cut into steps of at least a second
+ *          and at least an amp, so a site shedding load together comes
+ *          down in a slope rather than all at once. The pilot isn't
+ *          known before the EVSE has answered $GE; the level then goes
+ *          out in one step.
+ *
+ * @param   evse - charger
+ * @param   level - amps, held to what the EVSE takes
+ * @param   transitionTime - tenths of a second, 0 or 0xFFFF for at once
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelRamp( zclOpenEvse_evse_t *evse, uint8 level, uint16 transitionTime )
+{
+  uint8 from = evse->setAmps ? evse->setAmps : evse->wantAmps;
+  uint8 diff;
+  uint16 steps;
+
+  zclOpenEvse_LevelStop( evse );
+  if ( level < OPENEVSE_AMPS_MIN )
+  {
+    level = OPENEVSE_AMPS_MIN;
+  }
+  else if ( level > OPENEVSE_AMPS_MAX )
+  {
+    level = OPENEVSE_AMPS_MAX;
+  }
+  if ( from == 0 )
+  {
+    evse->setAmps = level;
+    return;
+  }
+  diff = ( level > from ) ? level - from : from - level;
+  if ( diff == 0 )
+  {
+    return;
+  }
+  if ( transitionTime == 0xFFFF )
+  {
+    transitionTime = 0;
+  }
+
+  steps = transitionTime / (OPENEVSE_LEVEL_STEP_MS / 100);
+  if ( steps > diff )
+  {
+    steps = diff;
+  }
+  else if ( steps == 0 )
+  {
+    steps = 1;
+  }
+  evse->levelFrom = from;
+  evse->levelTarget = level;
+  evse->levelSteps = (uint8)steps;
+  evse->levelStep = 0;
+  evse->levelStepMs = (uint32)transitionTime * 100 / steps;
+  evse->levelRemaining = transitionTime;
+  if ( evse->levelStepMs == 0 )
+  {
+    osal_set_event( evse->taskId, OPENEVSE_LEVEL_EVT );
+  }
+  else
+  {
+    osal_start_timerEx( evse->taskId, OPENEVSE_LEVEL_EVT, evse->levelStepMs );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LevelStop
+ *
+ * @brief   End a ramp where it is.
+ *
+ * @param   evse - charger
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LevelStop( zclOpenEvse_evse_t *evse )
+{
+  evse->levelSteps = 0;
+  evse->levelRemaining = 0;
+  osal_stop_timerEx( evse->taskId, OPENEVSE_LEVEL_EVT );
+}
+
+void zclOpenEvse_Identify(zclOpenEvse_evse_t *evse)
+{
+  evse->IdentifyTime = 5;
+  osal_start_timerEx( evse->taskId, OPENEVSE_IDENTIFY_EVT, OPENEVSE_IDENTIFY_PHASE );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_IdentifyCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when an
+ *          Identify command is received. An IdentifyTime of 0 ends
+ *          identify mode once the current blink is over.
+ *
+ * @param   pCmd - identify command
+ *
+ * @return  none
+ */
+static void zclOpenEvse_IdentifyCB( zclIdentify_t *pCmd )
+{
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( zcl_getRawAFMsg()->endPoint );
+
+  evse->IdentifyTime = pCmd->identifyTime;
+  osal_set_event( evse->taskId, OPENEVSE_IDENTIFY_EVT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_IdentifyTriggerEffectCB
+ *
+ * @brief   Callback from the ZCL General Cluster Library when an
+ *          Identify Trigger Effect command is received. Effects are
+ *          drawn with the LCD backlight in half-second phases and take
+ *          over from identify mode while they run.
+ *
+ * @param   pCmd - trigger effect command
+ *
+ * @return  none
+ */
+static void zclOpenEvse_IdentifyTriggerEffectCB( zclIdentifyTriggerEffect_t *pCmd )
+{
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( zcl_getRawAFMsg()->endPoint );
+
+  switch (pCmd->effectId)
+  {
+  case EFFECT_ID_BLINK:
+    evse->identColor = EVSE_CMD_LCDTEAL;
+    evse->identPhases = 2;
+    break;
+  case EFFECT_ID_BREATHE:
+    evse->identColor = EVSE_CMD_LCDTEAL;
+    evse->identPhases = 30; // 15 one-second cycles
+    break;
+  case EFFECT_ID_OKAY:
+    evse->identColor = EVSE_CMD_LCDGREEN;
+    evse->identPhases = 4;
+    break;
+  case EFFECT_ID_CHANNEL_CHANGE:
+    evse->identColor = EVSE_CMD_LCDTEAL;
+    evse->identPhases = 16;
+    break;
+  case EFFECT_ID_FINISH_EFFECT:
+    evse->identPhases &= 1; // Finish the lit phase, if that's where it is
+    return;
+  case EFFECT_ID_STOP_EFFECT:
+    evse->identPhases = 0;
+    break;
+  default:
+    return;
+  }
+  osal_set_event( evse->taskId, OPENEVSE_IDENTIFY_EVT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ReadWriteCB
+ *
+ * @brief   Read/write callback for attributes without a data pointer.
+ *          For CurrentDemandLimit, reads return the limit the EVSE
+ *          last accepted. Writes reaching here (Write Undivided, Write
+ *          No Response, or a plain write that could not be deferred) are
+ *          queued to the EVSE and acknowledged straight away.
+ *
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute ID
+ * @param   oper - ZCL_OPER_LEN, ZCL_OPER_READ or ZCL_OPER_WRITE
+ * @param   pValue - attribute data, little endian
+ * @param   pLen - length of the attribute data
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_ReadWriteCB( uint16 clusterId, uint16 attrId, uint8 oper,
+                                          uint8 *pValue, uint16 *pLen )
+{
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByEndpoint( zcl_getRawAFMsg()->endPoint );
+
+  if ( clusterId == ZCL_CLUSTER_ID_GEN_TIME )
+  {
+    return zclOpenEvse_TimeReadWrite( attrId, oper, pValue, pLen );
+  }
+#if defined OPENEVSE_SLEEPY
+  if ( clusterId == ZCL_CLUSTER_ID_GEN_POLL_CONTROL )
+  {
+    return zclOpenEvse_PollControlReadWrite( attrId, oper, pValue, pLen );
+  }
+#endif
+  if ( clusterId == ZCL_CLUSTER_ID_OPENEVSE_STATS )
+  {
+    if ( attrId == ATTRID_OPENEVSE_TOU_SCHEDULE )
+    {
+      return zclOpenEvse_TouReadWrite( evse, oper, pValue, pLen );
+    }
+    if ( attrId == ATTRID_OPENEVSE_CMD_RESENDS || attrId == ATTRID_OPENEVSE_CMD_GIVEN_UP )
+    {
+      return zclOpenEvse_CmdStatsRead( evse, attrId, oper, pValue, pLen );
+    }
+#if OPENEVSE_TRACE_ENTRIES
+    if ( attrId == ATTRID_OPENEVSE_TRACE_CHUNK )
+    {
+      return zclOpenEvse_TraceRead( oper, pValue, pLen );
+    }
+#endif
+#if defined OPENEVSE_PROFILE
+    return zclOpenEvse_ProfileRead( attrId, oper, pValue, pLen );
+#endif
+  }
+  if ( clusterId != ZCL_CLUSTER_ID_SE_METERING || attrId != ATTRID_CURRENT_DEMAND_LIMIT )
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+
+  switch ( oper )
+  {
+    case ZCL_OPER_LEN:
+      *pLen = 3;
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_OPER_READ:
+      pValue[0] = BREAK_UINT32( evse->energyLimit, 0 );
+      pValue[1] = BREAK_UINT32( evse->energyLimit, 1 );
+      pValue[2] = BREAK_UINT32( evse->energyLimit, 2 );
+      if ( pLen != NULL )
+      {
+        *pLen = 3;
+      }
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_OPER_WRITE:
+      return zclOpenEvse_LimitWrite( evse, BUILD_UINT32( pValue[0], pValue[1], pValue[2], 0 ), NULL, 0 );
+  }
+  return ZCL_STATUS_FAILURE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_TimeReadWrite
+ *
+ * @brief   Serve the Time and LocalTime attributes from the OSAL clock.
+ *          Writing Time sets the clock; the EVSE's RTC then only keeps
+ *          it from drifting.
+ *
+ * @param   attrId - ATTRID_TIME_TIME or ATTRID_TIME_LOCAL_TIME
+ * @param   oper - ZCL_OPER_LEN, ZCL_OPER_READ or ZCL_OPER_WRITE
+ * @param   pValue - attribute data, little endian
+ * @param   pLen - length of the attribute data
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_TimeReadWrite( uint16 attrId, uint8 oper, uint8 *pValue, uint16 *pLen )
+{
+  UTCTime value;
+  uint8 i;
+
+  if ( attrId != ATTRID_TIME_TIME && attrId != ATTRID_TIME_LOCAL_TIME )
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+
+  switch ( oper )
+  {
+    case ZCL_OPER_LEN:
+      *pLen = 4;
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_OPER_READ:
+      value = ( attrId == ATTRID_TIME_TIME ) ? osal_getClock() : zclOpenEvse_LocalTime();
+      pValue[0] = BREAK_UINT32( value, 0 );
+      pValue[1] = BREAK_UINT32( value, 1 );
+      pValue[2] = BREAK_UINT32( value, 2 );
+      pValue[3] = BREAK_UINT32( value, 3 );
+      if ( pLen != NULL )
+      {
+        *pLen = 4;
+      }
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_OPER_WRITE:
+      if ( attrId != ATTRID_TIME_TIME )
+      {
+        return ZCL_STATUS_READ_ONLY;
+      }
+      for ( i = 0; i < zclOpenEvse_numEvse; i++ )
+      {
+        zclOpenEvse_evse[i].rtcOffsetSet = FALSE; // Take the RTC's offset again, from the new time
+        zclOpenEvse_evse[i].touRtc = TRUE;
+      }
+      zclOpenEvse_TimeSet( BUILD_UINT32( pValue[0], pValue[1], pValue[2], pValue[3] ), OPENEVSE_TIME_ZCL );
+      return ZCL_STATUS_SUCCESS;
+  }
+  return ZCL_STATUS_FAILURE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_TouReadWrite
+ *
+ * @brief   Serve a charger's schedule as an octet string of 6 byte
+ *          windows: days, start and stop minute, amps. A write replaces
+ *          the whole schedule, is kept in NV and takes effect at once;
+ *          an empty string turns the schedule off.
+ *
+ * @param   evse - charger
+ * @param   oper - ZCL_OPER_LEN, ZCL_OPER_READ or ZCL_OPER_WRITE
+ * @param   pValue - length byte, then the windows
+ * @param   pLen - length of the attribute data
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_TouReadWrite( zclOpenEvse_evse_t *evse, uint8 oper, uint8 *pValue, uint16 *pLen )
+{
+  zclOpenEvse_touWindow_t *w;
+  uint8 count;
+  uint8 i;
+
+  if ( oper == ZCL_OPER_WRITE )
+  {
+    count = pValue[0] / 6;
+    if ( pValue[0] % 6 != 0 || count > OPENEVSE_TOU_WINDOWS )
+    {
+      return ZCL_STATUS_INVALID_VALUE;
+    }
+    for ( i = 0, pValue++; i < count; i++, pValue += 6 )
+    {
+      if ( pValue[0] == 0 || (pValue[0] & 0x80) ||
+           BUILD_UINT16( pValue[1], pValue[2] ) >= OPENEVSE_DAY_MINUTES ||
+           BUILD_UINT16( pValue[3], pValue[4] ) >= OPENEVSE_DAY_MINUTES ||
+           (pValue[5] != 0 && (pValue[5] < OPENEVSE_AMPS_MIN || pValue[5] > OPENEVSE_AMPS_MAX)) )
+      {
+        return ZCL_STATUS_INVALID_VALUE;
+      }
+    }
+    for ( i = 0, pValue -= 6 * count; i < count; i++, pValue += 6 )
+    {
+      w = &evse->tou.window[i];
+      w->days = pValue[0];
+      w->start = BUILD_UINT16( pValue[1], pValue[2] );
+      w->stop = BUILD_UINT16( pValue[3], pValue[4] );
+      w->amps = pValue[5];
+    }
+    evse->tou.count = count;
+    if ( count == 0 && evse->tou.restoreAmps != 0 )
+    {
+      evse->setAmps = evse->tou.restoreAmps; // Don't leave the pilot where a window put it
+      evse->tou.restoreAmps = 0;
+    }
+    zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_TOU_NV), 0, sizeof(evse->tou), &evse->tou );
+    evse->touActive = OPENEVSE_TOU_UNKNOWN; // Apply the window it is in now
+    osal_set_event( evse->taskId, OPENEVSE_TOU_EVT );
+    return ZCL_STATUS_SUCCESS;
+  }
+  if ( oper != ZCL_OPER_LEN && oper != ZCL_OPER_READ )
+  {
+    return ZCL_STATUS_FAILURE;
+  }
+
+  if ( oper == ZCL_OPER_READ )
+  {
+    *pValue++ = 6 * evse->tou.count;
+    for ( i = 0; i < evse->tou.count; i++ )
+    {
+      w = &evse->tou.window[i];
+      *pValue++ = w->days;
+      *pValue++ = LO_UINT16( w->start );
+      *pValue++ = HI_UINT16( w->start );
+      *pValue++ = LO_UINT16( w->stop );
+      *pValue++ = HI_UINT16( w->stop );
+      *pValue++ = w->amps;
+    }
+  }
+  if ( pLen != NULL )
+  {
+    *pLen = 1 + 6 * evse->tou.count;
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_CmdStatsRead
+ *
+ * @brief   Serve the resends or the commands given up on of a charger,
+ *          a uint16 for each command slot.
+ *
+ * @param   evse - charger
+ * @param   attrId - ATTRID_OPENEVSE_CMD_RESENDS or _GIVEN_UP
+ * @param   oper - ZCL_OPER_LEN or ZCL_OPER_READ
+ * @param   pValue - where the value goes
+ * @param   pLen - its length
+ *
+ * @return  ZStatus_t
+ */
+static ZStatus_t zclOpenEvse_CmdStatsRead( zclOpenEvse_evse_t *evse, uint16 attrId, uint8 oper,
+                                           uint8 *pValue, uint16 *pLen )
+{
+  uint16 *counts = attrId == ATTRID_OPENEVSE_CMD_RESENDS ? evse->retries : evse->failures;
+  uint8 i;
+
+  if ( oper != ZCL_OPER_LEN && oper != ZCL_OPER_READ )
+  {
+    return ZCL_STATUS_FAILURE;
+  }
+  if ( oper == ZCL_OPER_READ )
+  {
+    *pValue++ = 2 * EVSE_CMD_COUNT;
+    for ( i = 0; i < EVSE_CMD_COUNT; i++ )
+    {
+      *pValue++ = LO_UINT16( counts[i] );
+      *pValue++ = HI_UINT16( counts[i] );
+    }
+  }
+  if ( pLen != NULL )
+  {
+    *pLen = 1 + 2 * EVSE_CMD_COUNT;
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+#if defined OPENEVSE_SLEEPY
+/*********************************************************************
+ * @fn      zclOpenEvse_FastPoll
+ *
+ * @brief   Poll the parent at the short poll interval for at least this
+ *          long. A window already open for longer is left as it is.
+ *
+ * @param   quarterSecs - length of the window
+ *
+ * @return  none
+ */
+static void zclOpenEvse_FastPoll( uint16 quarterSecs )
+{
+  uint32 ms = (uint32)quarterSecs * 250;
+
+  if ( ms > osal_get_timeoutEx( zclOpenEvse_TaskID, OPENEVSE_POLL_CONTROL_TIMEOUT_EVT ) )
+  {
+    osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_CONTROL_TIMEOUT_EVT, ms );
+  }
+  NLME_SetPollRate( (uint32)zclOpenEvse_shortPollInterval * 250 );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_FastPollStop
+ *
+ * @brief   Close the fast poll window and go back to long polls.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvse_FastPollStop( void )
+{
+  osal_stop_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_CONTROL_TIMEOUT_EVT );
+  NLME_SetPollRate( zclOpenEvse_longPollInterval * 250 );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_CheckIn
+ *
+ * @brief   Send a Check-in to the bound clients, if on the network, and
+ *          fast poll a while for the response. Runs again after the
+ *          check-in interval, unless that is 0.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvse_CheckIn( void )
+{
+  if ( zclOpenEvse_NwkState == OPENEVSE_NWK_JOINED )
+  {
+    zclPollControl_Send_CheckIn( OPENEVSE_ENDPOINT, &zclOpenEvse_DstAddr, FALSE, zclOpenEvse_seqNum++ );
+    zclOpenEvse_FastPoll( OPENEVSE_CHECK_IN_WAIT );
+  }
+  if ( zclOpenEvse_checkInInterval != 0 )
+  {
+    osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_CHECK_IN_EVT, zclOpenEvse_checkInInterval * 250 );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_CheckInRspCB
+ *
+ * @brief   Check-in Response: fast poll for the time the client asks,
+ *          or FastPollTimeout if it leaves that to us, or stop waiting.
+ *
+ * @param   pCmd - response
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_CheckInRspCB( zclPollControlCheckInRsp_t *pCmd )
+{
+  zclOpenEvse_FastPollStop();
+  if ( pCmd->startFastPolling )
+  {
+    zclOpenEvse_FastPoll( pCmd->fastPollTimeOut ? pCmd->fastPollTimeOut : zclOpenEvse_fastPollTimeout );
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_FastPollStopCB
+ *
+ * @brief   Fast Poll Stop: the client is done with us.
+ *
+ * @param   pCmd - command
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_FastPollStopCB( zclPollControlFastPollStop_t *pCmd )
+{
+  zclOpenEvse_FastPollStop();
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_SetLongPollIntervalCB
+ *
+ * @brief   Set Long Poll Interval, taken at once unless fast polling.
+ *          It may not be under the short poll interval or over the
+ *          check-in interval.
+ *
+ * @param   pCmd - command
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_SetLongPollIntervalCB( zclPollControlSetLongPollInterval_t *pCmd )
+{
+  uint32 interval = pCmd->newLongPollInterval;
+
+  if ( interval < OPENEVSE_LONG_POLL_MIN || interval > OPENEVSE_POLL_INTERVAL_MAX ||
+       interval < zclOpenEvse_shortPollInterval ||
+       ( zclOpenEvse_checkInInterval != 0 && interval > zclOpenEvse_checkInInterval ) )
+  {
+    return ZCL_STATUS_INVALID_VALUE;
+  }
+  zclOpenEvse_longPollInterval = interval;
+  if ( osal_get_timeoutEx( zclOpenEvse_TaskID, OPENEVSE_POLL_CONTROL_TIMEOUT_EVT ) == 0 )
+  {
+    NLME_SetPollRate( zclOpenEvse_longPollInterval * 250 );
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_SetShortPollIntervalCB
+ *
+ * @brief   Set Short Poll Interval, taken at once when fast polling.
+ *          It may not be over the long poll interval.
+ *
+ * @param   pCmd - command
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_SetShortPollIntervalCB( zclPollControlSetShortPollInterval_t *pCmd )
+{
+  if ( pCmd->newShortPollInterval == 0 || pCmd->newShortPollInterval > zclOpenEvse_longPollInterval )
+  {
+    return ZCL_STATUS_INVALID_VALUE;
+  }
+  zclOpenEvse_shortPollInterval = pCmd->newShortPollInterval;
+  if ( osal_get_timeoutEx( zclOpenEvse_TaskID, OPENEVSE_POLL_CONTROL_TIMEOUT_EVT ) != 0 )
+  {
+    NLME_SetPollRate( (uint32)zclOpenEvse_shortPollInterval * 250 );
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_PollControlReadWrite
+ *
+ * @brief   Serve CheckInInterval and FastPollTimeout. A new check-in
+ *          interval restarts the timer from now; 0 stops check-ins.
+ *
+ * @param   attrId - ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL or
+ *                   ATTRID_POLL_CONTROL_FAST_POLL_TIMEOUT
+ * @param   oper - ZCL_OPER_LEN, ZCL_OPER_READ or ZCL_OPER_WRITE
+ * @param   pValue - attribute data, little endian
+ * @param   pLen - length of the attribute data
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_PollControlReadWrite( uint16 attrId, uint8 oper, uint8 *pValue, uint16 *pLen )
+{
+  uint32 value;
+
+  if ( attrId == ATTRID_POLL_CONTROL_FAST_POLL_TIMEOUT )
+  {
+    if ( oper == ZCL_OPER_WRITE )
+    {
+      value = BUILD_UINT16( pValue[0], pValue[1] );
+      if ( value == 0 )
+      {
+        return ZCL_STATUS_INVALID_VALUE;
+      }
+      zclOpenEvse_fastPollTimeout = (uint16)value;
+    }
+    else if ( oper == ZCL_OPER_READ )
+    {
+      pValue[0] = LO_UINT16( zclOpenEvse_fastPollTimeout );
+      pValue[1] = HI_UINT16( zclOpenEvse_fastPollTimeout );
+    }
+    if ( pLen != NULL )
+    {
+      *pLen = 2;
+    }
+    return ZCL_STATUS_SUCCESS;
+  }
+  if ( attrId != ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL )
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+
+  if ( oper == ZCL_OPER_WRITE )
+  {
+    value = BUILD_UINT32( pValue[0], pValue[1], pValue[2], pValue[3] );
+    if ( value != 0 && ( value < zclOpenEvse_longPollInterval || value > OPENEVSE_POLL_INTERVAL_MAX ) )
+    {
+      return ZCL_STATUS_INVALID_VALUE;
+    }
+    zclOpenEvse_checkInInterval = value;
+    if ( value != 0 )
+    {
+      osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_CHECK_IN_EVT, value * 250 );
+    }
+    else
+    {
+      osal_stop_timerEx( zclOpenEvse_TaskID, OPENEVSE_CHECK_IN_EVT );
+    }
+  }
+  else if ( oper == ZCL_OPER_READ )
+  {
+    pValue[0] = BREAK_UINT32( zclOpenEvse_checkInInterval, 0 );
+    pValue[1] = BREAK_UINT32( zclOpenEvse_checkInInterval, 1 );
+    pValue[2] = BREAK_UINT32( zclOpenEvse_checkInInterval, 2 );
+    pValue[3] = BREAK_UINT32( zclOpenEvse_checkInInterval, 3 );
+  }
+  if ( pLen != NULL )
+  {
+    *pLen = 4;
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+#endif // OPENEVSE_SLEEPY
+
+#if OPENEVSE_TRACE_ENTRIES
+/*********************************************************************
+ * @fn      zclOpenEvse_Trace
+ *
+ * @brief   Add an entry to the trace ring, over the oldest one.
+ *
+ * @param   evse - charger
+ * @param   id - RAPI command, or OPENEVSE_TRACE_REPORT | report class
+ * @param   len - bytes sent or received
+ * @param   result - OPENEVSE_TRACE_OK, ...
+ * @param   resends - of a RAPI command
+ * @param   latency - ms from the first send, or from the report request
+ *
+ * @return  none
+ */
+static void zclOpenEvse_Trace( zclOpenEvse_evse_t *evse, uint8 id, uint8 len, uint8 result,
+                               uint8 resends, uint32 latency )
+{
+  zclOpenEvse_traceEntry_t *entry = &zclOpenEvse_trace[zclOpenEvse_traceSeq & (OPENEVSE_TRACE_ENTRIES - 1)];
+
+  entry->time = osal_GetSystemClock();
+  entry->latency = latency > 0xFFFF ? 0xFFFF : (uint16)latency;
+  entry->id = id;
+  entry->len = len;
+  entry->result = result;
+  entry->info = (uint8)((evse - zclOpenEvse_evse) << 4) | (resends & 0x0F);
+  zclOpenEvse_traceSeq++;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_TraceRead
+ *
+ * @brief   Serve the trace chunk attribute: up to OPENEVSE_TRACE_CHUNK
+ *          entries from TRACE_CURSOR on, or from the oldest entry still
+ *          in the ring if the cursor is behind it. The reader moves the
+ *          cursor, so a repeated read returns the same chunk.
+ *
+ * @param   oper - ZCL_OPER_LEN or ZCL_OPER_READ
+ * @param   pValue - where the value goes
+ * @param   pLen - its length
+ *
+ * @return  ZStatus_t
+ */
+static ZStatus_t zclOpenEvse_TraceRead( uint8 oper, uint8 *pValue, uint16 *pLen )
+{
+  uint16 first = zclOpenEvse_traceCursor;
+  uint16 count = zclOpenEvse_traceSeq - first;
+  zclOpenEvse_traceEntry_t *entry;
+  uint16 len;
+  uint16 i;
+
+  if ( oper != ZCL_OPER_LEN && oper != ZCL_OPER_READ )
+  {
+    return ZCL_STATUS_FAILURE;
+  }
+
+  if ( count & 0x8000 )
+  {
+    count = 0; // Cursor is ahead of the trace
+  }
+  else if ( count > OPENEVSE_TRACE_ENTRIES )
+  {
+    first = zclOpenEvse_traceSeq - OPENEVSE_TRACE_ENTRIES;
+    count = OPENEVSE_TRACE_ENTRIES;
+  }
+  if ( count > OPENEVSE_TRACE_CHUNK )
+  {
+    count = OPENEVSE_TRACE_CHUNK;
+  }
+  len = 1 + 2 + count * 10;
+
+  if ( oper == ZCL_OPER_READ )
+  {
+    *pValue++ = len - 1;
+    *pValue++ = LO_UINT16( first );
+    *pValue++ = HI_UINT16( first );
+    for ( i = 0; i < count; i++ )
+    {
+      entry = &zclOpenEvse_trace[(first + i) & (OPENEVSE_TRACE_ENTRIES - 1)];
+      *pValue++ = BREAK_UINT32( entry->time, 0 );
+      *pValue++ = BREAK_UINT32( entry->time, 1 );
+      *pValue++ = BREAK_UINT32( entry->time, 2 );
+      *pValue++ = BREAK_UINT32( entry->time, 3 );
+      *pValue++ = entry->id;
+      *pValue++ = entry->len;
+      *pValue++ = entry->result;
+      *pValue++ = entry->info;
+      *pValue++ = LO_UINT16( entry->latency );
+      *pValue++ = HI_UINT16( entry->latency );
+    }
+  }
+  if ( pLen != NULL )
+  {
+    *pLen = len;
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+#endif
+
+#if defined OPENEVSE_PROFILE
+/*********************************************************************
+ * @fn      zclOpenEvse_ProfileRead
+ *
+ * @brief   Serve the event loop profile attributes: an octet string of
+ *          calls and histogram buckets per event bit, and the heap
+ *          high-water mark from OSAL.
+ *
+ * @param   attrId - attribute
+ * @param   oper - ZCL_OPER_LEN or ZCL_OPER_READ
+ * @param   pValue - where the value goes
+ * @param   pLen - its length
+ *
+ * @return  ZStatus_t
+ */
+static ZStatus_t zclOpenEvse_ProfileRead( uint16 attrId, uint8 oper, uint8 *pValue, uint16 *pLen )
+{
+  uint8 bit = (uint8)(attrId - ATTRID_OPENEVSE_PROFILE_EVENT);
+  uint16 len;
+  uint8 i;
+
+  if ( attrId == ATTRID_OPENEVSE_PROFILE_HEAP_HIGH )
+  {
+    len = 2;
+    if ( oper == ZCL_OPER_READ )
+    {
+      uint16 high = osal_heap_high_water();
+
+      pValue[0] = LO_UINT16( high );
+      pValue[1] = HI_UINT16( high );
+    }
+  }
+  else if ( attrId >= ATTRID_OPENEVSE_PROFILE_EVENT && bit < 16 )
+  {
+    len = 1 + 2 * (1 + OPENEVSE_PROFILE_BUCKETS);
+    if ( oper == ZCL_OPER_READ )
+    {
+      *pValue++ = len - 1;
+      *pValue++ = LO_UINT16( zclOpenEvse_profile.calls[bit] );
+      *pValue++ = HI_UINT16( zclOpenEvse_profile.calls[bit] );
+      for ( i = 0; i < OPENEVSE_PROFILE_BUCKETS; i++ )
+      {
+        *pValue++ = LO_UINT16( zclOpenEvse_profile.hist[bit][i] );
+        *pValue++ = HI_UINT16( zclOpenEvse_profile.hist[bit][i] );
+      }
+    }
+  }
+  else
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+
+  if ( oper != ZCL_OPER_LEN && oper != ZCL_OPER_READ )
+  {
+    return ZCL_STATUS_FAILURE;
+  }
+  if ( pLen != NULL )
+  {
+    *pLen = len;
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ProfileTicks
+ *
+ * @brief   Read the 24-bit, 32.768kHz sleep timer.
+ *
+ * @param   none
+ *
+ * @return  ticks
+ */
+static uint32 zclOpenEvse_ProfileTicks( void )
+{
+  uint32 ticks = ST0; // Reading ST0 latches ST1 and ST2
+
+  ticks |= (uint32)ST1 << 8;
+  ticks |= (uint32)ST2 << 16;
+  return ticks;
+}
+#endif
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessAFMsg
+ *
+ * @brief   Pick a plain Write Attributes of CurrentDemandLimit alone out
+ *          of the charger endpoint's traffic. Its Write Response is held
+ *          back until the EVSE has answered the $SH. Get Alerts is
+ *          answered here. OTA Upgrade commands to the first charger
+ *          endpoint go to the OTA client.
+ *
+ * @param   pkt - incoming AF message
+ *
+ * @return  TRUE if the message was taken, FALSE to pass it to the ZCL
+ */
+static uint8 zclOpenEvse_ProcessAFMsg( zclOpenEvse_evse_t *evse, afIncomingMSGPacket_t *pkt )
+{
+  uint8 *pData = pkt->cmd.Data;
+
+  if ( pkt->clusterId == ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS )
+  {
+    return zclOpenEvse_GetAlerts( evse, pkt );
+  }
+#if defined OPENEVSE_OTA
+  if ( pkt->clusterId == ZCL_CLUSTER_ID_OTA )
+  {
+    return evse == zclOpenEvse_evse && zclOpenEvseOta_ProcessAFMsg( pkt );
+  }
+#endif
+
+  // Frame control, sequence number and command, then one 6 byte record:
+  // attribute ID, data type and a 24 bit value
+  if ( pkt->clusterId != ZCL_CLUSTER_ID_SE_METERING || pkt->cmd.DataLength != 3 + 6 ||
+       (pData[0] & (ZCL_FRAME_CONTROL_TYPE | ZCL_FRAME_CONTROL_MANU_SPECIFIC |
+                    ZCL_FRAME_CONTROL_DIRECTION)) != 0 ||
+       pData[2] != ZCL_CMD_WRITE ||
+       BUILD_UINT16( pData[3], pData[4] ) != ATTRID_CURRENT_DEMAND_LIMIT ||
+       pData[5] != ZCL_DATATYPE_UINT24 )
+  {
+    return FALSE;
+  }
+
+  // If it can't be queued the ZCL answers it, with the same status
+  return zclOpenEvse_LimitWrite( evse, BUILD_UINT32( pData[6], pData[7], pData[8], 0 ),
+                                 pkt, pData[1] ) == ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_GetAlerts
+ *
+ * @brief   Answer Get Alerts with the alerts in force, so a hub that
+ *          missed a notification or has just started can catch up.
+ *          Other Appliance Events & Alerts commands go to the ZCL.
+ *
+ * @param   evse - charger the command is for
+ * @param   pkt - incoming frame on the Appliance Events & Alerts cluster
+ *
+ * @return  TRUE if answered here
+ */
+static uint8 zclOpenEvse_GetAlerts( zclOpenEvse_evse_t *evse, afIncomingMSGPacket_t *pkt )
+{
+  uint8 *pData = pkt->cmd.Data;
+  uint8 buf[1 + 3 * OPENEVSE_ALERTS];
+
+  if ( pkt->cmd.DataLength < 3 ||
+       (pData[0] & (ZCL_FRAME_CONTROL_TYPE | ZCL_FRAME_CONTROL_MANU_SPECIFIC |
+                    ZCL_FRAME_CONTROL_DIRECTION)) != ZCL_FRAME_TYPE_SPECIFIC_CMD ||
+       pData[2] != OPENEVSE_ALERTS_CMD_GET_ALERTS )
+  {
+    return FALSE;
+  }
+
+  zcl_SendCommand( evse->endpoint, &pkt->srcAddr, ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS,
+                   OPENEVSE_ALERTS_CMD_GET_ALERTS_RSP, TRUE, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, 0,
+                   pData[1], zclOpenEvse_AlertList( evse, 0, buf ), buf );
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LimitWrite
+ *
+ * @brief   Check a new CurrentDemandLimit and queue the $SH for it. One
+ *          write is handled at a time.
+ *
+ * @param   limit - kWh, or OPENEVSE_LIMIT_NONE
+ * @param   pkt - write to answer when the EVSE replies, or NULL
+ * @param   seqNum - ZCL sequence number of that write
+ *
+ * @return  ZCL status
+ */
+static ZStatus_t zclOpenEvse_LimitWrite( zclOpenEvse_evse_t *evse, uint32 limit, afIncomingMSGPacket_t *pkt, uint8 seqNum )
+{
+  if ( limit != OPENEVSE_LIMIT_NONE && limit > OPENEVSE_LIMIT_MAX )
+  {
+    return ZCL_STATUS_INVALID_VALUE;
+  }
+  if ( evse->limitWrite.state != LIMIT_WRITE_IDLE )
+  {
+    return ZCL_STATUS_FAILURE; // Previous write still with the EVSE
+  }
+
+  evse->limitWrite.value = limit;
+  evse->limitWrite.respond = (pkt != NULL);
+  if ( pkt != NULL )
+  {
+    evse->limitWrite.srcAddr = pkt->srcAddr;
+    evse->limitWrite.seqNum = seqNum;
+  }
+  evse->limitWrite.state = LIMIT_WRITE_QUEUED;
+  osal_set_event( evse->taskId, OPENEVSE_LIMIT_WRITE_EVT );
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LimitWriteDone
+ *
+ * @brief   The EVSE took the new limit, or the command was given up on.
+ *          Keep the limit on success and send any Write Response owed.
+ *
+ * @param   status - ZCL_STATUS_SUCCESS or ZCL_STATUS_FAILURE
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LimitWriteDone( zclOpenEvse_evse_t *evse, ZStatus_t status )
+{
+  zclWriteRspCmd_t *writeRspCmd;
+
+  if ( status == ZCL_STATUS_SUCCESS )
+  {
+    evse->energyLimit = evse->limitWrite.value;
+    // Save to NVRAM
+    zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_LIMIT_NV), 0, sizeof(evse->energyLimit), &evse->energyLimit );
+  }
+
+  if ( evse->limitWrite.respond )
+  {
+    writeRspCmd = (zclWriteRspCmd_t *)osal_mem_alloc( sizeof( zclWriteRspCmd_t ) +
+                                                      sizeof( zclWriteRspStatus_t ) );
+    if ( writeRspCmd != NULL )
+    {
+      writeRspCmd->numAttr = 1;
+      writeRspCmd->attrList[0].status = status;
+      writeRspCmd->attrList[0].attrID = ATTRID_CURRENT_DEMAND_LIMIT;
+      zcl_SendWriteRsp( evse->endpoint, &evse->limitWrite.srcAddr,
+                        ZCL_CLUSTER_ID_SE_METERING, writeRspCmd,
+                        ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, evse->limitWrite.seqNum );
+      osal_mem_free( writeRspCmd );
+    }
+  }
+  evse->limitWrite.state = LIMIT_WRITE_IDLE;
+}
+
+/******************************************************************************
+ *
+ *  Functions for processing ZCL Foundation incoming Command/Response messages
+ *
+ *****************************************************************************/
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessIncomingMsg
+ *
+ * @brief   Process ZCL Foundation incoming message
+ *
+ * @param   pInMsg - pointer to the received message
+ *
+ * @return  none
+ */
+static void zclOpenEvse_ProcessIncomingMsg( zclIncomingMsg_t *pInMsg )
+{
+  switch ( pInMsg->zclHdr.commandID )
+  {
+#ifdef ZCL_READ
+    case ZCL_CMD_READ_RSP:
+      zclOpenEvse_ProcessInReadRspCmd( pInMsg );
+      break;
+#endif
+#ifdef ZCL_WRITE
+    case ZCL_CMD_WRITE_RSP:
+      zclOpenEvse_ProcessInWriteRspCmd( pInMsg );
+      break;
+#endif
+#ifdef ZCL_REPORT
+    // Attribute Reporting implementation should be added here
+    case ZCL_CMD_CONFIG_REPORT:
+      // zclOpenEvse_ProcessInConfigReportCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_CONFIG_REPORT_RSP:
+      // zclOpenEvse_ProcessInConfigReportRspCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_READ_REPORT_CFG:
+      // zclOpenEvse_ProcessInReadReportCfgCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_READ_REPORT_CFG_RSP:
+      // zclOpenEvse_ProcessInReadReportCfgRspCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_REPORT:
+      // zclOpenEvse_ProcessInReportCmd( pInMsg );
+      break;
+#endif
+    case ZCL_CMD_DEFAULT_RSP:
+      zclOpenEvse_ProcessInDefaultRspCmd( pInMsg );
+      break;
+#ifdef ZCL_DISCOVER
+    case ZCL_CMD_DISCOVER_CMDS_RECEIVED_RSP:
+      zclOpenEvse_ProcessInDiscCmdsRspCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_DISCOVER_CMDS_GEN_RSP:
+      zclOpenEvse_ProcessInDiscCmdsRspCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_DISCOVER_ATTRS_RSP:
+      zclOpenEvse_ProcessInDiscAttrsRspCmd( pInMsg );
+      break;
+
+    case ZCL_CMD_DISCOVER_ATTRS_EXT_RSP:
+      zclOpenEvse_ProcessInDiscAttrsExtRspCmd( pInMsg );
+      break;
+#endif
+    default:
+      break;
+  }
+
+  if ( pInMsg->attrCmd )
+    osal_mem_free( pInMsg->attrCmd );
+}
+
+#ifdef ZCL_READ
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessInReadRspCmd
+ *
+ * @brief   Process the "Profile" Read Response Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static uint8 zclOpenEvse_ProcessInReadRspCmd( zclIncomingMsg_t *pInMsg )
+{
+  zclReadRspCmd_t *readRspCmd;
+  uint8 i;
+
+  readRspCmd = (zclReadRspCmd_t *)pInMsg->attrCmd;
+  for (i = 0; i < readRspCmd->numAttr; i++)
+  {
+    // Notify the originator of the results of the original read attributes
+    // attempt and, for each successfull request, the value of the requested
+    // attribute
+  }
+
+  return ( TRUE );
+}
+#endif // ZCL_READ
+
+#ifdef ZCL_WRITE
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessInWriteRspCmd
+ *
+ * @brief   Process the "Profile" Write Response Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static uint8 zclOpenEvse_ProcessInWriteRspCmd( zclIncomingMsg_t *pInMsg )
+{
+  zclWriteRspCmd_t *writeRspCmd;
+  uint8 i;
+
+  writeRspCmd = (zclWriteRspCmd_t *)pInMsg->attrCmd;
+  for ( i = 0; i < writeRspCmd->numAttr; i++ )
+  {
+    // Notify the device of the results of the its original write attributes
+    // command.
+  }
+
+  return ( TRUE );
+}
+#endif // ZCL_WRITE
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessInDefaultRspCmd
+ *
+ * @brief   Process the "Profile" Default Response Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static uint8 zclOpenEvse_ProcessInDefaultRspCmd( zclIncomingMsg_t *pInMsg )
+{
+  // zclDefaultRspCmd_t *defaultRspCmd = (zclDefaultRspCmd_t *)pInMsg->attrCmd;
+
+  // Device is notified of the Default Response command.
+  (void)pInMsg;
+
+  return ( TRUE );
+}
+
+#ifdef ZCL_DISCOVER
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessInDiscCmdsRspCmd
+ *
+ * @brief   Process the Discover Commands Response Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static uint8 zclOpenEvse_ProcessInDiscCmdsRspCmd( zclIncomingMsg_t *pInMsg )
+{
+  zclDiscoverCmdsCmdRsp_t *discoverRspCmd;
+  uint8 i;
+
+  discoverRspCmd = (zclDiscoverCmdsCmdRsp_t *)pInMsg->attrCmd;
+  for ( i = 0; i < discoverRspCmd->numCmd; i++ )
+  {
+    // Device is notified of the result of its attribute discovery command.
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessInDiscAttrsRspCmd
+ *
+ * @brief   Process the "Profile" Discover Attributes Response Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static uint8 zclOpenEvse_ProcessInDiscAttrsRspCmd( zclIncomingMsg_t *pInMsg )
+{
+  zclDiscoverAttrsRspCmd_t *discoverRspCmd;
+  uint8 i;
+
+  discoverRspCmd = (zclDiscoverAttrsRspCmd_t *)pInMsg->attrCmd;
+  for ( i = 0; i < discoverRspCmd->numAttr; i++ )
+  {
+    // Device is notified of the result of its attribute discovery command.
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ProcessInDiscAttrsExtRspCmd
+ *
+ * @brief   Process the "Profile" Discover Attributes Extended Response Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static uint8 zclOpenEvse_ProcessInDiscAttrsExtRspCmd( zclIncomingMsg_t *pInMsg )
+{
+  zclDiscoverAttrsExtRsp_t *discoverRspCmd;
+  uint8 i;
+
+  discoverRspCmd = (zclDiscoverAttrsExtRsp_t *)pInMsg->attrCmd;
+  for ( i = 0; i < discoverRspCmd->numAttr; i++ )
+  {
+    // Device is notified of the result of its attribute discovery command.
+  }
+
+  return ( TRUE );
+}
+#endif // ZCL_DISCOVER
+
+
+void zclOpenEvse_sendPower(zclOpenEvse_evse_t *evse)
+{
+  // Restart max timer because we just sent, stretched on a poor link
+  osal_start_timerEx( evse->taskId, OPENEVSE_GETPOWER_MAX_EVT,
+                      zclOpenEvse_reportPowerMax << zclOpenEvse_MeshStretch() );
+
+  zclOpenEvse_ReportRequest(evse, REPORT_POWER);
+}
+
+void zclOpenEvse_sendTemp(zclOpenEvse_evse_t *evse)
+{
+  osal_start_timerEx( evse->taskId, OPENEVSE_GETTEMP_MAX_EVT,
+                      zclOpenEvse_reportTempMax << zclOpenEvse_MeshStretch() );
+
+  zclOpenEvse_ReportRequest(evse, REPORT_TEMP);
+}
+
+void zclOpenEvse_sendEnergy(zclOpenEvse_evse_t *evse)
+{
+  osal_start_timerEx( evse->taskId, OPENEVSE_GETENERGY_MAX_EVT, zclOpenEvse_reportEnergyMax );
+
+  zclOpenEvse_ReportRequest(evse, REPORT_ENERGY);
+}
+
+void zclOpenEvse_sendState(zclOpenEvse_evse_t *evse)
+{
+  zclOpenEvse_ReportRequest(evse, REPORT_STATE);
+}
+
+void zclOpenEvse_sendLevel(zclOpenEvse_evse_t *evse)
+{
+  zclOpenEvse_ReportRequest(evse, REPORT_LEVEL);
+}
+
+void zclOpenEvse_sendThermal(zclOpenEvse_evse_t *evse)
+{
+  zclOpenEvse_ReportRequest(evse, REPORT_THERMAL);
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ReportRequest
+ *
+ * @brief   Queue a report class and send it if the airtime budget allows.
+ *          A report still waiting for budget is merged with the new one.
+ *
+ * @param   reportClass - REPORT_STATE, REPORT_POWER, ...
+ *
+ * @return  none
+ */
+void zclOpenEvse_ReportRequest(zclOpenEvse_evse_t *evse, uint8 reportClass)
+{
+  if (evse->reportPending & BV(reportClass))
+  {
+    zclOpenEvse_reportMerged++; // Older value is superseded before it went out
+    OPENEVSE_TRACE(evse, OPENEVSE_TRACE_REPORT | reportClass, 0, OPENEVSE_TRACE_SUPERSEDED, 0,
+                   (uint16)((uint16)osal_GetSystemClock() - evse->reportRequested[reportClass]));
+  }
+  else
+  {
+    evse->reportRequested[reportClass] = (uint16)osal_GetSystemClock();
+  }
+  evse->reportRetries[reportClass] = 0; // A new value gets its own retries
+  evse->reportPending |= BV(reportClass);
+  zclOpenEvse_ReportFlush();
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ReportFlush
+ *
+ * @brief   Send pending reports in priority order while the token bucket
+ *          has budget. Telemetry leaves enough budget for one state report
+ *          so a state change is never held behind it. Alerts and events
+ *          go out at once and take what budget there is. Chargers share
+ *          the budget; within a class they take turns in charger order.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zclOpenEvse_ReportFlush(void)
+{
+  zclOpenEvse_evse_t *evse;
+  uint8 reportClass;
+  uint8 result;
+  ZStatus_t status;
+  uint8 i, n;
+  uint8 urgent;
+  uint32 frames, bytes;
+  uint32 reserveFrames = 0, reserveBytes = 0;
+  uint32 wait = 0;
+
+  zclOpenEvse_BudgetRefill();
+
+  for (n = 0; n < REPORT_CLASSES; n++)
+  {
+    reportClass = zclOpenEvse_reportOrder[n];
+    urgent = (reportClass == REPORT_ALERT) || (reportClass == REPORT_EVENT);
+    frames = (uint32)(zclOpenEvse_reportFirst[reportClass+1] - zclOpenEvse_reportFirst[reportClass]) * 1000;
+    bytes = (uint32)zclOpenEvse_ReportBytes(reportClass) * 1000;
+    if (!urgent && reportClass != REPORT_STATE)
+    {
+      reserveFrames = 1000;
+      reserveBytes = (uint32)zclOpenEvse_ReportBytes(REPORT_STATE) * 1000;
+    }
+
+    for (evse = zclOpenEvse_evse; evse < zclOpenEvse_evse + zclOpenEvse_numEvse; evse++)
+    {
+      if (!(evse->reportPending & BV(reportClass)))
+      {
+        continue;
+      }
+
+      if ( !urgent &&
+           ((zclOpenEvse_budgetFrames && (zclOpenEvse_budgetFrameTokens < frames + reserveFrames)) ||
+            (zclOpenEvse_budgetBytes && (zclOpenEvse_budgetByteTokens < bytes + reserveBytes))) )
+      {
+        if (!(evse->reportDeferredMask & BV(reportClass)))
+        {
+          evse->reportDeferredMask |= BV(reportClass);
+          zclOpenEvse_reportDeferred++;
+        }
+
+        // Wake up when the emptier bucket can cover this class
+        if (zclOpenEvse_budgetFrames && (zclOpenEvse_budgetFrameTokens < frames + reserveFrames))
+        {
+          wait = (frames + reserveFrames - zclOpenEvse_budgetFrameTokens) / zclOpenEvse_budgetFrames;
+        }
+        if (zclOpenEvse_budgetBytes && (zclOpenEvse_budgetByteTokens < bytes + reserveBytes) &&
+            ((bytes + reserveBytes - zclOpenEvse_budgetByteTokens) / zclOpenEvse_budgetBytes > wait))
+        {
+          wait = (bytes + reserveBytes - zclOpenEvse_budgetByteTokens) / zclOpenEvse_budgetBytes;
+        }
+        osal_start_timerEx( zclOpenEvse_TaskID, OPENEVSE_REPORT_BUDGET_EVT, wait + 1 );
+        return; // Lower priority classes wait behind this one
+      }
+
+      // An urgent class may overdraw; the bucket then stays empty a while
+      zclOpenEvse_budgetFrameTokens -= (zclOpenEvse_budgetFrameTokens < frames) ? zclOpenEvse_budgetFrameTokens : frames;
+      zclOpenEvse_budgetByteTokens -= (zclOpenEvse_budgetByteTokens < bytes) ? zclOpenEvse_budgetByteTokens : bytes;
+      evse->reportPending &= ~BV(reportClass);
+      evse->reportDeferredMask &= ~BV(reportClass);
+
+      result = OPENEVSE_TRACE_OK;
+      for (i = zclOpenEvse_reportFirst[reportClass]; i < zclOpenEvse_reportFirst[reportClass+1]; i++)
+      {
+        status = zclOpenEvse_SendReport(evse, reportClass, i);
+        evse->delivery[reportClass].sent++;
+        if ( status == ZSuccess )
+        {
+          zclOpenEvse_reportSent++;
+        }
+        else
+        {
+          zclOpenEvse_reportDropped++;
+          evse->delivery[reportClass].failed++;
+          zclOpenEvse_MeshConfirm(status); // No confirm will follow
+          result = OPENEVSE_TRACE_FAILED;
+        }
+      }
+      OPENEVSE_TRACE(evse, OPENEVSE_TRACE_REPORT | reportClass, (uint8)(bytes / 1000), result, 0,
+                     (uint16)((uint16)osal_GetSystemClock() - evse->reportRequested[reportClass]));
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_SendReport
+ *
+ * @brief   Send one report frame, with APS acks if its class is in
+ *          zclOpenEvse_reportAcked. The frame is built here rather than
+ *          by zcl_SendReportCmd so its AF transaction ID is known and the
+ *          data confirm can be matched to the class. No Default Response
+ *          is asked for: the APS ack already says an acknowledged class
+ *          arrived, and the rest are fire and forget. Frames past the
+ *          attribute reports are the Alerts Notification, listing the
+ *          alerts raised and those cleared since the last one arrived,
+ *          and the Event Notification.
+ *
+ * @param   reportClass - class the frame belongs to
+ * @param   frame - index in zclOpenEvse_reportFrames, or past its end
+ *
+ * @return  status of AF_DataRequest
+ */
+ZStatus_t zclOpenEvse_SendReport(zclOpenEvse_evse_t *evse, uint8 reportClass, uint8 frame)
+{
+  zclOpenEvse_inflight_t *slot = &zclOpenEvse_inflight[zclOpenEvse_inflightNext];
+  uint8 buf[OPENEVSE_REPORT_FRAME_MAX];
+  zclReport_t *attr;
+  uint8 transID;
+  uint16 clusterId;
+  uint8 len;
+  ZStatus_t status;
+
+  // Keep well ahead of the ZCL's transaction IDs
+  if ((uint8)(zclOpenEvse_transID - zclOpenEvse_zclTransID - OPENEVSE_REPORT_TRANSID_MIN) >=
+      OPENEVSE_REPORT_TRANSID_MAX - OPENEVSE_REPORT_TRANSID_MIN)
+  {
+    zclOpenEvse_transID = zclOpenEvse_zclTransID + OPENEVSE_REPORT_TRANSID_MIN;
+  }
+  transID = zclOpenEvse_transID;
+
+  if (frame >= OPENEVSE_REPORT_CMDS)
+  {
+    clusterId = ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS;
+    buf[0] = ZCL_FRAME_TYPE_SPECIFIC_CMD | ZCL_FRAME_CONTROL_DIRECTION | ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP;
+    buf[1] = zclOpenEvse_seqNum++;
+    if (reportClass == REPORT_ALERT)
+    {
+      buf[2] = OPENEVSE_ALERTS_CMD_ALERTS_NOTIFICATION;
+      len = zclOpenEvse_AlertList(evse, evse->alertsCleared, &buf[3]);
+      evse->alertsClearedSent = evse->alertsCleared;
+      if (!(zclOpenEvse_reportAcked & BV(REPORT_ALERT)))
+      {
+        evse->alertsCleared = 0; // No confirm to wait for
+      }
+    }
+    else
+    {
+      buf[2] = OPENEVSE_ALERTS_CMD_EVENT_NOTIFICATION;
+      buf[3] = 0; // Event header
+      buf[4] = evse->event;
+      len = 2;
+    }
+    len += 3;
+  }
+  else
+  {
+    if (evse->reportCmd[frame] == NULL)
+    {
+      return ZMemError;
+    }
+    attr = &evse->reportCmd[frame]->attrList[0];
+    len = zclGetDataTypeLength(attr->dataType);
+    clusterId = zclOpenEvse_reportFrames[frame].clusterId;
+
+    buf[0] = ZCL_FRAME_TYPE_PROFILE_CMD | ZCL_FRAME_CONTROL_DIRECTION | ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP;
+    buf[1] = zclOpenEvse_seqNum++;
+    buf[2] = ZCL_CMD_REPORT;
+    buf[3] = LO_UINT16(attr->attrID);
+    buf[4] = HI_UINT16(attr->attrID);
+    buf[5] = attr->dataType;
+    osal_memcpy(&buf[6], attr->attrData, len); // Attributes are kept little endian, as sent
+    len += 6;
+  }
+
+  status = AF_DataRequest( &zclOpenEvse_DstAddr, afFindEndPointDesc(evse->endpoint),
+                           clusterId, len, buf, &zclOpenEvse_transID,
+                           (zclOpenEvse_reportAcked & BV(reportClass)) ? AF_ACK_REQUEST : AF_TX_OPTIONS_NONE,
+                           AF_DEFAULT_RADIUS );
+  if (status == ZSuccess)
+  {
+    // Oldest slot goes if its confirm never came
+    slot->transID = transID;
+    slot->charger = (uint8)(evse - zclOpenEvse_evse);
+    slot->reportClass = reportClass;
+    zclOpenEvse_inflightNext = (zclOpenEvse_inflightNext + 1) % OPENEVSE_REPORT_INFLIGHT;
+  }
+  return status;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_ReportConfirm
+ *
+ * @brief   Count a data confirm against the report class it is for and
+ *          queue an acknowledged class again if it did not arrive.
+ *          Confirms for frames the ZCL sent, such as Write Responses,
+ *          only go into the mesh failure rate and move on the ZCL's
+ *          transaction ID as the module knows it.
+ *
+ * @param   cnf - AF_DATA_CONFIRM_CMD message
+ *
+ * @return  none
+ */
+void zclOpenEvse_ReportConfirm(afDataConfirm_t *cnf)
+{
+  zclOpenEvse_evse_t *evse;
+  uint8 charger;
+  uint8 i;
+  uint8 reportClass;
+
+  zclOpenEvse_MeshConfirm(cnf->hdr.status);
+
+  if ((uint8)(cnf->transID - zclOpenEvse_zclTransID) < OPENEVSE_ZCL_TRANSID_AHEAD)
+  {
+    zclOpenEvse_zclTransID = cnf->transID + 1;
+    return;
+  }
+  evse = zclOpenEvse_EVSEByEndpoint(cnf->endpoint);
+  charger = (uint8)(evse - zclOpenEvse_evse);
+
+  for (i = 0; i < OPENEVSE_REPORT_INFLIGHT; i++)
+  {
+    if ( (zclOpenEvse_inflight[i].charger == charger) && (zclOpenEvse_inflight[i].transID == cnf->transID) )
+    {
+      break;
+    }
+  }
+  if ( (i == OPENEVSE_REPORT_INFLIGHT) || (evse->endpoint != cnf->endpoint) )
+  {
+    return;
+  }
+  reportClass = zclOpenEvse_inflight[i].reportClass;
+  zclOpenEvse_inflight[i].charger = 0xFF;
+
+  if (cnf->hdr.status == ZSuccess)
+  {
+    evse->delivery[reportClass].delivered++;
+    if (reportClass == REPORT_ALERT)
+    {
+      evse->alertsCleared &= ~evse->alertsClearedSent; // The hub has seen them go
+    }
+    return;
+  }
+  evse->delivery[reportClass].failed++;
+
+  // Send the class again, with its newest value, unless a newer one is already queued
+  if ( (zclOpenEvse_reportAcked & BV(reportClass)) && !(evse->reportPending & BV(reportClass)) &&
+       (evse->reportRetries[reportClass] < OPENEVSE_REPORT_RETRIES) )
+  {
+    evse->reportRetries[reportClass]++;
+    evse->delivery[reportClass].retried++;
+    evse->reportRequested[reportClass] = (uint16)osal_GetSystemClock();
+    evse->reportPending |= BV(reportClass);
+    zclOpenEvse_ReportFlush();
+  }
+}
+
+// Estimated over-the-air size of the frames in a report class
+uint16 zclOpenEvse_ReportBytes(uint8 reportClass)
+{
+  uint16 bytes = 0;
+  uint8 i;
+
+  for (i = zclOpenEvse_reportFirst[reportClass]; i < zclOpenEvse_reportFirst[reportClass+1]; i++)
+  {
+    if (i >= OPENEVSE_REPORT_CMDS)
+    {
+      // ZCL header, then every alert with its count, or the event header and ID
+      bytes += OPENEVSE_REPORT_OVERHEAD + 3 + ((reportClass == REPORT_ALERT) ? 1 + 3 * OPENEVSE_ALERTS : 2);
+    }
+    else
+    {
+      // ZCL header, then attribute ID, data type and value
+      bytes += OPENEVSE_REPORT_OVERHEAD + 3 + 3 + zclGetDataTypeLength(zclOpenEvse_reportFrames[i].dataType);
+    }
+  }
+  return bytes;
+}
+
+// Add tokens for the time since the last refill, up to the bucket depth
+void zclOpenEvse_BudgetRefill(void)
+{
+  uint32 now = osal_GetSystemClock();
+  uint32 elapsed = now - zclOpenEvse_budgetLastRefill;
+
+  zclOpenEvse_budgetLastRefill = now;
+  if (elapsed > OPENEVSE_BUDGET_DEPTH)
+  {
+    elapsed = OPENEVSE_BUDGET_DEPTH;
+  }
+
+  zclOpenEvse_budgetFrameTokens += (uint32)zclOpenEvse_budgetFrames * elapsed;
+  if (zclOpenEvse_budgetFrameTokens > (uint32)zclOpenEvse_budgetFrames * OPENEVSE_BUDGET_DEPTH)
+  {
+    zclOpenEvse_budgetFrameTokens = (uint32)zclOpenEvse_budgetFrames * OPENEVSE_BUDGET_DEPTH;
+  }
+  zclOpenEvse_budgetByteTokens += (uint32)zclOpenEvse_budgetBytes * elapsed;
+  if (zclOpenEvse_budgetByteTokens > (uint32)zclOpenEvse_budgetBytes * OPENEVSE_BUDGET_DEPTH)
+  {
+    zclOpenEvse_budgetByteTokens = (uint32)zclOpenEvse_budgetBytes * OPENEVSE_BUDGET_DEPTH;
+  }
+}
+
+// Fold the result of a report send into the failure rate, 1/8 weight each
+void zclOpenEvse_MeshConfirm(uint8 status)
+{
+  uint16 rate = zclOpenEvse_sendFailRate - (zclOpenEvse_sendFailRate >> 3);
+
+  if (status != ZSuccess)
+  {
+    zclOpenEvse_sendFailed++;
+    rate += 256 / 8;
+  }
+  zclOpenEvse_sendFailRate = (rate > 0xFF) ? 0xFF : (uint8)rate;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_MeshStretch
+ *
+ * @brief   Take one step of the report stretch towards what the parent
+ *          link can carry: up while its LQI is weak or sends are failing,
+ *          down once both are good again. State and energy reports are
+ *          never stretched.
+ *
+ * @param   none
+ *
+ * @return  shift for the power and temperature report periods
+ */
+uint8 zclOpenEvse_MeshStretch(void)
+{
+  associated_devices_t *parent = AssocGetWithShort( NLME_GetCoordShortAddr() );
+  uint8 max = zclOpenEvse_reportStretchMax;
+
+  if (parent != NULL)
+  {
+    zclOpenEvse_parentLqi = parent->linkInfo.rxLqi;
+  }
+  if (max > OPENEVSE_STRETCH_LIMIT)
+  {
+    max = OPENEVSE_STRETCH_LIMIT;
+  }
+
+  if ( (zclOpenEvse_parentLqi < OPENEVSE_LQI_WEAK) || (zclOpenEvse_sendFailRate >= OPENEVSE_FAIL_BUSY) )
+  {
+    if (zclOpenEvse_reportStretch < max)
+    {
+      zclOpenEvse_reportStretch++;
+    }
+  }
+  else if ( (zclOpenEvse_parentLqi >= OPENEVSE_LQI_GOOD) && (zclOpenEvse_sendFailRate < OPENEVSE_FAIL_CLEAR) &&
+            (zclOpenEvse_reportStretch > 0) )
+  {
+    zclOpenEvse_reportStretch--;
+  }
+  if (zclOpenEvse_reportStretch > max)
+  {
+    zclOpenEvse_reportStretch = max; // Maximum was lowered
+  }
+  return zclOpenEvse_reportStretch;
+}
+
+void zclOpenEvse_zigbeeReset(void)
+{
+  int i;
+  
+  for (i = HAL_NV_PAGE_BEG; i <= (HAL_NV_PAGE_BEG + HAL_NV_PAGE_CNT); i++)
+  {
+    HalFlashErase(i);
+  }
+  Onboard_soft_reset();
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_JitterInit
+ *
+ * @brief   Seed the phase jitter generator from the IEEE address so
+ *          every device gets a stable but distinct report phase.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zclOpenEvse_JitterInit(void)
+{
+  uint8 *extAddr = NLME_GetExtAddr();
+  uint16 seed = 0;
+  uint8 i;
+
+  for (i = 0; i < Z_EXTADDR_LEN; i++)
+  {
+    seed = (seed * 31) + extAddr[i];
+  }
+  if (seed == 0)
+  {
+    seed = 0xACE1; // xorshift must not be seeded with zero
+  }
+  zclOpenEvse_jitterSeed = seed;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_Jitter
+ *
+ * @brief   16-bit xorshift step, scaled to 0..range-1.
+ *
+ * @param   range - exclusive upper bound, 0 for no jitter
+ *
+ * @return  jitter value
+ */
+uint16 zclOpenEvse_Jitter(uint16 range)
+{
+  uint16 x = zclOpenEvse_jitterSeed;
+
+  x ^= x << 7;
+  x ^= x >> 9;
+  x ^= x << 8;
+  zclOpenEvse_jitterSeed = x;
+
+  if (range == 0)
+  {
+    return 0;
+  }
+  return x % range;
+}
+
+// Pick how many main loop passes to wait before the next report sweep
+void zclOpenEvse_SyncDelay(zclOpenEvse_evse_t *evse)
+{
+  evse->syncDelay = zclOpenEvse_Jitter(zclOpenEvse_reportJitter) / (3 * POLL_EVSE_PERIOD);
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LocalTime
+ *
+ * @brief   Local time on the OSAL clock, by the Time cluster rules: the
+ *          zone, plus the DST shift from its start to its end.
+ *
+ * @param   none
+ *
+ * @return  seconds since 2000-01-01 00:00 local
+ */
+UTCTime zclOpenEvse_LocalTime(void)
+{
+  UTCTime utc = osal_getClock();
+  UTCTime local = utc + zclOpenEvse_timeZone;
+
+  if (utc >= zclOpenEvse_dstStart && utc < zclOpenEvse_dstEnd)
+  {
+    local += zclOpenEvse_dstShift;
+  }
+  return local;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_TimeSet
+ *
+ * @brief   Set the OSAL clock and have every charger look at its
+ *          schedule again on the new time.
+ *
+ * @param   utc - seconds since 2000-01-01 00:00 UTC
+ * @param   source - OPENEVSE_TIME_RTC or OPENEVSE_TIME_ZCL
+ *
+ * @return  none
+ */
+void zclOpenEvse_TimeSet(UTCTime utc, uint8 source)
+{
+  uint8 i;
+
+  osal_setClock(utc);
+  zclOpenEvse_timeSource = source;
+  if (source == OPENEVSE_TIME_ZCL)
+  {
+    zclOpenEvse_timeStatus |= OPENEVSE_TIME_STATUS_SYNCHRONIZED;
+  }
+  for (i = 0; i < zclOpenEvse_numEvse; i++)
+  {
+    osal_set_event( zclOpenEvse_evse[i].taskId, OPENEVSE_TOU_EVT );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_RtcTime
+ *
+ * @brief   Take the time from a $GT reply. Until the Time cluster has
+ *          set the clock, the DS3231 sets it: it keeps local time, so
+ *          the zone and DST shift come off. After that the first reply
+ *          gives the RTC's offset from the network's time and later ones
+ *          keep the clock on it, so the module's crystal doesn't carry
+ *          it away while the coordinator is out of reach.
+ *
+ * @param   evse - charger
+ * @param   rxData - $GT reply, "OK yr mo day hr min sec"
+ *
+ * @return  FALSE if the reply didn't parse
+ */
+uint8 zclOpenEvse_RtcTime(zclOpenEvse_evse_t *evse, char * rxData)
+{
+  UTCTimeStruct tm;
+  UTCTime rtc;
+  UTCTime utc;
+  char * field[6];
+  uint8 i;
+
+  field[0] = strtok(&rxData[3], " ");
+  for (i = 1; i < 6; i++)
+  {
+    field[i] = strtok(NULL, " ");
+  }
+  if (!field[5])
+  {
+    return FALSE;
+  }
+
+  tm.year = 2000 + atoi(field[0]);
+  tm.month = (uint8)(atoi(field[1]) - 1);
+  tm.day = (uint8)(atoi(field[2]) - 1);
+  tm.hour = (uint8)atoi(field[3]);
+  tm.minutes = (uint8)atoi(field[4]);
+  tm.seconds = (uint8)atoi(field[5]);
+  if (tm.year >= 2100 || tm.month >= 12 || tm.day >= 31 || tm.hour >= 24 || tm.minutes >= 60 ||
+      tm.seconds >= 60)
+  {
+    return TRUE; // An EVSE without an RTC answers with 165s
+  }
+  rtc = osal_ConvertUTCSecs(&tm);
+
+  if (zclOpenEvse_timeSource == OPENEVSE_TIME_ZCL)
+  {
+    if (!evse->rtcOffsetSet)
+    {
+      evse->rtcOffset = (int32)(osal_getClock() - rtc);
+      evse->rtcOffsetSet = TRUE;
+    }
+    else
+    {
+      zclOpenEvse_TimeSet(rtc + evse->rtcOffset, OPENEVSE_TIME_ZCL);
+    }
+    return TRUE;
+  }
+
+  utc = rtc - zclOpenEvse_timeZone;
+  if (utc - zclOpenEvse_dstShift >= zclOpenEvse_dstStart && utc - zclOpenEvse_dstShift < zclOpenEvse_dstEnd)
+  {
+    utc -= zclOpenEvse_dstShift;
+  }
+  zclOpenEvse_TimeSet(utc, OPENEVSE_TIME_RTC);
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_TouWindow
+ *
+ * @brief   Find the schedule window a local time falls in. A window
+ *          that stops at or before its start runs past midnight into
+ *          the next day.
+ *
+ * @param   evse - charger
+ * @param   local - seconds since 2000-01-01 00:00 local
+ *
+ * @return  window index, or OPENEVSE_TOU_NONE
+ */
+uint8 zclOpenEvse_TouWindow(zclOpenEvse_evse_t *evse, UTCTime local)
+{
+  uint16 minute = (uint16)((local % OPENEVSE_DAY_SECS) / 60);
+  uint8 day = (uint8)((local / OPENEVSE_DAY_SECS + 6) % 7); // 1 January 2000 was a Saturday
+  uint8 yesterday = (day + 6) % 7;
+  zclOpenEvse_touWindow_t *w;
+  uint8 i;
+
+  for (i = 0; i < evse->tou.count; i++)
+  {
+    w = &evse->tou.window[i];
+    if (w->start < w->stop)
+    {
+      if ((w->days & BV(day)) && minute >= w->start && minute < w->stop)
+      {
+        return i;
+      }
+    }
+    else if (((w->days & BV(day)) && minute >= w->start) ||
+             ((w->days & BV(yesterday)) && minute < w->stop))
+    {
+      return i;
+    }
+  }
+  return OPENEVSE_TOU_NONE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_TouRun
+ *
+ * @brief   Run a charger's schedule, once a minute on the minute. On
+ *          entering a window the charger is enabled and, if the window
+ *          has a current, the pilot set to it; on leaving every window
+ *          it is put to sleep and the EVSE's own current put back. The
+ *          poll loop sends the $SC, $FE or $FS. Only the edges act, so
+ *          an On/Off from the hub holds until the next one.
+ *
+ * @param   evse - charger
+ *
+ * @return  none
+ */
+void zclOpenEvse_TouRun(zclOpenEvse_evse_t *evse)
+{
+  UTCTime local = zclOpenEvse_LocalTime();
+  uint8 active;
+  uint8 amps;
+
+  if (evse->tou.count == 0)
+  {
+    evse->touActive = OPENEVSE_TOU_NONE;
+    return; // Nothing to run until a schedule is written
+  }
+
+  // Ask the RTC every minute while there is no clock, then every hour
+  if (zclOpenEvse_timeSource == OPENEVSE_TIME_NONE || local % 3600 < 60)
+  {
+    evse->touRtc = TRUE;
+  }
+
+  // The EVSE's own current has to be known, to be put back
+  if (zclOpenEvse_timeSource != OPENEVSE_TIME_NONE && evse->wantAmps != 0)
+  {
+    active = zclOpenEvse_TouWindow(evse, local);
+    if (active != evse->touActive)
+    {
+      evse->OnOff = (active != OPENEVSE_TOU_NONE) ? LIGHT_ON : LIGHT_OFF;
+      amps = (active != OPENEVSE_TOU_NONE) ? evse->tou.window[active].amps : 0;
+      if (amps != 0 && evse->tou.restoreAmps == 0)
+      {
+        evse->tou.restoreAmps = evse->wantAmps;
+        zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_TOU_NV), 0, sizeof(evse->tou), &evse->tou );
+      }
+      else if (amps == 0 && evse->tou.restoreAmps != 0)
+      {
+        amps = evse->tou.restoreAmps;
+        evse->tou.restoreAmps = 0;
+        zcl_nv_write( OPENEVSE_EVSE_NV(evse, OPENEVSE_TOU_NV), 0, sizeof(evse->tou), &evse->tou );
+      }
+      zclOpenEvse_LevelStop(evse); // The edge wins over a ramp still running
+      evse->setAmps = (amps != evse->wantAmps) ? amps : 0;
+      evse->touActive = active;
+    }
+  }
+  // On the minute; the OSAL clock ticks its seconds with the system clock
+  osal_start_timerEx( evse->taskId, OPENEVSE_TOU_EVT, (60 - local % 60) * 1000UL - osal_GetSystemClock() % 1000 );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_EVSEState
+ *
+ * @brief   Take a new EVSE state, from a $ST or a $GS that found it
+ *          changed, and report it.
+ *
+ * @param   evse - charger
+ * @param   state - EVSE state, 0xFE for sleeping
+ *
+ * @return  none
+ */
+static void zclOpenEvse_EVSEState(zclOpenEvse_evse_t *evse, uint8 state)
+{
+  if (evse->backlight == LIGHT_OFF) // Turn backlight back off after change of state
+  {
+    osal_start_timerEx( evse->taskId, OPENEVSE_BACKLIGHT_OFF_EVT, 5000 );
+  }
+  if (state == 0xFE)
+  {
+    evse->OnOff = LIGHT_OFF;
+  }
+  else
+  {
+    evse->OnOff = LIGHT_ON;
+  }
+  evse->lastOnOff = evse->OnOff;
+  if (evse->state == 0x03 && state == 0x02)
+  {
+    zclOpenEvse_Event(evse, OPENEVSE_EVENT_END_OF_CYCLE);
+  }
+  else if (evse->state < 0xFE && state >= 0xFE)
+  {
+    zclOpenEvse_Event(evse, OPENEVSE_EVENT_SWITCHING_OFF);
+  }
+  evse->state = state;
+  zclOpenEvse_Alerts(evse);
+  zclOpenEvse_sendState(evse);
+}
+
+void zclOpenEvse_EVSESetLimit(zclOpenEvse_evse_t *evse, uint32 limit)
+{
+  if (limit == OPENEVSE_LIMIT_NONE)
+  {
+    limit = 0;
+  }
+  zclOpenEvse_EVSEWriteCmd(evse, EVSE_CMD_SETLIMIT, 1, (int32)limit);
+}
+
+void zclOpenEvse_EVSEWriteCmd(zclOpenEvse_evse_t *evse, uint8 command, uint8 numArgs, ...)
+{
+  char * string = evse->frame;
+  int strLen = 4;
+  unsigned char chk = 0;
+  va_list valist;
+  int i;
+
+  evse->cmd = command;
+  evse->resendCtr = 0;
+  evse->retryDue = FALSE;
+  evse->background = FALSE;
+  evse->cmdStart = osal_GetSystemClock();
+  evse->link.sent++;
+  
+  strcpy(&string[1], (const char *)evseCode[command]);
+
+  va_start(valist, numArgs);
+
+  for (i = 0; i < numArgs && i < 3; i++)
+  {
+    sprintf(string + strlen(string), " %ld", va_arg(valist, int32));
+  }
+
+  va_end(valist);
+
+  if (command == EVSE_CMD_SETCURRENT && evse->sentVolatile)
+  {
+    strcat(string, " V"); // Not saved by the EVSE
+  }
+
+  for (strLen = 0; strLen < strlen(string); strLen ++)
+  {
+    chk ^= string[strLen];
+  }
+  string[strLen++] = '^';
+  *((uint16 *)(&string[strLen++])) = zclOpenEvse_u8tohex(chk);
+  strLen++;
+  string[strLen++] = '\r';
+  string[strLen++] = 0;
+  evse->frameLen = strLen;
+
+  zclOpenEvse_EVSESendFrame(evse);
+}
+
+void zclOpenEvse_EVSESendFrame(zclOpenEvse_evse_t *evse)
+{
+  OPENEVSE_POWER(evse, PWRMGR_HOLD);
+  HalUARTWrite(evse->port, (uint8 *)evse->frame, evse->frameLen);
+  evse->sentAt = osal_GetSystemClock();
+  osal_start_timerEx( evse->taskId, OPENEVSE_CMD_TIMEOUT_EVT,
+                      evse->ready ? OPENEVSE_CMD_TIMEOUT : OPENEVSE_PROBE_TIMEOUT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_EVSEResend
+ *
+ * @brief   The current command failed (no reply, bad checksum, $NK or a
+ *          short reply). Schedule a resend of the exact frame after an
+ *          exponential backoff, or give up and count the failure once
+ *          the retries are used.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zclOpenEvse_EVSEResend(zclOpenEvse_evse_t *evse)
+{
+  uint32 backoff;
+
+  if (evse->background || (!evse->ready && evse->cmd == EVSE_CMD_GETSTATE))
+  {
+    // Background command or readiness probe went unanswered, the poll loop sends the next one
+    OPENEVSE_TRACE(evse, evse->cmd, evse->frameLen, OPENEVSE_TRACE_DROPPED, evse->resendCtr,
+                   osal_GetSystemClock() - evse->cmdStart);
+    evse->cmd = EVSE_CMD_NONE;
+    osal_stop_timerEx( evse->taskId, OPENEVSE_CMD_TIMEOUT_EVT );
+    OPENEVSE_POWER(evse, PWRMGR_CONSERVE);
+    return;
+  }
+
+  if (evse->retryDue)
+  {
+    return; // Resend already scheduled
+  }
+
+  if (evse->resendCtr >= OPENEVSE_CMD_RETRIES)
+  {
+    evse->failures[evse->cmd]++;
+    evse->link.abandoned++;
+    OPENEVSE_TRACE(evse, evse->cmd, evse->frameLen, OPENEVSE_TRACE_FAILED, evse->resendCtr,
+                   osal_GetSystemClock() - evse->cmdStart);
+    if (evse->cmd == EVSE_CMD_SETLIMIT && evse->limitWrite.state == LIMIT_WRITE_SENT)
+    {
+      zclOpenEvse_LimitWriteDone(evse, ZCL_STATUS_FAILURE);
+    }
+    evse->cmd = EVSE_CMD_NONE;
+    evse->resendCtr = 0;
+    osal_stop_timerEx( evse->taskId, OPENEVSE_CMD_TIMEOUT_EVT );
+    OPENEVSE_POWER(evse, PWRMGR_CONSERVE);
+    return;
+  }
+
+  backoff = (uint32)OPENEVSE_RETRY_BACKOFF << evse->resendCtr;
+  if (backoff > OPENEVSE_RETRY_BACKOFF_MAX)
+  {
+    backoff = OPENEVSE_RETRY_BACKOFF_MAX;
+  }
+  evse->retryDue = TRUE;
+  osal_start_timerEx( evse->taskId, OPENEVSE_CMD_TIMEOUT_EVT, backoff );
+}
+
+void zclOpenEvse_UARTInit(zclOpenEvse_evse_t *evse)
+{
+  halUARTCfg_t uartConfig;
+
+  /* UART Configuration */
+  uartConfig.configured           = TRUE;
+  uartConfig.baudRate             = HAL_UART_BR_115200;
+#if defined OPENEVSE_UART_FLOW
+  uartConfig.flowControl          = HAL_UART_FLOW_ON; // RTS/CTS wired to the EVSE
+#else
+  uartConfig.flowControl          = HAL_UART_FLOW_OFF;
+#endif
+  uartConfig.flowControlThreshold = HAL_UART_DMA_RX_MAX >> 1;
+  uartConfig.rx.maxBufSize        = HAL_UART_DMA_RX_MAX;
+  uartConfig.tx.maxBufSize        = HAL_UART_DMA_RX_MAX;
+  uartConfig.idleTimeout          = 50;
+  uartConfig.intEnable            = TRUE;
+  uartConfig.callBackFunc         = zclOpenEvse_UARTCallback;
+
+  /* Start UART */
+  HalUARTOpen(evse->port, &uartConfig);
+}
+
+void zclOpenEvse_UARTCallback(uint8 port, uint8 event)
+{
+  zclOpenEvse_evse_t *evse = zclOpenEvse_EVSEByPort(port);
+
+  uint8 ch;
+
+  // The ring filled up before this poll and may have lost bytes already
+  // (HAL_UART_RX_ABOUT_FULL needs nothing more than reading it all out)
+  if (event & HAL_UART_RX_FULL)
+  {
+    zclOpenEvse_UARTOverrun(evse);
+  }
+
+  while (Hal_UART_RxBufLen(port))
+  {
+    HalUARTRead (port, &ch, 1);
+    switch (ch)
+    {
+    case '$':
+      evse->rxIndex = 0;
+      evse->rxWaitSoc = FALSE;
+      break;
+    case '\r':
+      if (evse->rxWaitSoc)
+      {
+        break;
+      }
+      evse->rxData[evse->rxIndex] = 0;
+      evse->rxWaitSoc = TRUE;
+      zclOpenEvse_UARTParse(evse, (char *)evse->rxData);
+      break;
+    default:
+      if (evse->rxWaitSoc)
+      {
+        break;
+      }
+      if (evse->rxIndex >= (int8)(sizeof(evse->rxData) - 1))
+      {
+        zclOpenEvse_UARTOverrun(evse); // No frame is this long, a '\r' was lost
+        break;
+      }
+      evse->rxData[evse->rxIndex++] = ch;
+      break;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_UARTOverrun
+ *
+ * @brief   Input was lost to a full receive ring or line buffer. Drop
+ *          what is left of the frame up to the next '$', resend the
+ *          command in case its reply went with it, and re-read the
+ *          state in case a $ST did.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zclOpenEvse_UARTOverrun(zclOpenEvse_evse_t *evse)
+{
+  evse->link.rxOverflow++;
+  evse->rxWaitSoc = TRUE;
+  if (evse->cmd != EVSE_CMD_NONE)
+  {
+    zclOpenEvse_EVSEResend(evse);
+  }
+#if !defined OPENEVSE_SLEEPY
+  evse->resync = 2; // The end device build asks $GS every poll already
+#endif
+}
+
+
+void zclOpenEvse_UARTParse(zclOpenEvse_evse_t *evse, char * rxData)
+{
+  unsigned char chk = '$', i;
+  uint8 len = strlen(rxData);
+
+  if (len < 3) // Too short to hold a checksum, line noise
+  {
+    evse->link.checksum++;
+    zclOpenEvse_EVSEResend(evse);
+    return;
+  }
+
+  for (i = 0; i < len-3; i ++)
+  {
+    chk ^= (uint8)rxData[i];
+  }
+
+  if (chk != zclOpenEvse_hextou8(*((uint16 *)&rxData[i+1]))) // If bad checksum, resend
+  {
+    evse->link.checksum++;
+    zclOpenEvse_EVSEResend(evse);
+    return;
+  }
+
+  if (!strncmp((const char *)rxData, evseCode[EVSE_CMD_STATE], 2)) // Asynchronous state update
+  {
+    char * valid = NULL;
+    uint8 state = strtol((const char *)&rxData[3], &valid, 16);
+    if (valid)
+    {
+      OPENEVSE_TRACE(evse, EVSE_CMD_STATE, len, OPENEVSE_TRACE_ASYNC, 0, 0);
+      zclOpenEvse_EVSEState(evse, state);
+    }
+    return;
+  }
+  else if (!strncmp((const char *)rxData, evseCode[EVSE_CMD_WIFI], 2)) // Asynchronous wifi update
+  {
+    zclOpenEvse_zigbeeReset();
+    return;
+  } else if (strncmp((const char *)rxData, "OK", 2)) // If not OK resend
+  {
+    evse->link.nk++;
+    zclOpenEvse_EVSEResend(evse);
+    return;
+  }
+  
+  switch (evse->cmd)
+  {
+  case EVSE_CMD_GETPOWER:
+    {
+      char * amps = strtok(&rxData[3], " ");
+      char * volts = strtok(NULL, " ");
+      if (!amps || !volts)
+      {
+        evse->link.nk++;
+        zclOpenEvse_EVSEResend(evse);
+        return;
+      }
+      evse->noVoltmeter = (atol(volts) == -1);
+      if (!evse->noVoltmeter)
+      {
+        evse->voltsScaled = (uint16) (atol(volts) * 0.01);
+      }
+      else
+      {
+        evse->voltsScaled = (evse->powerLevel == 2) ? OPENEVSE_L2_VOLTS : OPENEVSE_L1_VOLTS;
+      }
+
+      if (atol(amps) != -1)
+      {
+        evse->ampsScaled = (uint16) (atol(amps) * 0.01);
+      }
+      evse->wattsScaled = (int16) ((float)evse->voltsScaled * (float)evse->ampsScaled * 0.001);
+      zclOpenEvse_Alerts(evse);
+    }
+    break;
+  case EVSE_CMD_GETTEMP:
+    {
+      char * ds3231 = strtok(&rxData[3], " ");
+      char * mcp9808 = strtok(NULL, " ");
+      char * tmp007 = strtok(NULL, " ");
+      if (!ds3231 || !mcp9808 || !tmp007)
+      {
+        evse->link.nk++;
+        zclOpenEvse_EVSEResend(evse);
+        return;
+      }
+      evse->temperature = (int16) (atoi(ds3231) * (1.0 / 10)); // Tenths of degree C to degrees C
+      // Sensors the EVSE doesn't have read lowest of all
+      evse->tempMax = (int16)atoi(ds3231);
+      if ((int16)atoi(mcp9808) > evse->tempMax)
+      {
+        evse->tempMax = (int16)atoi(mcp9808);
+      }
+      if ((int16)atoi(tmp007) > evse->tempMax)
+      {
+        evse->tempMax = (int16)atoi(tmp007);
+      }
+      zclOpenEvse_Thermal(evse);
+      zclOpenEvse_Alerts(evse);
+    }
+    break;
+  case EVSE_CMD_GETENERGY:
+    {
+      char * wattSecs = strtok(&rxData[3], " ");
+      char * wattAcc = strtok(NULL, " ");
+      if (!wattSecs || !wattAcc)
+      {
+        evse->link.nk++;
+        zclOpenEvse_EVSEResend(evse);
+        return;
+      }
+      evse->energyDemand = (uint32) (atol(wattSecs) * (1.0 / 3600)); // Convert watt-seconds to watt-hours
+      zclOpenEvse_Energy(evse, (uint32) strtoul(wattAcc, NULL, 10)); // Already in watt-hours
+    }
+    break;
+  case EVSE_CMD_GETSTATE:
+    {
+      // Later RAPI answers in hex, as $ST is sent, and earlier RAPI in
+      // decimal. They read alike up to 9, and a hex reading past the last
+      // error state and short of sleeping (0xFE) can only be decimal: 10, 11,
+      // 254 or 255.
+      char * valid = NULL;
+      uint32 value = strtoul((const char *)&rxData[3], &valid, 16);
+      uint8 state;
+      if (value >= OPENEVSE_ALERT_STATE_FIRST + OPENEVSE_ALERT_STATES && value < 0xFE)
+      {
+        value = strtoul((const char *)&rxData[3], &valid, 10);
+      }
+      state = (uint8)value;
+      if (evse->ready && valid != &rxData[3] && state != evse->state)
+      {
+        evse->resyncChanges++;
+        zclOpenEvse_EVSEState(evse, state); // Changed without a $ST reaching us
+      }
+      else if (valid != &rxData[3])
+      {
+        evse->state = state;
+      }
+      // Any answer means the EVSE is through its self test, unless it reads as state 0 (starting)
+      if (!evse->ready && (state != 0 || valid == &rxData[3]))
+      {
+        evse->ready = TRUE;
+        osal_set_event( evse->taskId, OPENEVSE_POLL_EVSE_EVT ); // Go on with initialization now
+      }
+    }
+    break;
+  case EVSE_CMD_GETSETTINGS:
+    {
+      char * amps = strtok(&rxData[3], " ");
+      char * flags = strtok(NULL, " ");
+      if (!amps || !flags)
+      {
+        evse->link.nk++;
+        zclOpenEvse_EVSEResend(evse);
+        return;
+      }
+
+      // Flags are hex; if bit 0 is set, power level is 2
+      zclOpenEvse_Settings(evse, (strtol(flags, NULL, 16) & 1) ? 2 : 1, (uint8)atoi(amps));
+    }
+    break;
+  case EVSE_CMD_SETCURRENT:
+    evse->pilotAmps = evse->sentAmps;
+    zclOpenEvse_sendLevel(evse);
+    break;
+  case EVSE_CMD_GETTIME:
+    if (!zclOpenEvse_RtcTime(evse, rxData))
+    {
+      evse->link.nk++;
+      zclOpenEvse_EVSEResend(evse);
+      return;
+    }
+    break;
+  case EVSE_CMD_SETLIMIT:
+    if (evse->limitWrite.state == LIMIT_WRITE_SENT)
+    {
+      zclOpenEvse_LimitWriteDone(evse, ZCL_STATUS_SUCCESS);
+    }
+    break;
+  }
+
+  evse->link.ok++;
+  if (evse->cmd != EVSE_CMD_NONE)
+  {
+    zclOpenEvse_LinkRtt(evse);
+    OPENEVSE_TRACE(evse, evse->cmd, evse->frameLen, OPENEVSE_TRACE_OK, evse->resendCtr,
+                   osal_GetSystemClock() - evse->cmdStart);
+  }
+  evse->cmd = EVSE_CMD_NONE;
+  evse->resendCtr = 0;
+  evse->retryDue = FALSE;
+  osal_stop_timerEx( evse->taskId, OPENEVSE_CMD_TIMEOUT_EVT );
+  OPENEVSE_POWER(evse, PWRMGR_CONSERVE);
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvse_LinkRtt
+ *
+ * @brief   Fold the round trip of the command just answered into the
+ *          link statistics: from the last time its frame went out to
+ *          the $OK.
+ *
+ * @param   evse - charger
+ *
+ * @return  none
+ */
+static void zclOpenEvse_LinkRtt(zclOpenEvse_evse_t *evse)
+{
+  uint32 elapsed = osal_GetSystemClock() - evse->sentAt;
+  uint16 rtt = elapsed > 0xFFFE ? 0xFFFE : (uint16)elapsed;
+
+  if (evse->link.rttMin == 0xFFFF) // First sample
+  {
+    evse->link.rttMin = rtt;
+    evse->link.rttAvg = rtt;
+    evse->link.rttMax = rtt;
+    return;
+  }
+  if (rtt < evse->link.rttMin)
+  {
+    evse->link.rttMin = rtt;
+  }
+  if (rtt > evse->link.rttMax)
+  {
+    evse->link.rttMax = rtt;
+  }
+  evse->link.rttAvg = (uint16)(((uint32)evse->link.rttAvg * 7 + rtt + 4) >> 3);
+}
+
+// converts 4-bit nibble to ascii hex
+uint8 zclOpenEvse_nibbletohex(uint8 value)
+{
+    if (value >= 10) return value - 10 + 'A';
+    return value + '0';
+}
+
+// converts ascii character to 4-bit nibble
+uint8 zclOpenEvse_hextonibble(uint8 value)
+{
+    if (value >= 'A') return value + 10 - 'A';
+    return value - '0';
+}
+
+// returns value as 2 ascii characters in a 16-bit int
+uint16 zclOpenEvse_u8tohex(uint8 value)
+{
+    uint16 hexdigits;
+
+    uint8 lodigit = (value >> 4);
+    uint8 hidigit = (value & 0x0F);
+    hexdigits = zclOpenEvse_nibbletohex(lodigit);
+    hexdigits |= (zclOpenEvse_nibbletohex(hidigit) << 8);
+
+    return hexdigits;
+}
+
+// value is 2 ascii characters in a 16-bit int
+uint8 zclOpenEvse_hextou8(uint16 value)
+{
+  uint8 chk;
+  uint8 lodigit = zclOpenEvse_hextonibble(value >> 8);
+  uint8 hidigit = zclOpenEvse_hextonibble(value & 0xFF);
+
+  chk = lodigit;
+  chk |= (hidigit << 4);
+
+  return chk;
+}
+/****************************************************************************
+****************************************************************************/
+
+
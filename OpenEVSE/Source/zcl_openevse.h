@@ -1,152 +1,549 @@
-/**************************************************************************************************
-  Filename:       zcl_openevse.h
-
-  Description:    This file contains the Zigbee Cluster Library Home
-                  Automation for OpenEVSE.
-
-
-  Copyright 2006-2014 Texas Instruments Incorporated. All rights reserved.
-  Copyright 2015 Ryan Press
-
-  IMPORTANT: Your use of this Software is limited to those specific rights
-  granted under the terms of a software license agreement between the user
-  who downloaded the software, his/her employer (which must be your employer)
-  and Texas Instruments Incorporated (the "License").  You may not use this
-  Software unless you agree to abide by the terms of the License. The License
-  limits your use, and you acknowledge, that the Software may not be modified,
-  copied or distributed unless embedded on a Texas Instruments microcontroller
-  or used solely and exclusively in conjunction with a Texas Instruments radio
-  frequency transceiver, which is integrated into your product.  Other than for
-  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
-  works of, modify, distribute, perform, display or sell this Software and/or
-  its documentation for any purpose.
-
-  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
-  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
-  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
-  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
-  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
-  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
-  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
-  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
-  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
-  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
-  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
-
-  Should you have any questions regarding your right to use this Software,
-  contact Texas Instruments Incorporated at www.TI.com.
-**************************************************************************************************/
-
-#ifndef ZCL_OPENEVSE_H
-#define ZCL_OPENEVSE_H
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-/*********************************************************************
- * INCLUDES
- */
-#include "zcl.h"
-
-/*********************************************************************
- * CONSTANTS
- */
-#define OPENEVSE_ENDPOINT            8
-
-#define LIGHT_OFF                       0x00
-#define LIGHT_ON                        0x01
-
-// Application Events
-#define OPENEVSE_POLL_CONTROL_TIMEOUT_EVT  0x0001
-#define OPENEVSE_POLL_EVSE_EVT             0x0002
-#define OPENEVSE_IDENTIFY_EVT              0x0004
-#define OPENEVSE_BACKLIGHT_OFF_EVT         0x0008
-#define OPENEVSE_GETPOWER_MIN_EVT          0x0010
-#define OPENEVSE_GETPOWER_MAX_EVT          0x0020
-#define OPENEVSE_GETTEMP_MAX_EVT           0x0040
-#define OPENEVSE_GETENERGY_MAX_EVT         0x0080
-#define OPENEVSE_CMD_TIMEOUT_EVT           0x0100
-  
-  // Application Display Modes
-#define LIGHT_MAINMODE      0x00
-#define LIGHT_HELPMODE      0x01
-
-#define ATTRID_CURRENT_SUM_DELIVERED 0x0000
-#define ATTRID_CURRENT_DEMAND_DELIVERED 0x0600
-#define ATTRID_CURRENT_DEMAND_LIMIT 0x0601
-  
-/*********************************************************************
- * MACROS
- */
-/*********************************************************************
- * TYPEDEFS
- */
-
-/*********************************************************************
- * VARIABLES
- */
-extern SimpleDescriptionFormat_t zclOpenEvse_SimpleDesc;
-extern SimpleDescriptionFormat_t zclOpenEvse_BlSimpleDesc;
-
-extern CONST zclCommandRec_t zclOpenEvse_Cmds[];
-
-extern CONST uint8 zclCmdsArraySize;
-
-// attribute list
-extern CONST zclAttrRec_t zclOpenEvse_Attrs[];
-extern CONST zclAttrRec_t zclOpenEvse_BlAttrs[];
-extern CONST uint8 zclOpenEvse_NumAttributes;
-extern CONST uint8 zclOpenEvse_BlNumAttributes;
-
-// Identify attributes
-extern uint16 zclOpenEvse_IdentifyTime;
-extern uint8  zclOpenEvse_IdentifyCommissionState;
-
-// OnOff attributes
-extern uint8  zclOpenEvse_OnOff;
-extern uint8  zclOpenEvse_backlight;
-
-// Device Temperature Configuration attributes
-extern int16  zclOpenEvse_temperature;
-
-// Multistate attributes
-extern uint16 zclOpenEvse_state;
-
-// Metering attributes
-extern uint8 zclOpenEvse_energySum[6];
-extern uint32 zclOpenEvse_energyDemand;
-extern uint32 zclOpenEvse_energyLimit;
-
-// Electrical Measurement attributes
-extern uint32 zclOpenEvse_elecMeasType;
-extern uint16 zclOpenEvse_voltsScaled;
-extern uint16 zclOpenEvse_ampsScaled;
-extern int16 zclOpenEvse_wattsScaled;
-extern uint16 zclOpenEvse_elecMeasMultiplier;
-extern uint16 zclOpenEvse_elecMeasDivisor;
-
-/*********************************************************************
- * FUNCTIONS
- */
-
- /*
-  * Initialization for the task
-  */
-extern void zclOpenEvse_Init( byte task_id );
-
-/*
- *  Event Process for the task
- */
-extern UINT16 zclOpenEvse_event_loop( byte task_id, UINT16 events );
-
-
-/*********************************************************************
-*********************************************************************/
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif /* ZCL_OPENEVSE_H */
+/**************************************************************************************************
+  Filename:       zcl_openevse.h
+
+  Description:    This file contains the Zigbee Cluster Library Home
+                  Automation for OpenEVSE.
+
+
+  Copyright 2006-2014 Texas Instruments Incorporated. All rights reserved.
+  Copyright 2015 Ryan Press
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef ZCL_OPENEVSE_H
+#define ZCL_OPENEVSE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcl.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define OPENEVSE_ENDPOINT            8
+
+// Chargers served by this module, each on its own USART with an endpoint
+// pair: charger n at OPENEVSE_ENDPOINT+2n, its backlight one above. The
+// gateway build drives a second EVSE on USART1 and needs HAL_UART_ISR=2
+// next to the default USART0 DMA driver.
+#if defined OPENEVSE_GATEWAY
+#define OPENEVSE_NUM_EVSE            2
+#else
+#define OPENEVSE_NUM_EVSE            1
+#endif
+
+#define LIGHT_OFF                       0x00
+#define LIGHT_ON                        0x01
+
+// Application Events
+#define OPENEVSE_POLL_CONTROL_TIMEOUT_EVT  0x0001
+#define OPENEVSE_POLL_EVSE_EVT             0x0002
+#define OPENEVSE_IDENTIFY_EVT              0x0004
+#define OPENEVSE_BACKLIGHT_OFF_EVT         0x0008
+#define OPENEVSE_GETPOWER_MIN_EVT          0x0010
+#define OPENEVSE_GETPOWER_MAX_EVT          0x0020
+#define OPENEVSE_GETTEMP_MAX_EVT           0x0040
+#define OPENEVSE_GETENERGY_MAX_EVT         0x0080
+#define OPENEVSE_CMD_TIMEOUT_EVT           0x0100
+#define OPENEVSE_REPORT_BUDGET_EVT         0x0200
+#define OPENEVSE_LIMIT_WRITE_EVT           0x0400
+#define OPENEVSE_TOU_EVT                   0x0800
+#define OPENEVSE_LEVEL_EVT                 0x1000
+#define OPENEVSE_RESTORE_EVT               0x2000
+#define OPENEVSE_CHECK_IN_EVT              0x4000
+  
+  // Application Display Modes
+#define LIGHT_MAINMODE      0x00
+#define LIGHT_HELPMODE      0x01
+
+#define ATTRID_CURRENT_SUM_DELIVERED 0x0000
+#define ATTRID_CURRENT_DEMAND_DELIVERED 0x0600
+#define ATTRID_CURRENT_DEMAND_LIMIT 0x0601
+
+// Manufacturer-specific OpenEVSE statistics cluster
+#define ZCL_CLUSTER_ID_OPENEVSE_STATS 0xFC00
+
+#define ATTRID_OPENEVSE_REPORT_SENT 0x0000
+#define ATTRID_OPENEVSE_REPORT_DEFERRED 0x0001
+#define ATTRID_OPENEVSE_REPORT_DROPPED 0x0002    // the stack wouldn't send
+#define ATTRID_OPENEVSE_REPORT_ACKED 0x0003     // bit per report class sent with APS acks
+#define ATTRID_OPENEVSE_REPORT_MERGED 0x0004    // superseded by a newer value while waiting
+#define ATTRID_OPENEVSE_BUDGET_FRAMES 0x0010
+#define ATTRID_OPENEVSE_BUDGET_BYTES 0x0011
+// Mesh link seen by the reports, shared by all chargers
+#define ATTRID_OPENEVSE_MESH_PARENT_LQI 0x0020
+#define ATTRID_OPENEVSE_MESH_FAIL_RATE 0x0021   // of recent sends, in 256ths
+#define ATTRID_OPENEVSE_MESH_SEND_FAILED 0x0022
+#define ATTRID_OPENEVSE_MESH_STRETCH 0x0023     // power and temperature periods are << this
+#define ATTRID_OPENEVSE_MESH_STRETCH_MAX 0x0024 // 0 keeps the configured periods
+#define ATTRID_OPENEVSE_LINK_SENT 0x0100
+#define ATTRID_OPENEVSE_LINK_OK 0x0101
+#define ATTRID_OPENEVSE_LINK_NK 0x0102
+#define ATTRID_OPENEVSE_LINK_CHECKSUM 0x0103
+#define ATTRID_OPENEVSE_LINK_RESENDS 0x0104
+#define ATTRID_OPENEVSE_LINK_ABANDONED 0x0105
+#define ATTRID_OPENEVSE_LINK_RX_OVERFLOW 0x0106
+#define ATTRID_OPENEVSE_LINK_RTT_MIN 0x0110
+#define ATTRID_OPENEVSE_LINK_RTT_AVG 0x0111
+#define ATTRID_OPENEVSE_LINK_RTT_MAX 0x0112
+// Event loop profile, only with OPENEVSE_PROFILE. One octet string per
+// event bit: calls, then the time histogram, all uint16.
+#define ATTRID_OPENEVSE_PROFILE_EVENT 0x0200  // + bit number, 0-15
+#define ATTRID_OPENEVSE_PROFILE_QUEUE_MAX 0x0210
+#define ATTRID_OPENEVSE_PROFILE_HEAP_HIGH 0x0211
+// Transaction trace. TRACE_SEQ counts entries since power-up, the chunk
+// holds up to OPENEVSE_TRACE_CHUNK entries from TRACE_CURSOR on, after
+// the sequence number of the first one (uint16). Each entry is 10 bytes:
+// time (uint32 ms), id, length, result, charger << 4 | resends and
+// latency (uint16 ms), all little endian.
+#define ATTRID_OPENEVSE_TRACE_SEQ 0x0300
+#define ATTRID_OPENEVSE_TRACE_CURSOR 0x0301
+#define ATTRID_OPENEVSE_TRACE_CHUNK 0x0302
+// Report delivery per class of each charger, class n at these plus n << 4
+#define ATTRID_OPENEVSE_DELIVERY_SENT 0x0400
+#define ATTRID_OPENEVSE_DELIVERY_DELIVERED 0x0401
+#define ATTRID_OPENEVSE_DELIVERY_FAILED 0x0402
+#define ATTRID_OPENEVSE_DELIVERY_RETRIED 0x0403
+// Charging schedule of each charger, and where the module's clock came from
+#define ATTRID_OPENEVSE_TOU_SCHEDULE 0x0500
+#define ATTRID_OPENEVSE_TOU_ACTIVE 0x0501
+#define ATTRID_OPENEVSE_TIME_SOURCE 0x0502
+// Longest random wait, in ms, before a restore sent to a group takes effect
+#define ATTRID_OPENEVSE_RESTORE_JITTER 0x0600
+// Thermal throttling. Once the hottest sensor of a charger is THERMAL_START
+// or over, its pilot current comes down THERMAL_AMPS for each THERMAL_BAND
+// it is into, and goes back up a step when it is THERMAL_HYSTERESIS under
+// the band of that step. Temperatures are in tenths of a degree C.
+#define ATTRID_OPENEVSE_THERMAL_START 0x0700
+#define ATTRID_OPENEVSE_THERMAL_BAND 0x0701
+#define ATTRID_OPENEVSE_THERMAL_HYSTERESIS 0x0702
+#define ATTRID_OPENEVSE_THERMAL_AMPS 0x0703     // 0 turns throttling off
+#define ATTRID_OPENEVSE_THERMAL_TEMP 0x0704     // hottest sensor of the charger
+#define ATTRID_OPENEVSE_THERMAL_STEP 0x0705     // steps in force, reported when it changes
+// Firmware upgrade over the air, only with OPENEVSE_OTA
+#define ATTRID_OPENEVSE_OTA_STATUS 0x0800       // ImageUpgradeStatus of the OTA Upgrade cluster
+#define ATTRID_OPENEVSE_OTA_FILE_OFFSET 0x0801  // bytes of the image downloaded
+#define ATTRID_OPENEVSE_OTA_FILE_VERSION 0x0802 // of the running image
+#define ATTRID_OPENEVSE_OTA_DOWNLOADED_VERSION 0x0803
+#define ATTRID_OPENEVSE_OTA_BLOCK_PERIOD 0x0804 // ms from one block request to the next
+#define ATTRID_OPENEVSE_OTA_BLOCK_RETRIES 0x0805
+// Appliance Events & Alerts. ALERTS is the bitmap of a charger's alerts in
+// force. The module raises two of its own: the hottest sensor at
+// ALERT_TEMP (tenths of a degree C) and the current drawn ALERT_AMPS over
+// the pilot; 0 turns either off.
+#define ATTRID_OPENEVSE_ALERTS 0x0900
+#define ATTRID_OPENEVSE_ALERT_TEMP 0x0901
+#define ATTRID_OPENEVSE_ALERT_AMPS 0x0902
+// Settings and state read again in the background every RESYNC_PERIOD
+// seconds (0 for never); RESYNC_CHANGES counts the changes found
+#define ATTRID_OPENEVSE_RESYNC_PERIOD 0x0A00
+#define ATTRID_OPENEVSE_RESYNC_CHANGES 0x0A01
+// Times the EVSE's energy count went back to 0 or wrapped, which
+// CurrentSummationDelivered carried on over
+#define ATTRID_OPENEVSE_ENERGY_RESETS 0x0B00
+// RAPI commands of each charger by command slot (EVSE_CMD_*): an octet
+// string of a uint16 per slot, resends and commands given up on
+#define ATTRID_OPENEVSE_CMD_RESENDS 0x0C00
+#define ATTRID_OPENEVSE_CMD_GIVEN_UP 0x0C01
+
+// Appliance Events & Alerts cluster commands
+#define OPENEVSE_ALERTS_CMD_GET_ALERTS 0x00           // client to server
+#define OPENEVSE_ALERTS_CMD_GET_ALERTS_RSP 0x00
+#define OPENEVSE_ALERTS_CMD_ALERTS_NOTIFICATION 0x01
+#define OPENEVSE_ALERTS_CMD_EVENT_NOTIFICATION 0x02
+
+// Alert structure, 24 bits little endian: alert ID, then category in the
+// low nibble of the second byte and recovery, the alert gone, above it
+#define OPENEVSE_ALERT_WARNING 0x01
+#define OPENEVSE_ALERT_DANGER 0x02
+#define OPENEVSE_ALERT_FAILURE 0x03
+#define OPENEVSE_ALERT_RECOVERY 0x10
+#define OPENEVSE_ALERTS 10            // bits of ATTRID_OPENEVSE_ALERTS
+
+// Event Notification event IDs
+#define OPENEVSE_EVENT_NONE 0x00
+#define OPENEVSE_EVENT_END_OF_CYCLE 0x01  // charging stopped with the car plugged in
+#define OPENEVSE_EVENT_SWITCHING_OFF 0x06 // the EVSE went to sleep or was disabled
+
+// Clock sources, in order of preference
+#define OPENEVSE_TIME_NONE 0
+#define OPENEVSE_TIME_RTC 1           // DS3231 on the EVSE, read with $GT
+#define OPENEVSE_TIME_ZCL 2           // Time attribute written over the network
+
+// TimeStatus bit of the Time cluster
+#define OPENEVSE_TIME_STATUS_SYNCHRONIZED 0x02
+
+// Weekly windows per charger
+#define OPENEVSE_TOU_WINDOWS 8
+#define OPENEVSE_TOU_NONE 0xFF        // TOU_ACTIVE outside every window
+
+// $GP reading of a sensor the EVSE doesn't have
+#define OPENEVSE_TEMP_INVALID (-2560)
+
+// Trace ring size, a power of two; 0 leaves the trace out
+#if !defined OPENEVSE_TRACE_ENTRIES
+#define OPENEVSE_TRACE_ENTRIES 32
+#endif
+#define OPENEVSE_TRACE_CHUNK 6
+
+// Trace entry id: the RAPI command, or a report class with this bit set
+#define OPENEVSE_TRACE_REPORT 0x80
+
+// Trace entry results
+#define OPENEVSE_TRACE_OK 0           // $OK, or report handed to the stack
+#define OPENEVSE_TRACE_FAILED 1       // given up after the last resend, or not sent
+#define OPENEVSE_TRACE_DROPPED 2      // background command or probe unanswered
+#define OPENEVSE_TRACE_ASYNC 3        // $ST from the EVSE
+#define OPENEVSE_TRACE_SUPERSEDED 4   // report replaced by a newer one before it went out
+  
+/*********************************************************************
+ * MACROS
+ */
+#define OPENEVSE_EVSE_ENDPOINT(n)    (OPENEVSE_ENDPOINT + 2 * (n))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+enum evseCmd { EVSE_CMD_NONE, EVSE_CMD_STATE, EVSE_CMD_WIFI, EVSE_CMD_SLEEP, EVSE_CMD_ENABLE,
+                  EVSE_CMD_LCDOFF, EVSE_CMD_LCDRGB, EVSE_CMD_LCDTEAL, EVSE_CMD_GETPOWER,
+                  EVSE_CMD_GETTEMP, EVSE_CMD_GETENERGY, EVSE_CMD_GETSTATE, EVSE_CMD_GETSETTINGS,
+                  EVSE_CMD_SETLIMIT, EVSE_CMD_SETCURRENT, EVSE_CMD_LCDGREEN, EVSE_CMD_GETTIME,
+                  EVSE_CMD_COUNT };
+
+#define OPENEVSE_REPORT_CMDS 10
+#define OPENEVSE_REPORT_CLASSES 8
+
+// A CurrentDemandLimit write on its way to the EVSE
+typedef struct
+{
+  uint8 state;
+  uint8 respond;        // Write Response owed to srcAddr once the EVSE answers
+  uint8 seqNum;
+  afAddrType_t srcAddr;
+  uint32 value;
+} zclOpenEvse_limitWrite_t;
+
+// RAPI link health, published in the statistics cluster of each charger
+typedef struct
+{
+  uint32 sent;          // commands written, not counting resends
+  uint32 ok;            // $OK replies
+  uint16 nk;            // $NK or replies that don't fit the command
+  uint16 checksum;      // replies with a bad or missing checksum
+  uint16 resends;
+  uint16 abandoned;     // commands given up on after the last resend
+  uint16 rxOverflow;    // frames dropped to a full receive ring or line buffer
+  uint16 rttMin;        // ms from the last send to its $OK, 0xFFFF until measured
+  uint16 rttAvg;        // moving average, 1/8 weight per reply
+  uint16 rttMax;
+} zclOpenEvse_linkStats_t;
+
+// Delivery of one report class, published in the statistics cluster of each charger
+typedef struct
+{
+  uint32 sent;          // frames handed to the stack
+  uint32 delivered;     // APS acknowledged, or through the first hop when not acknowledged
+  uint16 failed;        // refused by the stack, or confirmed as not delivered
+  uint16 retried;       // acknowledged class queued again after a failure
+} zclOpenEvse_delivery_t;
+
+// One weekly window of a charging schedule, in local time. The wire form
+// in ATTRID_OPENEVSE_TOU_SCHEDULE is the same 6 bytes, little endian.
+typedef struct
+{
+  uint8 days;           // bit 0 Sunday to bit 6 Saturday, the days it starts on
+  uint16 start;         // minute of the day
+  uint16 stop;          // minute of the day; at or before start runs into the next day
+  uint8 amps;           // pilot current while it is on, 0 to leave it alone
+} zclOpenEvse_touWindow_t;
+
+// Charging schedule of one charger, kept in NV
+typedef struct
+{
+  uint8 count;
+  uint8 restoreAmps;    // pilot current to put back once a window with amps is over, 0 for none
+  zclOpenEvse_touWindow_t window[OPENEVSE_TOU_WINDOWS];
+} zclOpenEvse_tou_t;
+
+// Energy delivered by one charger, kept in NV. The EVSE's own count goes
+// back to 0 when its EEPROM is cleared and wraps at 32 bits; this total
+// carries on across both.
+typedef struct
+{
+  uint32 totalLo;       // Wh, low 32 bits of the 48 of CurrentSummationDelivered
+  uint16 totalHi;
+  uint32 evseAcc;       // EVSE's count at the last reading
+} zclOpenEvse_energy_t;
+
+// Thermal throttling of one charger, kept in NV. The EVSE holds the cut
+// current, and gives it back in $GE after a restart, so the current asked
+// for under the cut is kept here.
+typedef struct
+{
+  uint8 step;           // thermal step in force
+  uint8 wantAmps;       // current asked for while it is, 0 with no step
+} zclOpenEvse_thermal_t;
+
+// Everything that belongs to one charger. The attributes come first, in
+// the order of OPENEVSE_EVSE_DEFAULTS in zcl_openevse_data.c.
+typedef struct
+{
+  // Attributes
+  uint8 OnOff;
+  uint8 backlight;
+  int16 temperature;
+  uint16 IdentifyTime;
+  uint16 state;
+  uint8 energySum[6];   // energy.total, little endian
+  uint32 energyDemand;
+  uint32 energyLimit;
+  uint16 voltsScaled;
+  uint16 ampsScaled;
+  int16 wattsScaled;
+
+  // Where it is
+  byte taskId;
+  uint8 endpoint;       // charger endpoint, the backlight is endpoint+1
+  uint8 port;
+
+  // RAPI command slot and resend state
+  uint8 cmd;
+  uint8 resendCtr;
+  uint8 retryDue;       // CMD_TIMEOUT_EVT is ending a backoff, not waiting for a reply
+  uint8 background;     // best effort: short wait for the reply, never resent
+  char frame[16+5];     // Command as sent, for resends
+  uint8 frameLen;
+  uint32 cmdStart;      // osal_GetSystemClock() at the first send
+  uint32 sentAt;        // osal_GetSystemClock() when the frame went out
+  uint16 retries[EVSE_CMD_COUNT];  // Resends per command, ATTRID_OPENEVSE_CMD_RESENDS
+  uint16 failures[EVSE_CMD_COUNT]; // Commands given up on, ATTRID_OPENEVSE_CMD_GIVEN_UP
+
+  // RAPI receive
+  uint8 rxWaitSoc;
+  int8 rxIndex;
+  uint8 rxData[34];
+
+  // Poll loop
+  uint8 pollNumber;
+  uint8 ready;          // EVSE has answered the readiness probe
+  uint8 probeCtr;
+  uint8 firstTime;
+  uint8 lastBacklight;
+  uint8 lastOnOff;
+  uint8 identColor;     // LCD command for the lit phases of the identify effect
+  uint8 identPhases;    // half-second phases of the effect left to run
+  uint8 identLcd;       // LCD command waiting for an identify slot
+  uint8 identTicks;     // poll ticks since the last identify slot
+  uint8 powerLevel;     // 1 or 2 from $GE, 0 before it answered
+  uint8 noVoltmeter;    // $GG gave no voltage, the level's is used
+  uint8 resync;         // $GS and $GE of a re-sync still to send
+  uint32 resyncLast;    // clock at the last re-sync
+  uint16 resyncChanges;
+  uint8 syncDelay;      // main loop passes to wait before the report sweep
+  uint16 lastVolts;
+  uint16 lastAmps;
+  int16 lastWatts;
+
+  // Pilot current, which Level Control's CurrentLevel reads in amps
+  uint8 pilotAmps;      // capacity the EVSE reported with $GE or took with $SC
+  uint8 wantAmps;       // asked for by Level, the schedule or the EVSE's own setting
+  uint8 setAmps;        // pilot current waiting to go out with $SC, 0 for none
+  uint8 sentAmps;       // $SC on the wire
+  uint8 sentVolatile;   // it is a ramp step or under a thermal cut, and goes with V
+  uint8 levelFrom;      // ramp from pilotAmps to levelTarget in levelSteps steps
+  uint8 levelTarget;
+  uint8 levelSteps;     // 0 when no ramp is running
+  uint8 levelStep;
+  uint32 levelStepMs;   // a slow ramp's steps run past 65 s
+  uint16 levelRemaining; // RemainingTime, tenths of a second
+
+  // Thermal throttling; the pilot is wantAmps less thermalStep steps
+  int16 tempMax;        // hottest valid sensor, tenths of a degree C
+  uint8 thermalStep;
+  uint32 thermalSince;  // clock at the last change of step
+  zclOpenEvse_thermal_t thermalSaved; // as last written to NV
+
+  // Appliance Events & Alerts
+  uint16 alerts;        // in force, once debounced
+  uint16 alertRaw;      // conditions at the last look
+  uint16 alertsCleared; // gone, and not yet in a notification that was delivered
+  uint16 alertsClearedSent; // of those, in the last notification sent
+  uint16 alertSince[OPENEVSE_ALERTS]; // low 16 bits of the clock when each condition last changed
+  uint8 event;          // Event Notification waiting to go out
+
+  // Restore sent to a group, held for OPENEVSE_RESTORE_EVT
+  uint8 restoreOn;      // turn the charger on
+  uint8 restoreLevel;   // pilot current to ramp to, 0 for none
+  uint16 restoreTime;   // transition time of the ramp
+
+  // Energy
+  zclOpenEvse_energy_t energy;
+  uint32 energySaved;   // energy.totalLo when it was last written to NV
+  uint8 energyDrop;     // the count fell at the last reading; a reset once the next agrees
+  uint16 energyResets;
+
+  // Charging schedule
+  zclOpenEvse_tou_t tou;
+  uint8 touActive;      // window the charger is in, OPENEVSE_TOU_NONE, or unknown
+  uint8 touRtc;         // $GT wanted
+  uint8 rtcOffsetSet;   // rtcOffset is good for this charger's RTC
+  int32 rtcOffset;      // clock minus RTC, taken after the Time cluster set the clock
+
+  // Reports
+  uint8 reportPending;  // bit per report class waiting for budget
+  uint8 reportDeferredMask;
+  uint16 reportRequested[OPENEVSE_REPORT_CLASSES]; // low 16 bits of the clock when each class was queued
+  uint8 reportRetries[OPENEVSE_REPORT_CLASSES];    // sent again since the last new value
+  zclReportCmd_t *reportCmd[OPENEVSE_REPORT_CMDS];
+
+  zclOpenEvse_limitWrite_t limitWrite;
+  zclOpenEvse_linkStats_t link;
+  zclOpenEvse_delivery_t delivery[OPENEVSE_REPORT_CLASSES];
+} zclOpenEvse_evse_t;
+
+#if defined OPENEVSE_PROFILE
+// Time per event bit in log2 buckets of sleep timer ticks (30.5us):
+// bucket 0 is under 2 ticks, bucket n is 2^n to 2^(n+1)-1 ticks and the
+// last bucket takes everything from 2^7 ticks (3.9ms) up
+#define OPENEVSE_PROFILE_BUCKETS 8
+
+typedef struct
+{
+  uint16 calls[16];
+  uint16 hist[16][OPENEVSE_PROFILE_BUCKETS];
+  uint8 queueMax;       // most messages drained in one SYS_EVENT_MSG
+} zclOpenEvse_profile_t;
+#endif
+
+/*********************************************************************
+ * VARIABLES
+ */
+extern SimpleDescriptionFormat_t zclOpenEvse_SimpleDesc[OPENEVSE_NUM_EVSE];
+extern SimpleDescriptionFormat_t zclOpenEvse_BlSimpleDesc[OPENEVSE_NUM_EVSE];
+
+extern CONST zclCommandRec_t zclOpenEvse_Cmds[];
+
+extern CONST uint8 zclCmdsArraySize;
+
+// attribute list
+extern CONST zclAttrRec_t zclOpenEvse_Attrs[];
+extern CONST zclAttrRec_t zclOpenEvse_BlAttrs[];
+extern CONST uint8 zclOpenEvse_NumAttributes;
+extern CONST uint8 zclOpenEvse_BlNumAttributes;
+
+// Per-charger attributes and state
+extern zclOpenEvse_evse_t zclOpenEvse_evse[OPENEVSE_NUM_EVSE];
+
+// Identify attributes
+extern uint8  zclOpenEvse_IdentifyCommissionState;
+
+// Electrical Measurement attributes
+extern uint32 zclOpenEvse_elecMeasType;
+extern uint16 zclOpenEvse_elecMeasMultiplier;
+extern uint16 zclOpenEvse_elecMeasDivisor;
+
+// OpenEVSE statistics attributes
+extern uint32 zclOpenEvse_reportSent;
+extern uint32 zclOpenEvse_reportDeferred;
+extern uint32 zclOpenEvse_reportDropped;
+extern uint8 zclOpenEvse_reportAcked;
+extern uint32 zclOpenEvse_reportMerged;
+extern uint16 zclOpenEvse_budgetFrames;
+extern uint16 zclOpenEvse_budgetBytes;
+extern uint8 zclOpenEvse_parentLqi;
+extern uint8 zclOpenEvse_sendFailRate;
+extern uint32 zclOpenEvse_sendFailed;
+extern uint8 zclOpenEvse_reportStretch;
+extern uint8 zclOpenEvse_reportStretchMax;
+extern uint8 zclOpenEvse_timeSource;
+extern uint16 zclOpenEvse_restoreJitter;
+extern int16 zclOpenEvse_thermalStart;
+extern uint16 zclOpenEvse_thermalBand;
+extern uint16 zclOpenEvse_thermalHysteresis;
+extern uint8 zclOpenEvse_thermalAmps;
+extern int16 zclOpenEvse_alertTemp;
+extern uint8 zclOpenEvse_alertAmps;
+extern uint16 zclOpenEvse_resyncPeriod;
+extern uint8 zclOpenEvse_timeStatus;
+extern int32 zclOpenEvse_timeZone;
+extern uint32 zclOpenEvse_dstStart;
+extern uint32 zclOpenEvse_dstEnd;
+extern int32 zclOpenEvse_dstShift;
+#if defined OPENEVSE_SLEEPY
+extern uint32 zclOpenEvse_checkInInterval;
+extern uint32 zclOpenEvse_longPollInterval;
+extern uint16 zclOpenEvse_shortPollInterval;
+extern uint16 zclOpenEvse_fastPollTimeout;
+#endif
+#if defined OPENEVSE_OTA
+extern uint8 zclOpenEvse_otaStatus;
+extern uint32 zclOpenEvse_otaFileOffset;
+extern uint32 zclOpenEvse_otaFileVersion;
+extern uint32 zclOpenEvse_otaDownloadedVersion;
+extern uint16 zclOpenEvse_otaBlockPeriod;
+extern uint16 zclOpenEvse_otaBlockRetries;
+#endif
+#if defined OPENEVSE_PROFILE
+extern zclOpenEvse_profile_t zclOpenEvse_profile;
+#endif
+#if OPENEVSE_TRACE_ENTRIES
+extern uint16 zclOpenEvse_traceSeq;
+extern uint16 zclOpenEvse_traceCursor;
+#endif
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+ /*
+  * Initialization for the task
+  */
+extern void zclOpenEvse_Init( byte task_id );
+
+/*
+ *  Event Process for the task
+ */
+extern UINT16 zclOpenEvse_event_loop( byte task_id, UINT16 events );
+
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZCL_OPENEVSE_H */
@@ -1,551 +1,1336 @@
-/**************************************************************************************************
-  Filename:       zcl_openevse_data.c
-
-  Description:    Zigbee Cluster Library - device data for OpenEVSE.
-
-
-  Copyright 2006-2014 Texas Instruments Incorporated. All rights reserved.
-  Copyright 2015 Ryan Press
-
-  IMPORTANT: Your use of this Software is limited to those specific rights
-  granted under the terms of a software license agreement between the user
-  who downloaded the software, his/her employer (which must be your employer)
-  and Texas Instruments Incorporated (the "License").  You may not use this
-  Software unless you agree to abide by the terms of the License. The License
-  limits your use, and you acknowledge, that the Software may not be modified,
-  copied or distributed unless embedded on a Texas Instruments microcontroller
-  or used solely and exclusively in conjunction with a Texas Instruments radio
-  frequency transceiver, which is integrated into your product.  Other than for
-  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
-  works of, modify, distribute, perform, display or sell this Software and/or
-  its documentation for any purpose.
-
-  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
-  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
-  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
-  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
-  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
-  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
-  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
-  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
-  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
-  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
-  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
-
-  Should you have any questions regarding your right to use this Software,
-  contact Texas Instruments Incorporated at www.TI.com.
-**************************************************************************************************/
-
-/*********************************************************************
- * INCLUDES
- */
-#include "ZComDef.h"
-#include "OSAL.h"
-#include "AF.h"
-#include "ZDConfig.h"
-
-#include "zcl.h"
-#include "zcl_general.h"
-#include "zcl_ha.h"
-#include "zcl_ezmode.h"
-#include "zcl_poll_control.h"
-#include "zcl_electrical_measurement.h"
-#include "zcl_meter_identification.h"
-#include "zcl_appliance_identification.h"
-#include "zcl_appliance_events_alerts.h"
-#include "zcl_power_profile.h"
-#include "zcl_appliance_control.h"
-#include "zcl_appliance_statistics.h"
-#include "zcl_hvac.h"
-
-#include "zcl_openevse.h"
-
-/*********************************************************************
- * CONSTANTS
- */
-
-#define OPENEVSE_DEVICE_VERSION     0
-#define OPENEVSE_FLAGS              0
-
-#define OPENEVSE_HWVERSION          1
-#define OPENEVSE_ZCLVERSION         1
-
-/*********************************************************************
- * TYPEDEFS
- */
-
-/*********************************************************************
- * MACROS
- */
-
-/*********************************************************************
- * GLOBAL VARIABLES
- */
-
-// Basic Cluster
-const uint8 zclOpenEvse_HWRevision = OPENEVSE_HWVERSION;
-const uint8 zclOpenEvse_ZCLVersion = OPENEVSE_ZCLVERSION;
-const uint8 zclOpenEvse_ManufacturerName[] = { 8, 'P','r','e','s','s','l','a','b' };
-const uint8 zclOpenEvse_ModelId[] = { 16, 'P','L','-','E','V','S','E','1',' ',' ',' ',' ',' ',' ',' ',' ' };
-const uint8 zclOpenEvse_DateCode[] = { 16, '2','0','1','5','1','2','2','3',' ',' ',' ',' ',' ',' ',' ',' ' };
-const uint8 zclOpenEvse_PowerSource = POWER_SOURCE_MAINS_1_PHASE;
-
-uint8 zclOpenEvse_LocationDescription[17] = { 16, ' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ' };
-uint8 zclOpenEvse_PhysicalEnvironment = 0;
-uint8 zclOpenEvse_DeviceEnable = DEVICE_ENABLED;
-
-// On/Off Cluster
-uint8 zclOpenEvse_OnOff = LIGHT_OFF;
-uint8 zclOpenEvse_backlight = LIGHT_ON;
-
-// Device Temperature Configuration attributes
-int16 zclOpenEvse_temperature = 20;
-
-// Identify attributes
-uint16 zclOpenEvse_IdentifyTime = 0;
-
-// Multistate attributes
-uint16 zclOpenEvse_state = 0;
-
-// Metering attributes
-uint8 zclOpenEvse_energySum[6] = {0};
-uint32 zclOpenEvse_energyDemand = 0;
-uint32 zclOpenEvse_energyLimit = 0xFFFFFF;
-
-// Electrical Measurement attributes
-uint32 zclOpenEvse_elecMeasType = 0;
-uint16 zclOpenEvse_voltsScaled = 0;
-uint16 zclOpenEvse_ampsScaled = 0;
-int16 zclOpenEvse_wattsScaled = 0;
-uint16 zclOpenEvse_elecMeasMultiplier = 10;
-uint16 zclOpenEvse_elecMeasDivisor = 1;
-uint16 zclOpenEvse_elecMeasWattsMultiplier = 1;
-uint16 zclOpenEvse_elecMeasWattsDivisor = 10;
-
-/*********************************************************************
- * ATTRIBUTE DEFINITIONS - Uses REAL cluster IDs
- */
-CONST zclAttrRec_t zclOpenEvse_Attrs[] =
-{
-  // *** General Basic Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,             // Cluster IDs - defined in the foundation (ie. zcl.h)
-    {  // Attribute record
-      ATTRID_BASIC_HW_VERSION,            // Attribute ID - Found in Cluster Library header (ie. zcl_general.h)
-      ZCL_DATATYPE_UINT8,                 // Data Type - found in zcl.h
-      ACCESS_CONTROL_READ,                // Variable access control - found in zcl.h
-      (void *)&zclOpenEvse_HWRevision  // Pointer to attribute variable
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_ZCL_VERSION,
-      ZCL_DATATYPE_UINT8,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_ZCLVersion
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_MANUFACTURER_NAME,
-      ZCL_DATATYPE_CHAR_STR,
-      ACCESS_CONTROL_READ,
-      (void *)zclOpenEvse_ManufacturerName
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_MODEL_ID,
-      ZCL_DATATYPE_CHAR_STR,
-      ACCESS_CONTROL_READ,
-      (void *)zclOpenEvse_ModelId
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_DATE_CODE,
-      ZCL_DATATYPE_CHAR_STR,
-      ACCESS_CONTROL_READ,
-      (void *)zclOpenEvse_DateCode
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_POWER_SOURCE,
-      ZCL_DATATYPE_UINT8,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_PowerSource
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_LOCATION_DESC,
-      ZCL_DATATYPE_CHAR_STR,
-      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
-      (void *)zclOpenEvse_LocationDescription
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_PHYSICAL_ENV,
-      ZCL_DATATYPE_UINT8,
-      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
-      (void *)&zclOpenEvse_PhysicalEnvironment
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_DEVICE_ENABLED,
-      ZCL_DATATYPE_BOOLEAN,
-      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
-      (void *)&zclOpenEvse_DeviceEnable
-    }
-  },
-
-  // *** Device Temperature Configuration Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG,
-    { // Attribute record
-      ATTRID_DEV_TEMP_CURRENT,
-      ZCL_DATATYPE_INT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_temperature
-    }
-  },
-
-  // *** On/Off Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_GEN_ON_OFF,
-    { // Attribute record
-      ATTRID_ON_OFF,
-      ZCL_DATATYPE_BOOLEAN,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_OnOff
-    }
-  },
-
-  // *** Multistate Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC,
-    { // Attribute record
-      ATTRID_IOV_BASIC_PRESENT_VALUE,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_state
-    }
-  },
-
-  // *** Metering Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_SE_METERING,
-    { // Attribute record
-      ATTRID_CURRENT_SUM_DELIVERED,
-      ZCL_DATATYPE_UINT48,
-      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
-      (void *)&zclOpenEvse_energySum
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_SE_METERING,
-    { // Attribute record
-      ATTRID_CURRENT_DEMAND_DELIVERED,
-      ZCL_DATATYPE_UINT24,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_energyDemand
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_SE_METERING,
-    { // Attribute record
-      ATTRID_CURRENT_DEMAND_LIMIT,
-      ZCL_DATATYPE_UINT24,
-      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
-      (void *)&zclOpenEvse_energyLimit
-    }
-  },
-
-  // *** Electrical Measurement Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_MEASUREMENT_TYPE,
-      ZCL_DATATYPE_BITMAP32,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasType
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_RMS_VOLTAGE,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_voltsScaled
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_RMS_CURRENT,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_ampsScaled
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_ACTIVE_POWER,
-      ZCL_DATATYPE_INT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_wattsScaled
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_AC_VOLTAGE_MULTIPLIER,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasMultiplier
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_AC_VOLTAGE_DIVISOR,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasDivisor
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_AC_CURRENT_MULTIPLIER,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasMultiplier
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_AC_CURRENT_DIVISOR,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasDivisor
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_AC_POWER_MULTIPLIER,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasWattsMultiplier
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
-    { // Attribute record
-      ATTRID_ELECTRICAL_MEASUREMENT_AC_POWER_DIVISOR,
-      ZCL_DATATYPE_UINT16,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_elecMeasWattsDivisor
-    }
-  }
-};
-
-uint8 CONST zclOpenEvse_NumAttributes = ( sizeof(zclOpenEvse_Attrs) / sizeof(zclOpenEvse_Attrs[0]) );
-
-/*********************************************************************
- * SIMPLE DESCRIPTOR
- */
-// This is the Cluster ID List and should be filled with Application
-// specific cluster IDs.
-const cId_t zclOpenEvse_InClusterList[] =
-{
-  ZCL_CLUSTER_ID_GEN_BASIC,
-  ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG,
-  ZCL_CLUSTER_ID_GEN_ON_OFF,
-  ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC,
-  ZCL_CLUSTER_ID_SE_METERING,
-  ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT
-};
-#define zclOpenEvse_MAX_INCLUSTERS   6
-
-const cId_t zclOpenEvse_OutClusterList[] =
-{
-  ZCL_CLUSTER_ID_GEN_BASIC
-};
-#define zclOpenEvse_MAX_OUTCLUSTERS  (sizeof(zclOpenEvse_OutClusterList) / sizeof(zclOpenEvse_OutClusterList[0]))
-
-SimpleDescriptionFormat_t zclOpenEvse_SimpleDesc =
-{
-  OPENEVSE_ENDPOINT,                  //  int Endpoint;
-  ZCL_HA_PROFILE_ID,                  //  uint16 AppProfId;
-  ZCL_HA_DEVICEID_SMART_PLUG,         //  uint16 AppDeviceId;
-  OPENEVSE_DEVICE_VERSION,            //  int   AppDevVer:4;
-  OPENEVSE_FLAGS,                     //  int   AppFlags:4;
-  zclOpenEvse_MAX_INCLUSTERS,         //  byte  AppNumInClusters;
-  (cId_t *)zclOpenEvse_InClusterList, //  byte *pAppInClusterList;
-  zclOpenEvse_MAX_OUTCLUSTERS,        //  byte  AppNumInClusters;
-  (cId_t *)zclOpenEvse_OutClusterList //  byte *pAppInClusterList;
-};
-
-
-/*********************************************************************
- * ATTRIBUTE DEFINITIONS - Uses REAL cluster IDs
- */
-CONST zclAttrRec_t zclOpenEvse_BlAttrs[] =
-{
-  // *** General Basic Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,             // Cluster IDs - defined in the foundation (ie. zcl.h)
-    {  // Attribute record
-      ATTRID_BASIC_HW_VERSION,            // Attribute ID - Found in Cluster Library header (ie. zcl_general.h)
-      ZCL_DATATYPE_UINT8,                 // Data Type - found in zcl.h
-      ACCESS_CONTROL_READ,                // Variable access control - found in zcl.h
-      (void *)&zclOpenEvse_HWRevision     // Pointer to attribute variable
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_ZCL_VERSION,
-      ZCL_DATATYPE_UINT8,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_ZCLVersion
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_MANUFACTURER_NAME,
-      ZCL_DATATYPE_CHAR_STR,
-      ACCESS_CONTROL_READ,
-      (void *)zclOpenEvse_ManufacturerName
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_MODEL_ID,
-      ZCL_DATATYPE_CHAR_STR,
-      ACCESS_CONTROL_READ,
-      (void *)zclOpenEvse_ModelId
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_DATE_CODE,
-      ZCL_DATATYPE_CHAR_STR,
-      ACCESS_CONTROL_READ,
-      (void *)zclOpenEvse_DateCode
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_POWER_SOURCE,
-      ZCL_DATATYPE_UINT8,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_PowerSource
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_LOCATION_DESC,
-      ZCL_DATATYPE_CHAR_STR,
-      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
-      (void *)zclOpenEvse_LocationDescription
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_PHYSICAL_ENV,
-      ZCL_DATATYPE_UINT8,
-      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
-      (void *)&zclOpenEvse_PhysicalEnvironment
-    }
-  },
-  {
-    ZCL_CLUSTER_ID_GEN_BASIC,
-    { // Attribute record
-      ATTRID_BASIC_DEVICE_ENABLED,
-      ZCL_DATATYPE_BOOLEAN,
-      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
-      (void *)&zclOpenEvse_DeviceEnable
-    }
-  },
-
-  // *** On/Off Cluster Attributes ***
-  {
-    ZCL_CLUSTER_ID_GEN_ON_OFF,
-    { // Attribute record
-      ATTRID_ON_OFF,
-      ZCL_DATATYPE_BOOLEAN,
-      ACCESS_CONTROL_READ,
-      (void *)&zclOpenEvse_backlight
-    }
-  },
-};
-
-uint8 CONST zclOpenEvse_BlNumAttributes = ( sizeof(zclOpenEvse_BlAttrs) / sizeof(zclOpenEvse_BlAttrs[0]) );
-
-/*********************************************************************
- * SIMPLE DESCRIPTOR
- */
-// This is the Cluster ID List and should be filled with Application
-// specific cluster IDs.
-const cId_t zclOpenEvse_BlInClusterList[] =
-{
-  ZCL_CLUSTER_ID_GEN_BASIC,
-  ZCL_CLUSTER_ID_GEN_ON_OFF,
-};
-#define zclOpenEvse_BL_MAX_INCLUSTERS   2
-
-const cId_t zclOpenEvse_BlOutClusterList[] =
-{
-  ZCL_CLUSTER_ID_GEN_BASIC
-};
-#define zclOpenEvse_BL_MAX_OUTCLUSTERS  (sizeof(zclOpenEvse_BlOutClusterList) / sizeof(zclOpenEvse_BlOutClusterList[0]))
-
-SimpleDescriptionFormat_t zclOpenEvse_BlSimpleDesc =
-{
-  OPENEVSE_ENDPOINT+1,                //  int Endpoint;
-  ZCL_HA_PROFILE_ID,                  //  uint16 AppProfId;
-  ZCL_HA_DEVICEID_ON_OFF_OUTPUT,      //  uint16 AppDeviceId;
-  OPENEVSE_DEVICE_VERSION,            //  int   AppDevVer:4;
-  OPENEVSE_FLAGS,                     //  int   AppFlags:4;
-  zclOpenEvse_BL_MAX_INCLUSTERS,      //  byte  AppNumInClusters;
-  (cId_t *)zclOpenEvse_BlInClusterList, //  byte *pAppInClusterList;
-  zclOpenEvse_BL_MAX_OUTCLUSTERS,       //  byte  AppNumInClusters;
-  (cId_t *)zclOpenEvse_BlOutClusterList //  byte *pAppInClusterList;
-};
-
-
-/*********************************************************************
- * GLOBAL FUNCTIONS
- */
-
-/*********************************************************************
- * LOCAL FUNCTIONS
- */
-
-/****************************************************************************
-****************************************************************************/
-
-
+/**************************************************************************************************
+  Filename:       zcl_openevse_data.c
+
+  Description:    Zigbee Cluster Library - device data for OpenEVSE.
+
+
+  Copyright 2006-2014 Texas Instruments Incorporated. All rights reserved.
+  Copyright 2015 Ryan Press
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "AF.h"
+#include "ZDConfig.h"
+
+#include "zcl.h"
+#include "zcl_general.h"
+#include "zcl_ha.h"
+#include "zcl_ezmode.h"
+#include "zcl_poll_control.h"
+#include "zcl_electrical_measurement.h"
+#include "zcl_meter_identification.h"
+#include "zcl_appliance_identification.h"
+#include "zcl_appliance_events_alerts.h"
+#include "zcl_power_profile.h"
+#include "zcl_appliance_control.h"
+#include "zcl_appliance_statistics.h"
+#include "zcl_hvac.h"
+
+#include "zcl_openevse.h"
+#if defined OPENEVSE_OTA
+#include "zcl_openevse_ota.h"
+#endif
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define OPENEVSE_DEVICE_VERSION     0
+#define OPENEVSE_FLAGS              0
+
+#define OPENEVSE_HWVERSION          1
+#define OPENEVSE_ZCLVERSION         1
+
+#define OPENEVSE_BUDGET_FRAMES      2   // report frames per second, 0 for no limit
+#define OPENEVSE_BUDGET_BYTES       160 // report bytes per second, 0 for no limit
+#define OPENEVSE_REPORT_STRETCH     3   // power/temperature periods up to 8x on a poor link
+#define OPENEVSE_REPORT_ACKED       0xF5 // all but power and temperature are APS acknowledged
+#define OPENEVSE_RESTORE_JITTER     30000 // ms, longest wait of a restore sent to a group
+#define OPENEVSE_THERMAL_START      600 // 60.0 C, pilot current starts coming down
+#define OPENEVSE_THERMAL_BAND       50  // 5.0 C more for each further step
+#define OPENEVSE_THERMAL_HYSTERESIS 30  // 3.0 C under a step's band before it is lifted
+#define OPENEVSE_THERMAL_AMPS       6   // amps per step, 0 for no throttling
+#define OPENEVSE_ALERT_TEMP         700 // 70.0 C, two steps into throttling
+#define OPENEVSE_ALERT_AMPS         2   // over the pilot current
+#define OPENEVSE_RESYNC_PERIOD      60  // seconds between background $GE and $GS
+#define OPENEVSE_CHECK_IN_INTERVAL  14400 // quarter seconds, an hour
+#define OPENEVSE_LONG_POLL_INTERVAL 4   // quarter seconds, POLL_RATE of f8wConfig.cfg
+#define OPENEVSE_SHORT_POLL_INTERVAL 2  // quarter seconds
+#define OPENEVSE_FAST_POLL_TIMEOUT  40  // quarter seconds
+#define OPENEVSE_OTA_BLOCK_PERIOD   250 // ms, so a site's downloads leave the mesh room
+
+// Power-up attribute values of a charger, in zclOpenEvse_evse_t order:
+// OnOff, backlight, temperature, IdentifyTime, state, energySum,
+// energyDemand, energyLimit, voltsScaled, ampsScaled, wattsScaled
+#define OPENEVSE_EVSE_DEFAULTS \
+  { LIGHT_OFF, LIGHT_ON, 20, 0, 0, {0}, 0, 0xFFFFFF, 0, 0, 0 }
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Profile record of one event bit, served by zclOpenEvse_ReadWriteCB
+#define OPENEVSE_PROFILE_EVENT_ATTR( bit ) \
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, \
+    { ATTRID_OPENEVSE_PROFILE_EVENT + (bit), ZCL_DATATYPE_OCTET_STR, ACCESS_CONTROL_READ, NULL } }
+
+// Delivery records of one report class, served from the first charger
+// and relocated for the others like the rest
+#define OPENEVSE_DELIVERY_ATTRS( cls ) \
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, \
+    { ATTRID_OPENEVSE_DELIVERY_SENT + ((cls) << 4), ZCL_DATATYPE_UINT32, ACCESS_CONTROL_READ, \
+      (void *)&zclOpenEvse_evse[0].delivery[cls].sent } }, \
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, \
+    { ATTRID_OPENEVSE_DELIVERY_DELIVERED + ((cls) << 4), ZCL_DATATYPE_UINT32, ACCESS_CONTROL_READ, \
+      (void *)&zclOpenEvse_evse[0].delivery[cls].delivered } }, \
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, \
+    { ATTRID_OPENEVSE_DELIVERY_FAILED + ((cls) << 4), ZCL_DATATYPE_UINT16, ACCESS_CONTROL_READ, \
+      (void *)&zclOpenEvse_evse[0].delivery[cls].failed } }, \
+  { ZCL_CLUSTER_ID_OPENEVSE_STATS, \
+    { ATTRID_OPENEVSE_DELIVERY_RETRIED + ((cls) << 4), ZCL_DATATYPE_UINT16, ACCESS_CONTROL_READ, \
+      (void *)&zclOpenEvse_evse[0].delivery[cls].retried } }
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Basic Cluster
+const uint8 zclOpenEvse_HWRevision = OPENEVSE_HWVERSION;
+const uint8 zclOpenEvse_ZCLVersion = OPENEVSE_ZCLVERSION;
+const uint8 zclOpenEvse_ManufacturerName[] = { 8, 'P','r','e','s','s','l','a','b' };
+const uint8 zclOpenEvse_ModelId[] = { 16, 'P','L','-','E','V','S','E','1',' ',' ',' ',' ',' ',' ',' ',' ' };
+const uint8 zclOpenEvse_DateCode[] = { 16, '2','0','1','5','1','2','2','3',' ',' ',' ',' ',' ',' ',' ',' ' };
+const uint8 zclOpenEvse_PowerSource = POWER_SOURCE_MAINS_1_PHASE;
+
+uint8 zclOpenEvse_LocationDescription[17] = { 16, ' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ' };
+uint8 zclOpenEvse_PhysicalEnvironment = 0;
+uint8 zclOpenEvse_DeviceEnable = DEVICE_ENABLED;
+
+// On/Off, Device Temperature Configuration, Identify, Multistate, Metering
+// and Electrical Measurement attributes of each charger
+zclOpenEvse_evse_t zclOpenEvse_evse[OPENEVSE_NUM_EVSE] =
+{
+  OPENEVSE_EVSE_DEFAULTS,
+#if OPENEVSE_NUM_EVSE > 1
+  OPENEVSE_EVSE_DEFAULTS,
+#endif
+};
+
+// Electrical Measurement attributes
+uint32 zclOpenEvse_elecMeasType = 0;
+uint16 zclOpenEvse_elecMeasMultiplier = 10;
+uint16 zclOpenEvse_elecMeasDivisor = 1;
+uint16 zclOpenEvse_elecMeasWattsMultiplier = 1;
+uint16 zclOpenEvse_elecMeasWattsDivisor = 10;
+
+// OpenEVSE statistics attributes
+uint32 zclOpenEvse_reportSent = 0;
+uint32 zclOpenEvse_reportDeferred = 0;
+uint32 zclOpenEvse_reportDropped = 0;
+uint32 zclOpenEvse_reportMerged = 0;
+uint8 zclOpenEvse_reportAcked = OPENEVSE_REPORT_ACKED;
+uint16 zclOpenEvse_budgetFrames = OPENEVSE_BUDGET_FRAMES;
+uint16 zclOpenEvse_budgetBytes = OPENEVSE_BUDGET_BYTES;
+uint8 zclOpenEvse_parentLqi = 0xFF; // Unknown until the parent is found
+uint8 zclOpenEvse_sendFailRate = 0;
+uint32 zclOpenEvse_sendFailed = 0;
+uint8 zclOpenEvse_reportStretch = 0;
+uint8 zclOpenEvse_reportStretchMax = OPENEVSE_REPORT_STRETCH;
+uint8 zclOpenEvse_timeSource = OPENEVSE_TIME_NONE;
+uint16 zclOpenEvse_restoreJitter = OPENEVSE_RESTORE_JITTER;
+int16 zclOpenEvse_thermalStart = OPENEVSE_THERMAL_START;
+uint16 zclOpenEvse_thermalBand = OPENEVSE_THERMAL_BAND;
+uint16 zclOpenEvse_thermalHysteresis = OPENEVSE_THERMAL_HYSTERESIS;
+uint8 zclOpenEvse_thermalAmps = OPENEVSE_THERMAL_AMPS;
+int16 zclOpenEvse_alertTemp = OPENEVSE_ALERT_TEMP;
+uint8 zclOpenEvse_alertAmps = OPENEVSE_ALERT_AMPS;
+uint16 zclOpenEvse_resyncPeriod = OPENEVSE_RESYNC_PERIOD;
+
+// Groups are kept by the stack's group table, without names
+const uint8 zclOpenEvse_GroupNameSupport = 0;
+
+// Time attributes. Time itself is the OSAL clock; the zone and daylight
+// saving rules are written by the hub and give the local time the
+// charging schedule runs on.
+uint8 zclOpenEvse_timeStatus = 0;
+int32 zclOpenEvse_timeZone = 0;
+uint32 zclOpenEvse_dstStart = 0;
+uint32 zclOpenEvse_dstEnd = 0;
+int32 zclOpenEvse_dstShift = 0;
+
+#if defined OPENEVSE_SLEEPY
+// Poll Control attributes of the end device build, in quarter seconds
+uint32 zclOpenEvse_checkInInterval = OPENEVSE_CHECK_IN_INTERVAL;
+uint32 zclOpenEvse_longPollInterval = OPENEVSE_LONG_POLL_INTERVAL;
+uint16 zclOpenEvse_shortPollInterval = OPENEVSE_SHORT_POLL_INTERVAL;
+uint16 zclOpenEvse_fastPollTimeout = OPENEVSE_FAST_POLL_TIMEOUT;
+#endif
+#if defined OPENEVSE_OTA
+uint8 zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_NORMAL;
+uint32 zclOpenEvse_otaFileOffset = 0;
+uint32 zclOpenEvse_otaFileVersion = OPENEVSE_OTA_FILE_VERSION;
+uint32 zclOpenEvse_otaDownloadedVersion = OPENEVSE_OTA_NO_VERSION;
+uint16 zclOpenEvse_otaBlockPeriod = OPENEVSE_OTA_BLOCK_PERIOD;
+uint16 zclOpenEvse_otaBlockRetries = 0;
+#endif
+#if defined OPENEVSE_PROFILE
+zclOpenEvse_profile_t zclOpenEvse_profile;
+#endif
+#if OPENEVSE_TRACE_ENTRIES
+uint16 zclOpenEvse_traceSeq = 0;
+uint16 zclOpenEvse_traceCursor = 0;
+#endif
+
+/*********************************************************************
+ * ATTRIBUTE DEFINITIONS - Uses REAL cluster IDs
+ *
+ * Per-charger attributes point into zclOpenEvse_evse[0]; the gateway
+ * build registers a copy of each table for the second charger with those
+ * pointers moved to zclOpenEvse_evse[1].
+ */
+CONST zclAttrRec_t zclOpenEvse_Attrs[] =
+{
+  // *** General Basic Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,             // Cluster IDs - defined in the foundation (ie. zcl.h)
+    {  // Attribute record
+      ATTRID_BASIC_HW_VERSION,            // Attribute ID - Found in Cluster Library header (ie. zcl_general.h)
+      ZCL_DATATYPE_UINT8,                 // Data Type - found in zcl.h
+      ACCESS_CONTROL_READ,                // Variable access control - found in zcl.h
+      (void *)&zclOpenEvse_HWRevision  // Pointer to attribute variable
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_ZCL_VERSION,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_ZCLVersion
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_MANUFACTURER_NAME,
+      ZCL_DATATYPE_CHAR_STR,
+      ACCESS_CONTROL_READ,
+      (void *)zclOpenEvse_ManufacturerName
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_MODEL_ID,
+      ZCL_DATATYPE_CHAR_STR,
+      ACCESS_CONTROL_READ,
+      (void *)zclOpenEvse_ModelId
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_DATE_CODE,
+      ZCL_DATATYPE_CHAR_STR,
+      ACCESS_CONTROL_READ,
+      (void *)zclOpenEvse_DateCode
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_POWER_SOURCE,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_PowerSource
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_LOCATION_DESC,
+      ZCL_DATATYPE_CHAR_STR,
+      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
+      (void *)zclOpenEvse_LocationDescription
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_PHYSICAL_ENV,
+      ZCL_DATATYPE_UINT8,
+      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
+      (void *)&zclOpenEvse_PhysicalEnvironment
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_DEVICE_ENABLED,
+      ZCL_DATATYPE_BOOLEAN,
+      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
+      (void *)&zclOpenEvse_DeviceEnable
+    }
+  },
+
+  // *** Device Temperature Configuration Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG,
+    { // Attribute record
+      ATTRID_DEV_TEMP_CURRENT,
+      ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].temperature
+    }
+  },
+
+  // *** Groups Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_GROUPS,
+    { // Attribute record
+      ATTRID_GROUP_NAME_SUPPORT,
+      ZCL_DATATYPE_BITMAP8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_GroupNameSupport
+    }
+  },
+
+  // *** On/Off Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_ON_OFF,
+    { // Attribute record
+      ATTRID_ON_OFF,
+      ZCL_DATATYPE_BOOLEAN,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].OnOff
+    }
+  },
+
+  // *** Level Control Cluster Attributes ***
+  // The level is the pilot current in amps
+  {
+    ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL,
+    { // Attribute record
+      ATTRID_LEVEL_CURRENT_LEVEL,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].pilotAmps
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL,
+    { // Attribute record
+      ATTRID_LEVEL_REMAINING_TIME,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].levelRemaining
+    }
+  },
+
+  // *** Time Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_TIME,
+      ZCL_DATATYPE_UTC,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      NULL // Through zclOpenEvse_ReadWriteCB, the OSAL clock
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_STATUS,
+      ZCL_DATATYPE_BITMAP8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_timeStatus
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_ZONE,
+      ZCL_DATATYPE_INT32,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_timeZone
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_DST_START,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_dstStart
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_DST_END,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_dstEnd
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_DST_SHIFT,
+      ZCL_DATATYPE_INT32,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_dstShift
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_TIME,
+    { // Attribute record
+      ATTRID_TIME_LOCAL_TIME,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      NULL // Through zclOpenEvse_ReadWriteCB
+    }
+  },
+
+  // *** Multistate Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC,
+    { // Attribute record
+      ATTRID_IOV_BASIC_PRESENT_VALUE,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].state
+    }
+  },
+
+  // *** Metering Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_SE_METERING,
+    { // Attribute record
+      ATTRID_CURRENT_SUM_DELIVERED,
+      ZCL_DATATYPE_UINT48,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_evse[0].energySum
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_SE_METERING,
+    { // Attribute record
+      ATTRID_CURRENT_DEMAND_DELIVERED,
+      ZCL_DATATYPE_UINT24,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].energyDemand
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_SE_METERING,
+    { // Attribute record
+      ATTRID_CURRENT_DEMAND_LIMIT,
+      ZCL_DATATYPE_UINT24,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      NULL // Through zclOpenEvse_ReadWriteCB so writes reach the EVSE
+    }
+  },
+
+  // *** Electrical Measurement Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_MEASUREMENT_TYPE,
+      ZCL_DATATYPE_BITMAP32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasType
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_RMS_VOLTAGE,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].voltsScaled
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_RMS_CURRENT,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].ampsScaled
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_ACTIVE_POWER,
+      ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].wattsScaled
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_AC_VOLTAGE_MULTIPLIER,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasMultiplier
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_AC_VOLTAGE_DIVISOR,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasDivisor
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_AC_CURRENT_MULTIPLIER,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasMultiplier
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_AC_CURRENT_DIVISOR,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasDivisor
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_AC_POWER_MULTIPLIER,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasWattsMultiplier
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+    { // Attribute record
+      ATTRID_ELECTRICAL_MEASUREMENT_AC_POWER_DIVISOR,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_elecMeasWattsDivisor
+    }
+  },
+
+  // *** OpenEVSE Statistics Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_REPORT_SENT,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_reportSent
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_REPORT_DEFERRED,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_reportDeferred
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_REPORT_DROPPED,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_reportDropped
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_REPORT_ACKED,
+      ZCL_DATATYPE_BITMAP8,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_reportAcked
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_REPORT_MERGED,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_reportMerged
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_BUDGET_FRAMES,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_budgetFrames
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_BUDGET_BYTES,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_budgetBytes
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_MESH_PARENT_LQI,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_parentLqi
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_MESH_FAIL_RATE,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_sendFailRate
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_MESH_SEND_FAILED,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_sendFailed
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_MESH_STRETCH,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_reportStretch
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_MESH_STRETCH_MAX,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_reportStretchMax
+    }
+  },
+
+  // RAPI link health of this charger
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_SENT,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.sent
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_OK,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.ok
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_NK,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.nk
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_CHECKSUM,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.checksum
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_RESENDS,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.resends
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_ABANDONED,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.abandoned
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_RX_OVERFLOW,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.rxOverflow
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_RTT_MIN,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.rttMin
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_RTT_AVG,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.rttAvg
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_LINK_RTT_MAX,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].link.rttMax
+    }
+  },
+
+  // Report delivery of this charger: state, power, energy, temperature,
+  // pilot current, thermal throttling, alerts and events
+  OPENEVSE_DELIVERY_ATTRS( 0 ),
+  OPENEVSE_DELIVERY_ATTRS( 1 ),
+  OPENEVSE_DELIVERY_ATTRS( 2 ),
+  OPENEVSE_DELIVERY_ATTRS( 3 ),
+  OPENEVSE_DELIVERY_ATTRS( 4 ),
+  OPENEVSE_DELIVERY_ATTRS( 5 ),
+  OPENEVSE_DELIVERY_ATTRS( 6 ),
+  OPENEVSE_DELIVERY_ATTRS( 7 ),
+
+  // Charging schedule of this charger
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_TOU_SCHEDULE,
+      ZCL_DATATYPE_OCTET_STR,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      NULL // Through zclOpenEvse_ReadWriteCB
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_TOU_ACTIVE,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].touActive
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_TIME_SOURCE,
+      ZCL_DATATYPE_ENUM8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_timeSource
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_RESTORE_JITTER,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_restoreJitter
+    }
+  },
+
+  // Thermal throttling: the thresholds are the module's, the readings each charger's
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_THERMAL_START,
+      ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_thermalStart
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_THERMAL_BAND,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_thermalBand
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_THERMAL_HYSTERESIS,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_thermalHysteresis
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_THERMAL_AMPS,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_thermalAmps
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_THERMAL_TEMP,
+      ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].tempMax
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_THERMAL_STEP,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].thermalStep
+    }
+  },
+
+  // Appliance Events & Alerts: the thresholds are the module's, the alerts each charger's
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_ALERTS,
+      ZCL_DATATYPE_BITMAP16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].alerts
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_ALERT_TEMP,
+      ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_alertTemp
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_ALERT_AMPS,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_alertAmps
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_RESYNC_PERIOD,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_resyncPeriod
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_RESYNC_CHANGES,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].resyncChanges
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_ENERGY_RESETS,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].energyResets
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_CMD_RESENDS,
+      ZCL_DATATYPE_OCTET_STR,
+      ACCESS_CONTROL_READ,
+      NULL // Through zclOpenEvse_ReadWriteCB
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_CMD_GIVEN_UP,
+      ZCL_DATATYPE_OCTET_STR,
+      ACCESS_CONTROL_READ,
+      NULL // Through zclOpenEvse_ReadWriteCB
+    }
+  },
+#if defined OPENEVSE_SLEEPY
+
+  // Poll Control of the module, the same on every charger endpoint
+  {
+    ZCL_CLUSTER_ID_GEN_POLL_CONTROL,
+    { // Attribute record
+      ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      NULL // Through zclOpenEvse_ReadWriteCB, which restarts the check-in timer
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_POLL_CONTROL,
+    { // Attribute record
+      ATTRID_POLL_CONTROL_LONG_POLL_INTERVAL,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_longPollInterval
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_POLL_CONTROL,
+    { // Attribute record
+      ATTRID_POLL_CONTROL_SHORT_POLL_INTERVAL,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_shortPollInterval
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_POLL_CONTROL,
+    { // Attribute record
+      ATTRID_POLL_CONTROL_FAST_POLL_TIMEOUT,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      NULL // Through zclOpenEvse_ReadWriteCB, 0 is out of range
+    }
+  },
+#endif
+#if defined OPENEVSE_OTA
+
+  // OTA client of the module, the same on every charger endpoint
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_OTA_STATUS,
+      ZCL_DATATYPE_ENUM8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_otaStatus
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_OTA_FILE_OFFSET,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_otaFileOffset
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_OTA_FILE_VERSION,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_otaFileVersion
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_OTA_DOWNLOADED_VERSION,
+      ZCL_DATATYPE_UINT32,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_otaDownloadedVersion
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_OTA_BLOCK_PERIOD,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_otaBlockPeriod
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_OTA_BLOCK_RETRIES,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_otaBlockRetries
+    }
+  },
+#endif
+#if OPENEVSE_TRACE_ENTRIES
+
+  // Transaction trace of the module, the same on every charger endpoint
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_TRACE_SEQ,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_traceSeq
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_TRACE_CURSOR,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE,
+      (void *)&zclOpenEvse_traceCursor
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_TRACE_CHUNK,
+      ZCL_DATATYPE_OCTET_STR,
+      ACCESS_CONTROL_READ,
+      NULL // Through zclOpenEvse_ReadWriteCB
+    }
+  },
+#endif
+#if defined OPENEVSE_PROFILE
+
+  // Event loop profile of the module, the same on every charger endpoint
+  OPENEVSE_PROFILE_EVENT_ATTR( 0 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 1 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 2 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 3 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 4 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 5 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 6 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 7 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 8 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 9 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 10 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 11 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 12 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 13 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 14 ),
+  OPENEVSE_PROFILE_EVENT_ATTR( 15 ),
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_PROFILE_QUEUE_MAX,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_profile.queueMax
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_OPENEVSE_STATS,
+    { // Attribute record
+      ATTRID_OPENEVSE_PROFILE_HEAP_HIGH,
+      ZCL_DATATYPE_UINT16,
+      ACCESS_CONTROL_READ,
+      NULL // Through zclOpenEvse_ReadWriteCB, from osal_heap_high_water()
+    }
+  },
+#endif
+};
+
+uint8 CONST zclOpenEvse_NumAttributes = ( sizeof(zclOpenEvse_Attrs) / sizeof(zclOpenEvse_Attrs[0]) );
+
+/*********************************************************************
+ * SIMPLE DESCRIPTOR
+ */
+// This is the Cluster ID List and should be filled with Application
+// specific cluster IDs.
+const cId_t zclOpenEvse_InClusterList[] =
+{
+  ZCL_CLUSTER_ID_GEN_BASIC,
+  ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG,
+  ZCL_CLUSTER_ID_GEN_GROUPS,
+  ZCL_CLUSTER_ID_GEN_ON_OFF,
+  ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL,
+  ZCL_CLUSTER_ID_GEN_TIME,
+  ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC,
+  ZCL_CLUSTER_ID_SE_METERING,
+  ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT,
+  ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS,
+#if defined OPENEVSE_SLEEPY
+  ZCL_CLUSTER_ID_GEN_POLL_CONTROL,
+#endif
+  ZCL_CLUSTER_ID_OPENEVSE_STATS
+};
+#define zclOpenEvse_MAX_INCLUSTERS   (sizeof(zclOpenEvse_InClusterList) / sizeof(zclOpenEvse_InClusterList[0]))
+
+const cId_t zclOpenEvse_OutClusterList[] =
+{
+  ZCL_CLUSTER_ID_GEN_BASIC
+#if defined OPENEVSE_OTA
+  , ZCL_CLUSTER_ID_OTA
+#endif
+};
+#define zclOpenEvse_MAX_OUTCLUSTERS  (sizeof(zclOpenEvse_OutClusterList) / sizeof(zclOpenEvse_OutClusterList[0]))
+
+SimpleDescriptionFormat_t zclOpenEvse_SimpleDesc[OPENEVSE_NUM_EVSE] =
+{
+  {
+    OPENEVSE_EVSE_ENDPOINT(0),          //  int Endpoint;
+    ZCL_HA_PROFILE_ID,                  //  uint16 AppProfId;
+    ZCL_HA_DEVICEID_SMART_PLUG,         //  uint16 AppDeviceId;
+    OPENEVSE_DEVICE_VERSION,            //  int   AppDevVer:4;
+    OPENEVSE_FLAGS,                     //  int   AppFlags:4;
+    zclOpenEvse_MAX_INCLUSTERS,         //  byte  AppNumInClusters;
+    (cId_t *)zclOpenEvse_InClusterList, //  byte *pAppInClusterList;
+    zclOpenEvse_MAX_OUTCLUSTERS,        //  byte  AppNumInClusters;
+    (cId_t *)zclOpenEvse_OutClusterList //  byte *pAppInClusterList;
+  },
+#if OPENEVSE_NUM_EVSE > 1
+  {
+    OPENEVSE_EVSE_ENDPOINT(1),
+    ZCL_HA_PROFILE_ID,
+    ZCL_HA_DEVICEID_SMART_PLUG,
+    OPENEVSE_DEVICE_VERSION,
+    OPENEVSE_FLAGS,
+    zclOpenEvse_MAX_INCLUSTERS,
+    (cId_t *)zclOpenEvse_InClusterList,
+    zclOpenEvse_MAX_OUTCLUSTERS,
+    (cId_t *)zclOpenEvse_OutClusterList
+  },
+#endif
+};
+
+
+/*********************************************************************
+ * ATTRIBUTE DEFINITIONS - Uses REAL cluster IDs
+ */
+CONST zclAttrRec_t zclOpenEvse_BlAttrs[] =
+{
+  // *** General Basic Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,             // Cluster IDs - defined in the foundation (ie. zcl.h)
+    {  // Attribute record
+      ATTRID_BASIC_HW_VERSION,            // Attribute ID - Found in Cluster Library header (ie. zcl_general.h)
+      ZCL_DATATYPE_UINT8,                 // Data Type - found in zcl.h
+      ACCESS_CONTROL_READ,                // Variable access control - found in zcl.h
+      (void *)&zclOpenEvse_HWRevision     // Pointer to attribute variable
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_ZCL_VERSION,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_ZCLVersion
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_MANUFACTURER_NAME,
+      ZCL_DATATYPE_CHAR_STR,
+      ACCESS_CONTROL_READ,
+      (void *)zclOpenEvse_ManufacturerName
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_MODEL_ID,
+      ZCL_DATATYPE_CHAR_STR,
+      ACCESS_CONTROL_READ,
+      (void *)zclOpenEvse_ModelId
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_DATE_CODE,
+      ZCL_DATATYPE_CHAR_STR,
+      ACCESS_CONTROL_READ,
+      (void *)zclOpenEvse_DateCode
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_POWER_SOURCE,
+      ZCL_DATATYPE_UINT8,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_PowerSource
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_LOCATION_DESC,
+      ZCL_DATATYPE_CHAR_STR,
+      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
+      (void *)zclOpenEvse_LocationDescription
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_PHYSICAL_ENV,
+      ZCL_DATATYPE_UINT8,
+      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
+      (void *)&zclOpenEvse_PhysicalEnvironment
+    }
+  },
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { // Attribute record
+      ATTRID_BASIC_DEVICE_ENABLED,
+      ZCL_DATATYPE_BOOLEAN,
+      (ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE),
+      (void *)&zclOpenEvse_DeviceEnable
+    }
+  },
+
+  // *** On/Off Cluster Attributes ***
+  {
+    ZCL_CLUSTER_ID_GEN_ON_OFF,
+    { // Attribute record
+      ATTRID_ON_OFF,
+      ZCL_DATATYPE_BOOLEAN,
+      ACCESS_CONTROL_READ,
+      (void *)&zclOpenEvse_evse[0].backlight
+    }
+  },
+};
+
+uint8 CONST zclOpenEvse_BlNumAttributes = ( sizeof(zclOpenEvse_BlAttrs) / sizeof(zclOpenEvse_BlAttrs[0]) );
+
+/*********************************************************************
+ * SIMPLE DESCRIPTOR
+ */
+// This is the Cluster ID List and should be filled with Application
+// specific cluster IDs.
+const cId_t zclOpenEvse_BlInClusterList[] =
+{
+  ZCL_CLUSTER_ID_GEN_BASIC,
+  ZCL_CLUSTER_ID_GEN_ON_OFF,
+};
+#define zclOpenEvse_BL_MAX_INCLUSTERS   2
+
+const cId_t zclOpenEvse_BlOutClusterList[] =
+{
+  ZCL_CLUSTER_ID_GEN_BASIC
+};
+#define zclOpenEvse_BL_MAX_OUTCLUSTERS  (sizeof(zclOpenEvse_BlOutClusterList) / sizeof(zclOpenEvse_BlOutClusterList[0]))
+
+SimpleDescriptionFormat_t zclOpenEvse_BlSimpleDesc[OPENEVSE_NUM_EVSE] =
+{
+  {
+    OPENEVSE_EVSE_ENDPOINT(0)+1,        //  int Endpoint;
+    ZCL_HA_PROFILE_ID,                  //  uint16 AppProfId;
+    ZCL_HA_DEVICEID_ON_OFF_OUTPUT,      //  uint16 AppDeviceId;
+    OPENEVSE_DEVICE_VERSION,            //  int   AppDevVer:4;
+    OPENEVSE_FLAGS,                     //  int   AppFlags:4;
+    zclOpenEvse_BL_MAX_INCLUSTERS,      //  byte  AppNumInClusters;
+    (cId_t *)zclOpenEvse_BlInClusterList, //  byte *pAppInClusterList;
+    zclOpenEvse_BL_MAX_OUTCLUSTERS,       //  byte  AppNumInClusters;
+    (cId_t *)zclOpenEvse_BlOutClusterList //  byte *pAppInClusterList;
+  },
+#if OPENEVSE_NUM_EVSE > 1
+  {
+    OPENEVSE_EVSE_ENDPOINT(1)+1,
+    ZCL_HA_PROFILE_ID,
+    ZCL_HA_DEVICEID_ON_OFF_OUTPUT,
+    OPENEVSE_DEVICE_VERSION,
+    OPENEVSE_FLAGS,
+    zclOpenEvse_BL_MAX_INCLUSTERS,
+    (cId_t *)zclOpenEvse_BlInClusterList,
+    zclOpenEvse_BL_MAX_OUTCLUSTERS,
+    (cId_t *)zclOpenEvse_BlOutClusterList
+  },
+#endif
+};
+
+
+/*********************************************************************
+ * GLOBAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/****************************************************************************
+****************************************************************************/
+
+
@@ -0,0 +1,1089 @@
+/**************************************************************************************************
+  Filename:       zcl_openevse_ota.c
+
+  Description:    OTA Upgrade cluster client for the OpenEVSE module.
+
+                  The module asks the OTA server for a new image once a
+                  day, or when the server notifies it of one, downloads it
+                  in the largest blocks a frame will carry at no more than
+                  one block per MinimumBlockPeriod, and stores it in the
+                  download slot at the top of flash. Images carry a block
+                  delta against the running image rather than the whole
+                  image, which would not fit the slot. Once the delta is
+                  verified against the running image and the server gives
+                  the word, it is applied in place page by page and the
+                  module restarts.
+
+                  There is no boot loader to fall back on, so a power cut
+                  while pages are rewritten leaves the module to the
+                  debugger. The client is for the bench, off unless
+                  OPENEVSE_OTA is defined.
+
+**************************************************************************************************/
+
+#if defined OPENEVSE_OTA
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "AF.h"
+
+#include "zcl.h"
+#include "zcl_openevse.h"
+#include "zcl_openevse_ota.h"
+
+#include "onboard.h"
+
+/* HAL */
+#include "hal_mcu.h"
+#include "hal_flash.h"
+
+#if !defined OPENEVSE_OTA_MANUFACTURER || OPENEVSE_OTA_MANUFACTURER == OPENEVSE_OTA_SAMPLE_MANUFACTURER
+#error "OPENEVSE_OTA needs OPENEVSE_OTA_MANUFACTURER set to the vendor's ZigBee manufacturer code"
+#endif
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define OPENEVSE_OTA_QUERY_PERIOD 86400000UL  // ask the server for a new image daily
+#define OPENEVSE_OTA_QUERY_JITTER 60000       // first ask, up to a minute after joining
+#define OPENEVSE_OTA_RSP_TIMEOUT 5000         // for each request to the server
+#define OPENEVSE_OTA_RETRIES 4                // then the download waits for the next query
+#define OPENEVSE_OTA_WAIT_FOR_MORE 3600000UL  // server said wait for the upgrade time
+#define OPENEVSE_OTA_SERVER_ENDPOINT 1        // until an Image Notify says otherwise
+#define OPENEVSE_OTA_BLOCK_RSP_LEN 17         // Image Block Response less its data
+#define OPENEVSE_OTA_VERIFY_BYTES 512         // of the running image checked per event
+#define OPENEVSE_OTA_VERIFY_BLOCKS 8          // of the new image rebuilt per event
+
+#define OPENEVSE_OTA_SLOT_ADDR ((uint32)OPENEVSE_OTA_SLOT_PAGE * OPENEVSE_OTA_PAGE_SIZE)
+#define OPENEVSE_OTA_SCRATCH_ADDR ((uint32)OPENEVSE_OTA_SCRATCH_PAGE * OPENEVSE_OTA_PAGE_SIZE)
+#define OPENEVSE_OTA_PAGE_BLOCKS (OPENEVSE_OTA_PAGE_SIZE / OPENEVSE_OTA_BLOCK)
+
+// Where the client is
+#define OTA_IDLE 0
+#define OTA_QUERY 1            // Query Next Image Request sent
+#define OTA_DOWNLOAD 2         // Image Block Requests
+#define OTA_VERIFY_HEADER 3
+#define OTA_VERIFY_BASE 4      // CRC of the running image
+#define OTA_VERIFY_DELTA 5     // the new image built without writing it
+#define OTA_END 6              // Upgrade End Request sent
+#define OTA_UPGRADE 7          // waiting for the upgrade time
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// Position in the delta's records
+typedef struct
+{
+  uint32 rec;         // slot offset of the next record
+  uint32 src;         // old image offset of the next block read from it
+  uint8 left;         // blocks left in the current record
+  uint8 hdr;          // its header
+} zclOpenEvseOta_cursor_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint8 zclOpenEvseOta_TaskID;
+static uint8 zclOpenEvseOta_phase = OTA_IDLE;
+static uint8 zclOpenEvseOta_retries;
+static uint8 zclOpenEvseOta_seqNum;
+static afAddrType_t zclOpenEvseOta_server;
+
+// Download
+static uint32 zclOpenEvseOta_imageSize;
+static uint32 zclOpenEvseOta_stored;   // slot bytes written, the rest are in the buffer
+static uint32 zclOpenEvseOta_lastRequest;
+static uint8 zclOpenEvseOta_buf[OPENEVSE_OTA_BLOCK];
+static uint8 zclOpenEvseOta_bufLen;
+
+// Verification and upgrade
+static uint32 zclOpenEvseOta_deltaEnd;  // slot offset past the last record
+static uint32 zclOpenEvseOta_baseLen;
+static uint32 zclOpenEvseOta_baseCrc;
+static uint32 zclOpenEvseOta_newLen;
+static uint32 zclOpenEvseOta_newCrc;
+static uint8 zclOpenEvseOta_flags;
+static uint32 zclOpenEvseOta_pos;
+static uint32 zclOpenEvseOta_crc;
+static zclOpenEvseOta_cursor_t zclOpenEvseOta_cur;
+static uint32 zclOpenEvseOta_recStart;
+static uint8 zclOpenEvseOta_block[OPENEVSE_OTA_BLOCK];
+static uint8 zclOpenEvseOta_cmp[OPENEVSE_OTA_BLOCK];
+static uint8 zclOpenEvseOta_applying;   // verifying again at the upgrade time
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 *zclOpenEvseOta_ImageId( uint8 *buf, uint32 version );
+static void zclOpenEvseOta_Send( uint8 cmd, uint8 *buf, uint8 len );
+static void zclOpenEvseOta_Query( void );
+static void zclOpenEvseOta_BlockRequest( void );
+static void zclOpenEvseOta_EndRequest( uint8 status );
+static void zclOpenEvseOta_Timeout( void );
+static void zclOpenEvseOta_Reset( void );
+static void zclOpenEvseOta_ImageNotify( afIncomingMSGPacket_t *pkt, uint8 *pData, uint8 len );
+static void zclOpenEvseOta_QueryRsp( afIncomingMSGPacket_t *pkt, uint8 *pData, uint8 len );
+static void zclOpenEvseOta_BlockRsp( uint8 *pData, uint8 len );
+static void zclOpenEvseOta_EndRsp( uint8 *pData, uint8 len );
+static void zclOpenEvseOta_Store( uint8 *data, uint8 len );
+static void zclOpenEvseOta_Flush( void );
+static uint8 zclOpenEvseOta_Verify( void );
+static uint8 zclOpenEvseOta_VerifyHeader( void );
+static uint32 zclOpenEvseOta_BlockAddr( uint32 block );
+static uint8 zclOpenEvseOta_NextBlock( uint32 dst, uint8 *block );
+static void zclOpenEvseOta_Apply( void );
+static void zclOpenEvseOta_FlashRead( uint32 addr, uint8 *buf, uint16 len );
+static void zclOpenEvseOta_FlashWrite( uint32 addr, uint8 *buf, uint16 len );
+
+/*********************************************************************
+ * @fn          zclOpenEvseOta_Init
+ *
+ * @brief       Initialization function for the OTA client task.
+ *
+ * @param       task_id - OSAL task ID
+ *
+ * @return      none
+ */
+void zclOpenEvseOta_Init( byte task_id )
+{
+  zclOpenEvseOta_TaskID = task_id;
+
+  // The coordinator, until an Image Notify or a response comes from elsewhere
+  zclOpenEvseOta_server.addrMode = (afAddrMode_t)Addr16Bit;
+  zclOpenEvseOta_server.addr.shortAddr = 0x0000;
+  zclOpenEvseOta_server.endPoint = OPENEVSE_OTA_SERVER_ENDPOINT;
+}
+
+/*********************************************************************
+ * @fn          zclOpenEvseOta_event_loop
+ *
+ * @brief       Event Loop Processor for the OTA client.
+ *
+ * @param       task_id - OSAL task ID
+ * @param       events - events bitmap
+ *
+ * @return      unprocessed events bitmap
+ */
+uint16 zclOpenEvseOta_event_loop( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+
+  if ( events & OPENEVSE_OTA_QUERY_EVT )
+  {
+    if ( zclOpenEvseOta_phase == OTA_IDLE )
+    {
+      zclOpenEvseOta_retries = 0;
+      zclOpenEvseOta_Query();
+    }
+    osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_QUERY_EVT, OPENEVSE_OTA_QUERY_PERIOD );
+    return ( events ^ OPENEVSE_OTA_QUERY_EVT );
+  }
+
+  if ( events & OPENEVSE_OTA_BLOCK_EVT )
+  {
+    if ( zclOpenEvseOta_phase == OTA_DOWNLOAD )
+    {
+      zclOpenEvseOta_BlockRequest();
+    }
+    return ( events ^ OPENEVSE_OTA_BLOCK_EVT );
+  }
+
+  if ( events & OPENEVSE_OTA_TIMEOUT_EVT )
+  {
+    zclOpenEvseOta_Timeout();
+    return ( events ^ OPENEVSE_OTA_TIMEOUT_EVT );
+  }
+
+  if ( events & OPENEVSE_OTA_VERIFY_EVT )
+  {
+    // A step at a time, so the charger tasks keep running
+    if ( zclOpenEvseOta_Verify() )
+    {
+      osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_VERIFY_EVT );
+    }
+    return ( events ^ OPENEVSE_OTA_VERIFY_EVT );
+  }
+
+  if ( events & OPENEVSE_OTA_UPGRADE_EVT )
+  {
+    if ( zclOpenEvseOta_phase == OTA_UPGRADE )
+    {
+      // The slot may have been checked days ago; check it again first
+      zclOpenEvseOta_applying = TRUE;
+      zclOpenEvseOta_phase = OTA_VERIFY_HEADER;
+      osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_VERIFY_EVT );
+    }
+    return ( events ^ OPENEVSE_OTA_UPGRADE_EVT );
+  }
+
+  // Discard unknown events
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_NwkUp
+ *
+ * @brief   The module has joined; ask for an image a random time from
+ *          now, and daily after that.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zclOpenEvseOta_NwkUp( void )
+{
+  if ( osal_get_timeoutEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_QUERY_EVT ) == 0 )
+  {
+    osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_QUERY_EVT,
+                        1 + osal_rand() % OPENEVSE_OTA_QUERY_JITTER );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_ProcessAFMsg
+ *
+ * @brief   Handle an OTA Upgrade cluster command from the server.
+ *
+ * @param   pkt - incoming AF message
+ *
+ * @return  TRUE if the message was taken, FALSE to pass it to the ZCL
+ */
+uint8 zclOpenEvseOta_ProcessAFMsg( afIncomingMSGPacket_t *pkt )
+{
+  uint8 *pData = pkt->cmd.Data;
+  uint8 len;
+
+  // Cluster specific, server to client, no manufacturer code
+  if ( pkt->cmd.DataLength < 3 || pkt->cmd.DataLength > 0xFF ||
+       (pData[0] & (ZCL_FRAME_CONTROL_TYPE | ZCL_FRAME_CONTROL_MANU_SPECIFIC |
+                    ZCL_FRAME_CONTROL_DIRECTION)) !=
+         (ZCL_FRAME_TYPE_SPECIFIC_CMD | ZCL_FRAME_CONTROL_DIRECTION) )
+  {
+    return FALSE;
+  }
+  len = (uint8)pkt->cmd.DataLength - 3;
+
+  switch ( pData[2] )
+  {
+    case OPENEVSE_OTA_CMD_IMAGE_NOTIFY:
+      zclOpenEvseOta_ImageNotify( pkt, &pData[3], len );
+      break;
+
+    case OPENEVSE_OTA_CMD_QUERY_NEXT_IMAGE_RSP:
+      zclOpenEvseOta_QueryRsp( pkt, &pData[3], len );
+      break;
+
+    case OPENEVSE_OTA_CMD_IMAGE_BLOCK_RSP:
+      zclOpenEvseOta_BlockRsp( &pData[3], len );
+      break;
+
+    case OPENEVSE_OTA_CMD_UPGRADE_END_RSP:
+      zclOpenEvseOta_EndRsp( &pData[3], len );
+      break;
+
+    default:
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_Crc32
+ *
+ * @brief   CRC-32, bit by bit; only verification uses it.
+ *
+ * @param   crc - running value
+ * @param   buf - bytes
+ * @param   len - their number
+ *
+ * @return  new running value
+ */
+uint32 zclOpenEvseOta_Crc32( uint32 crc, const uint8 *buf, uint16 len )
+{
+  uint8 bit;
+
+  while ( len-- )
+  {
+    crc ^= *buf++;
+    for ( bit = 0; bit < 8; bit++ )
+    {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320UL : 0);
+    }
+  }
+  return crc;
+}
+
+/******************************************************************************
+ *
+ *  Requests to the server
+ *
+ *****************************************************************************/
+
+// Manufacturer code, image type and file version, as every request carries them
+static uint8 *zclOpenEvseOta_ImageId( uint8 *buf, uint32 version )
+{
+  *buf++ = LO_UINT16( OPENEVSE_OTA_MANUFACTURER );
+  *buf++ = HI_UINT16( OPENEVSE_OTA_MANUFACTURER );
+  *buf++ = LO_UINT16( OPENEVSE_OTA_IMAGE_TYPE );
+  *buf++ = HI_UINT16( OPENEVSE_OTA_IMAGE_TYPE );
+  *buf++ = BREAK_UINT32( version, 0 );
+  *buf++ = BREAK_UINT32( version, 1 );
+  *buf++ = BREAK_UINT32( version, 2 );
+  *buf++ = BREAK_UINT32( version, 3 );
+  return buf;
+}
+
+static void zclOpenEvseOta_Send( uint8 cmd, uint8 *buf, uint8 len )
+{
+  zcl_SendCommand( OPENEVSE_ENDPOINT, &zclOpenEvseOta_server, ZCL_CLUSTER_ID_OTA, cmd, TRUE,
+                   ZCL_FRAME_CLIENT_SERVER_DIR, TRUE, 0, zclOpenEvseOta_seqNum++, len, buf );
+}
+
+static void zclOpenEvseOta_Query( void )
+{
+  uint8 buf[9];
+
+  buf[0] = 0; // No hardware version
+  zclOpenEvseOta_ImageId( &buf[1], zclOpenEvse_otaFileVersion );
+  zclOpenEvseOta_Send( OPENEVSE_OTA_CMD_QUERY_NEXT_IMAGE_REQ, buf, sizeof( buf ) );
+  zclOpenEvseOta_phase = OTA_QUERY;
+  osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT, OPENEVSE_OTA_RSP_TIMEOUT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_BlockRequest
+ *
+ * @brief   Ask for the next block, as much as fits in the response frame.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_BlockRequest( void )
+{
+  afDataReqMTU_t mtu;
+  uint8 buf[14];
+  uint8 *p;
+  uint8 max;
+
+  mtu.kvp = FALSE;
+  mtu.aps.secure = FALSE;
+  max = afDataReqMTU( &mtu ) - OPENEVSE_OTA_BLOCK_RSP_LEN;
+
+  buf[0] = 0; // No IEEE address or block period
+  p = zclOpenEvseOta_ImageId( &buf[1], zclOpenEvse_otaDownloadedVersion );
+  *p++ = BREAK_UINT32( zclOpenEvse_otaFileOffset, 0 );
+  *p++ = BREAK_UINT32( zclOpenEvse_otaFileOffset, 1 );
+  *p++ = BREAK_UINT32( zclOpenEvse_otaFileOffset, 2 );
+  *p++ = BREAK_UINT32( zclOpenEvse_otaFileOffset, 3 );
+  *p = max;
+  zclOpenEvseOta_Send( OPENEVSE_OTA_CMD_IMAGE_BLOCK_REQ, buf, sizeof( buf ) );
+  zclOpenEvseOta_lastRequest = osal_GetSystemClock();
+  osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT, OPENEVSE_OTA_RSP_TIMEOUT );
+}
+
+static void zclOpenEvseOta_EndRequest( uint8 status )
+{
+  uint8 buf[9];
+
+  buf[0] = status;
+  zclOpenEvseOta_ImageId( &buf[1], zclOpenEvse_otaDownloadedVersion );
+  zclOpenEvseOta_Send( OPENEVSE_OTA_CMD_UPGRADE_END_REQ, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_Timeout
+ *
+ * @brief   No response from the server: ask again, or give up until the
+ *          next query. A download given up on keeps what it has, and
+ *          goes on from there if the server offers the same image.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_Timeout( void )
+{
+  if ( zclOpenEvseOta_phase == OTA_QUERY || zclOpenEvseOta_phase == OTA_DOWNLOAD ||
+       zclOpenEvseOta_phase == OTA_END )
+  {
+    if ( zclOpenEvseOta_retries++ < OPENEVSE_OTA_RETRIES ||
+         zclOpenEvse_otaStatus == OPENEVSE_OTA_STATUS_WAIT_FOR_MORE )
+    {
+      if ( zclOpenEvseOta_phase == OTA_QUERY )
+      {
+        zclOpenEvseOta_Query();
+      }
+      else if ( zclOpenEvseOta_phase == OTA_DOWNLOAD )
+      {
+        zclOpenEvse_otaBlockRetries++;
+        zclOpenEvseOta_BlockRequest();
+      }
+      else
+      {
+        zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_COMPLETE;
+        zclOpenEvseOta_EndRequest( ZCL_STATUS_SUCCESS );
+        osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT, OPENEVSE_OTA_RSP_TIMEOUT );
+      }
+    }
+    else if ( zclOpenEvseOta_phase == OTA_DOWNLOAD )
+    {
+      zclOpenEvseOta_phase = OTA_IDLE;
+      zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_NORMAL;
+    }
+    else
+    {
+      zclOpenEvseOta_Reset();
+    }
+  }
+}
+
+// Back to running the current image, with nothing downloaded
+static void zclOpenEvseOta_Reset( void )
+{
+  osal_stop_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT );
+  zclOpenEvseOta_phase = OTA_IDLE;
+  zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_NORMAL;
+  zclOpenEvse_otaFileOffset = 0;
+  zclOpenEvse_otaDownloadedVersion = OPENEVSE_OTA_NO_VERSION;
+  zclOpenEvseOta_applying = FALSE;
+}
+
+/******************************************************************************
+ *
+ *  Commands from the server
+ *
+ *****************************************************************************/
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_ImageNotify
+ *
+ * @brief   The server has an image. Take it up if it could be for us and
+ *          the query jitter lets us, so a broadcast notify doesn't bring
+ *          every module on the site in at once.
+ *
+ * @param   pkt - incoming AF message
+ * @param   pData - payload
+ * @param   len - its length
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_ImageNotify( afIncomingMSGPacket_t *pkt, uint8 *pData, uint8 len )
+{
+  uint8 type;
+
+  if ( len < 2 || zclOpenEvseOta_phase != OTA_IDLE ||
+       (type = pData[0]) > 3 || len < 2 + 2 * (type > 0) + 2 * (type > 1) + 4 * (type > 2) )
+  {
+    return;
+  }
+  if ( pData[1] == 0 || pData[1] > 100 || (osal_rand() % 100) >= pData[1] )
+  {
+    return;
+  }
+  if ( (type > 0 && BUILD_UINT16( pData[2], pData[3] ) != OPENEVSE_OTA_MANUFACTURER) ||
+       (type > 1 && BUILD_UINT16( pData[4], pData[5] ) != OPENEVSE_OTA_IMAGE_TYPE) ||
+       (type > 2 && BUILD_UINT32( pData[6], pData[7], pData[8], pData[9] ) == zclOpenEvse_otaFileVersion) )
+  {
+    return;
+  }
+  zclOpenEvseOta_server = pkt->srcAddr;
+  osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_QUERY_EVT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_QueryRsp
+ *
+ * @brief   Start downloading the image offered, or go on with it if it
+ *          is the one a download was given up on.
+ *
+ * @param   pkt - incoming AF message
+ * @param   pData - payload
+ * @param   len - its length
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_QueryRsp( afIncomingMSGPacket_t *pkt, uint8 *pData, uint8 len )
+{
+  uint32 version;
+  uint32 size;
+
+  if ( zclOpenEvseOta_phase != OTA_QUERY || len < 1 )
+  {
+    return;
+  }
+  osal_stop_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT );
+  zclOpenEvseOta_phase = OTA_IDLE;
+  if ( pData[0] != ZCL_STATUS_SUCCESS || len < 13 )
+  {
+    return; // ZCL_STATUS_NO_IMAGE_AVAILABLE, most days
+  }
+  version = BUILD_UINT32( pData[5], pData[6], pData[7], pData[8] );
+  size = BUILD_UINT32( pData[9], pData[10], pData[11], pData[12] );
+  if ( BUILD_UINT16( pData[1], pData[2] ) != OPENEVSE_OTA_MANUFACTURER ||
+       BUILD_UINT16( pData[3], pData[4] ) != OPENEVSE_OTA_IMAGE_TYPE ||
+       version == zclOpenEvse_otaFileVersion ||
+       size < OPENEVSE_OTA_HEADER_LEN || size > OPENEVSE_OTA_SLOT_SIZE )
+  {
+    return;
+  }
+
+  if ( version != zclOpenEvse_otaDownloadedVersion || size != zclOpenEvseOta_imageSize )
+  {
+    zclOpenEvse_otaFileOffset = 0;
+    zclOpenEvseOta_stored = 0;
+    zclOpenEvseOta_bufLen = 0;
+  }
+  zclOpenEvse_otaDownloadedVersion = version;
+  zclOpenEvseOta_imageSize = size;
+  zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_DOWNLOADING;
+  zclOpenEvseOta_server = pkt->srcAddr;
+  zclOpenEvseOta_phase = OTA_DOWNLOAD;
+  zclOpenEvseOta_retries = 0;
+  osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_BLOCK_EVT );
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_BlockRsp
+ *
+ * @brief   Store a block and ask for the next one once MinimumBlockPeriod
+ *          has gone by since the last request. Blocks for any other
+ *          offset are late copies and are dropped.
+ *
+ * @param   pData - payload
+ * @param   len - its length
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_BlockRsp( uint8 *pData, uint8 len )
+{
+  uint32 elapsed;
+  uint32 wait;
+  uint8 size;
+
+  if ( zclOpenEvseOta_phase != OTA_DOWNLOAD || len < 1 )
+  {
+    return;
+  }
+
+  if ( pData[0] == ZCL_STATUS_WAIT_FOR_DATA && len >= 9 )
+  {
+    // Current time and request time, then the server's block period if it has one
+    osal_stop_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT );
+    if ( len >= 11 )
+    {
+      zclOpenEvse_otaBlockPeriod = BUILD_UINT16( pData[9], pData[10] );
+    }
+    wait = BUILD_UINT32( pData[5], pData[6], pData[7], pData[8] ) -
+           BUILD_UINT32( pData[1], pData[2], pData[3], pData[4] );
+    osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_BLOCK_EVT,
+                        (wait > 0 && wait <= OPENEVSE_OTA_QUERY_PERIOD / 1000) ? wait * 1000 : zclOpenEvse_otaBlockPeriod + 1 );
+    return;
+  }
+  if ( pData[0] == ZCL_STATUS_ABORT )
+  {
+    zclOpenEvseOta_Reset();
+    return;
+  }
+  if ( pData[0] != ZCL_STATUS_SUCCESS || len < 14 ||
+       BUILD_UINT16( pData[1], pData[2] ) != OPENEVSE_OTA_MANUFACTURER ||
+       BUILD_UINT16( pData[3], pData[4] ) != OPENEVSE_OTA_IMAGE_TYPE ||
+       BUILD_UINT32( pData[5], pData[6], pData[7], pData[8] ) != zclOpenEvse_otaDownloadedVersion ||
+       BUILD_UINT32( pData[9], pData[10], pData[11], pData[12] ) != zclOpenEvse_otaFileOffset )
+  {
+    return;
+  }
+  size = pData[13];
+  if ( size == 0 || size > len - 14 || size > zclOpenEvseOta_imageSize - zclOpenEvse_otaFileOffset )
+  {
+    return;
+  }
+
+  osal_stop_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT );
+  zclOpenEvseOta_Store( &pData[14], size );
+  zclOpenEvse_otaFileOffset += size;
+  zclOpenEvseOta_retries = 0;
+
+  if ( zclOpenEvse_otaFileOffset == zclOpenEvseOta_imageSize )
+  {
+    zclOpenEvseOta_Flush();
+    zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_COMPLETE;
+    zclOpenEvseOta_phase = OTA_VERIFY_HEADER;
+    osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_VERIFY_EVT );
+    return;
+  }
+
+  elapsed = osal_GetSystemClock() - zclOpenEvseOta_lastRequest;
+  if ( elapsed < zclOpenEvse_otaBlockPeriod )
+  {
+    osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_BLOCK_EVT, zclOpenEvse_otaBlockPeriod - elapsed );
+  }
+  else
+  {
+    osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_BLOCK_EVT );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_EndRsp
+ *
+ * @brief   The server says when to upgrade: now, after a while, or in a
+ *          later response.
+ *
+ * @param   pData - payload
+ * @param   len - its length
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_EndRsp( uint8 *pData, uint8 len )
+{
+  uint32 version;
+  uint32 now;
+  uint32 at;
+
+  if ( (zclOpenEvseOta_phase != OTA_END && zclOpenEvseOta_phase != OTA_UPGRADE) || len < 16 )
+  {
+    return;
+  }
+  version = BUILD_UINT32( pData[4], pData[5], pData[6], pData[7] );
+  if ( (BUILD_UINT16( pData[0], pData[1] ) != OPENEVSE_OTA_MANUFACTURER &&
+        BUILD_UINT16( pData[0], pData[1] ) != 0xFFFF) ||
+       (BUILD_UINT16( pData[2], pData[3] ) != OPENEVSE_OTA_IMAGE_TYPE &&
+        BUILD_UINT16( pData[2], pData[3] ) != 0xFFFF) ||
+       (version != zclOpenEvse_otaDownloadedVersion && version != OPENEVSE_OTA_NO_VERSION) )
+  {
+    return;
+  }
+  now = BUILD_UINT32( pData[8], pData[9], pData[10], pData[11] );
+  at = BUILD_UINT32( pData[12], pData[13], pData[14], pData[15] );
+
+  osal_stop_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT );
+  osal_stop_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_UPGRADE_EVT );
+  if ( at == OPENEVSE_OTA_UPGRADE_WAIT )
+  {
+    // Ask again in a while, unless the server sends the time first
+    zclOpenEvseOta_phase = OTA_END;
+    zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_WAIT_FOR_MORE;
+    osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT, OPENEVSE_OTA_WAIT_FOR_MORE );
+    return;
+  }
+  zclOpenEvseOta_phase = OTA_UPGRADE;
+  if ( at > now )
+  {
+    zclOpenEvse_otaStatus = OPENEVSE_OTA_STATUS_COUNTDOWN;
+    osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_UPGRADE_EVT, (at - now) * 1000 );
+  }
+  else
+  {
+    osal_set_event( zclOpenEvseOta_TaskID, OPENEVSE_OTA_UPGRADE_EVT );
+  }
+}
+
+/******************************************************************************
+ *
+ *  Download slot
+ *
+ *****************************************************************************/
+
+// Buffer the image and write it out a block at a time, erasing each
+// slot page as the download reaches it
+static void zclOpenEvseOta_Store( uint8 *data, uint8 len )
+{
+  while ( len-- )
+  {
+    zclOpenEvseOta_buf[zclOpenEvseOta_bufLen++] = *data++;
+    if ( zclOpenEvseOta_bufLen == OPENEVSE_OTA_BLOCK )
+    {
+      zclOpenEvseOta_Flush();
+    }
+  }
+}
+
+// Write what is buffered, padded to whole flash words
+static void zclOpenEvseOta_Flush( void )
+{
+  uint32 addr = OPENEVSE_OTA_SLOT_ADDR + zclOpenEvseOta_stored;
+
+  if ( zclOpenEvseOta_bufLen == 0 )
+  {
+    return;
+  }
+  if ( (zclOpenEvseOta_stored % OPENEVSE_OTA_PAGE_SIZE) == 0 )
+  {
+    HalFlashErase( (uint8)(addr / OPENEVSE_OTA_PAGE_SIZE) );
+  }
+  while ( zclOpenEvseOta_bufLen & 3 )
+  {
+    zclOpenEvseOta_buf[zclOpenEvseOta_bufLen++] = 0xFF;
+  }
+  zclOpenEvseOta_FlashWrite( addr, zclOpenEvseOta_buf, zclOpenEvseOta_bufLen );
+  zclOpenEvseOta_stored += zclOpenEvseOta_bufLen;
+  zclOpenEvseOta_bufLen = 0;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_Verify
+ *
+ * @brief   One step of checking the downloaded image: its header, then
+ *          that the running image is the one the delta was made against,
+ *          then that the delta builds the image it promises without
+ *          reading any page the upgrade will have rewritten by then.
+ *          Tells the server how it went when done, or at the upgrade
+ *          time goes on to rewrite the image.
+ *
+ * @param   none
+ *
+ * @return  TRUE while there is more to check
+ */
+static uint8 zclOpenEvseOta_Verify( void )
+{
+  uint8 ok = TRUE;
+  uint16 n;
+  uint8 i;
+
+  switch ( zclOpenEvseOta_phase )
+  {
+    case OTA_VERIFY_HEADER:
+      ok = zclOpenEvseOta_VerifyHeader();
+      zclOpenEvseOta_phase = OTA_VERIFY_BASE;
+      zclOpenEvseOta_pos = 0;
+      zclOpenEvseOta_crc = 0xFFFFFFFF;
+      break;
+
+    case OTA_VERIFY_BASE:
+      for ( n = 0; n < OPENEVSE_OTA_VERIFY_BYTES && zclOpenEvseOta_pos < zclOpenEvseOta_baseLen;
+            n += OPENEVSE_OTA_BLOCK )
+      {
+        zclOpenEvseOta_FlashRead( zclOpenEvseOta_pos, zclOpenEvseOta_block, OPENEVSE_OTA_BLOCK );
+        zclOpenEvseOta_crc = zclOpenEvseOta_Crc32( zclOpenEvseOta_crc, zclOpenEvseOta_block, OPENEVSE_OTA_BLOCK );
+        zclOpenEvseOta_pos += OPENEVSE_OTA_BLOCK;
+      }
+      if ( zclOpenEvseOta_pos == zclOpenEvseOta_baseLen )
+      {
+        ok = ~zclOpenEvseOta_crc == zclOpenEvseOta_baseCrc;
+        zclOpenEvseOta_phase = OTA_VERIFY_DELTA;
+        zclOpenEvseOta_pos = 0;
+        zclOpenEvseOta_crc = 0xFFFFFFFF;
+        zclOpenEvseOta_cur.rec = zclOpenEvseOta_recStart;
+        zclOpenEvseOta_cur.src = 0;
+        zclOpenEvseOta_cur.left = 0;
+      }
+      break;
+
+    case OTA_VERIFY_DELTA:
+      for ( i = 0; i < OPENEVSE_OTA_VERIFY_BLOCKS && ok &&
+                   zclOpenEvseOta_pos < zclOpenEvseOta_newLen / OPENEVSE_OTA_BLOCK; i++ )
+      {
+        ok = zclOpenEvseOta_NextBlock( zclOpenEvseOta_BlockAddr( zclOpenEvseOta_pos ), zclOpenEvseOta_block );
+        zclOpenEvseOta_crc = zclOpenEvseOta_Crc32( zclOpenEvseOta_crc, zclOpenEvseOta_block, OPENEVSE_OTA_BLOCK );
+        zclOpenEvseOta_pos++;
+      }
+      if ( ok && zclOpenEvseOta_pos == zclOpenEvseOta_newLen / OPENEVSE_OTA_BLOCK )
+      {
+        if ( ~zclOpenEvseOta_crc != zclOpenEvseOta_newCrc || zclOpenEvseOta_cur.left != 0 ||
+             zclOpenEvseOta_cur.rec != zclOpenEvseOta_deltaEnd )
+        {
+          ok = FALSE;
+          break;
+        }
+        if ( zclOpenEvseOta_applying )
+        {
+          zclOpenEvseOta_Apply();
+          return FALSE;
+        }
+        zclOpenEvseOta_phase = OTA_END;
+        zclOpenEvseOta_retries = 0;
+        zclOpenEvseOta_EndRequest( ZCL_STATUS_SUCCESS );
+        osal_start_timerEx( zclOpenEvseOta_TaskID, OPENEVSE_OTA_TIMEOUT_EVT, OPENEVSE_OTA_RSP_TIMEOUT );
+        return FALSE;
+      }
+      break;
+
+    default:
+      return FALSE;
+  }
+
+  if ( !ok )
+  {
+    zclOpenEvseOta_EndRequest( ZCL_STATUS_INVALID_IMAGE );
+    zclOpenEvseOta_Reset();
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_VerifyHeader
+ *
+ * @brief   Check the OTA header against what was asked for and find the
+ *          delta among the sub-elements.
+ *
+ * @param   none
+ *
+ * @return  TRUE if there is a usable delta
+ */
+static uint8 zclOpenEvseOta_VerifyHeader( void )
+{
+  uint8 *hdr = zclOpenEvseOta_block;
+  uint32 off;
+  uint32 len;
+
+  zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR, hdr, OPENEVSE_OTA_HEADER_LEN );
+  if ( BUILD_UINT32( hdr[0], hdr[1], hdr[2], hdr[3] ) != OPENEVSE_OTA_MAGIC ||
+       BUILD_UINT16( hdr[10], hdr[11] ) != OPENEVSE_OTA_MANUFACTURER ||
+       BUILD_UINT16( hdr[12], hdr[13] ) != OPENEVSE_OTA_IMAGE_TYPE ||
+       BUILD_UINT32( hdr[14], hdr[15], hdr[16], hdr[17] ) != zclOpenEvse_otaDownloadedVersion ||
+       BUILD_UINT32( hdr[52], hdr[53], hdr[54], hdr[55] ) != zclOpenEvseOta_imageSize )
+  {
+    return FALSE;
+  }
+
+  // Skip the optional fields and any sub-element that isn't the delta
+  for ( off = BUILD_UINT16( hdr[6], hdr[7] );
+        off + OPENEVSE_OTA_SUB_HEADER_LEN <= zclOpenEvseOta_imageSize;
+        off += OPENEVSE_OTA_SUB_HEADER_LEN + len )
+  {
+    zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + off, hdr, OPENEVSE_OTA_SUB_HEADER_LEN );
+    len = BUILD_UINT32( hdr[2], hdr[3], hdr[4], hdr[5] );
+    if ( len > zclOpenEvseOta_imageSize - off - OPENEVSE_OTA_SUB_HEADER_LEN )
+    {
+      return FALSE;
+    }
+    if ( BUILD_UINT16( hdr[0], hdr[1] ) == OPENEVSE_OTA_TAG_DELTA )
+    {
+      break;
+    }
+  }
+  if ( off + OPENEVSE_OTA_SUB_HEADER_LEN > zclOpenEvseOta_imageSize || len < OPENEVSE_OTA_DELTA_HEADER_LEN )
+  {
+    return FALSE;
+  }
+  off += OPENEVSE_OTA_SUB_HEADER_LEN;
+  zclOpenEvseOta_deltaEnd = off + len;
+  zclOpenEvseOta_recStart = off + OPENEVSE_OTA_DELTA_HEADER_LEN;
+
+  zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + off, hdr, OPENEVSE_OTA_DELTA_HEADER_LEN );
+  zclOpenEvseOta_flags = hdr[1];
+  zclOpenEvseOta_baseLen = BUILD_UINT32( hdr[2], hdr[3], hdr[4], hdr[5] );
+  zclOpenEvseOta_baseCrc = BUILD_UINT32( hdr[6], hdr[7], hdr[8], hdr[9] );
+  zclOpenEvseOta_newLen = BUILD_UINT32( hdr[10], hdr[11], hdr[12], hdr[13] );
+  zclOpenEvseOta_newCrc = BUILD_UINT32( hdr[14], hdr[15], hdr[16], hdr[17] );
+  return hdr[0] == OPENEVSE_OTA_DELTA_VERSION &&
+         zclOpenEvseOta_baseLen % OPENEVSE_OTA_PAGE_SIZE == 0 &&
+         zclOpenEvseOta_baseLen <= OPENEVSE_OTA_IMAGE_MAX &&
+         zclOpenEvseOta_newLen % OPENEVSE_OTA_PAGE_SIZE == 0 &&
+         zclOpenEvseOta_newLen != 0 && zclOpenEvseOta_newLen <= OPENEVSE_OTA_IMAGE_MAX;
+}
+
+/******************************************************************************
+ *
+ *  Building the new image
+ *
+ *****************************************************************************/
+
+// Flash address of a block of the new image, counting in the order they are written
+static uint32 zclOpenEvseOta_BlockAddr( uint32 block )
+{
+  uint16 page = (uint16)(block / OPENEVSE_OTA_PAGE_BLOCKS);
+
+  if ( zclOpenEvseOta_flags & OPENEVSE_OTA_DELTA_DESCENDING )
+  {
+    page = (uint16)(zclOpenEvseOta_newLen / OPENEVSE_OTA_PAGE_SIZE) - 1 - page;
+  }
+  return (uint32)page * OPENEVSE_OTA_PAGE_SIZE +
+         (block % OPENEVSE_OTA_PAGE_BLOCKS) * OPENEVSE_OTA_BLOCK;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_NextBlock
+ *
+ * @brief   Build the next block of the new image from the delta.
+ *
+ * @param   dst - where it goes, to check its source against
+ * @param   block - OPENEVSE_OTA_BLOCK bytes for it
+ *
+ * @return  FALSE if the delta is malformed or reads a rewritten page
+ */
+static uint8 zclOpenEvseOta_NextBlock( uint32 dst, uint8 *block )
+{
+  zclOpenEvseOta_cursor_t *cur = &zclOpenEvseOta_cur;
+  uint32 page = dst - dst % OPENEVSE_OTA_PAGE_SIZE;
+  uint8 buf[3];
+  uint8 runs;
+  uint8 pos;
+
+  if ( cur->left == 0 )
+  {
+    if ( cur->rec >= zclOpenEvseOta_deltaEnd )
+    {
+      return FALSE;
+    }
+    zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + cur->rec++, &cur->hdr, 1 );
+    cur->left = (cur->hdr & (OPENEVSE_OTA_COUNT_MAX - 1)) + 1;
+    if ( (cur->hdr >> 6) == OPENEVSE_OTA_SRC_OLD )
+    {
+      zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + cur->rec, buf, 3 );
+      cur->rec += 3;
+      cur->src = BUILD_UINT32( buf[0], buf[1], buf[2], 0 );
+    }
+    else if ( (cur->hdr >> 6) > OPENEVSE_OTA_SRC_ERASED ||
+              ((cur->hdr & OPENEVSE_OTA_PATCHED) && cur->left != 1) )
+    {
+      return FALSE;
+    }
+  }
+  cur->left--;
+
+  if ( (cur->hdr >> 6) == OPENEVSE_OTA_SRC_ERASED )
+  {
+    osal_memset( block, 0xFF, OPENEVSE_OTA_BLOCK );
+  }
+  else
+  {
+    if ( cur->src + OPENEVSE_OTA_BLOCK > zclOpenEvseOta_baseLen ||
+         ((zclOpenEvseOta_flags & OPENEVSE_OTA_DELTA_DESCENDING) ?
+            cur->src + OPENEVSE_OTA_BLOCK > page + OPENEVSE_OTA_PAGE_SIZE : cur->src < page) )
+    {
+      return FALSE;
+    }
+    zclOpenEvseOta_FlashRead( cur->src, block, OPENEVSE_OTA_BLOCK );
+    cur->src += OPENEVSE_OTA_BLOCK;
+  }
+
+  if ( cur->hdr & OPENEVSE_OTA_PATCHED )
+  {
+    zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + cur->rec++, &runs, 1 );
+    for ( pos = 0; runs; runs-- )
+    {
+      // Bytes skipped and run length
+      zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + cur->rec, buf, 2 );
+      cur->rec += 2;
+      if ( (uint16)buf[0] + buf[1] > OPENEVSE_OTA_BLOCK - pos )
+      {
+        return FALSE;
+      }
+      pos += buf[0];
+      zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SLOT_ADDR + cur->rec, &block[pos], buf[1] );
+      cur->rec += buf[1];
+      pos += buf[1];
+    }
+  }
+  return cur->rec <= zclOpenEvseOta_deltaEnd;
+}
+
+/*********************************************************************
+ * @fn      zclOpenEvseOta_Apply
+ *
+ * @brief   Rewrite the image from the verified delta and restart. Each
+ *          page that changes is built in the scratch page first, since
+ *          its blocks may come from the page itself. Runs with interrupts
+ *          off from code the delta leaves alone, straight after checking
+ *          the slot again. A bad record found before the first image page
+ *          is erased gives the upgrade up; after that there is no going
+ *          back, and a power cut part way leaves a module that needs the
+ *          debugger.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOpenEvseOta_Apply( void )
+{
+  zclOpenEvseOta_cursor_t start;
+  uint16 pages = (uint16)(zclOpenEvseOta_newLen / OPENEVSE_OTA_PAGE_SIZE);
+  uint32 block;
+  uint32 page;
+  uint8 changed;
+  uint8 erased = FALSE;
+  uint8 ok = TRUE;
+  uint8 b;
+
+  HAL_DISABLE_INTERRUPTS();
+  zclOpenEvseOta_cur.rec = zclOpenEvseOta_recStart;
+  zclOpenEvseOta_cur.src = 0;
+  zclOpenEvseOta_cur.left = 0;
+
+  for ( block = 0; block < (uint32)pages * OPENEVSE_OTA_PAGE_BLOCKS; block += OPENEVSE_OTA_PAGE_BLOCKS )
+  {
+    page = zclOpenEvseOta_BlockAddr( block );
+    start = zclOpenEvseOta_cur;
+
+    // Pages the delta leaves as they are aren't erased
+    changed = FALSE;
+    for ( b = 0; b < OPENEVSE_OTA_PAGE_BLOCKS && !changed && ok; b++ )
+    {
+      ok &= zclOpenEvseOta_NextBlock( page + b * OPENEVSE_OTA_BLOCK, zclOpenEvseOta_block );
+      zclOpenEvseOta_FlashRead( page + b * OPENEVSE_OTA_BLOCK, zclOpenEvseOta_cmp, OPENEVSE_OTA_BLOCK );
+      changed = !osal_memcmp( zclOpenEvseOta_block, zclOpenEvseOta_cmp, OPENEVSE_OTA_BLOCK );
+    }
+    if ( !changed && ok )
+    {
+      continue;
+    }
+
+    zclOpenEvseOta_cur = start;
+    HalFlashErase( OPENEVSE_OTA_SCRATCH_PAGE );
+    for ( b = 0; b < OPENEVSE_OTA_PAGE_BLOCKS; b++ )
+    {
+      ok &= zclOpenEvseOta_NextBlock( page + b * OPENEVSE_OTA_BLOCK, zclOpenEvseOta_block );
+      zclOpenEvseOta_FlashWrite( OPENEVSE_OTA_SCRATCH_ADDR + b * OPENEVSE_OTA_BLOCK,
+                                 zclOpenEvseOta_block, OPENEVSE_OTA_BLOCK );
+    }
+    if ( !ok && !erased )
+    {
+      // The image is as it was, so keep running it
+      HAL_ENABLE_INTERRUPTS();
+      zclOpenEvseOta_EndRequest( ZCL_STATUS_INVALID_IMAGE );
+      zclOpenEvseOta_Reset();
+      return;
+    }
+    erased = TRUE;
+    HalFlashErase( (uint8)(page / OPENEVSE_OTA_PAGE_SIZE) );
+    for ( b = 0; b < OPENEVSE_OTA_PAGE_BLOCKS; b++ )
+    {
+      zclOpenEvseOta_FlashRead( OPENEVSE_OTA_SCRATCH_ADDR + b * OPENEVSE_OTA_BLOCK,
+                                zclOpenEvseOta_block, OPENEVSE_OTA_BLOCK );
+      zclOpenEvseOta_FlashWrite( page + b * OPENEVSE_OTA_BLOCK, zclOpenEvseOta_block, OPENEVSE_OTA_BLOCK );
+    }
+  }
+
+  zclOpenEvseOta_phase = OTA_IDLE;
+  Onboard_soft_reset();
+}
+
+/*********************************************************************
+ * Flash by byte address, across page boundaries
+ */
+static void zclOpenEvseOta_FlashRead( uint32 addr, uint8 *buf, uint16 len )
+{
+  uint16 offset;
+  uint16 n;
+
+  while ( len )
+  {
+    offset = (uint16)(addr % OPENEVSE_OTA_PAGE_SIZE);
+    n = OPENEVSE_OTA_PAGE_SIZE - offset;
+    if ( n > len )
+    {
+      n = len;
+    }
+    HalFlashRead( (uint8)(addr / OPENEVSE_OTA_PAGE_SIZE), offset, buf, n );
+    addr += n;
+    buf += n;
+    len -= n;
+  }
+}
+
+// addr and len are whole flash words
+static void zclOpenEvseOta_FlashWrite( uint32 addr, uint8 *buf, uint16 len )
+{
+  HalFlashWrite( (uint16)(addr / HAL_FLASH_WORD_SIZE), buf, len / HAL_FLASH_WORD_SIZE );
+}
+
+#endif // OPENEVSE_OTA
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,154 @@
+/**************************************************************************************************
+  Filename:       zcl_openevse_ota.h
+
+  Description:    OTA Upgrade cluster client for the OpenEVSE module, which
+                  takes block-level delta images and applies them in place.
+
+**************************************************************************************************/
+
+#ifndef ZCL_OPENEVSE_OTA_H
+#define ZCL_OPENEVSE_OTA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcl.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// File version of this build, as the OTA server knows it; set it per
+// release in the project options
+#if !defined OPENEVSE_OTA_FILE_VERSION
+#define OPENEVSE_OTA_FILE_VERSION 0x00000001
+#endif
+#define OPENEVSE_OTA_NO_VERSION 0xFFFFFFFF
+
+// Manufacturer code and image type the module asks for. There is no
+// default: set OPENEVSE_OTA_MANUFACTURER to the code the ZigBee Alliance
+// gave the vendor, so a server never sends this image type of another's.
+#define OPENEVSE_OTA_SAMPLE_MANUFACTURER 0x5678 // Z-Stack's OTA samples
+#define OPENEVSE_OTA_IMAGE_TYPE 0x0E5E
+
+// Flash layout. The download slot sits between the end of the image and
+// the NV pages; its last page is scratch for building each new page of
+// the image. The linker must not place code from OPENEVSE_OTA_SLOT_PAGE on,
+// which ota_tool checks for both builds of a delta.
+#if !defined OPENEVSE_OTA_SLOT_PAGES
+#define OPENEVSE_OTA_SLOT_PAGES 16
+#endif
+#define OPENEVSE_OTA_SCRATCH_PAGE (HAL_NV_PAGE_BEG - 1)
+#define OPENEVSE_OTA_SLOT_PAGE (OPENEVSE_OTA_SCRATCH_PAGE - OPENEVSE_OTA_SLOT_PAGES)
+#define OPENEVSE_OTA_PAGE_SIZE 2048
+#define OPENEVSE_OTA_SLOT_SIZE ((uint32)OPENEVSE_OTA_SLOT_PAGES * OPENEVSE_OTA_PAGE_SIZE)
+#define OPENEVSE_OTA_IMAGE_MAX ((uint32)OPENEVSE_OTA_SLOT_PAGE * OPENEVSE_OTA_PAGE_SIZE)
+
+// OTA Upgrade cluster commands
+#define OPENEVSE_OTA_CMD_IMAGE_NOTIFY 0x00
+#define OPENEVSE_OTA_CMD_QUERY_NEXT_IMAGE_REQ 0x01
+#define OPENEVSE_OTA_CMD_QUERY_NEXT_IMAGE_RSP 0x02
+#define OPENEVSE_OTA_CMD_IMAGE_BLOCK_REQ 0x03
+#define OPENEVSE_OTA_CMD_IMAGE_BLOCK_RSP 0x05
+#define OPENEVSE_OTA_CMD_UPGRADE_END_REQ 0x06
+#define OPENEVSE_OTA_CMD_UPGRADE_END_RSP 0x07
+
+// ImageUpgradeStatus
+#define OPENEVSE_OTA_STATUS_NORMAL 0
+#define OPENEVSE_OTA_STATUS_DOWNLOADING 1
+#define OPENEVSE_OTA_STATUS_COMPLETE 2
+#define OPENEVSE_OTA_STATUS_WAITING 3
+#define OPENEVSE_OTA_STATUS_COUNTDOWN 4
+#define OPENEVSE_OTA_STATUS_WAIT_FOR_MORE 5
+
+// Upgrade End Response upgrade time that means wait for another response
+#define OPENEVSE_OTA_UPGRADE_WAIT 0xFFFFFFFF
+
+// OTA file header, without the optional fields
+#define OPENEVSE_OTA_MAGIC 0x0BEEF11E
+#define OPENEVSE_OTA_HEADER_VERSION 0x0100
+#define OPENEVSE_OTA_HEADER_LEN 56
+#define OPENEVSE_OTA_STACK_PRO 0x0002
+#define OPENEVSE_OTA_SUB_HEADER_LEN 6   // tag (uint16) and length (uint32)
+#define OPENEVSE_OTA_TAG_IMAGE 0x0000   // whole image, for a boot loader
+#define OPENEVSE_OTA_TAG_DELTA 0xF000   // block delta, applied by this module
+
+/*
+ * Block delta. The header is version, flags, then base length, base CRC,
+ * new length and new CRC, all uint32 little endian. Lengths are whole
+ * pages and the CRCs are CRC-32 (reflected 0xEDB88320) of the running
+ * image and of the new one in the order its pages are written: first to
+ * last, or last to first with OPENEVSE_OTA_DELTA_DESCENDING. Within a
+ * page blocks go in address order, each made by a record:
+ *
+ *   header   source << 6 | patched << 5 | count - 1
+ *   offset   3 bytes, with OPENEVSE_OTA_SRC_OLD only
+ *   patch    with patched, which makes count 1: number of runs, then per
+ *            run the bytes skipped since the last one, its length and
+ *            its bytes
+ *
+ * A block from the old image is the 64 bytes at its source offset, and
+ * each further block of a record continues where the last one ended.
+ * Only old pages not yet rewritten may be read from, so in ascending order
+ * a source starts no lower than its page, and in descending order ends no
+ * higher than it.
+ */
+#define OPENEVSE_OTA_DELTA_VERSION 1
+#define OPENEVSE_OTA_DELTA_HEADER_LEN 18
+#define OPENEVSE_OTA_DELTA_DESCENDING 0x01
+#define OPENEVSE_OTA_BLOCK 64
+#define OPENEVSE_OTA_SRC_OLD 0          // old image at the offset given
+#define OPENEVSE_OTA_SRC_NEXT 1         // old image where the last block ended
+#define OPENEVSE_OTA_SRC_ERASED 2       // all 0xFF
+#define OPENEVSE_OTA_PATCHED 0x20
+#define OPENEVSE_OTA_COUNT_MAX 32
+
+// Events
+#define OPENEVSE_OTA_QUERY_EVT 0x0001
+#define OPENEVSE_OTA_BLOCK_EVT 0x0002
+#define OPENEVSE_OTA_TIMEOUT_EVT 0x0004
+#define OPENEVSE_OTA_VERIFY_EVT 0x0008
+#define OPENEVSE_OTA_UPGRADE_EVT 0x0010
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Initialization for the task
+ */
+extern void zclOpenEvseOta_Init( byte task_id );
+
+/*
+ *  Event Process for the task
+ */
+extern UINT16 zclOpenEvseOta_event_loop( byte task_id, UINT16 events );
+
+/*
+ * OTA Upgrade cluster frame from the server, to the first charger endpoint
+ */
+extern uint8 zclOpenEvseOta_ProcessAFMsg( afIncomingMSGPacket_t *pkt );
+
+/*
+ * The module is on the network; start asking for images
+ */
+extern void zclOpenEvseOta_NwkUp( void );
+
+/*
+ * CRC-32 of a buffer, continuing from crc; start from 0xFFFFFFFF and
+ * invert the result
+ */
+extern uint32 zclOpenEvseOta_Crc32( uint32 crc, const uint8 *buf, uint16 len );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZCL_OPENEVSE_OTA_H */
@@ -23,6 +23,7 @@ metadata {
 		capability "Voltage Measurement"
 
 		attribute "chargeLimit", "string"
+		attribute "pilotAmps", "number"
 
 		command "backlightOff"
 		command "backlightOn"
@@ -160,6 +161,18 @@ def parse(String description) {
 				sendEvent(name: "powerkw", value: (zigbee.convertHexToInt(descMap.value) / (float)100.0).round(1), unit: "kW") // Convert from tens of W to kW
 				sendEvent(name: "power", value: zigbee.convertHexToInt(descMap.value) * (float)10.0, unit: "W") // Convert from tens of W to W
 		}
+	} else if (descMap.cluster == "0008" && descMap.attrId == "0000") {
+		// Level Control's CurrentLevel is the pilot current in amps
+		sendEvent(name: "pilotAmps", value: zigbee.convertHexToInt(descMap.value), unit: "A")
+	} else if (descMap.clusterId == "0B02" && descMap.command == "01") {
+		// Alerts Notification: count, then ID, category and recovery, and a 0 byte per alert
+		def count = zigbee.convertHexToInt(descMap.data[0]) & 0x0F
+		for (int i = 0; i < count; i++) {
+			def id = zigbee.convertHexToInt(descMap.data[1 + 3 * i])
+			def recovered = zigbee.convertHexToInt(descMap.data[2 + 3 * i]) & 0x10
+			if (id >= 0x04 && id <= 0x0B && !recovered)
+				sendEvent(name: "state", value: "fault")
+		}
 	}
 }
 
@@ -188,9 +201,11 @@ def off() {
 }
 
 private getCLUSTER_DEVTEMP() { 0x0002 }
+private getCLUSTER_LEVEL() { 0x0008 }
 private getCLUSTER_MULTISTATE() { 0x0012 }
 private getCLUSTER_METERING() { 0x0702 }
 private getCLUSTER_ELECMEAS() { 0x0B04 }
+private getCLUSTER_ALERTS() { 0x0B02 }
 
 private getMULTISTATE_ATTR_VALUE() { 0x0055 }
 private getDEVTEMP_ATTR_VALUE() { 0x0000 }
@@ -220,7 +235,11 @@ def configure() {
         zigbee.configSetup("${CLUSTER_ELECMEAS}", "${ELECMEAS_ATTR_AMPS}",
                            "${TYPE_U16}", 2, 60, "{01}") +
         zigbee.configSetup("${CLUSTER_ELECMEAS}", "${ELECMEAS_ATTR_WATTS}",
-                           "${TYPE_S16}", 2, 60, "{01}")
+                           "${TYPE_S16}", 2, 60, "{01}") +
+        // The module reports the pilot current and sends alerts and events
+        // itself; these only need the bind
+        ["zdo bind 0x${device.deviceNetworkId} ${endpointId} 1 ${CLUSTER_LEVEL} {${device.zigbeeId}} {}", "delay 500",
+         "zdo bind 0x${device.deviceNetworkId} ${endpointId} 1 ${CLUSTER_ALERTS} {${device.zigbeeId}} {}", "delay 500"]
     log.info "configure() --- cmds: $cmds"
     return cmds
 }
@@ -0,0 +1,358 @@
+/*
+ * alert_bench.c - EVSE faults and temperature alerts pushed by the module
+ * against the hub polling for them.
+ *
+ * Usage: alert_bench [-H hours] [-f fault_min] [-g glitch_min] [-s seed]
+ *
+ * The car charges at 32 A. The EVSE faults every fault_min minutes on
+ * average (10 by default), into one of its error states 4 to 0x0A, for 3
+ * to 60 s before it recovers. The hottest sensor reads 35 C; every 40
+ * minutes on average it goes over 70 C for 2 to 5 minutes, and every
+ * glitch_min minutes (2 by default) a single $GP sample reads 95 C.
+ * Runs:
+ *
+ *   poll 30s  the hub reads the state and the hottest sensor every 30 s
+ *   poll 5s   the same every 5 s
+ *   push      the module's Alerts Notifications
+ *
+ * For each run it reports the faults caught, the time from the fault to
+ * the hub seeing it (p50 and max), faults over before the hub saw them,
+ * the over temperature spells caught, alerts for a glitch and nothing
+ * else, and the frames between module and hub: a read and its response
+ * per poll, or the Appliance Events & Alerts frames. Times are to the
+ * frame leaving the module.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define ALERT_CAR_AMPS 32
+#define ALERT_TEMP_DECIC 350
+#define ALERT_HOT_DECIC 750
+#define ALERT_GLITCH_DECIC 950
+#define ALERT_LIMIT_DECIC 700       // module default for the hot alert, which the hub uses too
+#define ALERT_GLITCH_US 600000      // one $GP sample
+#define ALERT_HOT_MIN 40
+#define ALERT_FAULTS_MAX 1024
+
+enum { ALERT_POLL_30, ALERT_POLL_5, ALERT_PUSH, ALERT_RUNS };
+
+static const char *alertRunNames[ALERT_RUNS] = { "poll 30s", "poll 5s", "push" };
+static const uint32_t alertPollUs[ALERT_RUNS] = { 30000000, 5000000, 0 };
+
+typedef struct
+{
+  uint32_t faults;
+  uint32_t seen;
+  uint32_t missed;
+  double p50Ms;
+  double maxMs;
+  uint32_t hot;
+  uint32_t hotSeen;
+  uint32_t spurious;
+  uint32_t frames;
+} alertResult_t;
+
+static evse_t alertEvse;
+static alertResult_t alertResult;
+static uint8_t alertRun;
+static double alertFaultMin = 10;
+static double alertGlitchMin = 2;
+static double alertHours = 24;
+static uint32_t alertSeed = 1;
+
+static uint64_t alertFaultAt[ALERT_FAULTS_MAX];
+static double alertLatency[ALERT_FAULTS_MAX];
+static uint8_t alertFaultState;     // in force, 0 for none
+static uint8_t alertFaultSeen;
+static uint8_t alertHotOn;          // a real spell over the limit
+static uint8_t alertHotSeen;
+static uint8_t alertHubHot;         // hub's view of the hot alert
+static uint8_t alertHubFault;       // fault alert the hub was last told is in force
+
+static uint64_t alert_exp_us( double meanMin )
+{
+  return (uint64_t)(-meanMin * 60e6 * log1p( -bench_rand( &alertSeed ) ));
+}
+
+// The hub learns of the fault in force
+static void alert_fault_seen( void )
+{
+  if ( alertFaultState == 0 || alertFaultSeen )
+  {
+    return;
+  }
+  alertFaultSeen = 1;
+  alertLatency[alertResult.seen++] = (sim_now_us() - alertFaultAt[alertResult.faults - 1]) / 1e3;
+}
+
+// The hub raises its hot alert
+static void alert_hot_seen( void )
+{
+  if ( alertHotOn )
+  {
+    if ( !alertHotSeen )
+    {
+      alertHotSeen = 1;
+      alertResult.hotSeen++;
+    }
+  }
+  else
+  {
+    alertResult.spurious++;
+  }
+}
+
+static void alert_fault_end( void *arg, uint32_t argInt );
+
+static void alert_fault( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  if ( alertResult.faults < ALERT_FAULTS_MAX )
+  {
+    alertFaultState = EVSE_STATE_VENT_REQ + (uint8_t)(bench_rand( &alertSeed ) * (EVSE_STATE_OVER_TEMP - EVSE_STATE_VENT_REQ + 1));
+    alertFaultSeen = 0;
+    alertFaultAt[alertResult.faults++] = sim_now_us();
+    evse_set_state( &alertEvse, alertFaultState );
+    if ( alertHubFault == alertFaultState )
+    {
+      alert_fault_seen(); // Back within the clear time, the alert never went
+    }
+    sim_schedule( sim_now_us() + 3000000 + (uint64_t)(bench_rand( &alertSeed ) * 57e6), alert_fault_end, NULL, 0 );
+  }
+}
+
+static void alert_fault_end( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  if ( !alertFaultSeen )
+  {
+    alertResult.missed++;
+  }
+  alertFaultState = 0;
+  evse_set_state( &alertEvse, EVSE_STATE_CHARGING );
+  sim_schedule( sim_now_us() + alert_exp_us( alertFaultMin ), alert_fault, NULL, 0 );
+}
+
+static void alert_temp( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  switch ( argInt )
+  {
+    case 0: // Spell over
+      evse_set_temp( &alertEvse, ALERT_TEMP_DECIC );
+      alertHotOn = 0;
+      sim_schedule( sim_now_us() + alert_exp_us( ALERT_HOT_MIN ), alert_temp, NULL, 1 );
+      break;
+    case 1: // A spell over the limit
+      alertHotOn = 1;
+      alertHotSeen = 0;
+      alertResult.hot++;
+      if ( alertHubHot )
+      {
+        alert_hot_seen(); // Still up from the last one
+      }
+      evse_set_temp( &alertEvse, ALERT_HOT_DECIC );
+      sim_schedule( sim_now_us() + 120000000 + (uint64_t)(bench_rand( &alertSeed ) * 180e6), alert_temp, NULL, 0 );
+      break;
+    case 2: // One bad sample, unless a spell is on
+      if ( !alertHotOn )
+      {
+        evse_set_temp( &alertEvse, ALERT_GLITCH_DECIC );
+        sim_schedule( sim_now_us() + ALERT_GLITCH_US, alert_temp, NULL, 3 );
+      }
+      sim_schedule( sim_now_us() + alert_exp_us( alertGlitchMin ), alert_temp, NULL, 2 );
+      break;
+    case 3: // Glitch over, unless a spell has started since
+      if ( !alertHotOn )
+      {
+        evse_set_temp( &alertEvse, ALERT_TEMP_DECIC );
+      }
+      break;
+  }
+}
+
+static void alert_poll( void *arg, uint32_t argInt )
+{
+  uint16 state = 0;
+  int16 temp = 0;
+
+  (void)arg;
+  (void)argInt;
+  alertResult.frames += 2;
+  sim_zcl_read( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC, ATTRID_IOV_BASIC_PRESENT_VALUE,
+                &state, sizeof( state ) );
+  sim_zcl_read( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_THERMAL_TEMP,
+                &temp, sizeof( temp ) );
+  if ( (uint8_t)state == alertFaultState )
+  {
+    alert_fault_seen();
+  }
+  if ( temp >= ALERT_LIMIT_DECIC && !alertHubHot )
+  {
+    alertHubHot = 1;
+    alert_hot_seen();
+  }
+  else if ( temp < ALERT_LIMIT_DECIC )
+  {
+    alertHubHot = 0;
+  }
+  sim_schedule( sim_now_us() + alertPollUs[alertRun], alert_poll, NULL, 0 );
+}
+
+static void alert_frame( uint64_t t_us, uint8 endpoint, afAddrType_t *dstAddr, uint16 clusterId,
+                         const uint8 *buf, uint16 len )
+{
+  uint8 i;
+
+  (void)t_us;
+  (void)endpoint;
+  (void)dstAddr;
+  if ( clusterId != ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS )
+  {
+    return;
+  }
+  if ( alertRun != ALERT_PUSH )
+  {
+    return;
+  }
+  alertResult.frames++;
+  if ( len < 4 || buf[2] != OPENEVSE_ALERTS_CMD_ALERTS_NOTIFICATION )
+  {
+    return;
+  }
+  for ( i = 0; i < (buf[3] & 0x0F) && 4 + 3 * i + 2 < len; i++ )
+  {
+    const uint8 *alert = &buf[4 + 3 * i];
+
+    if ( alert[1] & OPENEVSE_ALERT_RECOVERY )
+    {
+      continue;
+    }
+    if ( alert[0] == alertFaultState )
+    {
+      alertHubFault = alert[0];
+      alert_fault_seen();
+    }
+    else if ( alert[0] == 0x20 && !alertHubHot )
+    {
+      alertHubHot = 1;
+      alert_hot_seen();
+    }
+  }
+  for ( i = 0; i < (buf[3] & 0x0F) && 4 + 3 * i + 2 < len; i++ )
+  {
+    const uint8 *alert = &buf[4 + 3 * i];
+
+    if ( alert[1] & OPENEVSE_ALERT_RECOVERY )
+    {
+      if ( alert[0] == 0x20 )
+      {
+        alertHubHot = 0;
+      }
+      else if ( alert[0] == alertHubFault )
+      {
+        alertHubFault = 0;
+      }
+    }
+  }
+}
+
+static int alert_cmp( const void *a, const void *b )
+{
+  double d = *(const double *)a - *(const double *)b;
+
+  return (d > 0) - (d < 0);
+}
+
+// One run, by bench_run_child
+static void alert_run( void *arg, void *result )
+{
+  evseCfg_t cfg = evse_default_cfg;
+
+  alertRun = *(const uint8_t *)arg;
+  evse_init( &alertEvse, &cfg, sim_uart_evse_send, sim_now_us );
+  bench_evse = &alertEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_frame_hook = alert_frame;
+  sim_osal_init();
+  sim_set_nwk_state( DEV_ROUTER );
+  evse_set_temp( &alertEvse, ALERT_TEMP_DECIC );
+  evse_plug( &alertEvse, 1 );
+  evse_charge( &alertEvse, ALERT_CAR_AMPS );
+  sim_schedule( 60000000 + alert_exp_us( alertFaultMin ), alert_fault, NULL, 0 );
+  sim_schedule( 60000000 + alert_exp_us( ALERT_HOT_MIN ), alert_temp, NULL, 1 );
+  sim_schedule( 60000000 + alert_exp_us( alertGlitchMin ), alert_temp, NULL, 2 );
+  if ( alertPollUs[alertRun] )
+  {
+    sim_schedule( alertPollUs[alertRun], alert_poll, NULL, 0 );
+  }
+  sim_run_until( (uint64_t)(alertHours * 3600e6) );
+
+  if ( alertFaultState && !alertFaultSeen )
+  {
+    alertResult.faults--; // Still on at the end, not counted
+  }
+  qsort( alertLatency, alertResult.seen, sizeof( alertLatency[0] ), alert_cmp );
+  if ( alertResult.seen )
+  {
+    alertResult.p50Ms = alertLatency[alertResult.seen / 2];
+    alertResult.maxMs = alertLatency[alertResult.seen - 1];
+  }
+  *(alertResult_t *)result = alertResult;
+}
+
+int main( int argc, char **argv )
+{
+  uint8_t run;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "H:f:g:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'H': alertHours = atof( optarg ); break;
+      case 'f': alertFaultMin = atof( optarg ); break;
+      case 'g': alertGlitchMin = atof( optarg ); break;
+      case 's': alertSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-H hours] [-f fault_min] [-g glitch_min] [-s seed]\n", argv[0] );
+        return 2;
+    }
+  }
+  if ( alertHours <= 0 || alertFaultMin <= 0 || alertGlitchMin <= 0 )
+  {
+    fprintf( stderr, "%s: hours and intervals must be positive\n", argv[0] );
+    return 2;
+  }
+
+  printf( "EVSE faults every %.0f min, temperature glitches every %.0f min, over %.1f hours\n",
+          alertFaultMin, alertGlitchMin, alertHours );
+  printf( "%-9s %6s %6s %9s %9s %6s %7s %8s %6s\n", "run", "faults", "seen", "p50 ms", "max ms",
+          "missed", "hot", "spurious", "frames" );
+  for ( run = 0; run < ALERT_RUNS; run++ )
+  {
+    alertResult_t r;
+    char hot[16];
+
+    if ( bench_run_child( alert_run, &run, &r, sizeof( r ) ) < 0 )
+    {
+      fprintf( stderr, "%s: run failed\n", alertRunNames[run] );
+      return 1;
+    }
+
+    snprintf( hot, sizeof( hot ), "%u/%u", r.hotSeen, r.hot );
+    printf( "%-9s %6u %6u %9.0f %9.0f %6u %7s %8u %6u\n", alertRunNames[run], r.faults, r.seen,
+            r.p50Ms, r.maxMs, r.missed, hot, r.spurious, r.frames );
+  }
+  return 0;
+}
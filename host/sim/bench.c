@@ -0,0 +1,109 @@
+/*
+ * bench.c - latency samples, the benchmark report, runs from power-up, the
+ * benches' random numbers and their single EVSE model.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "evse_model.h"
+
+struct evse *bench_evse = NULL;
+
+void bench_add( benchSeries_t *s, double ms )
+{
+  if ( s->count == s->size )
+  {
+    s->size = s->size ? s->size * 2 : 256;
+    s->ms = realloc( s->ms, s->size * sizeof( double ) );
+  }
+  s->ms[s->count++] = ms;
+}
+
+static int bench_cmp( const void *a, const void *b )
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+double bench_percentile( const benchSeries_t *s, double pct )
+{
+  uint32_t i;
+
+  if ( s->count == 0 )
+  {
+    return 0;
+  }
+  qsort( s->ms, s->count, sizeof( double ), bench_cmp );
+  i = (uint32_t)(pct / 100.0 * (s->count - 1) + 0.5);
+  return s->ms[i];
+}
+
+void bench_print( const benchSeries_t *s )
+{
+  double sum = 0;
+  uint32_t i;
+
+  if ( s->count == 0 )
+  {
+    printf( "  %-28s %8s\n", s->name, "no samples" );
+    return;
+  }
+  for ( i = 0; i < s->count; i++ )
+  {
+    sum += s->ms[i];
+  }
+  printf( "  %-28s n=%-6u min %8.1f  p50 %8.1f  p99 %8.1f  max %8.1f  mean %8.1f ms\n",
+          s->name, s->count, bench_percentile( s, 0 ), bench_percentile( s, 50 ),
+          bench_percentile( s, 99 ), bench_percentile( s, 100 ), sum / s->count );
+}
+
+int bench_run_child( benchRunFn_t fn, void *arg, void *result, size_t size )
+{
+  ssize_t got;
+  int fds[2];
+  pid_t pid;
+
+  if ( pipe( fds ) < 0 )
+  {
+    perror( "pipe" );
+    return -1;
+  }
+  fflush( stdout );
+  pid = fork();
+  if ( pid == 0 )
+  {
+    close( fds[0] );
+    fn( arg, result );
+    _exit( write( fds[1], result, size ) == (ssize_t)size ? 0 : 1 );
+  }
+  close( fds[1] );
+  got = pid < 0 ? -1 : read( fds[0], result, size );
+  close( fds[0] );
+  if ( pid > 0 )
+  {
+    waitpid( pid, NULL, 0 );
+  }
+  return got == (ssize_t)size ? 0 : -1;
+}
+
+uint32_t bench_rand32( uint32_t *seed )
+{
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 17;
+  *seed ^= *seed << 5;
+  return *seed;
+}
+
+double bench_rand( uint32_t *seed )
+{
+  return (bench_rand32( seed ) & 0xFFFFFF) / (double)0x1000000;
+}
+
+void bench_uart_to_evse( uint8_t port, const uint8_t *buf, uint16_t len )
+{
+  (void)port;
+  evse_rx( bench_evse, buf, len );
+}
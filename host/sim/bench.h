@@ -0,0 +1,42 @@
+/*
+ * bench.h - latency samples, the benchmark report, runs from power-up, the
+ * benches' random numbers and their single EVSE model.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+  const char *name;
+  double *ms;
+  uint32_t count;
+  uint32_t size;
+} benchSeries_t;
+
+extern void bench_add( benchSeries_t *s, double ms );
+extern void bench_print( const benchSeries_t *s );
+extern double bench_percentile( const benchSeries_t *s, double pct );
+
+// One run of a scenario, leaving what it found in result
+typedef void (*benchRunFn_t)( void *arg, void *result );
+
+// The application keeps its state in statics, so each run starts from
+// power-up in a child process, which hands result back over a pipe.
+// Returns 0, or -1 when the child didn't get to the end.
+extern int bench_run_child( benchRunFn_t fn, void *arg, void *result, size_t size );
+
+// xorshift32 from *seed, which must not be 0, so a run repeats for a seed
+extern uint32_t bench_rand32( uint32_t *seed );
+// The same, as a fraction in [0, 1)
+extern double bench_rand( uint32_t *seed );
+
+// UART sink for a bench with one EVSE model: the module's frames go to
+// bench_evse once they are off the wire, whatever the port
+struct evse;
+extern struct evse *bench_evse;
+extern void bench_uart_to_evse( uint8_t port, const uint8_t *buf, uint16_t len );
+
+#endif /* BENCH_H */
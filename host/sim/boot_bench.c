@@ -0,0 +1,179 @@
+/*
+ * boot_bench.c - time from power-up to the first report.
+ *
+ * Usage: boot_bench [-n devices] [-j join_ms] [-d reply_ms] [-J]
+ *
+ * Powers the module and the EVSE model up together and runs until the
+ * first report reaches the air, for a range of EVSE boot times (how long
+ * the EVSE ignores RAPI while it runs its self test). Each boot time is
+ * tried with n module addresses, so n different jitter seeds, and the
+ * network comes up join_ms after power-up (default 2000).
+ *
+ * For each boot time it reports power-up to first report, and the part of
+ * that after both the EVSE and the network were ready: the later of the
+ * EVSE's first reply and the join. -J turns the startup and report jitter
+ * off, leaving only the application's own delays.
+ *
+ * zcl_openevse.c is compiled into this file so the jitter settings can be
+ * changed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+
+#include "zcl_openevse.c"
+
+#define BOOT_LIMIT_US 120000000 // give up on a trial after 2 minutes
+
+typedef struct
+{
+  double firstReportMs;
+  double afterReadyMs;
+} bootResult_t;
+
+typedef struct
+{
+  const evseCfg_t *cfg;
+  uint16_t device;
+  uint32_t joinMs;
+  int noJitter;
+} bootTrial_t;
+
+static const uint32_t bootTimes[] = { 0, 1000, 2000, 4000, 8000 };
+
+#define BOOT_NUM_TIMES (sizeof( bootTimes ) / sizeof( bootTimes[0] ))
+
+static evse_t bootEvse;
+static uint64_t bootFirstReport_us = 0;
+static uint64_t bootEvseReady_us = 0;
+
+static void boot_evse_reply( evse_t *e, const char *cmd, const char *reply, uint32_t delayMs )
+{
+  (void)e;
+  (void)cmd;
+  (void)reply;
+  if ( bootEvseReady_us == 0 )
+  {
+    bootEvseReady_us = sim_now_us() + (uint64_t)delayMs * 1000;
+  }
+}
+
+static void boot_report( uint64_t t_us, uint8 endpoint, uint16 clusterId, uint16 attrId, uint32_t value )
+{
+  (void)endpoint;
+  (void)clusterId;
+  (void)attrId;
+  (void)value;
+  if ( bootFirstReport_us == 0 )
+  {
+    bootFirstReport_us = t_us;
+  }
+}
+
+static void boot_join( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  sim_set_nwk_state( DEV_ROUTER );
+}
+
+// One power-up, run by bench_run_child
+static void boot_trial( void *arg, void *result )
+{
+  const bootTrial_t *trial = arg;
+  bootResult_t *r = result;
+  uint64_t ready;
+
+  sim_ext_addr[0] = (uint8)trial->device;
+  sim_ext_addr[1] = (uint8)(trial->device >> 8);
+  if ( trial->noJitter )
+  {
+    zclOpenEvse_startupJitter = 0;
+    zclOpenEvse_reportJitter = 0;
+  }
+
+  evse_init( &bootEvse, trial->cfg, sim_uart_evse_send, sim_now_us );
+  bootEvse.onReply = boot_evse_reply;
+  bench_evse = &bootEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_report_hook = boot_report;
+  sim_osal_init();
+  sim_schedule( (uint64_t)trial->joinMs * 1000, boot_join, NULL, 0 );
+
+  while ( bootFirstReport_us == 0 && sim_now_us() < BOOT_LIMIT_US )
+  {
+    sim_run_until( sim_now_us() + 10000 );
+  }
+
+  ready = (uint64_t)trial->joinMs * 1000;
+  if ( bootEvseReady_us > ready )
+  {
+    ready = bootEvseReady_us;
+  }
+  r->firstReportMs = bootFirstReport_us ? bootFirstReport_us / 1000.0 : -1;
+  r->afterReadyMs = bootFirstReport_us ? (bootFirstReport_us - ready) / 1000.0 : -1;
+}
+
+int main( int argc, char **argv )
+{
+  evseCfg_t cfg = evse_default_cfg;
+  uint32_t devices = 50;
+  uint32_t joinMs = 2000;
+  int noJitter = 0;
+  uint8 t;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "n:j:d:J" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'n': devices = (uint32_t)atoi( optarg ); break;
+      case 'j': joinMs = (uint32_t)atoi( optarg ); break;
+      case 'd': cfg.respDelayMs = (uint32_t)atoi( optarg ); break;
+      case 'J': noJitter = 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-n devices] [-j join_ms] [-d reply_ms] [-J]\n", argv[0] );
+        return 2;
+    }
+  }
+
+  printf( "Power-up to first report: %u devices per EVSE boot time, join at %u ms, jitter %s\n",
+          devices, joinMs, noJitter ? "off" : "on" );
+  printf( "%9s  %-30s %-30s %s\n", "EVSE boot", "first report p50/p99/max s",
+          "after ready p50/p99/max s", "missed" );
+  for ( t = 0; t < BOOT_NUM_TIMES; t++ )
+  {
+    benchSeries_t first = { "first report" };
+    benchSeries_t after = { "after ready" };
+    uint32_t missed = 0;
+    uint32_t d;
+
+    cfg.bootMs = bootTimes[t];
+    for ( d = 0; d < devices; d++ )
+    {
+      bootTrial_t trial = { &cfg, (uint16_t)(d + 1), joinMs, noJitter };
+      bootResult_t r;
+
+      if ( bench_run_child( boot_trial, &trial, &r, sizeof( r ) ) < 0 || r.firstReportMs < 0 )
+      {
+        missed++;
+      }
+      else
+      {
+        bench_add( &first, r.firstReportMs / 1000.0 );
+        bench_add( &after, r.afterReadyMs / 1000.0 );
+      }
+    }
+    printf( "%7.1f s  %8.2f %8.2f %8.2f     %8.2f %8.2f %8.2f     %u\n", cfg.bootMs / 1000.0,
+            bench_percentile( &first, 50 ), bench_percentile( &first, 99 ), bench_percentile( &first, 100 ),
+            bench_percentile( &after, 50 ), bench_percentile( &after, 99 ), bench_percentile( &after, 100 ),
+            missed );
+    free( first.ms );
+    free( after.ms );
+  }
+  return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * burst_bench.c - bursts of $ST overrunning the RAPI receive ring.
+ *
+ * Usage: burst_bench [-m minutes] [-t stall_ms] [-p period_s] [-s seed]
+ *
+ * Every period_s seconds (5 by default) the EVSE answers the module's next
+ * command after a burst of $ST frames, as a contactor bouncing through
+ * states would send, and the module is held up for stall_ms (20 by
+ * default, about a flash page erase) from the burst on, so the HAL poll
+ * doesn't empty the 64 byte ring. The last $ST of a burst is always a state
+ * the module didn't have before it. Each burst size runs for minutes (30
+ * by default) of simulated time.
+ *
+ * For each size it reports the bytes lost to a full ring, the overruns the
+ * module detected, bursts that left it with the wrong state once the ring
+ * had been read, the time to put that right (p50 and max), bursts still
+ * wrong when the next one came, and resends and commands given up on.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define BURST_FRAME_BYTES 10        // "$ST 02^xx\r"
+#define BURST_CHECK_US 10000
+#define BURST_SETTLE_US 2000       // past the idle time, so the callback has run
+#define BURST_BOOT_US 30000000      // let the module find the EVSE first
+#define BURST_MAX 4096
+
+static const uint8_t burstSizes[] = { 1, 2, 3, 4, 6, 8, 12, 16 };
+static const uint8_t burstStates[] = { EVSE_STATE_READY, EVSE_STATE_CONNECTED, EVSE_STATE_CHARGING };
+
+#define BURST_NUM_SIZES (sizeof( burstSizes ) / sizeof( burstSizes[0] ))
+
+typedef struct
+{
+  uint32_t bursts;
+  uint64_t bytes;
+  uint64_t lost;
+  uint32_t overruns;
+  uint32_t stale;
+  uint32_t unrecovered;
+  double p50Ms;
+  double maxMs;
+  uint32_t resends;
+  uint32_t abandoned;
+} burstResult_t;
+
+static evse_t burstEvse;
+static burstResult_t burstResult;
+static uint8_t burstSize;
+static uint32_t burstStallMs = 20;
+static uint32_t burstPeriodS = 5;
+static uint32_t burstSeed = 1;
+static double burstMinutes = 30;
+
+static uint8_t burstArmed;
+static uint8_t burstChecking;
+static uint64_t burstSettled;       // ring read out after the last burst
+static double burstRecover[BURST_MAX];
+static uint32_t burstRecovered;
+
+// Until the module has the EVSE's state again, or the next burst
+static void burst_check( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  if ( !burstChecking )
+  {
+    return;
+  }
+  if ( zclOpenEvse_evse[0].state == burstEvse.state )
+  {
+    burstChecking = FALSE;
+    if ( burstRecovered < BURST_MAX )
+    {
+      burstRecover[burstRecovered++] = (sim_now_us() - burstSettled) / 1000.0;
+    }
+    return;
+  }
+  sim_schedule( sim_now_us() + BURST_CHECK_US, burst_check, NULL, 0 );
+}
+
+// The ring has been read out after the burst
+static void burst_settled( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  burstSettled = sim_now_us();
+  if ( zclOpenEvse_evse[0].state != burstEvse.state )
+  {
+    burstResult.stale++;
+    burstChecking = TRUE;
+    sim_schedule( sim_now_us() + BURST_CHECK_US, burst_check, NULL, 0 );
+  }
+}
+
+static void burst_arm( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  if ( burstChecking )
+  {
+    burstResult.unrecovered++;
+    burstChecking = FALSE;
+  }
+  burstArmed = TRUE;
+  sim_schedule( sim_now_us() + (uint64_t)burstPeriodS * 1000000, burst_arm, NULL, 0 );
+}
+
+// Bounce through states, ending in one the module didn't have
+static uint64_t burst_send( void )
+{
+  uint8_t before = burstEvse.state;
+  uint8_t state = before;
+  uint8_t i;
+
+  for ( i = 0; i < burstSize; i++ )
+  {
+    uint8_t next;
+
+    do
+    {
+      next = burstStates[bench_rand32( &burstSeed ) % sizeof( burstStates )];
+    } while ( next == state || (i == burstSize - 1 && next == before) );
+    evse_set_state( &burstEvse, next );
+    state = next;
+  }
+  return sim_now_us() + (uint64_t)burstSize * BURST_FRAME_BYTES * SIM_UART_BYTE_US;
+}
+
+static void burst_uart_to_evse( uint8 port, const uint8 *buf, uint16 len )
+{
+  uint64_t end;
+
+  (void)port;
+  if ( !burstArmed )
+  {
+    evse_rx( &burstEvse, buf, len );
+    return;
+  }
+  burstArmed = FALSE;
+  burstResult.bursts++;
+  end = burst_send();
+  evse_rx( &burstEvse, buf, len ); // The reply queues behind the burst
+  sim_uart_stall( sim_now_us() + (uint64_t)burstStallMs * 1000 );
+  if ( end < sim_now_us() + (uint64_t)burstStallMs * 1000 )
+  {
+    end = sim_now_us() + (uint64_t)burstStallMs * 1000;
+  }
+  sim_schedule( end + BURST_SETTLE_US, burst_settled, NULL, 0 );
+}
+
+static int burst_cmp( const void *a, const void *b )
+{
+  double d = *(const double *)a - *(const double *)b;
+
+  return (d > 0) - (d < 0);
+}
+
+// One burst size, by bench_run_child
+static void burst_run( void *arg, void *result )
+{
+  uint8_t size = *(const uint8_t *)arg;
+  evseCfg_t cfg = evse_default_cfg;
+  zclOpenEvse_linkStats_t *link = &zclOpenEvse_evse[0].link;
+
+  burstSize = size;
+  burstSeed += size;
+  evse_init( &burstEvse, &cfg, sim_uart_evse_send, sim_now_us );
+  sim_uart_sink = burst_uart_to_evse;
+  sim_osal_init();
+  sim_set_nwk_state( DEV_ROUTER );
+  sim_schedule( BURST_BOOT_US, burst_arm, NULL, 0 );
+  sim_run_until( BURST_BOOT_US + (uint64_t)(burstMinutes * 60e6) );
+
+  if ( burstChecking )
+  {
+    burstResult.stale--; // Still being put right at the end, not counted
+  }
+  burstResult.bytes = sim_uart_rx_bytes[HAL_UART_PORT_0];
+  burstResult.lost = sim_uart_rx_overflow[HAL_UART_PORT_0];
+  burstResult.overruns = link->rxOverflow;
+  burstResult.resends = link->resends;
+  burstResult.abandoned = link->abandoned;
+  qsort( burstRecover, burstRecovered, sizeof( burstRecover[0] ), burst_cmp );
+  if ( burstRecovered )
+  {
+    burstResult.p50Ms = burstRecover[burstRecovered / 2];
+    burstResult.maxMs = burstRecover[burstRecovered - 1];
+  }
+  *(burstResult_t *)result = burstResult;
+}
+
+int main( int argc, char **argv )
+{
+  uint8_t i;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "m:t:p:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'm': burstMinutes = atof( optarg ); break;
+      case 't': burstStallMs = (uint32_t)atoi( optarg ); break;
+      case 'p': burstPeriodS = (uint32_t)atoi( optarg ); break;
+      case 's': burstSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-m minutes] [-t stall_ms] [-p period_s] [-s seed]\n", argv[0] );
+        return 2;
+    }
+  }
+  if ( burstMinutes <= 0 || burstPeriodS == 0 )
+  {
+    fprintf( stderr, "%s: minutes and period must be positive\n", argv[0] );
+    return 2;
+  }
+
+  printf( "$ST bursts ahead of a reply every %u s with the module held up %u ms, %u byte ring, "
+          "%.0f min each\n", burstPeriodS, burstStallMs, HAL_UART_DMA_RX_MAX, burstMinutes );
+  printf( "%5s %6s %7s %8s %6s %6s %7s %7s %7s %7s %8s\n", "burst", "bursts", "bytes", "lost",
+          "caught", "stale", "p50 ms", "max ms", "unfixed", "resends", "given up" );
+  for ( i = 0; i < BURST_NUM_SIZES; i++ )
+  {
+    burstResult_t r;
+
+    if ( bench_run_child( burst_run, (void *)&burstSizes[i], &r, sizeof( r ) ) < 0 )
+    {
+      fprintf( stderr, "burst %u: run failed\n", burstSizes[i] );
+      return 1;
+    }
+
+    printf( "%5u %6u %7llu %7.2f%% %6u %6u %7.0f %7.0f %7u %7u %8u\n", burstSizes[i], r.bursts,
+            (unsigned long long)r.bytes, r.bytes ? 100.0 * r.lost / r.bytes : 0, r.overruns, r.stale,
+            r.p50Ms, r.maxMs, r.unrecovered, r.resends, r.abandoned );
+  }
+  return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * duty_bench.c - duty cycle and latency of the end device build.
+ *
+ * Usage: duty_bench [-H hours] [-b burst_min] [-s seed]
+ *
+ * The module runs the OPENEVSE_SLEEPY build against the EVSE model on a
+ * simulated clock, sleeping between RAPI polls. Every 30 minutes (by
+ * default, give or take one) the hub sends On and, once that is through, a Move to Level,
+ * alternately 32 and 16 A. Every 6 hours a car plugs in, charges for 4
+ * hours, stops and leaves. Runs:
+ *
+ *   always-on     never sleeps and never polls, as the router build
+ *   poll 1 s      the default long poll interval
+ *   poll 7.5 s    long poll interval set to 30 quarter seconds with Set
+ *                 Long Poll Interval
+ *   check-in      as above with a 5 minute check-in interval; the hub
+ *                 holds commands until the module checks in, answers with
+ *                 Start Fast Polling, sends and ends with Fast Poll Stop
+ *
+ * For each run it reports the MCU's time awake, the radio's, the average
+ * current from CC2530 datasheet figures (no range extender), the wakes,
+ * the latency of the first and the follow-up command of a burst, and of
+ * the state report from the EVSE's $ST to the Present Value report.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define DUTY_HOUR_US 3600000000ULL
+#define DUTY_SESSION_US (6 * DUTY_HOUR_US)
+#define DUTY_PLUG_US (DUTY_HOUR_US / 2)       // into each session
+#define DUTY_CHARGE_US (4 * DUTY_HOUR_US)
+#define DUTY_CAR_AMPS 32
+#define DUTY_LONG_POLL 30                     // quarter seconds, 7.5 s
+#define DUTY_CHECK_IN 1200                    // quarter seconds, 5 minutes
+#define DUTY_FAST_POLL 40                     // asked for in the Check-in Response
+
+// CC2530 datasheet, mA
+#define DUTY_MCU_MA 6.5
+#define DUTY_RX_MA 24.0
+#define DUTY_TX_MA 29.0
+#define DUTY_SLEEP_MA 0.001
+
+enum { DUTY_ALWAYS_ON, DUTY_POLL_1S, DUTY_POLL_7S, DUTY_CHECK_IN_RUN, DUTY_RUNS };
+
+static const char *dutyRunNames[DUTY_RUNS] = { "always-on", "poll 1 s", "poll 7.5 s", "check-in" };
+
+typedef struct
+{
+  double awake;       // fractions of the run
+  double rx;
+  double tx;
+  uint32_t wakes;
+  double cmdAvg, cmdMax;        // first command of a burst, s
+  double followAvg, followMax;  // the command after it
+  double stateAvg, stateMax;    // $ST to Present Value report
+  uint32_t stateLost;           // state changes never reported
+} dutyResult_t;
+
+static evse_t dutyEvse;
+static dutyResult_t dutyResult;
+static uint8_t dutyRun;
+static uint64_t dutyBurst_us = 30 * 60000000ULL;
+static double dutyHours = 24;
+static uint32_t dutySeed = 1;
+static uint32_t dutyBursts;
+static uint8_t dutyHeld;            // check-in run: a burst waits for the module
+static uint8_t dutyFastPolling;     // check-in run: the hub has asked for it
+static uint64_t dutySent_us;        // when the hub sent the frame in flight
+static uint64_t dutyState_us;       // pending $ST, 0 for none
+static uint8_t dutyState;
+static double dutyCmdSum, dutyFollowSum, dutyStateSum;
+static uint32_t dutyCmds, dutyFollows, dutyStates;
+
+// $ST goes out whether or not the module is awake to hear it
+static void duty_evse_send( evse_t *e, const char *frame, uint32_t delayMs )
+{
+  if ( strncmp( frame, "$ST", 3 ) == 0 )
+  {
+    if ( dutyState_us != 0 )
+    {
+      dutyResult.stateLost++; // Overtaken by the next one
+    }
+    dutyState_us = sim_now_us() + (uint64_t)delayMs * 1000;
+    dutyState = e->state;
+  }
+  sim_uart_evse_send( e, frame, delayMs );
+}
+
+static void duty_report( uint64_t t_us, uint8 endpoint, uint16 clusterId, uint16 attrId, uint32_t value )
+{
+  double lat;
+
+  (void)endpoint;
+  if ( clusterId != ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC || attrId != ATTRID_IOV_BASIC_PRESENT_VALUE ||
+       dutyState_us == 0 || value != dutyState )
+  {
+    return;
+  }
+  lat = (t_us - dutyState_us) / 1e6;
+  dutyStateSum += lat;
+  dutyStates++;
+  if ( lat > dutyResult.stateMax )
+  {
+    dutyResult.stateMax = lat;
+  }
+  dutyState_us = 0;
+}
+
+static void duty_latency( double *sum, uint32_t *n, double *max )
+{
+  double lat = (sim_now_us() - dutySent_us) / 1e6;
+
+  *sum += lat;
+  (*n)++;
+  if ( lat > *max )
+  {
+    *max = lat;
+  }
+}
+
+static void duty_fast_poll_stop( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  sim_zcl_poll_control( OPENEVSE_ENDPOINT, COMMAND_POLL_CONTROL_FAST_POLL_STOP, 0 );
+}
+
+// The hub is done once this is through, and lets the module off fast polling
+static void duty_level( void *arg, uint32_t amps )
+{
+  (void)arg;
+  duty_latency( &dutyFollowSum, &dutyFollows, &dutyResult.followMax );
+  sim_zcl_level( OPENEVSE_ENDPOINT, (uint8)amps, 0 );
+  if ( dutyFastPolling )
+  {
+    dutyFastPolling = FALSE;
+    sim_parent_send( duty_fast_poll_stop, NULL, 0 );
+  }
+}
+
+// The APS ack of the On tells the hub it is through; the follow-up goes then
+static void duty_on( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  duty_latency( &dutyCmdSum, &dutyCmds, &dutyResult.cmdMax );
+  sim_zcl_onoff( OPENEVSE_ENDPOINT, COMMAND_ON );
+  dutySent_us = sim_now_us();
+  sim_parent_send( duty_level, NULL, (dutyBursts & 1) ? 16 : DUTY_CAR_AMPS );
+}
+
+static void duty_burst( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  dutyBursts++;
+  dutySent_us = sim_now_us();
+  if ( dutyRun == DUTY_CHECK_IN_RUN )
+  {
+    dutyHeld = TRUE; // Latency counts from when the hub had it
+  }
+  else
+  {
+    sim_parent_send( duty_on, NULL, 0 );
+  }
+  sim_schedule( sim_now_us() + dutyBurst_us - 60000000ULL + (uint64_t)(bench_rand( &dutySeed ) * 120e6),
+                duty_burst, NULL, 0 );
+}
+
+static void duty_check_in_rsp( void *arg, uint32_t timeout )
+{
+  (void)arg;
+  sim_zcl_poll_control( OPENEVSE_ENDPOINT, COMMAND_POLL_CONTROL_CHECK_IN_RSP, timeout );
+  if ( timeout != 0 )
+  {
+    dutyFastPolling = TRUE;
+    sim_parent_send( duty_on, NULL, 0 );
+  }
+}
+
+static void duty_check_in( uint64_t t_us, uint8 endpoint )
+{
+  (void)t_us;
+  (void)endpoint;
+  sim_parent_send( duty_check_in_rsp, NULL, dutyHeld ? DUTY_FAST_POLL : 0 );
+  dutyHeld = FALSE;
+}
+
+static void duty_session( void *arg, uint32_t step )
+{
+  (void)arg;
+  switch ( step )
+  {
+    case 0:
+      evse_plug( &dutyEvse, 1 );
+      sim_schedule( sim_now_us() + 60000000ULL + (uint64_t)(bench_rand( &dutySeed ) * 60e6), duty_session, NULL, 1 );
+      break;
+    case 1:
+      evse_charge( &dutyEvse, DUTY_CAR_AMPS );
+      sim_schedule( sim_now_us() + DUTY_CHARGE_US, duty_session, NULL, 2 );
+      break;
+    case 2:
+      evse_charge( &dutyEvse, 0 );
+      sim_schedule( sim_now_us() + 60000000ULL + (uint64_t)(bench_rand( &dutySeed ) * 600e6), duty_session, NULL, 3 );
+      break;
+    default:
+      evse_plug( &dutyEvse, 0 );
+      sim_schedule( sim_now_us() - sim_now_us() % DUTY_SESSION_US + DUTY_SESSION_US + DUTY_PLUG_US,
+                    duty_session, NULL, 0 );
+      break;
+  }
+}
+
+// One run, by bench_run_child
+static void duty_run( void *arg, void *result )
+{
+  uint8_t run = *(const uint8_t *)arg;
+  evseCfg_t cfg = evse_default_cfg;
+  uint64_t end_us = (uint64_t)(dutyHours * 3600e6);
+  uint32 interval = DUTY_CHECK_IN;
+
+  dutyRun = run;
+  evse_init( &dutyEvse, &cfg, duty_evse_send, sim_now_us );
+  bench_evse = &dutyEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_report_hook = duty_report;
+  sim_checkin_hook = duty_check_in;
+  sim_pwr_always_on = run == DUTY_ALWAYS_ON;
+  sim_osal_init();
+  sim_set_nwk_state( DEV_END_DEVICE );
+  sim_run_until( 1000 );
+  if ( run == DUTY_POLL_7S || run == DUTY_CHECK_IN_RUN )
+  {
+    sim_zcl_poll_control( OPENEVSE_ENDPOINT, COMMAND_POLL_CONTROL_SET_LONG_POLL_INTERVAL, DUTY_LONG_POLL );
+  }
+  if ( run == DUTY_CHECK_IN_RUN )
+  {
+    sim_zcl_write( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_GEN_POLL_CONTROL, ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL,
+                   &interval );
+  }
+  sim_schedule( 60000000ULL, duty_burst, NULL, 0 );
+  sim_schedule( DUTY_PLUG_US, duty_session, NULL, 0 );
+  sim_run_until( end_us );
+
+  dutyResult.awake = (double)sim_awake_us() / end_us;
+  dutyResult.tx = (double)sim_radio_tx_us / end_us;
+  dutyResult.rx = run == DUTY_ALWAYS_ON ? 1 - dutyResult.tx : (double)sim_radio_rx_us / end_us;
+  dutyResult.wakes = sim_wakes;
+  dutyResult.cmdAvg = dutyCmds ? dutyCmdSum / dutyCmds : 0;
+  dutyResult.followAvg = dutyFollows ? dutyFollowSum / dutyFollows : 0;
+  dutyResult.stateAvg = dutyStates ? dutyStateSum / dutyStates : 0;
+  *(dutyResult_t *)result = dutyResult;
+}
+
+int main( int argc, char **argv )
+{
+  uint8_t run;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "H:b:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'H': dutyHours = atof( optarg ); break;
+      case 'b': dutyBurst_us = (uint64_t)(atof( optarg ) * 60e6); break;
+      case 's': dutySeed = (uint32_t)atoi( optarg ) | 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-H hours] [-b burst_min] [-s seed]\n", argv[0] );
+        return 2;
+    }
+  }
+  if ( dutyHours <= 0 || dutyBurst_us < 120000000ULL )
+  {
+    fprintf( stderr, "%s: hours must be positive and bursts two minutes or more apart\n", argv[0] );
+    return 2;
+  }
+
+  printf( "End device duty cycle over %.1f hours, hub burst every %.0f min, a session every 6 hours\n",
+          dutyHours, dutyBurst_us / 60e6 );
+  printf( "%-11s %7s %7s %7s %6s %6s %13s %13s %13s %5s\n", "run", "awake %", "rx %", "tx %", "mA",
+          "wakes", "cmd avg/max", "next avg/max", "state avg/max", "lost" );
+  for ( run = 0; run < DUTY_RUNS; run++ )
+  {
+    dutyResult_t r;
+    double mA;
+
+    if ( bench_run_child( duty_run, &run, &r, sizeof( r ) ) < 0 )
+    {
+      fprintf( stderr, "%s: run failed\n", dutyRunNames[run] );
+      return 1;
+    }
+
+    mA = r.awake * DUTY_MCU_MA + r.rx * DUTY_RX_MA + r.tx * DUTY_TX_MA + (1 - r.awake) * DUTY_SLEEP_MA;
+    printf( "%-11s %7.3f %7.3f %7.3f %6.2f %6u %6.2f/%6.2f %6.2f/%6.2f %6.2f/%6.2f %5u\n",
+            dutyRunNames[run], r.awake * 100, r.rx * 100, r.tx * 100, mA, r.wakes,
+            r.cmdAvg, r.cmdMax, r.followAvg, r.followMax, r.stateAvg, r.stateMax, r.stateLost );
+  }
+  return 0;
+}
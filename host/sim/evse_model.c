@@ -0,0 +1,318 @@
+/*
+ * evse_model.c - scripted OpenEVSE RAPI responder.
+ *
+ * Answers the commands the ZigBee module uses ($GG, $GP, $GU, $GS, $GE,
+ * $GT, $FE, $FS, $FB, $S0, $SH, $SC) and sends $ST whenever its state changes,
+ * whether from a command, the script or the charge limit running out.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "evse_model.h"
+
+const evseCfg_t evse_default_cfg =
+{
+  10,       // respDelayMs
+  2,        // level
+  240000,   // millivolts
+  32,       // pilotAmps
+  0,        // bootMs
+  0         // rtcLocal
+};
+
+void evse_frame( char *out, const char *body )
+{
+  uint8_t chk = 0;
+  const char *p;
+
+  for ( p = body; *p; p++ )
+  {
+    chk ^= (uint8_t)*p;
+  }
+  sprintf( out, "%s^%02X\r", body, chk );
+}
+
+static void evse_send( evse_t *e, const char *body, uint32_t delayMs )
+{
+  char frame[80];
+
+  evse_frame( frame, body );
+  e->send( e, frame, delayMs );
+}
+
+static uint8_t evse_drawing( evse_t *e )
+{
+  return e->state == EVSE_STATE_CHARGING;
+}
+
+uint32_t evse_amps_ma( evse_t *e )
+{
+  uint8_t amps;
+
+  if ( !evse_drawing( e ) )
+  {
+    return 0;
+  }
+  amps = e->wantAmps < e->cfg.pilotAmps ? e->wantAmps : e->cfg.pilotAmps;
+  return (uint32_t)amps * 1000;
+}
+
+// Integrate energy up to now
+static void evse_integrate( evse_t *e )
+{
+  uint64_t now = e->now_us();
+  double secs = (now - e->lastUpdate_us) / 1e6;
+  double watts = evse_amps_ma( e ) / 1000.0 *
+                 (e->cfg.millivolts > 0 ? e->cfg.millivolts : (e->cfg.level == 2 ? 240000 : 120000)) / 1000.0;
+
+  e->lastUpdate_us = now;
+  e->wattSecs += watts * secs;
+  e->wattHours += watts * secs / 3600.0;
+}
+
+// Integrate energy and put the EVSE to sleep once the charge limit is reached
+static void evse_update( evse_t *e )
+{
+  evse_integrate( e );
+  if ( e->limitKwh && evse_drawing( e ) && e->wattSecs >= e->limitKwh * 3600000.0 )
+  {
+    evse_set_state( e, EVSE_STATE_SLEEPING );
+  }
+}
+
+void evse_set_state( evse_t *e, uint8_t state )
+{
+  char body[16];
+
+  evse_integrate( e );
+  if ( state == e->state )
+  {
+    return;
+  }
+  e->state = state;
+  sprintf( body, "$ST %02X", state );
+  evse_send( e, body, 0 );
+}
+
+// The state an enabled EVSE would be in with the current plug and car
+static uint8_t evse_active_state( evse_t *e )
+{
+  if ( !e->plugged )
+  {
+    return EVSE_STATE_READY;
+  }
+  return e->wantAmps ? EVSE_STATE_CHARGING : EVSE_STATE_CONNECTED;
+}
+
+void evse_plug( evse_t *e, uint8_t plugged )
+{
+  evse_update( e );
+  e->plugged = plugged;
+  if ( plugged )
+  {
+    e->wattSecs = 0;
+    e->sessionStart_us = e->now_us();
+  }
+  else
+  {
+    e->wantAmps = 0;
+  }
+  if ( e->state == EVSE_STATE_READY || e->state == EVSE_STATE_CONNECTED || e->state == EVSE_STATE_CHARGING )
+  {
+    evse_set_state( e, evse_active_state( e ) );
+  }
+}
+
+void evse_charge( evse_t *e, uint8_t amps )
+{
+  evse_update( e );
+  e->wantAmps = amps;
+  if ( e->state == EVSE_STATE_CONNECTED || e->state == EVSE_STATE_CHARGING )
+  {
+    evse_set_state( e, evse_active_state( e ) );
+  }
+}
+
+void evse_set_temp( evse_t *e, int16_t deciC )
+{
+  e->tempDeciC = deciC;
+}
+
+void evse_init( evse_t *e, const evseCfg_t *cfg, evseSend_t send, uint64_t (*now_us)( void ) )
+{
+  memset( e, 0, sizeof( *e ) );
+  e->cfg = *cfg;
+  e->send = send;
+  e->now_us = now_us;
+  e->state = EVSE_STATE_READY;
+  e->tempDeciC = 250;
+  e->lastUpdate_us = now_us();
+  e->power_us = e->lastUpdate_us;
+  e->bootDone_us = e->lastUpdate_us + (uint64_t)cfg->bootMs * 1000;
+}
+
+static void evse_command( evse_t *e, char *cmd )
+{
+  char reply[64];
+  char *arg = strchr( cmd, ' ' );
+  uint8_t newState = 0;
+
+  evse_update( e );
+  e->cmds++;
+  if ( arg )
+  {
+    *arg++ = 0;
+  }
+
+  strcpy( reply, "$OK" );
+  if ( !strcmp( cmd, "GG" ) )
+  {
+    sprintf( reply, "$OK %lu %ld", (unsigned long)evse_amps_ma( e ),
+             (long)(e->cfg.millivolts > 0 ? e->cfg.millivolts : -1) );
+  }
+  else if ( !strcmp( cmd, "GP" ) )
+  {
+    sprintf( reply, "$OK %d %d %d", e->tempDeciC, e->tempDeciC - 5, e->tempDeciC + 5 );
+  }
+  else if ( !strcmp( cmd, "GU" ) )
+  {
+    sprintf( reply, "$OK %lu %lu", (unsigned long)e->wattSecs, (unsigned long)e->wattHours );
+  }
+  else if ( !strcmp( cmd, "GS" ) )
+  {
+    sprintf( reply, "$OK %x %lu", e->state,
+             (unsigned long)((e->now_us() - e->sessionStart_us) / 1000000) );
+  }
+  else if ( !strcmp( cmd, "GE" ) )
+  {
+    sprintf( reply, "$OK %u %04x", e->cfg.pilotAmps, e->cfg.level == 2 ? 1 : 0 );
+  }
+  else if ( !strcmp( cmd, "GT" ) )
+  {
+    // Without an RTC the firmware reads 165 from every register
+    time_t t = (time_t)e->cfg.rtcLocal + (e->now_us() - e->power_us) / 1000000 + 946684800;
+    struct tm tm;
+
+    gmtime_r( &t, &tm );
+    if ( e->cfg.rtcLocal == 0 )
+    {
+      strcpy( reply, "$OK 165 165 165 165 165 85" );
+    }
+    else
+    {
+      sprintf( reply, "$OK %d %d %d %d %d %d", tm.tm_year - 100, tm.tm_mon + 1, tm.tm_mday,
+               tm.tm_hour, tm.tm_min, tm.tm_sec );
+    }
+  }
+  else if ( !strcmp( cmd, "FE" ) )
+  {
+    if ( e->state == EVSE_STATE_SLEEPING || e->state == EVSE_STATE_DISABLED )
+    {
+      newState = evse_active_state( e );
+    }
+  }
+  else if ( !strcmp( cmd, "FS" ) )
+  {
+    newState = EVSE_STATE_SLEEPING;
+  }
+  else if ( !strcmp( cmd, "FD" ) )
+  {
+    newState = EVSE_STATE_DISABLED;
+  }
+  else if ( !strcmp( cmd, "SH" ) )
+  {
+    e->limitKwh = arg ? strtoul( arg, NULL, 10 ) : 0;
+  }
+  else if ( !strcmp( cmd, "SC" ) )
+  {
+    if ( arg == NULL || atoi( arg ) < 6 || atoi( arg ) > 80 )
+    {
+      strcpy( reply, "$NK" );
+    }
+    else
+    {
+      e->cfg.pilotAmps = (uint8_t)atoi( arg );
+      if ( strcmp( arg + strcspn( arg, " " ), " V" ) )
+      {
+        e->saves++;
+      }
+    }
+  }
+  else if ( strcmp( cmd, "FB" ) && strcmp( cmd, "S0" ) )
+  {
+    e->unknown++;
+    strcpy( reply, "$NK" );
+  }
+
+  if ( e->onReply )
+  {
+    e->onReply( e, cmd, reply, e->cfg.respDelayMs );
+  }
+  evse_send( e, reply, e->cfg.respDelayMs );
+  if ( newState )
+  {
+    evse_set_state( e, newState );
+  }
+}
+
+// Check "$XX args^HH" and strip the checksum; frames without one are accepted
+static int evse_checksum_ok( char *line )
+{
+  char *hat = strrchr( line, '^' );
+  uint8_t chk = 0;
+  char *p;
+
+  if ( hat == NULL )
+  {
+    return 1;
+  }
+  for ( p = line; p < hat; p++ )
+  {
+    chk ^= (uint8_t)*p;
+  }
+  *hat = 0;
+  return strtoul( hat + 1, NULL, 16 ) == chk;
+}
+
+void evse_rx( evse_t *e, const uint8_t *buf, uint16_t len )
+{
+  uint16_t i;
+
+  if ( e->now_us() < e->bootDone_us )
+  {
+    return; // Still in the self test, nothing is reading the serial port
+  }
+  for ( i = 0; i < len; i++ )
+  {
+    char ch = (char)buf[i];
+
+    if ( ch == '$' )
+    {
+      e->len = 0;
+      e->inFrame = 1;
+      e->line[e->len++] = ch;
+    }
+    else if ( ch == '\r' )
+    {
+      if ( !e->inFrame )
+      {
+        continue;
+      }
+      e->inFrame = 0;
+      e->line[e->len] = 0;
+      if ( !evse_checksum_ok( e->line ) )
+      {
+        e->badChecksum++;
+        evse_send( e, "$NK", e->cfg.respDelayMs );
+        continue;
+      }
+      evse_command( e, e->line + 1 );
+    }
+    else if ( e->inFrame && ch != 0 && e->len < sizeof( e->line ) - 1 )
+    {
+      e->line[e->len++] = ch;
+    }
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * evse_model.h - scripted OpenEVSE RAPI responder.
+ *
+ * The model only sees bytes in and frames out; whoever owns it decides how
+ * they travel (the virtual UART in the simulator, a pty in rapi_emu). All
+ * frames it sends carry the RAPI "^XX" checksum and the trailing '\r'.
+ */
+#ifndef EVSE_MODEL_H
+#define EVSE_MODEL_H
+
+#include <stdint.h>
+
+#define EVSE_STATE_READY       0x01
+#define EVSE_STATE_CONNECTED   0x02
+#define EVSE_STATE_CHARGING    0x03
+#define EVSE_STATE_VENT_REQ    0x04
+#define EVSE_STATE_DIODE_FAULT 0x05
+#define EVSE_STATE_GFI_FAULT   0x06
+#define EVSE_STATE_NO_GROUND   0x07
+#define EVSE_STATE_STUCK_RELAY 0x08
+#define EVSE_STATE_GFI_SELF    0x09
+#define EVSE_STATE_OVER_TEMP   0x0A
+#define EVSE_STATE_SLEEPING    0xFE
+#define EVSE_STATE_DISABLED    0xFF
+
+typedef struct evse evse_t;
+
+// Send a complete frame after delayMs of processing time
+typedef void (*evseSend_t)( evse_t *e, const char *frame, uint32_t delayMs );
+// A command was answered; reply is the frame without checksum
+typedef void (*evseReply_t)( evse_t *e, const char *cmd, const char *reply, uint32_t delayMs );
+
+typedef struct
+{
+  uint32_t respDelayMs;      // time from the end of a command to the reply
+  uint8_t level;             // 1 or 2
+  int32_t millivolts;        // -1 for no voltmeter
+  uint8_t pilotAmps;         // maximum current advertised to the car
+  uint32_t bootMs;           // power-on self test; RAPI input is lost until it is over
+  uint32_t rtcLocal;         // DS3231 at power on, local seconds since 2000; 0 for no RTC
+} evseCfg_t;
+
+struct evse
+{
+  evseCfg_t cfg;
+  evseSend_t send;
+  evseReply_t onReply;
+  void *ctx;
+  uint64_t (*now_us)( void );
+  uint64_t bootDone_us;
+  uint64_t power_us;
+
+  char line[64];
+  uint8_t len;
+  uint8_t inFrame;
+
+  uint8_t state;
+  uint8_t plugged;
+  uint8_t wantAmps;          // what the car would draw
+  uint32_t limitKwh;         // 0 for no limit
+  int16_t tempDeciC;
+  uint64_t sessionStart_us;
+  uint64_t lastUpdate_us;
+  double wattSecs;           // this session
+  double wattHours;          // lifetime
+
+  uint32_t cmds;
+  uint32_t saves;            // $SC without V, each an EEPROM write
+  uint32_t badChecksum;
+  uint32_t unknown;
+};
+
+extern const evseCfg_t evse_default_cfg;
+
+extern void evse_init( evse_t *e, const evseCfg_t *cfg, evseSend_t send, uint64_t (*now_us)( void ) );
+extern void evse_rx( evse_t *e, const uint8_t *buf, uint16_t len );
+extern void evse_plug( evse_t *e, uint8_t plugged );
+extern void evse_charge( evse_t *e, uint8_t amps );
+extern void evse_set_state( evse_t *e, uint8_t state );
+extern void evse_set_temp( evse_t *e, int16_t deciC );
+extern uint32_t evse_amps_ma( evse_t *e );
+extern void evse_frame( char *out, const char *body );
+
+#endif /* EVSE_MODEL_H */
@@ -0,0 +1,204 @@
+/*
+ * fault_bench.c - recovery of the RAPI resend path under line noise.
+ *
+ * Usage: fault_bench [-n commands] [-s seed] [-d reply_ms]
+ *
+ * Sends a fixed mix of commands back to back to the EVSE model over the
+ * virtual UART, first with byte loss and then with garbage bytes injected
+ * at increasing rates in both directions. For each rate it reports the
+ * fraction of commands the firmware gave up on, resends per command, the
+ * round trip of commands that went through first time, and the time to
+ * recover: from the first failure of a command (bad reply or timeout) to
+ * its good reply. Per-command failure counts and the link statistics at
+ * the end come from the firmware's own counters.
+ *
+ * Everything runs on the virtual clock, so a sweep takes seconds and is
+ * repeatable for a given seed. zcl_openevse.c is compiled into this file
+ * so the static writer and command slot can be driven directly.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+
+#include "zcl_openevse.c"
+
+typedef struct
+{
+  uint8 cmd;
+  uint8 numArgs;
+  int32 arg;
+} faultCmd_t;
+
+static const faultCmd_t faultMix[] =
+{
+  { EVSE_CMD_GETPOWER, 0, 0 },
+  { EVSE_CMD_GETSTATE, 0, 0 },
+  { EVSE_CMD_GETTEMP, 0, 0 },
+  { EVSE_CMD_GETENERGY, 0, 0 },
+  { EVSE_CMD_GETSETTINGS, 0, 0 },
+  { EVSE_CMD_SETLIMIT, 1, 16777215 },
+  { EVSE_CMD_SETCURRENT, 1, 16 },
+  { EVSE_CMD_LCDTEAL, 0, 0 },
+};
+
+static const double faultRates[] = { 0, 0.1, 0.2, 0.5, 1, 2, 5 };
+
+#define FAULT_NUM_MIX   (sizeof( faultMix ) / sizeof( faultMix[0] ))
+#define FAULT_NUM_RATES (sizeof( faultRates ) / sizeof( faultRates[0] ))
+
+static evse_t faultEvse;
+
+// Resends or commands given up on, per command slot, as the hub reads them
+static void fault_cmd_counts( uint16 attrId, uint16_t *counts )
+{
+  uint8 buf[1 + 2 * EVSE_CMD_COUNT];
+  uint8 i;
+
+  sim_zcl_read( OPENEVSE_EVSE_ENDPOINT( 0 ), ZCL_CLUSTER_ID_OPENEVSE_STATS, attrId, buf, sizeof( buf ) );
+  for ( i = 0; i < EVSE_CMD_COUNT; i++ )
+  {
+    counts[i] = BUILD_UINT16( buf[1 + 2 * i], buf[2 + 2 * i] );
+  }
+}
+
+static uint32_t fault_cmd_total( uint16 attrId )
+{
+  uint16_t counts[EVSE_CMD_COUNT];
+  uint32_t n = 0;
+  uint8 i;
+
+  fault_cmd_counts( attrId, counts );
+  for ( i = 0; i < EVSE_CMD_COUNT; i++ )
+  {
+    n += counts[i];
+  }
+  return n;
+}
+
+// Run one command to completion, one simulation step at a time
+static void fault_run_cmd( const faultCmd_t *c, benchSeries_t *clean, benchSeries_t *recover )
+{
+  uint32_t failuresBefore = fault_cmd_total( ATTRID_OPENEVSE_CMD_GIVEN_UP );
+  uint64_t start = sim_now_us();
+  uint64_t firstFail = 0;
+
+  zclOpenEvse_EVSEWriteCmd( &zclOpenEvse_evse[0], c->cmd, c->numArgs, c->arg );
+  while ( zclOpenEvse_evse[0].cmd != EVSE_CMD_NONE && sim_next_us() != UINT64_MAX )
+  {
+    sim_run_until( sim_next_us() );
+    if ( !firstFail && (zclOpenEvse_evse[0].retryDue || zclOpenEvse_evse[0].resendCtr) )
+    {
+      firstFail = sim_now_us();
+    }
+  }
+  if ( fault_cmd_total( ATTRID_OPENEVSE_CMD_GIVEN_UP ) != failuresBefore )
+  {
+    return;
+  }
+  if ( firstFail )
+  {
+    bench_add( recover, (sim_now_us() - firstFail) / 1000.0 );
+  }
+  else
+  {
+    bench_add( clean, (sim_now_us() - start) / 1000.0 );
+  }
+}
+
+static void fault_sweep( const char *name, double *rate, uint32_t count )
+{
+  uint8 r;
+
+  printf( "%-8s %7s %8s %8s  %-22s %-22s\n", name, "cmds", "lost", "resends",
+          "first try p50/p99 ms", "recover p50/p99 ms" );
+  for ( r = 0; r < FAULT_NUM_RATES; r++ )
+  {
+    benchSeries_t clean = { "first try" };
+    benchSeries_t recover = { "recover" };
+    uint32_t failures = fault_cmd_total( ATTRID_OPENEVSE_CMD_GIVEN_UP );
+    uint32_t retries = fault_cmd_total( ATTRID_OPENEVSE_CMD_RESENDS );
+    uint32_t i;
+
+    *rate = faultRates[r];
+    for ( i = 0; i < count; i++ )
+    {
+      fault_run_cmd( &faultMix[i % FAULT_NUM_MIX], &clean, &recover );
+    }
+    failures = fault_cmd_total( ATTRID_OPENEVSE_CMD_GIVEN_UP ) - failures;
+    retries = fault_cmd_total( ATTRID_OPENEVSE_CMD_RESENDS ) - retries;
+    printf( "%6.1f %% %7u %7.2f%% %8.3f  %8.1f / %-8.1f    ",
+            faultRates[r], count, 100.0 * failures / count, (double)retries / count,
+            bench_percentile( &clean, 50 ), bench_percentile( &clean, 99 ) );
+    if ( recover.count )
+    {
+      printf( "%8.1f / %-8.1f (n=%u)\n", bench_percentile( &recover, 50 ),
+              bench_percentile( &recover, 99 ), recover.count );
+    }
+    else
+    {
+      printf( "%8s\n", "-" );
+    }
+    free( clean.ms );
+    free( recover.ms );
+  }
+  *rate = 0;
+
+  // Let anything still on the wire drain before the next sweep
+  sim_run_until( sim_now_us() + 2000000 );
+}
+
+int main( int argc, char **argv )
+{
+  evseCfg_t cfg = evse_default_cfg;
+  zclOpenEvse_linkStats_t *link = &zclOpenEvse_evse[0].link;
+  uint16_t resends[EVSE_CMD_COUNT], givenUp[EVSE_CMD_COUNT];
+  uint32_t count = 2000;
+  uint8 i;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "n:s:d:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'n': count = (uint32_t)atoi( optarg ); break;
+      case 's': sim_uart_seed( (uint32_t)atoi( optarg ) ); break;
+      case 'd': cfg.respDelayMs = (uint32_t)atoi( optarg ); break;
+      default:
+        fprintf( stderr, "usage: %s [-n commands] [-s seed] [-d reply_ms]\n", argv[0] );
+        return 2;
+    }
+  }
+
+  evse_init( &faultEvse, &cfg, sim_uart_evse_send, sim_now_us );
+  bench_evse = &faultEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_osal_init();
+  osal_stop_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_EVSE_EVT );
+  zclOpenEvse_evse[0].ready = TRUE; // No readiness probe, so full reply timeouts and resends
+
+  printf( "RAPI resend path under line noise: %u commands per rate, EVSE reply delay %u ms\n",
+          count, cfg.respDelayMs );
+  fault_sweep( "loss", &sim_uart_loss_pct, count );
+  fault_sweep( "garbage", &sim_uart_garbage_pct, count );
+
+  fault_cmd_counts( ATTRID_OPENEVSE_CMD_RESENDS, resends );
+  fault_cmd_counts( ATTRID_OPENEVSE_CMD_GIVEN_UP, givenUp );
+  printf( "Failures by command:" );
+  for ( i = 1; i < EVSE_CMD_COUNT; i++ )
+  {
+    if ( resends[i] || givenUp[i] )
+    {
+      printf( " $%s %u/%u", evseCode[i], givenUp[i], resends[i] );
+    }
+  }
+  printf( " (given up / resends)\n" );
+  printf( "Link statistics: sent %u ok %u nk %u checksum %u resends %u abandoned %u rx overflow %u "
+          "rtt %u/%u/%u ms\n",
+          link->sent, link->ok, link->nk, link->checksum, link->resends, link->abandoned, link->rxOverflow,
+          link->rttMin, link->rttAvg, link->rttMax );
+  return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * hal_uart_host.c - HAL UART stand-in.
+ *
+ * Writes are serialized on a virtual 115200 baud wire and handed to
+ * sim_uart_sink when the last byte is out. Injected bytes land in an RX
+ * ring of HAL_UART_DMA_RX_MAX bytes at wire speed, and the callback runs
+ * after one idle millisecond or when the ring passes the about-full mark,
+ * as HalUARTPollDMA does. Bytes that find the ring full are lost.
+ * sim_uart_stall holds the callback off, as a long event or a flash erase
+ * keeps the HAL poll from running, while the ring goes on filling.
+ *
+ * Flow control isn't modelled. The DMA driver only drops RTS from its
+ * poll, just before the callback empties the ring, so it can't hold the
+ * EVSE off through a stall.
+ *
+ * Line noise can be injected in both directions: each byte is lost with
+ * probability sim_uart_loss_pct and preceded by a random byte with
+ * probability sim_uart_garbage_pct.
+ *
+ * With POWER_SAVING, bytes that arrive with the MCU asleep are lost, as
+ * HalUARTSuspendDMA turns the receiver off; a byte that gets in keeps the
+ * MCU awake until the line has been idle for SIM_UART_IDLE_US.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define SIM_UART_IDLE_US    1000
+#define SIM_UART_HIGH       (HAL_UART_DMA_RX_MAX / 2 - 16)
+#define SIM_UART_FULL       (HAL_UART_DMA_RX_MAX - 16)
+
+typedef struct
+{
+  uint8 open;
+  halUARTCBack_t callBack;
+  uint8 ring[HAL_UART_DMA_RX_MAX];
+  uint16 head, tail, count;
+  uint64_t txBusyUntil;
+  uint64_t rxBusyUntil;
+  uint64_t lastRx;
+  uint8 pollPending;
+} simUart_t;
+
+typedef struct
+{
+  uint16 len;
+  uint8 data[];
+} simUartChunk_t;
+
+static simUart_t simUarts[SIM_UART_PORTS];
+static uint64_t simUartStallUntil;
+
+simUartSink_t sim_uart_sink = NULL;
+uint64_t sim_uart_tx_bytes[SIM_UART_PORTS];
+uint64_t sim_uart_rx_bytes[SIM_UART_PORTS];
+uint64_t sim_uart_rx_overflow[SIM_UART_PORTS];
+uint64_t sim_uart_rx_asleep[SIM_UART_PORTS];
+double sim_uart_loss_pct = 0;
+double sim_uart_garbage_pct = 0;
+
+static uint32_t simUartRand = 1;
+
+void sim_uart_seed( uint32_t seed )
+{
+  simUartRand = seed ? seed : 1;
+}
+
+// xorshift32, so a run is repeatable whatever the C library does
+static uint32_t sim_uart_rand( void )
+{
+  simUartRand ^= simUartRand << 13;
+  simUartRand ^= simUartRand >> 17;
+  simUartRand ^= simUartRand << 5;
+  return simUartRand;
+}
+
+void sim_uart_stall( uint64_t until_us )
+{
+  if ( until_us > simUartStallUntil )
+  {
+    simUartStallUntil = until_us;
+  }
+}
+
+static uint8 sim_uart_chance( double pct )
+{
+  return pct > 0 && (sim_uart_rand() % 1000000) < pct * 10000;
+}
+
+// Copy len bytes to out (room for 2 * len) with noise applied; returns the new length
+static uint16 sim_uart_noise( const uint8 *in, uint16 len, uint8 *out )
+{
+  uint16 i, n = 0;
+
+  for ( i = 0; i < len; i++ )
+  {
+    if ( sim_uart_chance( sim_uart_garbage_pct ) )
+    {
+      out[n++] = (uint8)sim_uart_rand();
+    }
+    if ( !sim_uart_chance( sim_uart_loss_pct ) )
+    {
+      out[n++] = in[i];
+    }
+  }
+  return n;
+}
+
+uint8 HalUARTOpen( uint8 port, halUARTCfg_t *config )
+{
+  simUarts[port].open = TRUE;
+  simUarts[port].callBack = config->callBackFunc;
+  return ZSuccess;
+}
+
+uint16 Hal_UART_RxBufLen( uint8 port )
+{
+  return simUarts[port].count;
+}
+
+uint16 HalUARTRead( uint8 port, uint8 *buf, uint16 len )
+{
+  simUart_t *u = &simUarts[port];
+  uint16 n = 0;
+
+  while ( n < len && u->count )
+  {
+    buf[n++] = u->ring[u->tail];
+    u->tail = (u->tail + 1) % HAL_UART_DMA_RX_MAX;
+    u->count--;
+  }
+  return n;
+}
+
+static void sim_uart_tx_done( void *arg, uint32_t port )
+{
+  simUartChunk_t *chunk = arg;
+
+  if ( sim_uart_sink )
+  {
+    sim_uart_sink( (uint8)port, chunk->data, chunk->len );
+  }
+  free( chunk );
+}
+
+uint16 HalUARTWrite( uint8 port, uint8 *buf, uint16 len )
+{
+  simUart_t *u = &simUarts[port];
+  simUartChunk_t *chunk = malloc( sizeof( simUartChunk_t ) + 2 * len );
+  uint64_t start = u->txBusyUntil > sim_now_us() ? u->txBusyUntil : sim_now_us();
+
+  chunk->len = sim_uart_noise( buf, len, chunk->data );
+  u->txBusyUntil = start + (uint64_t)len * SIM_UART_BYTE_US;
+  sim_uart_tx_bytes[port] += len;
+  sim_schedule( u->txBusyUntil, sim_uart_tx_done, chunk, port );
+  return len;
+}
+
+static void sim_uart_poll( void *arg, uint32_t port )
+{
+  simUart_t *u = &simUarts[port];
+
+  (void)arg;
+  u->pollPending = FALSE;
+  if ( u->count == 0 || u->callBack == NULL )
+  {
+    return;
+  }
+  if ( sim_now_us() < simUartStallUntil )
+  {
+    u->pollPending = TRUE;
+    sim_schedule( simUartStallUntil, sim_uart_poll, NULL, port );
+    return;
+  }
+  if ( sim_now_us() < u->lastRx + SIM_UART_IDLE_US && u->count < SIM_UART_HIGH )
+  {
+    // Still receiving; look again once the line goes idle
+    u->pollPending = TRUE;
+    sim_schedule( u->lastRx + SIM_UART_IDLE_US, sim_uart_poll, NULL, port );
+    return;
+  }
+  u->callBack( (uint8)port, u->count >= SIM_UART_FULL ? HAL_UART_RX_FULL :
+                            u->count >= SIM_UART_HIGH ? HAL_UART_RX_ABOUT_FULL :
+                                                        HAL_UART_RX_TIMEOUT );
+}
+
+static void sim_uart_rx_byte( void *arg, uint32_t argInt )
+{
+  simUart_t *u = &simUarts[argInt >> 8];
+  uint8 port = (uint8)(argInt >> 8);
+
+  (void)arg;
+  sim_uart_rx_bytes[port]++;
+#if defined POWER_SAVING
+  if ( !sim_awake() )
+  {
+    sim_uart_rx_asleep[port]++;
+    return;
+  }
+  sim_wake( sim_now_us() + SIM_UART_IDLE_US );
+#endif
+  u->lastRx = sim_now_us();
+  if ( u->count == HAL_UART_DMA_RX_MAX )
+  {
+    sim_uart_rx_overflow[port]++;
+  }
+  else
+  {
+    u->ring[u->head] = (uint8)argInt;
+    u->head = (u->head + 1) % HAL_UART_DMA_RX_MAX;
+    u->count++;
+  }
+  if ( !u->pollPending || u->count == SIM_UART_HIGH )
+  {
+    u->pollPending = TRUE;
+    sim_schedule( u->count >= SIM_UART_HIGH ? sim_now_us() : u->lastRx + SIM_UART_IDLE_US,
+                  sim_uart_poll, NULL, port );
+  }
+}
+
+uint64_t sim_uart_inject( uint8 port, const uint8 *buf, uint16 len )
+{
+  simUart_t *u = &simUarts[port];
+  uint64_t t = u->rxBusyUntil > sim_now_us() ? u->rxBusyUntil : sim_now_us();
+  uint8 *noisy = malloc( 2 * len );
+  uint16 n = sim_uart_noise( buf, len, noisy );
+  uint16 i;
+
+  for ( i = 0; i < n; i++ )
+  {
+    t += SIM_UART_BYTE_US;
+    sim_schedule( t, sim_uart_rx_byte, NULL, ((uint32_t)port << 8) | noisy[i] );
+  }
+  free( noisy );
+  u->rxBusyUntil = t;
+  return t;
+}
+
+static void sim_uart_evse_inject( void *arg, uint32_t argInt )
+{
+  char *frame = arg;
+
+  (void)argInt;
+  sim_uart_inject( HAL_UART_PORT_0, (uint8 *)frame, (uint16)strlen( frame ) );
+  free( frame );
+}
+
+void sim_uart_evse_send( struct evse *e, const char *frame, uint32_t delayMs )
+{
+  (void)e;
+  sim_schedule( sim_now_us() + (uint64_t)delayMs * 1000, sim_uart_evse_inject, strdup( frame ), 0 );
+}
+
+void HalUARTSuspend( void )
+{
+}
+
+void HalUARTResume( void )
+{
+}
@@ -0,0 +1,202 @@
+/*
+ * hal_uart_pty.c - HAL UART stand-in backed by a file descriptor, normally
+ * the slave side of the pty that rapi_emu serves.
+ *
+ * Writes go straight to the descriptor. Received bytes are moved into an
+ * RX ring of HAL_UART_DMA_RX_MAX bytes by sim_pty_poll(), which then runs
+ * the UART callback, so the application drains the ring in the same sized
+ * pieces it would on the CC2530. Bytes beyond the free space are left in
+ * the pty until the next poll.
+ *
+ * Every frame in either direction is also scanned here so uart_bench can
+ * count what went over the link without touching the application.
+ */
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "sim_pty.h"
+
+typedef struct
+{
+  halUARTCBack_t callBack;
+  uint8 ring[HAL_UART_DMA_RX_MAX];
+  uint16 head, tail, count;
+} simPty_t;
+
+static simPty_t simPty;
+static int simPtyFd = -1;
+
+// Receive frame scanner
+static char simPtyLine[80];
+static uint8 simPtyLen = 0;
+static uint8 simPtyInFrame = FALSE;
+
+simPtyStats_t sim_pty_stats;
+
+void sim_pty_attach( int fd )
+{
+  simPtyFd = fd;
+}
+
+// Check the "^XX" checksum of a frame, as the EVSE computes it
+static uint8 sim_pty_checksum_ok( const char *line, uint8 len )
+{
+  uint8 chk = 0;
+  uint8 i;
+
+  if ( len < 4 || line[len - 3] != '^' )
+  {
+    return FALSE;
+  }
+  for ( i = 0; i < len - 3; i++ )
+  {
+    chk ^= (uint8)line[i];
+  }
+  return strtoul( &line[len - 2], NULL, 16 ) == chk;
+}
+
+static void sim_pty_scan( uint8 ch )
+{
+  if ( ch == '$' )
+  {
+    simPtyLen = 0;
+    simPtyInFrame = TRUE;
+  }
+  else if ( ch == '\r' )
+  {
+    if ( !simPtyInFrame )
+    {
+      return;
+    }
+    simPtyInFrame = FALSE;
+    simPtyLine[simPtyLen] = 0;
+    sim_pty_stats.rxFrames++;
+    if ( !sim_pty_checksum_ok( simPtyLine, simPtyLen ) )
+    {
+      sim_pty_stats.rxBadFrames++;
+    }
+    else if ( !strncmp( simPtyLine, "$OK", 3 ) )
+    {
+      sim_pty_stats.rxOk++;
+    }
+    else if ( !strncmp( simPtyLine, "$NK", 3 ) )
+    {
+      sim_pty_stats.rxNk++;
+    }
+    else if ( !strncmp( simPtyLine, "$ST", 3 ) )
+    {
+      sim_pty_stats.rxAsync++;
+    }
+    return;
+  }
+  if ( simPtyInFrame && simPtyLen < sizeof( simPtyLine ) - 1 )
+  {
+    simPtyLine[simPtyLen++] = (char)ch;
+  }
+}
+
+int sim_pty_poll( int timeoutMs )
+{
+  struct pollfd pfd;
+  uint8 buf[HAL_UART_DMA_RX_MAX];
+  ssize_t n;
+  ssize_t i;
+
+  pfd.fd = simPtyFd;
+  pfd.events = POLLIN;
+  if ( poll( &pfd, 1, timeoutMs ) <= 0 )
+  {
+    return 0;
+  }
+  if ( pfd.revents & (POLLHUP | POLLERR) )
+  {
+    return -1;
+  }
+  n = read( simPtyFd, buf, HAL_UART_DMA_RX_MAX - simPty.count );
+  if ( n < 0 )
+  {
+    return errno == EAGAIN || errno == EINTR ? 0 : -1;
+  }
+  for ( i = 0; i < n; i++ )
+  {
+    simPty.ring[simPty.head] = buf[i];
+    simPty.head = (simPty.head + 1) % HAL_UART_DMA_RX_MAX;
+    simPty.count++;
+    sim_pty_scan( buf[i] );
+  }
+  sim_pty_stats.rxBytes += n;
+  if ( n && simPty.callBack )
+  {
+    simPty.callBack( HAL_UART_PORT_0, HAL_UART_RX_TIMEOUT );
+  }
+  return (int)n;
+}
+
+uint8 HalUARTOpen( uint8 port, halUARTCfg_t *config )
+{
+  (void)port;
+  simPty.callBack = config->callBackFunc;
+  return ZSuccess;
+}
+
+uint16 Hal_UART_RxBufLen( uint8 port )
+{
+  (void)port;
+  return simPty.count;
+}
+
+uint16 HalUARTRead( uint8 port, uint8 *buf, uint16 len )
+{
+  uint16 n = 0;
+
+  (void)port;
+  while ( n < len && simPty.count )
+  {
+    buf[n++] = simPty.ring[simPty.tail];
+    simPty.tail = (simPty.tail + 1) % HAL_UART_DMA_RX_MAX;
+    simPty.count--;
+  }
+  return n;
+}
+
+uint16 HalUARTWrite( uint8 port, uint8 *buf, uint16 len )
+{
+  uint16 done = 0;
+
+  (void)port;
+  sim_pty_stats.txBytes += len;
+  if ( len == 1 && buf[0] == '\r' )
+  {
+    sim_pty_stats.txFlush++; // The resend path clears the EVSE's line first
+  }
+  else if ( len && buf[0] == '$' )
+  {
+    sim_pty_stats.txFrames++;
+  }
+  while ( done < len )
+  {
+    ssize_t n = write( simPtyFd, buf + done, len - done );
+
+    if ( n < 0 )
+    {
+      if ( errno == EAGAIN || errno == EINTR )
+      {
+        continue;
+      }
+      break;
+    }
+    done += (uint16)n;
+  }
+  return len;
+}
+
+void HalUARTSuspend( void )
+{
+}
+
+void HalUARTResume( void )
+{
+}
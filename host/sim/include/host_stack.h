@@ -0,0 +1,836 @@
+/*
+ * host_stack.h - stand-in for the Z-Stack, OSAL and HAL declarations used
+ * by the OpenEVSE application, so zcl_openevse.c and zcl_openevse_data.c
+ * build unmodified on Linux. Every Z-Stack header the application includes
+ * is a one-line wrapper around this file.
+ *
+ * Only what the application touches is declared. Constants carry the same
+ * values as Z-Stack Home 1.2.2a.
+ */
+#ifndef HOST_STACK_H
+#define HOST_STACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*********************************************************************
+ * Types and compiler keywords
+ */
+typedef unsigned char uint8;
+typedef signed char int8;
+typedef unsigned short uint16;
+typedef signed short int16;
+typedef unsigned int uint32;
+// The application prints int32 with "%ld", so it has to be a long here
+typedef signed long int32;
+typedef unsigned char byte;
+typedef unsigned short UINT16;
+typedef uint8 bool;
+typedef uint8 halIntState_t;
+
+#define CONST const
+#define __code
+#define GENERIC
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define BV(n)                   (1 << (n))
+#define LO_UINT16(a)            ((a) & 0xFF)
+#define HI_UINT16(a)            (((a) >> 8) & 0xFF)
+#define BUILD_UINT16(lo, hi)    ((uint16)(((lo) & 0x00FF) + (((hi) & 0x00FF) << 8)))
+#define BREAK_UINT32(v, b)      ((uint8)(((v) >> ((b) * 8)) & 0xFF))
+#define BUILD_UINT32(b0, b1, b2, b3) \
+  ((uint32)((uint32)((b0) & 0xFF) + ((uint32)((b1) & 0xFF) << 8) + \
+            ((uint32)((b2) & 0xFF) << 16) + ((uint32)((b3) & 0xFF) << 24)))
+
+typedef uint8 ZStatus_t;
+typedef ZStatus_t afStatus_t;
+#define ZSuccess                0x00
+#define ZFailure                0x01
+#define ZInvalidParameter       0x02
+#define ZMemError               0x10
+#define ZBufferFull             0x11
+#define ZApsNoAck               0xB7
+#define ZApsNoBoundDevice       0xB9
+#define ZNwkNoRoute             0xCD
+#define ZMacChannelAccessFailure 0xE1
+#define ZMacNoACK               0xE9
+
+#define Z_EXTADDR_LEN           8
+
+/*********************************************************************
+ * OSAL
+ */
+#define SYS_EVENT_MSG           0x8000
+#define AF_INCOMING_MSG_CMD     0x1A
+#define AF_DATA_CONFIRM_CMD     0xFD
+#define ZCL_INCOMING_MSG        0x34
+#define KEY_CHANGE              0xC0
+#define ZDO_STATE_CHANGE        0xD1
+
+typedef struct
+{
+  uint8 event;
+  uint8 status;
+} osal_event_hdr_t;
+
+extern uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value );
+extern uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id );
+extern uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id );
+extern uint8 osal_set_event( uint8 task_id, uint16 event_flag );
+extern uint8 osal_clear_event( uint8 task_id, uint16 event_flag );
+extern uint32 osal_GetSystemClock( void );
+
+// OSAL_Clock: seconds since 2000-01-01 00:00, day and month from 0
+typedef uint32 UTCTime;
+typedef struct
+{
+  uint8 seconds;
+  uint8 minutes;
+  uint8 hour;
+  uint8 day;
+  uint8 month;
+  uint16 year;
+} UTCTimeStruct;
+extern UTCTime osal_getClock( void );
+extern void osal_setClock( UTCTime newTime );
+extern void osal_ConvertUTCTime( UTCTimeStruct *tm, UTCTime secTime );
+extern UTCTime osal_ConvertUTCSecs( UTCTimeStruct *tm );
+extern uint8 *osal_msg_allocate( uint16 len );
+extern uint8 osal_msg_deallocate( uint8 *msg_ptr );
+extern uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr );
+extern uint8 *osal_msg_receive( uint8 task_id );
+extern void *osal_mem_alloc( uint16 size );
+extern void osal_mem_free( void *ptr );
+extern uint16 osal_heap_high_water( void );
+extern void *osal_memset( void *dest, uint8 value, int len );
+extern void *osal_memcpy( void *dst, const void GENERIC *src, unsigned int len );
+extern uint8 osal_memcmp( const void GENERIC *src1, const void GENERIC *src2, unsigned int len );
+extern uint16 osal_rand( void );
+extern uint8 osal_nv_item_init( uint16 id, uint16 len, void *buf );
+extern uint8 osal_nv_read( uint16 id, uint16 ndx, uint16 len, void *buf );
+extern uint8 osal_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf );
+
+// OSAL_PwrMgr
+#define PWRMGR_CONSERVE         0
+#define PWRMGR_HOLD             1
+extern uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state );
+
+/*********************************************************************
+ * HAL
+ */
+// CC2530 sleep timer, 32.768kHz off the host's monotonic clock; reading
+// ST0 latches ST1 and ST2 as on the chip
+extern uint8 sim_sleep_timer( uint8 reg );
+#define ST0                     sim_sleep_timer( 0 )
+#define ST1                     sim_sleep_timer( 1 )
+#define ST2                     sim_sleep_timer( 2 )
+
+#define HAL_UART_PORT_0         0x00
+#define HAL_UART_PORT_1         0x01
+
+#define HAL_UART_BR_9600        0x00
+#define HAL_UART_BR_19200       0x01
+#define HAL_UART_BR_38400       0x02
+#define HAL_UART_BR_57600       0x03
+#define HAL_UART_BR_115200      0x04
+
+#define HAL_UART_FLOW_OFF       FALSE
+#define HAL_UART_FLOW_ON        TRUE
+
+#define HAL_UART_RX_FULL        0x01
+#define HAL_UART_RX_ABOUT_FULL  0x02
+#define HAL_UART_RX_TIMEOUT     0x04
+#define HAL_UART_TX_FULL        0x08
+#define HAL_UART_TX_EMPTY       0x10
+
+#if !defined HAL_UART_DMA_RX_MAX
+#define HAL_UART_DMA_RX_MAX     256
+#endif
+
+typedef void (*halUARTCBack_t) (uint8 port, uint8 event);
+
+typedef struct
+{
+  uint16 bufferHead;
+  uint16 bufferTail;
+  uint16 maxBufSize;
+  uint8 *pBuffer;
+} halUARTBufControl_t;
+
+typedef struct
+{
+  bool configured;
+  uint8 baudRate;
+  bool flowControl;
+  uint16 flowControlThreshold;
+  uint8 idleTimeout;
+  halUARTBufControl_t rx;
+  halUARTBufControl_t tx;
+  bool intEnable;
+  uint32 rxChRvdTime;
+  halUARTCBack_t callBackFunc;
+} halUARTCfg_t;
+
+extern uint8 HalUARTOpen( uint8 port, halUARTCfg_t *config );
+extern uint16 HalUARTRead( uint8 port, uint8 *buf, uint16 len );
+extern uint16 HalUARTWrite( uint8 port, uint8 *buf, uint16 len );
+extern uint16 Hal_UART_RxBufLen( uint8 port );
+extern void HalUARTSuspend( void );
+extern void HalUARTResume( void );
+
+#define HAL_NV_PAGE_BEG         0x79
+#define HAL_NV_PAGE_CNT         6
+#define HAL_FLASH_PAGE_SIZE     2048
+#define HAL_FLASH_WORD_SIZE     4
+extern void HalFlashErase( uint8 pg );
+extern void HalFlashRead( uint8 pg, uint16 offset, uint8 *buf, uint16 cnt );
+extern void HalFlashWrite( uint16 addr, uint8 *buf, uint16 cnt );
+extern void Onboard_soft_reset( void );
+
+// hal_mcu: the host has no interrupts to turn off
+#define HAL_DISABLE_INTERRUPTS()
+#define HAL_ENABLE_INTERRUPTS()
+
+/*********************************************************************
+ * AF / NWK / ZDO
+ */
+typedef uint16 cId_t;
+
+typedef enum
+{
+  afAddrNotPresent = 0,
+  afAddrGroup      = 1,
+  afAddr16Bit      = 2,
+  afAddr64Bit      = 3,
+  afAddrBroadcast  = 15
+} afAddrMode_t;
+
+#define AddrNotPresent          0
+#define AddrGroup               1
+#define Addr16Bit               2
+#define Addr64Bit               3
+#define AddrBroadcast           15
+
+typedef struct
+{
+  union
+  {
+    uint16 shortAddr;
+    uint8 extAddr[Z_EXTADDR_LEN];
+  } addr;
+  afAddrMode_t addrMode;
+  uint8 endPoint;
+  uint16 panId;
+} afAddrType_t;
+
+typedef struct
+{
+  uint8 TransSeqNumber;
+  uint16 DataLength;
+  uint8 *Data;
+} afMSGCommandFormat_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint16 groupId;
+  uint16 clusterId;
+  afAddrType_t srcAddr;
+  uint16 macDestAddr;
+  uint8 endPoint;
+  uint8 wasBroadcast;
+  uint8 LinkQuality;
+  uint8 correlation;
+  int8 rssi;
+  uint8 SecurityUse;
+  uint32 timestamp;
+  uint8 nwkSeqNum;
+  afMSGCommandFormat_t cmd;
+} afIncomingMSGPacket_t;
+
+typedef struct
+{
+  uint8 EndPoint;
+  uint16 AppProfId;
+  uint16 AppDeviceId;
+  uint8 AppDevVer:4;
+  uint8 Reserved:4;
+  uint8 AppNumInClusters;
+  cId_t *pAppInClusterList;
+  uint8 AppNumOutClusters;
+  cId_t *pAppOutClusterList;
+} SimpleDescriptionFormat_t;
+
+typedef struct
+{
+  uint8 endPoint;
+  uint8 *task_id;
+  SimpleDescriptionFormat_t *simpleDesc;
+  uint8 latencyReq;
+} endPointDesc_t;
+
+#define noLatencyReqs           0
+
+extern afStatus_t afRegister( endPointDesc_t *epDesc );
+extern endPointDesc_t *afFindEndPointDesc( uint8 EndPoint );
+
+#define AF_TX_OPTIONS_NONE      0x00
+#define AF_ACK_REQUEST          0x10
+#define AF_DEFAULT_RADIUS       0x1E
+
+extern afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                                  uint16 cID, uint16 len, uint8 *buf, uint8 *transID,
+                                  uint8 options, uint8 radius );
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 endpoint;
+  uint8 transID;
+} afDataConfirm_t;
+
+typedef struct
+{
+  uint8 secure;
+} APSDE_DataReqMTU_t;
+
+typedef struct
+{
+  uint8 kvp;
+  APSDE_DataReqMTU_t aps;
+} afDataReqMTU_t;
+
+extern uint8 afDataReqMTU( afDataReqMTU_t *fields );
+
+typedef enum
+{
+  DEV_HOLD,
+  DEV_INIT,
+  DEV_NWK_DISC,
+  DEV_NWK_JOINING,
+  DEV_NWK_SEC_REJOIN_CURR_CHANNEL,
+  DEV_END_DEVICE_UNAUTH,
+  DEV_END_DEVICE,
+  DEV_ROUTER,
+  DEV_COORD_STARTING,
+  DEV_ZB_COORD,
+  DEV_NWK_ORPHAN,
+  DEV_NWK_KA,
+  DEV_NWK_BACKOFF,
+  DEV_NWK_SEC_REJOIN_ALL_CHANNEL,
+  DEV_NWK_TC_REJOIN_CURR_CHANNEL,
+  DEV_NWK_TC_REJOIN_ALL_CHANNEL
+} devStates_t;
+
+typedef struct
+{
+  uint8 *extAddr;
+  uint8 removeChildren;
+  uint8 rejoin;
+  uint8 silent;
+} NLME_LeaveReq_t;
+
+#define ZG_STARTUP_SET                      0xFF
+#define ZG_STARTUP_CLEAR                    0x00
+#define ZCD_STARTOPT_DEFAULT_NETWORK_STATE  0x02
+
+extern ZStatus_t NLME_LeaveReq( NLME_LeaveReq_t *req );
+extern uint8 *NLME_GetExtAddr( void );
+extern uint16 NLME_GetCoordShortAddr( void );
+extern void NLME_SetPollRate( uint32 newRate );
+
+typedef struct
+{
+  uint8 txCounter;
+  uint8 txCost;
+  uint8 rxLqi;
+  uint8 inKeySeqNum;
+  uint32 inFrmCntr;
+  uint16 txFailure;
+} linkInfo_t;
+
+typedef struct
+{
+  uint16 shortAddr;
+  uint16 addrIdx;
+  uint8 nodeRelation;
+  uint8 devStatus;
+  uint8 assocCnt;
+  uint8 age;
+  linkInfo_t linkInfo;
+} associated_devices_t;
+
+extern associated_devices_t *AssocGetWithShort( uint16 shortAddr );
+extern uint8 zgWriteStartupOptions( uint8 action, uint8 bitOptions );
+extern void ZDApp_LeaveReset( uint8 ra );
+
+/*********************************************************************
+ * ZCL
+ */
+#define ZCL_HA_PROFILE_ID                          0x0104
+#define ZCL_HA_DEVICEID_ON_OFF_OUTPUT              0x0002
+#define ZCL_HA_DEVICEID_SMART_PLUG                 0x0051
+
+#define ZCL_CLUSTER_ID_GEN_BASIC                   0x0000
+#define ZCL_CLUSTER_ID_GEN_POWER_CFG               0x0001
+#define ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG      0x0002
+#define ZCL_CLUSTER_ID_GEN_IDENTIFY                0x0003
+#define ZCL_CLUSTER_ID_GEN_GROUPS                  0x0004
+#define ZCL_CLUSTER_ID_GEN_SCENES                  0x0005
+#define ZCL_CLUSTER_ID_GEN_ON_OFF                  0x0006
+#define ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL           0x0008
+#define ZCL_CLUSTER_ID_GEN_ALARMS                  0x0009
+#define ZCL_CLUSTER_ID_GEN_TIME                    0x000A
+#define ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC  0x0012
+#define ZCL_CLUSTER_ID_OTA                         0x0019
+#define ZCL_CLUSTER_ID_GEN_POLL_CONTROL            0x0020
+#define ZCL_CLUSTER_ID_SE_METERING                 0x0702
+#define ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS  0x0B02
+#define ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT   0x0B04
+#define ZCL_CLUSTER_ID_HA_DIAGNOSTIC               0x0B05
+
+#define ZCL_DATATYPE_NO_DATA                       0x00
+#define ZCL_DATATYPE_BOOLEAN                       0x10
+#define ZCL_DATATYPE_BITMAP8                       0x18
+#define ZCL_DATATYPE_BITMAP16                      0x19
+#define ZCL_DATATYPE_BITMAP32                      0x1b
+#define ZCL_DATATYPE_UINT8                         0x20
+#define ZCL_DATATYPE_UINT16                        0x21
+#define ZCL_DATATYPE_UINT24                        0x22
+#define ZCL_DATATYPE_UINT32                        0x23
+#define ZCL_DATATYPE_UINT48                        0x25
+#define ZCL_DATATYPE_INT8                          0x28
+#define ZCL_DATATYPE_INT16                         0x29
+#define ZCL_DATATYPE_INT32                         0x2b
+#define ZCL_DATATYPE_ENUM8                         0x30
+#define ZCL_DATATYPE_OCTET_STR                     0x41
+#define ZCL_DATATYPE_CHAR_STR                      0x42
+#define ZCL_DATATYPE_UTC                           0xe2
+
+#define ACCESS_CONTROL_READ                        0x01
+#define ACCESS_CONTROL_WRITE                       0x02
+#define ACCESS_CONTROL_COMMAND                     0x04
+#define ACCESS_CONTROL_AUTH_READ                   0x10
+#define ACCESS_CONTROL_AUTH_WRITE                  0x20
+
+#define ZCL_STATUS_SUCCESS                         0x00
+#define ZCL_STATUS_FAILURE                         0x01
+#define ZCL_STATUS_NOT_AUTHORIZED                  0x7E
+#define ZCL_STATUS_UNSUP_CLUSTER_COMMAND           0x81
+#define ZCL_STATUS_INVALID_FIELD                   0x85
+#define ZCL_STATUS_UNSUPPORTED_ATTRIBUTE           0x86
+#define ZCL_STATUS_INVALID_VALUE                   0x87
+#define ZCL_STATUS_READ_ONLY                       0x88
+#define ZCL_STATUS_INSUFFICIENT_SPACE              0x89
+#define ZCL_STATUS_INVALID_DATA_TYPE               0x8D
+#define ZCL_STATUS_ABORT                           0x95
+#define ZCL_STATUS_INVALID_IMAGE                   0x96
+#define ZCL_STATUS_WAIT_FOR_DATA                   0x97
+#define ZCL_STATUS_NO_IMAGE_AVAILABLE              0x98
+#define ZCL_STATUS_REQUIRE_MORE_IMAGE              0x99
+#define ZCL_STATUS_HARDWARE_FAILURE                0xC0
+#define ZCL_STATUS_CMD_HAS_RSP                     0xFF
+
+#define ZCL_CMD_READ                               0x00
+#define ZCL_CMD_READ_RSP                           0x01
+#define ZCL_CMD_WRITE                              0x02
+#define ZCL_CMD_WRITE_UNDIVIDED                    0x03
+#define ZCL_CMD_WRITE_RSP                          0x04
+#define ZCL_CMD_WRITE_NO_RSP                       0x05
+#define ZCL_CMD_CONFIG_REPORT                      0x06
+#define ZCL_CMD_CONFIG_REPORT_RSP                  0x07
+#define ZCL_CMD_READ_REPORT_CFG                    0x08
+#define ZCL_CMD_READ_REPORT_CFG_RSP                0x09
+#define ZCL_CMD_REPORT                             0x0a
+#define ZCL_CMD_DEFAULT_RSP                        0x0b
+
+#define ZCL_FRAME_CONTROL_TYPE                     0x03
+#define ZCL_FRAME_TYPE_PROFILE_CMD                 0x00
+#define ZCL_FRAME_TYPE_SPECIFIC_CMD                0x01
+#define ZCL_FRAME_CONTROL_MANU_SPECIFIC            0x04
+#define ZCL_FRAME_CONTROL_DIRECTION                0x08
+#define ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP      0x10
+
+#define ZCL_OPER_LEN                               0x00
+#define ZCL_OPER_READ                              0x01
+#define ZCL_OPER_WRITE                             0x02
+
+#define ZCL_FRAME_CLIENT_SERVER_DIR                0x00
+#define ZCL_FRAME_SERVER_CLIENT_DIR                0x01
+
+// Basic
+#define ATTRID_BASIC_ZCL_VERSION                   0x0000
+#define ATTRID_BASIC_HW_VERSION                    0x0003
+#define ATTRID_BASIC_MANUFACTURER_NAME             0x0004
+#define ATTRID_BASIC_MODEL_ID                      0x0005
+#define ATTRID_BASIC_DATE_CODE                     0x0006
+#define ATTRID_BASIC_POWER_SOURCE                  0x0007
+#define ATTRID_BASIC_LOCATION_DESC                 0x0010
+#define ATTRID_BASIC_PHYSICAL_ENV                  0x0011
+#define ATTRID_BASIC_DEVICE_ENABLED                0x0012
+#define POWER_SOURCE_MAINS_1_PHASE                 0x01
+#define DEVICE_ENABLED                             TRUE
+
+// Device temperature, identify, on/off, multistate
+#define ATTRID_DEV_TEMP_CURRENT                    0x0000
+#define ATTRID_IDENTIFY_TIME                       0x0000
+#define ATTRID_GROUP_NAME_SUPPORT                  0x0000
+#define ATTRID_ON_OFF                              0x0000
+#define ATTRID_LEVEL_CURRENT_LEVEL                 0x0000
+#define ATTRID_LEVEL_REMAINING_TIME                0x0001
+#define LEVEL_MOVE_UP                              0x00
+#define LEVEL_MOVE_DOWN                            0x01
+#define LEVEL_STEP_UP                              0x00
+#define LEVEL_STEP_DOWN                            0x01
+#define ATTRID_IOV_BASIC_PRESENT_VALUE             0x0055
+
+// Time
+#define ATTRID_TIME_TIME                           0x0000
+#define ATTRID_TIME_STATUS                         0x0001
+#define ATTRID_TIME_ZONE                           0x0002
+#define ATTRID_TIME_DST_START                      0x0003
+#define ATTRID_TIME_DST_END                        0x0004
+#define ATTRID_TIME_DST_SHIFT                      0x0005
+#define ATTRID_TIME_LOCAL_TIME                     0x0007
+#define COMMAND_OFF                                0x00
+#define COMMAND_ON                                 0x01
+#define COMMAND_TOGGLE                             0x02
+#define EFFECT_ID_BLINK                            0x00
+#define EFFECT_ID_BREATHE                          0x01
+#define EFFECT_ID_OKAY                             0x02
+#define EFFECT_ID_CHANNEL_CHANGE                   0x0B
+#define EFFECT_ID_FINISH_EFFECT                    0xFE
+#define EFFECT_ID_STOP_EFFECT                      0xFF
+
+// Electrical measurement
+#define ATTRID_ELECTRICAL_MEASUREMENT_MEASUREMENT_TYPE        0x0000
+#define ATTRID_ELECTRICAL_MEASUREMENT_RMS_VOLTAGE             0x0505
+#define ATTRID_ELECTRICAL_MEASUREMENT_RMS_CURRENT             0x0508
+#define ATTRID_ELECTRICAL_MEASUREMENT_ACTIVE_POWER            0x050B
+#define ATTRID_ELECTRICAL_MEASUREMENT_AC_VOLTAGE_MULTIPLIER   0x0600
+#define ATTRID_ELECTRICAL_MEASUREMENT_AC_VOLTAGE_DIVISOR      0x0601
+#define ATTRID_ELECTRICAL_MEASUREMENT_AC_CURRENT_MULTIPLIER   0x0602
+#define ATTRID_ELECTRICAL_MEASUREMENT_AC_CURRENT_DIVISOR      0x0603
+#define ATTRID_ELECTRICAL_MEASUREMENT_AC_POWER_MULTIPLIER     0x0604
+#define ATTRID_ELECTRICAL_MEASUREMENT_AC_POWER_DIVISOR        0x0605
+
+typedef struct
+{
+  uint16 attrId;
+  uint8 dataType;
+  uint8 accessControl;
+  void *dataPtr;
+} zclAttribute_t;
+
+typedef struct
+{
+  uint16 clusterID;
+  zclAttribute_t attr;
+} zclAttrRec_t;
+
+typedef struct
+{
+  uint16 clusterID;
+  uint8 cmdID;
+  uint8 flag;
+} zclCommandRec_t;
+
+typedef struct
+{
+  uint16 attrID;
+  uint8 dataType;
+  uint8 *attrData;
+} zclReport_t;
+
+typedef struct
+{
+  uint8 numAttr;
+  zclReport_t attrList[];
+} zclReportCmd_t;
+
+typedef struct
+{
+  unsigned int type:2;
+  unsigned int manuSpecific:1;
+  unsigned int direction:1;
+  unsigned int disableDefaultRsp:1;
+  unsigned int reserved:3;
+} zclFrameControl_t;
+
+typedef struct
+{
+  zclFrameControl_t fc;
+  uint16 manuCode;
+  uint8 transSeqNum;
+  uint8 commandID;
+} zclFrameHdr_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  zclFrameHdr_t zclHdr;
+  uint16 clusterId;
+  afAddrType_t srcAddr;
+  uint8 endPoint;
+  void *attrCmd;
+} zclIncomingMsg_t;
+
+typedef struct
+{
+  uint16 attrID;
+  uint8 status;
+  uint8 dataType;
+  uint8 *data;
+} zclReadRspStatus_t;
+
+typedef struct
+{
+  uint8 numAttr;
+  zclReadRspStatus_t attrList[];
+} zclReadRspCmd_t;
+
+typedef struct
+{
+  uint8 status;
+  uint16 attrID;
+} zclWriteRspStatus_t;
+
+typedef struct
+{
+  uint8 numAttr;
+  zclWriteRspStatus_t attrList[];
+} zclWriteRspCmd_t;
+
+typedef struct
+{
+  uint8 commandID;
+  uint8 statusCode;
+} zclDefaultRspCmd_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint16 identifyTime;
+} zclIdentify_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint8 effectId;
+  uint8 effectVariant;
+} zclIdentifyTriggerEffect_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint16 timeout;
+} zclIdentifyQueryRsp_t;
+
+typedef struct
+{
+  uint8 effectId;
+  uint8 effectVariant;
+} zclOffWithEffect_t;
+
+typedef struct
+{
+  uint8 onOffCtrl;
+  uint16 onTime;
+  uint16 offWaitTime;
+} zclOnWithTimedOff_t;
+
+typedef struct
+{
+  uint8 level;
+  uint16 transitionTime;
+  uint8 withOnOff;
+} zclLCMoveToLevel_t;
+
+typedef struct
+{
+  uint8 moveMode;
+  uint8 rate;
+  uint8 withOnOff;
+} zclLCMove_t;
+
+typedef struct
+{
+  uint8 stepMode;
+  uint8 amount;
+  uint16 transitionTime;
+  uint8 withOnOff;
+} zclLCStep_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint8 cmdID;
+  uint8 grpCnt;
+  uint16 *grpList;
+  uint8 capacity;
+} zclGroupRsp_t;
+
+typedef void (*zclGCB_BasicReset_t)( void );
+typedef void (*zclGCB_Identify_t)( zclIdentify_t *pCmd );
+typedef void (*zclGCB_IdentifyTriggerEffect_t)( zclIdentifyTriggerEffect_t *pCmd );
+typedef void (*zclGCB_IdentifyQueryRsp_t)( zclIdentifyQueryRsp_t *pRsp );
+typedef void (*zclGCB_OnOff_t)( uint8 cmd );
+typedef void (*zclGCB_OnOff_OffWithEffect_t)( zclOffWithEffect_t *pCmd );
+typedef void (*zclGCB_OnOff_OnWithRecallGlobalScene_t)( void );
+typedef void (*zclGCB_OnOff_OnWithTimedOff_t)( zclOnWithTimedOff_t *pCmd );
+typedef void (*zclGCB_LevelControlMoveToLevel_t)( zclLCMoveToLevel_t *pCmd );
+typedef void (*zclGCB_LevelControlMove_t)( zclLCMove_t *pCmd );
+typedef void (*zclGCB_LevelControlStep_t)( zclLCStep_t *pCmd );
+typedef void (*zclGCB_LevelControlStop_t)( void );
+typedef void (*zclGCB_GroupRsp_t)( zclGroupRsp_t *pRsp );
+typedef void (*zclGCB_Location_t)( void *pCmd );
+typedef void (*zclGCB_LocationRsp_t)( void *pRsp );
+
+typedef struct
+{
+  zclGCB_BasicReset_t                     pfnBasicReset;
+  zclGCB_Identify_t                       pfnIdentify;
+#ifdef ZCL_EZMODE
+  void                                   *pfnIdentifyEZModeInvoke;
+  void                                   *pfnIdentifyUpdateCommState;
+#endif
+  zclGCB_IdentifyTriggerEffect_t          pfnIdentifyTriggerEffect;
+  zclGCB_IdentifyQueryRsp_t               pfnIdentifyQueryRsp;
+  zclGCB_OnOff_t                          pfnOnOff;
+  zclGCB_OnOff_OffWithEffect_t            pfnOnOff_OffWithEffect;
+  zclGCB_OnOff_OnWithRecallGlobalScene_t  pfnOnOff_OnWithRecallGlobalScene;
+  zclGCB_OnOff_OnWithTimedOff_t           pfnOnOff_OnWithTimedOff;
+#ifdef ZCL_LEVEL_CTRL
+  zclGCB_LevelControlMoveToLevel_t        pfnLevelControlMoveToLevel;
+  zclGCB_LevelControlMove_t               pfnLevelControlMove;
+  zclGCB_LevelControlStep_t               pfnLevelControlStep;
+  zclGCB_LevelControlStop_t               pfnLevelControlStop;
+#endif
+#ifdef ZCL_GROUPS
+  zclGCB_GroupRsp_t                       pfnGroupRsp;
+#endif
+#ifdef ZCL_SCENES
+  void                                   *pfnSceneStoreReq;
+  void                                   *pfnSceneRecallReq;
+  void                                   *pfnSceneRsp;
+#endif
+#ifdef ZCL_ALARMS
+  void                                   *pfnAlarm;
+#endif
+#ifdef SE_UK_EXT
+  void                                   *pfnGetEventLog;
+  void                                   *pfnPublishEventLog;
+#endif
+  zclGCB_Location_t                       pfnLocation;
+  zclGCB_LocationRsp_t                    pfnLocationRsp;
+} zclGeneral_AppCallbacks_t;
+
+// Poll Control
+#define ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL       0x0000
+#define ATTRID_POLL_CONTROL_LONG_POLL_INTERVAL      0x0001
+#define ATTRID_POLL_CONTROL_SHORT_POLL_INTERVAL     0x0002
+#define ATTRID_POLL_CONTROL_FAST_POLL_TIMEOUT       0x0003
+#define COMMAND_POLL_CONTROL_CHECK_IN_RSP           0x00
+#define COMMAND_POLL_CONTROL_FAST_POLL_STOP         0x01
+#define COMMAND_POLL_CONTROL_SET_LONG_POLL_INTERVAL 0x02
+#define COMMAND_POLL_CONTROL_SET_SHORT_POLL_INTERVAL 0x03
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint8 seqNum;
+} zclPollControlCheckIn_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint8 seqNum;
+  uint8 startFastPolling;
+  uint16 fastPollTimeOut;
+} zclPollControlCheckInRsp_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+} zclPollControlFastPollStop_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint32 newLongPollInterval;
+} zclPollControlSetLongPollInterval_t;
+
+typedef struct
+{
+  afAddrType_t *srcAddr;
+  uint16 newShortPollInterval;
+} zclPollControlSetShortPollInterval_t;
+
+typedef ZStatus_t (*zclPoll_Control_CheckIn_t)( zclPollControlCheckIn_t *pCmd );
+typedef ZStatus_t (*zclPoll_Control_CheckInRsp_t)( zclPollControlCheckInRsp_t *pCmd );
+typedef ZStatus_t (*zclPoll_Control_FastPollStop_t)( zclPollControlFastPollStop_t *pCmd );
+typedef ZStatus_t (*zclPoll_Control_SetLongPollInterval_t)( zclPollControlSetLongPollInterval_t *pCmd );
+typedef ZStatus_t (*zclPoll_Control_SetShortPollInterval_t)( zclPollControlSetShortPollInterval_t *pCmd );
+
+typedef struct
+{
+  zclPoll_Control_CheckIn_t               pfnPollControlCheckIn;
+  zclPoll_Control_CheckInRsp_t            pfnPollControlCheckInRsp;
+  zclPoll_Control_FastPollStop_t          pfnPollControlFastPollStop;
+  zclPoll_Control_SetLongPollInterval_t   pfnPollControlSetLongPollInterval;
+  zclPoll_Control_SetShortPollInterval_t  pfnPollControlSetShortPollInterval;
+} zclPollControl_AppCallbacks_t;
+
+extern ZStatus_t zclPollControl_RegisterCmdCallbacks( uint8 endpoint, zclPollControl_AppCallbacks_t *callbacks );
+extern ZStatus_t zclPollControl_Send_CheckIn( uint8 srcEP, afAddrType_t *dstAddr,
+                                              uint8 disableDefaultRsp, uint8 seqNum );
+
+extern ZStatus_t zcl_SendWriteRspCmd( uint8 srcEP, afAddrType_t *dstAddr,
+                                      uint16 clusterID, zclWriteRspCmd_t *writeRspCmd, uint8 cmd,
+                                      uint8 direction, uint8 disableDefaultRsp, uint8 seqNum );
+extern ZStatus_t zcl_SendCommand( uint8 srcEP, afAddrType_t *dstAddr,
+                                  uint16 clusterID, uint8 cmd, uint8 specific, uint8 direction,
+                                  uint8 disableDefaultRsp, uint16 manuCode, uint8 seqNum,
+                                  uint16 cmdFormatLen, uint8 *cmdFormat );
+#define zcl_SendWriteRsp(a,b,c,d,e,f,g) (zcl_SendWriteRspCmd( (a), (b), (c), (d), ZCL_CMD_WRITE_RSP, (e), (f), (g) ))
+
+typedef ZStatus_t (*zclReadWriteCB_t)( uint16 clusterId, uint16 attrId, uint8 oper,
+                                       uint8 *pValue, uint16 *pLen );
+typedef ZStatus_t (*zclAuthorizeCB_t)( afAddrType_t *srcAddr, zclAttrRec_t *pAttr, uint8 oper );
+
+typedef enum
+{
+  ZCL_PROC_SUCCESS = 0,
+  ZCL_PROC_INVALID,
+  ZCL_PROC_EP_NOT_FOUND,
+  ZCL_PROC_NOT_OPERATIONAL,
+  ZCL_PROC_INTERPAN_FOUNDATION_CMD,
+  ZCL_PROC_NOT_SECURE,
+  ZCL_PROC_MANUFACTURER_SPECIFIC,
+  ZCL_PROC_MANUFACTURER_SPECIFIC_DR,
+  ZCL_PROC_NOT_HANDLED,
+  ZCL_PROC_NOT_HANDLED_DR,
+} zclProcMsgStatus_t;
+
+extern zclProcMsgStatus_t zcl_ProcessMessageMSG( afIncomingMSGPacket_t *pkt );
+extern ZStatus_t zcl_registerReadWriteCB( uint8 endpoint, zclReadWriteCB_t pfnReadWriteCB,
+                                          zclAuthorizeCB_t pfnAuthorizeCB );
+extern ZStatus_t zcl_registerAttrList( uint8 endpoint, uint8 numAttr, CONST zclAttrRec_t attrList[] );
+extern ZStatus_t zcl_registerCmdList( uint8 endpoint, CONST uint8 cmdListSize, CONST zclCommandRec_t newCmdList[] );
+extern uint8 zcl_registerForMsg( uint8 taskId );
+extern ZStatus_t zclGeneral_RegisterCmdCallbacks( uint8 endpoint, zclGeneral_AppCallbacks_t *callbacks );
+extern void zclHA_Init( SimpleDescriptionFormat_t *simpleDesc );
+extern afIncomingMSGPacket_t *zcl_getRawAFMsg( void );
+extern uint8 zclGetDataTypeLength( uint8 dataType );
+extern uint8 zcl_nv_item_init( uint16 id, uint16 len, void *buf );
+extern uint8 zcl_nv_read( uint16 id, uint16 ndx, uint16 len, void *buf );
+extern uint8 zcl_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf );
+
+#endif /* HOST_STACK_H */
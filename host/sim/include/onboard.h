@@ -0,0 +1,2 @@
+/* Host build stand-in, see host_stack.h */
+#include "host_stack.h"
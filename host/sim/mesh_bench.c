@@ -0,0 +1,328 @@
+/*
+ * mesh_bench.c - report back-off on weak and busy mesh links.
+ *
+ * Usage: mesh_bench [-H hours] [-s seed]
+ *
+ * Puts the module at a range of positions in a simulated mesh: hops to the
+ * coordinator, LQI of the parent link, frame loss on that link and the
+ * chance the channel is too busy to send at all. Every report frame is
+ * relayed hop by hop with up to 4 MAC attempts per hop and 2% loss per
+ * attempt past the parent. Without APS acks the module only hears about
+ * the first hop, which is what its data confirm carries. With them the
+ * frame goes end to end up to 4 times, as the APS retries it, until an
+ * ack makes it back over the same hops. The fading position swaps
+ * between the edge link and a good one every hour.
+ *
+ * Each position is run with the report periods fixed (stretch maximum 0)
+ * and with the adaptive back-off, both without APS acks, and then with
+ * the back-off and the default delivery policy (state and energy acked),
+ * with a car charging and a plug cycle every two hours. For each run it
+ * reports frames per hour by report class, transmissions per hour over
+ * all hops (what the module costs the mesh), the share of frames that
+ * reach the coordinator, the state changes and energy readings that
+ * reached it at least once, the report classes the module queued again
+ * and the stretch and failure rate at the end.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define MESH_MAC_ATTEMPTS 4     // first try and 3 MAC retries, per hop
+#define MESH_RELAY_LOSS_PCT 2.0 // per attempt, on the hops past the parent
+#define MESH_APS_ATTEMPTS 4     // first try and 3 APS retries, end to end
+#define MESH_FADE_US 3600000000ULL
+
+enum { MESH_STATE, MESH_POWER, MESH_ENERGY, MESH_TEMP, MESH_CLASSES };
+enum { MESH_FIXED, MESH_ADAPTIVE, MESH_ACKED, MESH_POLICIES };
+
+static const char *meshPolicyNames[MESH_POLICIES] = { "fixed", "adaptive", "acked" };
+
+typedef struct
+{
+  const char *name;
+  uint8_t hops;
+  uint8_t lqi;
+  double lossPct;       // per attempt on the parent link
+  double busyPct;       // per frame, no clear channel
+  uint8_t fade;         // alternate with a good link every hour
+} meshPosition_t;
+
+typedef struct
+{
+  uint32_t frames[MESH_CLASSES];
+  uint32_t tx;          // transmissions over all hops
+  uint32_t delivered;
+  uint32_t values[MESH_CLASSES];  // distinct values sent, state and energy
+  uint32_t reached[MESH_CLASSES]; // of those, at the coordinator
+  uint32_t retried;
+  uint8_t stretch;
+  uint8_t failRate;
+} meshResult_t;
+
+static const meshPosition_t meshPositions[] =
+{
+  { "coordinator", 1, 220, 1.0, 0, 0 },
+  { "two hops", 2, 150, 3.0, 0, 0 },
+  { "busy parent", 3, 140, 5.0, 25.0, 0 },
+  { "edge", 4, 45, 15.0, 0, 0 },
+  { "fading", 4, 45, 15.0, 0, 1 },
+};
+
+#define MESH_NUM_POSITIONS (sizeof( meshPositions ) / sizeof( meshPositions[0] ))
+
+static evse_t meshEvse;
+typedef struct
+{
+  const meshPosition_t *pos;
+  uint8_t policy;
+  uint32_t hours;
+} meshRun_t;
+
+static meshResult_t meshResult;
+static meshPosition_t meshPos;
+static uint8_t meshFaded = 0;
+static uint8_t meshReached = FALSE; // the frame being sent got to the coordinator
+static uint32_t meshLastSent[MESH_CLASSES];
+static uint32_t meshLastReached[MESH_CLASSES];
+static uint32_t meshSeed = 1;
+
+// Up to MESH_MAC_ATTEMPTS transmissions over one hop; TRUE if one got through
+static uint8_t mesh_hop( double lossPct )
+{
+  uint8_t i;
+
+  for ( i = 0; i < MESH_MAC_ATTEMPTS; i++ )
+  {
+    meshResult.tx++;
+    if ( bench_rand( &meshSeed ) * 100 >= lossPct )
+    {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+// Past the parent to the coordinator, or back; TRUE if every hop made it
+static uint8_t mesh_relay( void )
+{
+  uint8_t hop;
+
+  for ( hop = 1; hop < meshPos.hops; hop++ )
+  {
+    if ( !mesh_hop( MESH_RELAY_LOSS_PCT ) )
+    {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static uint8 mesh_send( uint8 endpoint, uint16 clusterId, uint8 options )
+{
+  double lossPct = meshFaded ? 3.0 : meshPos.lossPct;
+  uint8_t attempt;
+
+  (void)endpoint;
+  switch ( clusterId )
+  {
+    case ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC: meshResult.frames[MESH_STATE]++; break;
+    case ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT:  meshResult.frames[MESH_POWER]++; break;
+    case ZCL_CLUSTER_ID_SE_METERING:                meshResult.frames[MESH_ENERGY]++; break;
+    case ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG:     meshResult.frames[MESH_TEMP]++; break;
+  }
+  meshReached = FALSE;
+
+  if ( !(options & AF_ACK_REQUEST) )
+  {
+    if ( bench_rand( &meshSeed ) * 100 < meshPos.busyPct )
+    {
+      return ZMacChannelAccessFailure;
+    }
+    if ( !mesh_hop( lossPct ) )
+    {
+      return ZMacNoACK;
+    }
+    if ( mesh_relay() )
+    {
+      meshReached = TRUE;
+      meshResult.delivered++;
+    }
+    return ZSuccess; // Lost past the parent, the module never hears of it
+  }
+
+  for ( attempt = 0; attempt < MESH_APS_ATTEMPTS; attempt++ )
+  {
+    if ( bench_rand( &meshSeed ) * 100 < meshPos.busyPct || !mesh_hop( lossPct ) || !mesh_relay() )
+    {
+      continue;
+    }
+    if ( !meshReached )
+    {
+      meshReached = TRUE;
+      meshResult.delivered++;
+    }
+    if ( mesh_relay() && mesh_hop( lossPct ) )
+    {
+      return ZSuccess; // The ack made it back
+    }
+  }
+  return ZApsNoAck;
+}
+
+// Follows every frame out of mesh_send with the value it carried
+static void mesh_report( uint64_t t_us, uint8 endpoint, uint16 clusterId, uint16 attrId, uint32_t value )
+{
+  uint8_t cls;
+
+  (void)t_us;
+  (void)endpoint;
+  if ( clusterId == ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC )
+  {
+    cls = MESH_STATE;
+  }
+  else if ( clusterId == ZCL_CLUSTER_ID_SE_METERING && attrId == ATTRID_CURRENT_SUM_DELIVERED )
+  {
+    cls = MESH_ENERGY;
+  }
+  else
+  {
+    return;
+  }
+  if ( meshResult.values[cls] == 0 || value != meshLastSent[cls] )
+  {
+    meshResult.values[cls]++;
+    meshLastSent[cls] = value;
+  }
+  if ( meshReached && (meshResult.reached[cls] == 0 || value != meshLastReached[cls]) )
+  {
+    meshResult.reached[cls]++;
+    meshLastReached[cls] = value;
+  }
+}
+
+static void mesh_fade( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  meshFaded = !meshFaded;
+  sim_parent_lqi = meshFaded ? 160 : meshPos.lqi;
+  sim_schedule( sim_now_us() + MESH_FADE_US, mesh_fade, NULL, 0 );
+}
+
+static void mesh_action( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  switch ( argInt )
+  {
+    case 0: sim_set_nwk_state( DEV_ROUTER ); break;
+    case 1: evse_plug( &meshEvse, 1 ); break;
+    case 2: evse_charge( &meshEvse, 30 ); break;
+    case 3: evse_plug( &meshEvse, 0 ); break;
+  }
+}
+
+// One position and setting, run by bench_run_child
+static void mesh_run( void *arg, void *result )
+{
+  const meshRun_t *run = arg;
+  const meshPosition_t *pos = run->pos;
+  uint8_t policy = run->policy;
+  uint64_t end_us = (uint64_t)run->hours * 3600000000ULL;
+  uint64_t t;
+  uint8_t i;
+
+  meshPos = *pos;
+  sim_parent_lqi = pos->lqi;
+  if ( policy == MESH_FIXED )
+  {
+    zclOpenEvse_reportStretchMax = 0;
+  }
+  if ( policy != MESH_ACKED )
+  {
+    zclOpenEvse_reportAcked = 0;
+  }
+  evse_init( &meshEvse, &evse_default_cfg, sim_uart_evse_send, sim_now_us );
+  bench_evse = &meshEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_send_hook = mesh_send;
+  sim_report_hook = mesh_report;
+  sim_osal_init();
+
+  sim_schedule( 5000000, mesh_action, NULL, 0 );
+  for ( t = 0; t < end_us; t += 7200000000ULL )
+  {
+    sim_schedule( t + 30000000, mesh_action, NULL, 1 );
+    sim_schedule( t + 40000000, mesh_action, NULL, 2 );
+    sim_schedule( t + 6000000000ULL, mesh_action, NULL, 3 );
+  }
+  if ( pos->fade )
+  {
+    sim_schedule( MESH_FADE_US, mesh_fade, NULL, 0 );
+  }
+  sim_run_until( end_us );
+
+  for ( i = 0; i < MESH_CLASSES; i++ )
+  {
+    meshResult.retried += zclOpenEvse_evse[0].delivery[i].retried;
+  }
+  meshResult.stretch = zclOpenEvse_reportStretch;
+  meshResult.failRate = zclOpenEvse_sendFailRate;
+  *(meshResult_t *)result = meshResult;
+}
+
+int main( int argc, char **argv )
+{
+  uint32_t hours = 24;
+  uint8_t p, policy;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "H:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'H': hours = (uint32_t)atoi( optarg ); break;
+      case 's': meshSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-H hours] [-s seed]\n", argv[0] );
+        return 2;
+    }
+  }
+
+  printf( "Report back-off over a simulated mesh, %u hours per run, frames per hour\n", hours );
+  printf( "%-12s %4s %4s %5s %5s  %-8s %6s %6s %6s %6s %8s %10s %7s %9s %7s %s\n", "position", "hops", "lqi",
+          "loss", "busy", "policy", "state", "power", "energy", "temp", "tx", "delivered", "state", "energy",
+          "retried", "stretch/fail" );
+  for ( p = 0; p < MESH_NUM_POSITIONS; p++ )
+  {
+    const meshPosition_t *pos = &meshPositions[p];
+
+    for ( policy = 0; policy < MESH_POLICIES; policy++ )
+    {
+      meshRun_t run = { pos, policy, hours };
+      meshResult_t r;
+      uint32_t frames;
+
+      if ( bench_run_child( mesh_run, &run, &r, sizeof( r ) ) < 0 )
+      {
+        fprintf( stderr, "%s: run failed\n", pos->name );
+        return 1;
+      }
+
+      frames = r.frames[MESH_STATE] + r.frames[MESH_POWER] + r.frames[MESH_ENERGY] + r.frames[MESH_TEMP];
+      printf( "%-12s %4u %4u %4.0f%% %4.0f%%  %-8s %6.1f %6.1f %6.1f %6.1f %8.1f %9.1f%% %3u/%-3u %4u/%-4u %7u %3ux %3u\n",
+              policy ? "" : pos->name, pos->hops, pos->lqi, pos->lossPct, pos->busyPct,
+              meshPolicyNames[policy],
+              (double)r.frames[MESH_STATE] / hours, (double)r.frames[MESH_POWER] / hours,
+              (double)r.frames[MESH_ENERGY] / hours, (double)r.frames[MESH_TEMP] / hours,
+              (double)r.tx / hours, frames ? 100.0 * r.delivered / frames : 0,
+              r.reached[MESH_STATE], r.values[MESH_STATE], r.reached[MESH_ENERGY], r.values[MESH_ENERGY],
+              r.retried, 1u << r.stretch, r.failRate );
+    }
+  }
+  return 0;
+}
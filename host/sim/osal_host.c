@@ -0,0 +1,625 @@
+/*
+ * osal_host.c - OSAL stand-in with a virtual clock.
+ *
+ * Implements timers, events, message queues, heap and NV for the
+ * application tasks, one per charger and the OTA client, plus a
+ * scheduler for simulation
+ * events (UART bytes, EVSE model actions, script steps). sim_run_until()
+ * plays the role of osal_run_system(): it runs the tasks in priority order
+ * while they have events and otherwise jumps the clock to the next timer
+ * or simulation event.
+ *
+ * Built with POWER_SAVING, it also keeps the books the power manager
+ * would: the MCU is awake for SIM_WAKE_US around every run of the tasks
+ * and for as long as any task holds power, and asleep otherwise.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim.h"
+#include "zcl_openevse.h"
+#if defined OPENEVSE_OTA
+#include "zcl_openevse_ota.h"
+#endif
+
+#define SIM_MAX_TIMERS 32
+#define SIM_MAX_NV     16
+#define SIM_WAKE_US    1000 // wake-up, a run of the tasks and back to sleep
+
+typedef uint16 (*simTaskFn_t)( uint8 task_id, uint16 events );
+
+// The application's tasks in tasksArr order, highest priority first
+static const simTaskFn_t simTasks[] =
+{
+  zclOpenEvse_event_loop
+#if OPENEVSE_NUM_EVSE > 1
+  , zclOpenEvse_event_loop
+#endif
+#if defined OPENEVSE_OTA
+  , zclOpenEvseOta_event_loop
+#endif
+};
+#define SIM_NUM_TASKS (sizeof( simTasks ) / sizeof( simTasks[0] ))
+
+typedef struct
+{
+  uint8 active;
+  uint8 task;
+  uint16 event;
+  uint64_t expire_us;
+} simTimer_t;
+
+typedef struct simEvent
+{
+  uint64_t at_us;
+  uint64_t order;
+  simFn_t fn;
+  void *arg;
+  uint32_t argInt;
+  struct simEvent *next;
+} simEvent_t;
+
+typedef struct simMsg
+{
+  struct simMsg *next;
+  uint16 len;
+} simMsg_t;
+
+typedef struct
+{
+  uint16 id;
+  uint16 len;
+  uint8 *buf;
+} simNv_t;
+
+static uint64_t simNow = 0;
+static uint64_t simOrder = 0;
+static simTimer_t simTimers[SIM_MAX_TIMERS];
+static simEvent_t *simEvents = NULL;
+static simMsg_t *simMsgHead[SIM_NUM_TASKS];
+static uint16 simTaskEvents[SIM_NUM_TASKS];
+static simNv_t simNv[SIM_MAX_NV];
+static uint32_t simHeapUsed = 0;
+static uint32_t simHeapHigh = 0;
+static uint8 simPwrHold = 0;      // tasks holding power, one bit each
+static uint64_t simAwakeUntil = 0;
+static uint64_t simAwakeUs = 0;
+
+uint32_t sim_wakes = 0;
+uint8 sim_pwr_always_on = FALSE;
+
+uint64_t sim_now_us( void )
+{
+  return simNow;
+}
+
+void sim_schedule( uint64_t at_us, simFn_t fn, void *arg, uint32_t argInt )
+{
+  simEvent_t *ev = malloc( sizeof( simEvent_t ) );
+  simEvent_t **pp = &simEvents;
+
+  ev->at_us = at_us < simNow ? simNow : at_us;
+  ev->order = simOrder++;
+  ev->fn = fn;
+  ev->arg = arg;
+  ev->argInt = argInt;
+
+  while ( *pp && (*pp)->at_us <= ev->at_us )
+  {
+    pp = &(*pp)->next;
+  }
+  ev->next = *pp;
+  *pp = ev;
+}
+
+/*********************************************************************
+ * Power manager
+ */
+// Keeps the MCU awake until until_us, counting a wake-up if it was asleep
+void sim_wake( uint64_t until_us )
+{
+  uint64_t from = simAwakeUntil > simNow ? simAwakeUntil : simNow;
+
+  if ( until_us <= from )
+  {
+    return;
+  }
+  if ( simAwakeUntil < simNow && !simPwrHold && !sim_pwr_always_on )
+  {
+    sim_wakes++;
+  }
+  simAwakeUs += until_us - from;
+  simAwakeUntil = until_us;
+}
+
+uint8 sim_awake( void )
+{
+#if defined POWER_SAVING
+  return sim_pwr_always_on || simPwrHold || simNow < simAwakeUntil;
+#else
+  return TRUE;
+#endif
+}
+
+uint64_t sim_awake_us( void )
+{
+  return sim_pwr_always_on ? simNow : simAwakeUs;
+}
+
+uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state )
+{
+  if ( task_id >= SIM_NUM_TASKS )
+  {
+    return ZInvalidParameter;
+  }
+  if ( state == PWRMGR_HOLD )
+  {
+    simPwrHold |= BV( task_id );
+  }
+  else
+  {
+    simPwrHold &= ~BV( task_id );
+  }
+  return ZSuccess;
+}
+
+void sim_osal_init( void )
+{
+  uint8 task;
+
+  for ( task = 0; task < OPENEVSE_NUM_EVSE; task++ )
+  {
+    zclOpenEvse_Init( task );
+  }
+#if defined OPENEVSE_OTA
+  zclOpenEvseOta_Init( task );
+#endif
+}
+
+uint32_t sim_heap_high_water( void )
+{
+  return simHeapHigh;
+}
+
+// Time of the next timer or simulation event, UINT64_MAX if there is none
+uint64_t sim_next_us( void )
+{
+  uint64_t next = simEvents ? simEvents->at_us : UINT64_MAX;
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].active && simTimers[i].expire_us < next )
+    {
+      next = simTimers[i].expire_us;
+    }
+  }
+  return next;
+}
+
+/*
+ * Run the application until end_us. A handler that hands back every event
+ * it was given is waiting on something (the RAPI slot); the real OSAL would
+ * spin on it, here that task is passed over until the clock moves on to the
+ * next thing that can happen. Tasks run until none of them makes progress,
+ * since one can post to another.
+ */
+void sim_run_until( uint64_t end_us )
+{
+  for ( ;; )
+  {
+    uint64_t next;
+    uint8 progress;
+    uint8 task;
+    uint8 i;
+
+    do
+    {
+      progress = FALSE;
+      for ( task = 0; task < SIM_NUM_TASKS; task++ )
+      {
+        while ( simTaskEvents[task] )
+        {
+          uint16 events = simTaskEvents[task];
+          uint16 left;
+
+          simTaskEvents[task] = 0;
+          sim_wake( simNow + SIM_WAKE_US );
+          left = simTasks[task]( task, events );
+          simTaskEvents[task] |= left;
+          if ( left == events )
+          {
+            break;
+          }
+          progress = TRUE;
+        }
+      }
+    } while ( progress );
+
+    next = sim_next_us();
+    if ( next > end_us )
+    {
+      next = end_us;
+    }
+    if ( simPwrHold )
+    {
+      sim_wake( next );
+    }
+    simNow = next;
+    if ( next == end_us && sim_next_us() > end_us )
+    {
+      return;
+    }
+
+    for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+    {
+      if ( simTimers[i].active && simTimers[i].expire_us <= simNow )
+      {
+        simTimers[i].active = FALSE;
+        simTaskEvents[simTimers[i].task] |= simTimers[i].event;
+      }
+    }
+    while ( simEvents && simEvents->at_us <= simNow )
+    {
+      simEvent_t *ev = simEvents;
+      simEvents = ev->next;
+      ev->fn( ev->arg, ev->argInt );
+      free( ev );
+    }
+  }
+}
+
+/*********************************************************************
+ * Timers and events
+ */
+uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value )
+{
+  uint8 i, free_slot = SIM_MAX_TIMERS;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].active && simTimers[i].task == task_id && simTimers[i].event == event_id )
+    {
+      break;
+    }
+    if ( !simTimers[i].active && free_slot == SIM_MAX_TIMERS )
+    {
+      free_slot = i;
+    }
+  }
+  if ( i == SIM_MAX_TIMERS )
+  {
+    i = free_slot;
+  }
+  if ( i == SIM_MAX_TIMERS )
+  {
+    return ZFailure;
+  }
+  simTimers[i].active = TRUE;
+  simTimers[i].task = task_id;
+  simTimers[i].event = event_id;
+  simTimers[i].expire_us = simNow + (uint64_t)timeout_value * 1000;
+  return ZSuccess;
+}
+
+uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].active && simTimers[i].task == task_id && simTimers[i].event == event_id )
+    {
+      simTimers[i].active = FALSE;
+      return ZSuccess;
+    }
+  }
+  return ZFailure;
+}
+
+uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].active && simTimers[i].task == task_id && simTimers[i].event == event_id )
+    {
+      return (uint32)((simTimers[i].expire_us - simNow) / 1000);
+    }
+  }
+  return 0;
+}
+
+uint8 osal_set_event( uint8 task_id, uint16 event_flag )
+{
+  if ( task_id >= SIM_NUM_TASKS )
+  {
+    return ZInvalidParameter;
+  }
+  simTaskEvents[task_id] |= event_flag;
+  return ZSuccess;
+}
+
+uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
+{
+  if ( task_id >= SIM_NUM_TASKS )
+  {
+    return ZInvalidParameter;
+  }
+  simTaskEvents[task_id] &= ~event_flag;
+  return ZSuccess;
+}
+
+uint32 osal_GetSystemClock( void )
+{
+  return (uint32)(simNow / 1000);
+}
+
+/*
+ * OSAL_Clock: the UTC clock runs with simulated time from wherever it was
+ * last set, gaining or losing whole seconds at sim_clock_ppm
+ */
+#define SIM_EPOCH_2000 946684800
+
+double sim_clock_ppm;
+static int64_t simClockBase;
+
+static int64_t sim_clock_secs( void )
+{
+  int64_t secs = (int64_t)(simNow / 1000000);
+
+  return secs + (int64_t)(secs * sim_clock_ppm / 1e6);
+}
+
+UTCTime osal_getClock( void )
+{
+  return (UTCTime)(simClockBase + sim_clock_secs());
+}
+
+void osal_setClock( UTCTime newTime )
+{
+  simClockBase = (int64_t)newTime - sim_clock_secs();
+}
+
+void osal_ConvertUTCTime( UTCTimeStruct *tm, UTCTime secTime )
+{
+  time_t t = (time_t)secTime + SIM_EPOCH_2000;
+  struct tm g;
+
+  gmtime_r( &t, &g );
+  tm->seconds = g.tm_sec;
+  tm->minutes = g.tm_min;
+  tm->hour = g.tm_hour;
+  tm->day = g.tm_mday - 1;
+  tm->month = g.tm_mon;
+  tm->year = g.tm_year + 1900;
+}
+
+UTCTime osal_ConvertUTCSecs( UTCTimeStruct *tm )
+{
+  struct tm g = { 0 };
+
+  g.tm_sec = tm->seconds;
+  g.tm_min = tm->minutes;
+  g.tm_hour = tm->hour;
+  g.tm_mday = tm->day + 1;
+  g.tm_mon = tm->month;
+  g.tm_year = tm->year - 1900;
+  return (UTCTime)(timegm( &g ) - SIM_EPOCH_2000);
+}
+
+// Handlers take no virtual time, so the sleep timer runs on the host's
+// own clock: what it measures is the host CPU, not the CC2530's
+uint8 sim_sleep_timer( uint8 reg )
+{
+  static uint32_t latch;
+  struct timespec ts;
+
+  if ( reg == 0 )
+  {
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    latch = (uint32_t)(((uint64_t)ts.tv_sec * 32768 + (uint64_t)ts.tv_nsec * 32768 / 1000000000) & 0xFFFFFF);
+  }
+  return (uint8)(latch >> (8 * reg));
+}
+
+/*********************************************************************
+ * Messages
+ */
+uint8 *osal_msg_allocate( uint16 len )
+{
+  simMsg_t *hdr = osal_mem_alloc( sizeof( simMsg_t ) + len );
+
+  if ( hdr == NULL )
+  {
+    return NULL;
+  }
+  hdr->next = NULL;
+  hdr->len = len;
+  return (uint8 *)(hdr + 1);
+}
+
+uint8 osal_msg_deallocate( uint8 *msg_ptr )
+{
+  osal_mem_free( (simMsg_t *)msg_ptr - 1 );
+  return ZSuccess;
+}
+
+uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr )
+{
+  simMsg_t *hdr = (simMsg_t *)msg_ptr - 1;
+  simMsg_t **pp;
+
+  if ( destination_task >= SIM_NUM_TASKS )
+  {
+    osal_msg_deallocate( msg_ptr );
+    return ZInvalidParameter;
+  }
+  pp = &simMsgHead[destination_task];
+  while ( *pp )
+  {
+    pp = &(*pp)->next;
+  }
+  *pp = hdr;
+  hdr->next = NULL;
+  return osal_set_event( destination_task, SYS_EVENT_MSG );
+}
+
+uint8 *osal_msg_receive( uint8 task_id )
+{
+  simMsg_t *hdr;
+
+  if ( task_id >= SIM_NUM_TASKS || simMsgHead[task_id] == NULL )
+  {
+    return NULL;
+  }
+  hdr = simMsgHead[task_id];
+  simMsgHead[task_id] = hdr->next;
+  if ( simMsgHead[task_id] )
+  {
+    osal_set_event( task_id, SYS_EVENT_MSG ); // More to come
+  }
+  return (uint8 *)(hdr + 1);
+}
+
+/*********************************************************************
+ * Heap, tracked so the benchmark can report the high-water mark
+ */
+void *osal_mem_alloc( uint16 size )
+{
+  uint32_t *blk = malloc( size + sizeof( uint32_t ) * 2 );
+
+  if ( blk == NULL )
+  {
+    return NULL;
+  }
+  blk[0] = size;
+  simHeapUsed += size;
+  if ( simHeapUsed > simHeapHigh )
+  {
+    simHeapHigh = simHeapUsed;
+  }
+  return blk + 2;
+}
+
+uint16 osal_heap_high_water( void )
+{
+  return simHeapHigh > 0xFFFF ? 0xFFFF : (uint16)simHeapHigh;
+}
+
+void osal_mem_free( void *ptr )
+{
+  uint32_t *blk;
+
+  if ( ptr == NULL )
+  {
+    return;
+  }
+  blk = (uint32_t *)ptr - 2;
+  simHeapUsed -= blk[0];
+  free( blk );
+}
+
+void *osal_memset( void *dest, uint8 value, int len )
+{
+  return memset( dest, value, len );
+}
+
+void *osal_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+  return (uint8 *)dst + len;
+}
+
+uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+  return memcmp( src1, src2, len ) == 0;
+}
+
+uint16 osal_rand( void )
+{
+  return (uint16)rand();
+}
+
+/*********************************************************************
+ * NV, kept in memory for the life of the run
+ */
+static simNv_t *sim_nv_find( uint16 id )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_NV; i++ )
+  {
+    if ( simNv[i].buf && simNv[i].id == id )
+    {
+      return &simNv[i];
+    }
+  }
+  return NULL;
+}
+
+uint8 osal_nv_item_init( uint16 id, uint16 len, void *buf )
+{
+  uint8 i;
+
+  if ( sim_nv_find( id ) )
+  {
+    return ZSuccess;
+  }
+  for ( i = 0; i < SIM_MAX_NV; i++ )
+  {
+    if ( simNv[i].buf == NULL )
+    {
+      simNv[i].id = id;
+      simNv[i].len = len;
+      simNv[i].buf = calloc( 1, len );
+      if ( buf )
+      {
+        memcpy( simNv[i].buf, buf, len );
+      }
+      return 0x09; // NV_ITEM_UNINIT, as for a fresh device
+    }
+  }
+  return ZFailure;
+}
+
+uint8 osal_nv_read( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  simNv_t *nv = sim_nv_find( id );
+
+  if ( nv == NULL || ndx + len > nv->len )
+  {
+    return ZFailure;
+  }
+  memcpy( buf, nv->buf + ndx, len );
+  return ZSuccess;
+}
+
+uint8 osal_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  simNv_t *nv = sim_nv_find( id );
+
+  if ( nv == NULL || ndx + len > nv->len )
+  {
+    return ZFailure;
+  }
+  memcpy( nv->buf + ndx, buf, len );
+  return ZSuccess;
+}
+
+uint8 zcl_nv_item_init( uint16 id, uint16 len, void *buf )
+{
+  return osal_nv_item_init( id, len, buf );
+}
+
+uint8 zcl_nv_read( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  return osal_nv_read( id, ndx, len, buf );
+}
+
+uint8 zcl_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  return osal_nv_write( id, ndx, len, buf );
+}
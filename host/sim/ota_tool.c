@@ -0,0 +1,1132 @@
+/*
+ * ota_tool.c - OTA images for the module, and a stand-in OTA server to
+ * measure their transfer.
+ *
+ * Usage: ota_tool delta [-k start-end]... [-v version] OLD.hex NEW.hex OUT
+ *        ota_tool full [-v version] NEW.hex OUT
+ *        ota_tool shift [-a addr] [-i bytes] [-e edits] [-s seed] OLD.hex OUT.hex
+ *        ota_tool serve [-c] [-N chargers] [-H hops] [-l loss_pct] [-s seed] OLD.hex FILE [NEW.hex]
+ *
+ * delta writes an OTA upgrade file whose image is the block delta from
+ * OLD to NEW that zcl_openevse_ota.c applies, in whichever page order
+ * comes out smaller, and checks it by applying it in place to a copy of
+ * OLD. Pages overlapping a -k range (hex addresses, inclusive) must be the
+ * same in both builds: the code that applies the delta, hal_flash and
+ * the interrupt vectors have to stay put while it runs. full writes the
+ * whole image, for a boot loader; it doesn't fit the module's slot.
+ *
+ * shift makes a stand-in for a rebuild from OLD: it inserts random bytes
+ * at addr as new code, moves the rest of that 32 KB bank up, bumps the
+ * LJMP, LCALL and MOV DPTR operands in the bank that pointed past addr,
+ * and changes a few random bytes from that bank on. The default addr,
+ * 0x28400, is in the last bank, the only one with room in the RouterEB
+ * build.
+ *
+ * serve runs the module with OLD in its flash against a stand-in OTA
+ * server at the coordinator offering FILE, starting with an Image Notify.
+ * Frames take 5 ms per hop each way and each is lost with the given
+ * chance. It reports frames, bytes and airtime (250 kbit/s, the 802.15.4,
+ * network security and APS overhead and the MAC ack, at every hop) per
+ * module and for the site, and, given NEW, checks the flash after the
+ * upgrade against it. The same figures for the full image are estimated
+ * from the per-block cost of the delta's download. It also gives the
+ * pages rewritten and how long the image is broken for while it is, from
+ * the CC2530's page erase and flash word write times. With -c, one byte
+ * of the downloaded delta in the slot is changed as the server sends the
+ * upgrade time, and the module must give the upgrade up with its flash
+ * as it was.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+#include "zcl_openevse_ota.h"
+
+#define OTA_PAGE OPENEVSE_OTA_PAGE_SIZE
+#define OTA_BLOCK OPENEVSE_OTA_BLOCK
+#define OTA_BANK 0x8000
+#define OTA_HASH_LEN 8             // bytes of a block looked up in the old image
+#define OTA_HASH_BITS 16
+#define OTA_CHAIN_MAX 32           // candidates tried per lookup
+#define OTA_KEEP_MAX 8
+
+#define OTA_US_PER_BYTE 32         // 250 kbit/s
+#define OTA_FRAME_OVERHEAD 51      // PHY 6, MAC 11, NWK 8, security 18, APS 8
+#define OTA_ACK_BYTES 11           // MAC ack with its PHY header
+#define OTA_HOP_US 5000
+#define OTA_SERVER_US 10000        // server turnaround
+#define OTA_NOTIFY_US 1000000
+#define OTA_LIMIT_US (24 * 3600000000ULL)
+#define OTA_ERASE_US 20000         // CC2530 page erase
+#define OTA_WORD_US 20             // CC2530 flash word write
+
+typedef struct
+{
+  uint8_t *data;
+  uint32_t len;
+  uint32_t size;
+} otaBuf_t;
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t bytes;
+  uint64_t air_us;
+} otaCount_t;
+
+// Stand-in server
+static uint8_t *otaFile;
+static uint32_t otaFileLen;
+static uint32_t otaFileVersion;
+static uint8_t otaHops = 2;
+static double otaLossPct = 0;
+static uint32_t otaSeed = 1;
+static otaCount_t otaQuery, otaBlocks, otaEnd;
+static uint32_t otaLost;
+static uint32_t otaBlockData;      // largest block served
+static uint32_t otaBlocksServed;
+static uint64_t otaStart_us, otaDownloaded_us, otaReset_us;
+static uint32_t otaErasesBefore;
+static uint32_t otaWordsBefore;
+static uint8_t otaCorrupt;
+static uint8_t otaEndStatus = 0xFF;
+
+static evse_t otaEvse;
+
+/*********************************************************************
+ * Images
+ */
+static uint32_t ota_crc( uint32_t crc, const uint8_t *buf, uint32_t len )
+{
+  while ( len > 0xFFFF )
+  {
+    crc = zclOpenEvseOta_Crc32( crc, buf, 0xFFFF );
+    buf += 0xFFFF;
+    len -= 0xFFFF;
+  }
+  return zclOpenEvseOta_Crc32( crc, buf, (uint16)len );
+}
+
+static uint32_t ota_pages( uint32_t len )
+{
+  return (len + OTA_PAGE - 1) / OTA_PAGE * OTA_PAGE;
+}
+
+static void ota_put( otaBuf_t *b, const void *data, uint32_t len )
+{
+  if ( b->len + len > b->size )
+  {
+    b->size = (b->len + len) * 2 + 256;
+    b->data = realloc( b->data, b->size );
+  }
+  memcpy( b->data + b->len, data, len );
+  b->len += len;
+}
+
+static void ota_put8( otaBuf_t *b, uint8_t v )
+{
+  ota_put( b, &v, 1 );
+}
+
+static void ota_put32( otaBuf_t *b, uint32_t v )
+{
+  uint8_t le[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+
+  ota_put( b, le, 4 );
+}
+
+static uint32_t ota_get32( const uint8_t *p )
+{
+  return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Intel HEX into a flash image filled with 0xFF; *len is one past the last byte
+static int ota_load_hex( const char *path, uint8_t *img, uint32_t *len )
+{
+  FILE *f = fopen( path, "r" );
+  char line[600];
+  uint32_t base = 0;
+  unsigned lineNo = 0;
+
+  if ( f == NULL )
+  {
+    perror( path );
+    return -1;
+  }
+  memset( img, 0xFF, SIM_FLASH_SIZE );
+  *len = 0;
+  while ( fgets( line, sizeof( line ), f ) )
+  {
+    uint8_t rec[256 + 5];
+    unsigned n, i, sum = 0, count, type, addr;
+
+    lineNo++;
+    if ( line[0] != ':' )
+    {
+      continue;
+    }
+    for ( n = 0; n < sizeof( rec ) && sscanf( &line[1 + 2 * n], "%2x", &i ) == 1; n++ )
+    {
+      rec[n] = (uint8_t)i;
+      sum += i;
+    }
+    if ( n < 5 || n != rec[0] + 5u || (sum & 0xFF) != 0 )
+    {
+      fprintf( stderr, "%s:%u: bad record\n", path, lineNo );
+      fclose( f );
+      return -1;
+    }
+    count = rec[0];
+    addr = (rec[1] << 8) | rec[2];
+    type = rec[3];
+    if ( type == 0 )
+    {
+      if ( base + addr + count > SIM_FLASH_SIZE )
+      {
+        fprintf( stderr, "%s:%u: past the end of flash\n", path, lineNo );
+        fclose( f );
+        return -1;
+      }
+      memcpy( &img[base + addr], &rec[4], count );
+      if ( base + addr + count > *len )
+      {
+        *len = base + addr + count;
+      }
+    }
+    else if ( type == 1 )
+    {
+      break;
+    }
+    else if ( type == 2 && count == 2 )
+    {
+      base = ((rec[4] << 8) | rec[5]) << 4;
+    }
+    else if ( type == 4 && count == 2 )
+    {
+      base = ((rec[4] << 8) | rec[5]) << 16;
+    }
+  }
+  fclose( f );
+  return 0;
+}
+
+static int ota_save_hex( const char *path, const uint8_t *img, uint32_t len )
+{
+  FILE *f = fopen( path, "w" );
+  uint32_t addr;
+  uint32_t upper = 0xFFFFFFFF;
+
+  if ( f == NULL )
+  {
+    perror( path );
+    return -1;
+  }
+  for ( addr = 0; addr < len; addr += 16 )
+  {
+    uint32_t n = len - addr < 16 ? len - addr : 16;
+    unsigned sum;
+    uint32_t i;
+
+    for ( i = 0; i < n && img[addr + i] == 0xFF; i++ )
+    {
+    }
+    if ( i == n )
+    {
+      continue; // Erased
+    }
+    if ( (addr >> 16) != upper )
+    {
+      upper = addr >> 16;
+      fprintf( f, ":02000004%04X%02X\n", upper,
+               (unsigned)(-(int)(2 + 4 + (upper >> 8) + (upper & 0xFF))) & 0xFF );
+    }
+    sum = n + ((addr >> 8) & 0xFF) + (addr & 0xFF);
+    fprintf( f, ":%02X%04X00", n, addr & 0xFFFF );
+    for ( i = 0; i < n; i++ )
+    {
+      fprintf( f, "%02X", img[addr + i] );
+      sum += img[addr + i];
+    }
+    fprintf( f, "%02X\n", (unsigned)(-(int)sum) & 0xFF );
+  }
+  fprintf( f, ":00000001FF\n" );
+  return fclose( f );
+}
+
+// Images must stay clear of the download slot and scratch page
+static int ota_check_image( const char *path, uint32_t len )
+{
+  if ( len > OPENEVSE_OTA_IMAGE_MAX )
+  {
+    fprintf( stderr, "%s: image runs into the download slot at 0x%05X\n", path,
+             (unsigned)OPENEVSE_OTA_IMAGE_MAX );
+    return -1;
+  }
+  return 0;
+}
+
+// OTA header and one sub-element header
+static void ota_header( otaBuf_t *b, uint32_t version, uint16_t tag, uint32_t elemLen )
+{
+  char str[32] = "OpenEVSE ZigBee module";
+  uint32_t total = OPENEVSE_OTA_HEADER_LEN + OPENEVSE_OTA_SUB_HEADER_LEN + elemLen;
+
+  ota_put32( b, OPENEVSE_OTA_MAGIC );
+  ota_put8( b, LO_UINT16( OPENEVSE_OTA_HEADER_VERSION ) );
+  ota_put8( b, HI_UINT16( OPENEVSE_OTA_HEADER_VERSION ) );
+  ota_put8( b, OPENEVSE_OTA_HEADER_LEN );
+  ota_put8( b, 0 );
+  ota_put8( b, 0 ); // Field control: no optional fields
+  ota_put8( b, 0 );
+  ota_put8( b, LO_UINT16( OPENEVSE_OTA_MANUFACTURER ) );
+  ota_put8( b, HI_UINT16( OPENEVSE_OTA_MANUFACTURER ) );
+  ota_put8( b, LO_UINT16( OPENEVSE_OTA_IMAGE_TYPE ) );
+  ota_put8( b, HI_UINT16( OPENEVSE_OTA_IMAGE_TYPE ) );
+  ota_put32( b, version );
+  ota_put8( b, LO_UINT16( OPENEVSE_OTA_STACK_PRO ) );
+  ota_put8( b, HI_UINT16( OPENEVSE_OTA_STACK_PRO ) );
+  ota_put( b, str, sizeof( str ) );
+  ota_put32( b, total );
+  ota_put8( b, LO_UINT16( tag ) );
+  ota_put8( b, HI_UINT16( tag ) );
+  ota_put32( b, elemLen );
+}
+
+static int ota_write( const char *path, const otaBuf_t *b )
+{
+  FILE *f = fopen( path, "wb" );
+
+  if ( f == NULL || fwrite( b->data, 1, b->len, f ) != b->len )
+  {
+    perror( path );
+    return -1;
+  }
+  return fclose( f );
+}
+
+/*********************************************************************
+ * Delta
+ */
+typedef struct
+{
+  const uint8_t *old;
+  uint32_t oldLen;
+  const uint8_t *img;          // new image
+  uint32_t newLen;
+  uint8_t descending;
+  int32_t *head;               // hash chains over the old image
+  int32_t *next;
+  otaBuf_t out;                // records
+  int32_t open;                // header of the record blocks can be added to, -1 for none
+  uint32_t lastEnd;            // where the last block from the old image ended
+  uint8_t haveLast;
+  uint32_t literal;            // patch bytes
+} otaDelta_t;
+
+static uint32_t ota_hash( const uint8_t *p )
+{
+  uint32_t h = ota_get32( p ) * 2654435761u ^ ota_get32( p + 4 ) * 40503u;
+
+  return (h >> (32 - OTA_HASH_BITS)) & ((1 << OTA_HASH_BITS) - 1);
+}
+
+static int ota_erased( const uint8_t *p, uint32_t len )
+{
+  while ( len-- )
+  {
+    if ( *p++ != 0xFF )
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Page of the new image written n-th
+static uint32_t ota_page_addr( const otaDelta_t *d, uint32_t n )
+{
+  return (d->descending ? d->newLen / OTA_PAGE - 1 - n : n) * OTA_PAGE;
+}
+
+// The same test as zclOpenEvseOta_NextBlock: old pages not yet rewritten
+static int ota_source_ok( const otaDelta_t *d, int64_t src, uint32_t dst )
+{
+  uint32_t page = dst - dst % OTA_PAGE;
+
+  if ( src < 0 || src + OTA_BLOCK > d->oldLen )
+  {
+    return 0;
+  }
+  return d->descending ? src + OTA_BLOCK <= page + OTA_PAGE : src >= page;
+}
+
+// Patch runs turning have into want; bytes written to out if given
+static uint32_t ota_patch( const uint8_t *have, const uint8_t *want, otaBuf_t *out )
+{
+  uint8_t runs[OTA_BLOCK][2];
+  uint32_t n = 0, cost = 1;
+  uint32_t pos = 0, i, end;
+
+  for ( i = 0; i < OTA_BLOCK; i++ )
+  {
+    if ( have[i] == want[i] )
+    {
+      continue;
+    }
+    // A gap of two or less costs no more than a new run's header
+    for ( end = i + 1; end < OTA_BLOCK; end++ )
+    {
+      if ( have[end] == want[end] &&
+           (end + 1 >= OTA_BLOCK || have[end + 1] == want[end + 1]) &&
+           (end + 2 >= OTA_BLOCK || have[end + 2] == want[end + 2]) )
+      {
+        break;
+      }
+    }
+    runs[n][0] = (uint8_t)(i - pos);
+    runs[n][1] = (uint8_t)(end - i);
+    cost += 2 + (end - i);
+    pos = end;
+    i = end;
+    n++;
+  }
+  if ( out )
+  {
+    ota_put8( out, (uint8_t)n );
+    for ( i = 0, pos = 0; i < n; i++ )
+    {
+      pos += runs[i][0];
+      ota_put( out, runs[i], 2 );
+      ota_put( out, &want[pos], runs[i][1] );
+      pos += runs[i][1];
+    }
+  }
+  return n ? cost : 0;
+}
+
+// Cost of making the block at dst from src (-1 for erased), in record bytes
+static uint32_t ota_cost( const otaDelta_t *d, int64_t src, uint32_t dst, uint32_t *patch )
+{
+  static const uint8_t ff[OTA_BLOCK] = { [0 ... OTA_BLOCK - 1] = 0xFF };
+  const uint8_t *have = src < 0 ? ff : &d->old[src];
+  uint8_t openHdr = d->open >= 0 ? d->out.data[d->open] : 0;
+  uint8_t openKind = openHdr >> 6;
+  uint8_t extendable = d->open >= 0 && (openHdr & (OPENEVSE_OTA_COUNT_MAX - 1)) < OPENEVSE_OTA_COUNT_MAX - 1 &&
+                       !(openHdr & OPENEVSE_OTA_PATCHED);
+
+  *patch = ota_patch( have, &d->img[dst], NULL );
+  if ( src < 0 )
+  {
+    return *patch ? 1 + *patch : (extendable && openKind == OPENEVSE_OTA_SRC_ERASED ? 0 : 1);
+  }
+  if ( d->haveLast && src == d->lastEnd )
+  {
+    return *patch ? 1 + *patch : (extendable && openKind != OPENEVSE_OTA_SRC_ERASED ? 0 : 1);
+  }
+  return 4 + *patch;
+}
+
+static void ota_emit( otaDelta_t *d, int64_t src, uint32_t dst )
+{
+  static const uint8_t ff[OTA_BLOCK] = { [0 ... OTA_BLOCK - 1] = 0xFF };
+  const uint8_t *have = src < 0 ? ff : &d->old[src];
+  uint32_t patch;
+  uint32_t cost = ota_cost( d, src, dst, &patch );
+  uint8_t kind = src < 0 ? OPENEVSE_OTA_SRC_ERASED :
+                 (d->haveLast && src == d->lastEnd) ? OPENEVSE_OTA_SRC_NEXT : OPENEVSE_OTA_SRC_OLD;
+
+  if ( cost == 0 )
+  {
+    d->out.data[d->open]++; // One more block in the open record
+  }
+  else
+  {
+    d->open = patch ? -1 : (int32_t)d->out.len;
+    ota_put8( &d->out, (uint8_t)(kind << 6 | (patch ? OPENEVSE_OTA_PATCHED : 0)) );
+    if ( kind == OPENEVSE_OTA_SRC_OLD )
+    {
+      ota_put8( &d->out, (uint8_t)src );
+      ota_put8( &d->out, (uint8_t)(src >> 8) );
+      ota_put8( &d->out, (uint8_t)(src >> 16) );
+    }
+    if ( patch )
+    {
+      ota_patch( have, &d->img[dst], &d->out );
+      d->literal += patch;
+    }
+  }
+  if ( src >= 0 )
+  {
+    d->lastEnd = (uint32_t)src + OTA_BLOCK;
+    d->haveLast = 1;
+  }
+}
+
+static void ota_delta_build( otaDelta_t *d )
+{
+  uint32_t n, b, k;
+
+  d->out.len = 0;
+  d->open = -1;
+  d->haveLast = 0;
+  d->literal = 0;
+  for ( n = 0; n < d->newLen / OTA_PAGE; n++ )
+  {
+    for ( b = 0; b < OTA_PAGE / OTA_BLOCK; b++ )
+    {
+      uint32_t dst = ota_page_addr( d, n ) + b * OTA_BLOCK;
+      int64_t best = -1;
+      uint32_t bestCost, cost, patch;
+
+      bestCost = ota_cost( d, -1, dst, &patch );
+      if ( d->haveLast && ota_source_ok( d, d->lastEnd, dst ) &&
+           (cost = ota_cost( d, d->lastEnd, dst, &patch )) < bestCost )
+      {
+        best = d->lastEnd;
+        bestCost = cost;
+      }
+      if ( ota_source_ok( d, dst, dst ) && (cost = ota_cost( d, dst, dst, &patch )) < bestCost )
+      {
+        best = dst;
+        bestCost = cost;
+      }
+      for ( k = 0; k + OTA_HASH_LEN <= OTA_BLOCK && bestCost > 0; k += OTA_HASH_LEN )
+      {
+        int32_t q;
+        uint32_t tries = 0;
+
+        if ( ota_erased( &d->img[dst + k], OTA_HASH_LEN ) )
+        {
+          continue;
+        }
+        for ( q = d->head[ota_hash( &d->img[dst + k] )]; q >= 0 && tries < OTA_CHAIN_MAX; q = d->next[q], tries++ )
+        {
+          int64_t src = (int64_t)q - k;
+
+          if ( ota_source_ok( d, src, dst ) && (cost = ota_cost( d, src, dst, &patch )) < bestCost )
+          {
+            best = src;
+            bestCost = cost;
+          }
+        }
+      }
+      ota_emit( d, best, dst );
+    }
+  }
+}
+
+// Apply the records in place to a copy of the old image, the way the module does
+static int ota_delta_check( const otaDelta_t *d, uint8_t *flash, uint32_t *crc )
+{
+  static uint8_t page[OTA_PAGE];
+  uint32_t rec = 0, src = 0, n, b;
+  uint8_t hdr = 0, left = 0;
+
+  *crc = 0xFFFFFFFF;
+  for ( n = 0; n < d->newLen / OTA_PAGE; n++ )
+  {
+    uint32_t addr = ota_page_addr( d, n );
+
+    for ( b = 0; b < OTA_PAGE / OTA_BLOCK; b++ )
+    {
+      uint8_t *block = &page[b * OTA_BLOCK];
+      uint32_t dst = addr + b * OTA_BLOCK;
+
+      if ( left == 0 )
+      {
+        hdr = d->out.data[rec++];
+        left = (hdr & (OPENEVSE_OTA_COUNT_MAX - 1)) + 1;
+        if ( (hdr >> 6) == OPENEVSE_OTA_SRC_OLD )
+        {
+          src = d->out.data[rec] | (d->out.data[rec + 1] << 8) | (d->out.data[rec + 2] << 16);
+          rec += 3;
+        }
+      }
+      left--;
+      if ( (hdr >> 6) == OPENEVSE_OTA_SRC_ERASED )
+      {
+        memset( block, 0xFF, OTA_BLOCK );
+      }
+      else
+      {
+        if ( !ota_source_ok( d, src, dst ) )
+        {
+          return -1;
+        }
+        memcpy( block, &flash[src], OTA_BLOCK );
+        src += OTA_BLOCK;
+      }
+      if ( hdr & OPENEVSE_OTA_PATCHED )
+      {
+        uint8_t runs = d->out.data[rec++];
+        uint32_t pos = 0;
+
+        while ( runs-- )
+        {
+          pos += d->out.data[rec];
+          memcpy( &block[pos], &d->out.data[rec + 2], d->out.data[rec + 1] );
+          pos += d->out.data[rec + 1];
+          rec += 2 + d->out.data[rec + 1];
+        }
+      }
+      *crc = ota_crc( *crc, block, OTA_BLOCK );
+    }
+    memcpy( &flash[addr], page, OTA_PAGE );
+  }
+  *crc = ~*crc;
+  return rec == d->out.len && left == 0 && memcmp( flash, d->img, d->newLen ) == 0 ? 0 : -1;
+}
+
+static int ota_cmd_delta( int argc, char **argv )
+{
+  static uint8_t old[SIM_FLASH_SIZE], img[SIM_FLASH_SIZE], flash[SIM_FLASH_SIZE];
+  uint32_t keep[OTA_KEEP_MAX][2];
+  uint32_t nKeep = 0, version = OPENEVSE_OTA_FILE_VERSION + 1;
+  uint32_t oldLen, newLen, q, i, crc[2], baseCrc;
+  otaDelta_t d[2];
+  otaBuf_t file = { NULL, 0, 0 };
+  int opt, best;
+
+  while ( (opt = getopt( argc, argv, "k:v:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'k':
+        if ( nKeep == OTA_KEEP_MAX || sscanf( optarg, "%x-%x", &keep[nKeep][0], &keep[nKeep][1] ) != 2 ||
+             keep[nKeep][0] > keep[nKeep][1] || keep[nKeep][1] >= SIM_FLASH_SIZE )
+        {
+          fprintf( stderr, "delta: bad keep range %s\n", optarg );
+          return 2;
+        }
+        nKeep++;
+        break;
+      case 'v': version = (uint32_t)strtoul( optarg, NULL, 0 ); break;
+      default: return 2;
+    }
+  }
+  if ( argc - optind != 3 )
+  {
+    fprintf( stderr, "usage: ota_tool delta [-k start-end]... [-v version] OLD.hex NEW.hex OUT\n" );
+    return 2;
+  }
+  if ( ota_load_hex( argv[optind], old, &oldLen ) || ota_load_hex( argv[optind + 1], img, &newLen ) ||
+       ota_check_image( argv[optind], oldLen ) || ota_check_image( argv[optind + 1], newLen ) )
+  {
+    return 1;
+  }
+  oldLen = ota_pages( oldLen );
+  newLen = ota_pages( newLen );
+  for ( i = 0; i < nKeep; i++ )
+  {
+    uint32_t from = keep[i][0] - keep[i][0] % OTA_PAGE;
+
+    if ( memcmp( &old[from], &img[from], ota_pages( keep[i][1] + 1 ) - from ) )
+    {
+      fprintf( stderr, "delta: pages of %05X-%05X differ between the builds\n", keep[i][0], keep[i][1] );
+      return 1;
+    }
+  }
+
+  // Chains of the old image's windows, the nearest first
+  memset( d, 0, sizeof( d ) );
+  d[0].head = malloc( sizeof( int32_t ) << OTA_HASH_BITS );
+  d[0].next = malloc( sizeof( int32_t ) * oldLen );
+  memset( d[0].head, 0xFF, sizeof( int32_t ) << OTA_HASH_BITS );
+  for ( q = oldLen - OTA_HASH_LEN + 1; q-- > 0; )
+  {
+    if ( !ota_erased( &old[q], OTA_HASH_LEN ) )
+    {
+      uint32_t h = ota_hash( &old[q] );
+
+      d[0].next[q] = d[0].head[h];
+      d[0].head[h] = (int32_t)q;
+    }
+  }
+
+  for ( i = 0; i < 2; i++ )
+  {
+    d[i].head = d[0].head;
+    d[i].next = d[0].next;
+    d[i].old = old;
+    d[i].oldLen = oldLen;
+    d[i].img = img;
+    d[i].newLen = newLen;
+    d[i].descending = (uint8_t)i;
+    ota_delta_build( &d[i] );
+    memcpy( flash, old, SIM_FLASH_SIZE );
+    if ( ota_delta_check( &d[i], flash, &crc[i] ) )
+    {
+      fprintf( stderr, "delta: %s records don't rebuild NEW\n", i ? "descending" : "ascending" );
+      return 1;
+    }
+  }
+  best = d[1].out.len < d[0].out.len;
+  baseCrc = ~ota_crc( 0xFFFFFFFF, old, oldLen );
+
+  ota_header( &file, version, OPENEVSE_OTA_TAG_DELTA, OPENEVSE_OTA_DELTA_HEADER_LEN + d[best].out.len );
+  ota_put8( &file, OPENEVSE_OTA_DELTA_VERSION );
+  ota_put8( &file, best ? OPENEVSE_OTA_DELTA_DESCENDING : 0 );
+  ota_put32( &file, oldLen );
+  ota_put32( &file, baseCrc );
+  ota_put32( &file, newLen );
+  ota_put32( &file, crc[best] );
+  ota_put( &file, d[best].out.data, d[best].out.len );
+  if ( file.len > OPENEVSE_OTA_SLOT_SIZE )
+  {
+    fprintf( stderr, "delta: %u bytes, more than the %u byte slot\n", file.len, (unsigned)OPENEVSE_OTA_SLOT_SIZE );
+    return 1;
+  }
+  printf( "delta %s: %u -> %u pages, records %u bytes ascending, %u descending; "
+          "file %u bytes, %u of them patch, version 0x%08X\n",
+          argv[optind + 2], oldLen / OTA_PAGE, newLen / OTA_PAGE, d[0].out.len, d[1].out.len,
+          file.len, d[best].literal, version );
+  return ota_write( argv[optind + 2], &file ) ? 1 : 0;
+}
+
+static int ota_cmd_full( int argc, char **argv )
+{
+  static uint8_t img[SIM_FLASH_SIZE];
+  uint32_t version = OPENEVSE_OTA_FILE_VERSION + 1;
+  uint32_t len;
+  otaBuf_t file = { NULL, 0, 0 };
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "v:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'v': version = (uint32_t)strtoul( optarg, NULL, 0 ); break;
+      default: return 2;
+    }
+  }
+  if ( argc - optind != 2 )
+  {
+    fprintf( stderr, "usage: ota_tool full [-v version] NEW.hex OUT\n" );
+    return 2;
+  }
+  if ( ota_load_hex( argv[optind], img, &len ) )
+  {
+    return 1;
+  }
+  ota_header( &file, version, OPENEVSE_OTA_TAG_IMAGE, len );
+  ota_put( &file, img, len );
+  printf( "full %s: file %u bytes, version 0x%08X\n", argv[optind + 1], file.len, version );
+  return ota_write( argv[optind + 1], &file ) ? 1 : 0;
+}
+
+/*********************************************************************
+ * Synthetic rebuild
+ */
+static int ota_cmd_shift( int argc, char **argv )
+{
+  static uint8_t img[SIM_FLASH_SIZE];
+  uint32_t at = 0x28400, ins = 48, edits = 8;
+  uint32_t len, bank, used, logical, p, x;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "a:i:e:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'a': at = (uint32_t)strtoul( optarg, NULL, 0 ); break;
+      case 'i': ins = (uint32_t)strtoul( optarg, NULL, 0 ); break;
+      case 'e': edits = (uint32_t)strtoul( optarg, NULL, 0 ); break;
+      case 's': otaSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default: return 2;
+    }
+  }
+  if ( argc - optind != 2 )
+  {
+    fprintf( stderr, "usage: ota_tool shift [-a addr] [-i bytes] [-e edits] [-s seed] OLD.hex OUT.hex\n" );
+    return 2;
+  }
+  if ( ota_load_hex( argv[optind], img, &len ) )
+  {
+    return 1;
+  }
+
+  // The bank's code as the CPU sees it: the common area at 0, banks at 0x8000
+  bank = at - at % OTA_BANK;
+  for ( used = bank + OTA_BANK; used > bank && img[used - 1] == 0xFF; used-- )
+  {
+  }
+  if ( at >= used || used + ins > bank + OTA_BANK )
+  {
+    fprintf( stderr, "shift: 0x%05X is not in code with %u bytes to spare in its bank\n", at, ins );
+    return 1;
+  }
+  logical = bank ? OTA_BANK : 0;
+  for ( p = bank; p + 2 < used; p++ )
+  {
+    if ( img[p] != 0x02 && img[p] != 0x12 && img[p] != 0x90 )
+    {
+      continue;
+    }
+    x = (img[p + 1] << 8) | img[p + 2];
+    if ( x >= logical + (at - bank) && x < logical + (used - bank) )
+    {
+      x += ins;
+      img[p + 1] = (uint8_t)(x >> 8);
+      img[p + 2] = (uint8_t)x;
+    }
+    p += 2;
+  }
+  memmove( &img[at + ins], &img[at], used - at );
+  for ( p = at; p < at + ins; p++ )
+  {
+    img[p] = (uint8_t)bench_rand32( &otaSeed );
+  }
+  if ( used + ins > len )
+  {
+    len = used + ins;
+  }
+  while ( edits-- )
+  {
+    do
+    {
+      p = bank + bench_rand32( &otaSeed ) % (len - bank);
+    } while ( img[p] == 0xFF );
+    img[p] = (uint8_t)bench_rand32( &otaSeed );
+  }
+  return ota_save_hex( argv[optind + 1], img, len ) ? 1 : 0;
+}
+
+/*********************************************************************
+ * Stand-in OTA server
+ */
+static uint64_t ota_air_us( uint32_t zclLen )
+{
+  return (uint64_t)otaHops * (OTA_FRAME_OVERHEAD + zclLen + OTA_ACK_BYTES) * OTA_US_PER_BYTE;
+}
+
+static int ota_lost( void )
+{
+  return (bench_rand32( &otaSeed ) % 100000) < otaLossPct * 1000;
+}
+
+static void ota_count( otaCount_t *c, uint32_t zclLen )
+{
+  c->frames++;
+  c->bytes += zclLen;
+  c->air_us += ota_air_us( zclLen );
+}
+
+static void ota_deliver( void *arg, uint32_t argInt )
+{
+  sim_zcl_frame( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_OTA, 0x0000, 1, arg, (uint16)argInt );
+  free( arg );
+}
+
+// A response from the server, which reaches the module unless it is lost
+static void ota_respond( otaCount_t *c, uint8_t seq, uint8_t cmd, const uint8_t *payload, uint32_t len )
+{
+  uint8_t *frame = malloc( 3 + len );
+
+  frame[0] = ZCL_FRAME_TYPE_SPECIFIC_CMD | ZCL_FRAME_CONTROL_DIRECTION | ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP;
+  frame[1] = seq;
+  frame[2] = cmd;
+  memcpy( &frame[3], payload, len );
+  ota_count( c, 3 + len );
+  if ( ota_lost() )
+  {
+    otaLost++;
+    free( frame );
+    return;
+  }
+  sim_schedule( sim_now_us() + 2ULL * otaHops * OTA_HOP_US + OTA_SERVER_US, ota_deliver, frame, 3 + len );
+}
+
+static void ota_id( uint8_t *p, uint32_t version )
+{
+  p[0] = LO_UINT16( OPENEVSE_OTA_MANUFACTURER );
+  p[1] = HI_UINT16( OPENEVSE_OTA_MANUFACTURER );
+  p[2] = LO_UINT16( OPENEVSE_OTA_IMAGE_TYPE );
+  p[3] = HI_UINT16( OPENEVSE_OTA_IMAGE_TYPE );
+  memcpy( &p[4], &version, 4 );
+}
+
+static void ota_server( uint64_t t_us, uint8 endpoint, afAddrType_t *dstAddr,
+                        uint16 clusterId, const uint8 *buf, uint16 len )
+{
+  uint8_t rsp[14 + 0xFF];
+  otaCount_t *c;
+  uint32_t offset, n;
+
+  (void)endpoint;
+  (void)dstAddr;
+  if ( clusterId != ZCL_CLUSTER_ID_OTA || len < 3 )
+  {
+    return;
+  }
+  c = buf[2] == OPENEVSE_OTA_CMD_IMAGE_BLOCK_REQ ? &otaBlocks :
+      buf[2] == OPENEVSE_OTA_CMD_UPGRADE_END_REQ ? &otaEnd : &otaQuery;
+  ota_count( c, len );
+  if ( ota_lost() )
+  {
+    otaLost++;
+    return;
+  }
+
+  switch ( buf[2] )
+  {
+    case OPENEVSE_OTA_CMD_QUERY_NEXT_IMAGE_REQ:
+      rsp[0] = ZCL_STATUS_SUCCESS;
+      ota_id( &rsp[1], otaFileVersion );
+      memcpy( &rsp[9], &otaFileLen, 4 );
+      ota_respond( c, buf[1], OPENEVSE_OTA_CMD_QUERY_NEXT_IMAGE_RSP, rsp, 13 );
+      break;
+
+    case OPENEVSE_OTA_CMD_IMAGE_BLOCK_REQ:
+      if ( len < 3 + 14 )
+      {
+        break;
+      }
+      offset = ota_get32( &buf[3 + 9] );
+      n = buf[3 + 13];
+      if ( n > sizeof( rsp ) - 14 )
+      {
+        n = sizeof( rsp ) - 14;
+      }
+      if ( offset >= otaFileLen )
+      {
+        rsp[0] = ZCL_STATUS_ABORT;
+        ota_respond( c, buf[1], OPENEVSE_OTA_CMD_IMAGE_BLOCK_RSP, rsp, 1 );
+        break;
+      }
+      if ( n > otaFileLen - offset )
+      {
+        n = otaFileLen - offset;
+      }
+      if ( n > otaBlockData )
+      {
+        otaBlockData = n;
+      }
+      otaBlocksServed++;
+      rsp[0] = ZCL_STATUS_SUCCESS;
+      ota_id( &rsp[1], otaFileVersion );
+      memcpy( &rsp[9], &offset, 4 );
+      rsp[13] = (uint8_t)n;
+      memcpy( &rsp[14], &otaFile[offset], n );
+      ota_respond( c, buf[1], OPENEVSE_OTA_CMD_IMAGE_BLOCK_RSP, rsp, 14 + n );
+      break;
+
+    case OPENEVSE_OTA_CMD_UPGRADE_END_REQ:
+      otaEndStatus = buf[3];
+      if ( otaDownloaded_us == 0 )
+      {
+        otaDownloaded_us = t_us;
+      }
+      if ( buf[3] != ZCL_STATUS_SUCCESS )
+      {
+        break;
+      }
+      // Upgrade now: current time and upgrade time the same
+      ota_id( rsp, otaFileVersion );
+      memset( &rsp[8], 0, 8 );
+      otaErasesBefore = sim_flash_erases;
+      otaWordsBefore = sim_flash_words;
+      if ( otaCorrupt )
+      {
+        // The last byte of the delta, past the header the module checks
+        sim_flash[(uint32_t)OPENEVSE_OTA_SLOT_PAGE * OTA_PAGE + otaFileLen - 1] ^= 0x5A;
+      }
+      ota_respond( c, buf[1], OPENEVSE_OTA_CMD_UPGRADE_END_RSP, rsp, 16 );
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void ota_notify( void *arg, uint32_t argInt )
+{
+  // Query jitter only, all modules
+  uint8_t frame[5] = { ZCL_FRAME_TYPE_SPECIFIC_CMD | ZCL_FRAME_CONTROL_DIRECTION |
+                       ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP, 0, OPENEVSE_OTA_CMD_IMAGE_NOTIFY, 0, 100 };
+
+  (void)arg;
+  (void)argInt;
+  ota_count( &otaQuery, sizeof( frame ) );
+  otaStart_us = sim_now_us();
+  sim_zcl_frame( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_OTA, 0x0000, 1, frame, sizeof( frame ) );
+}
+
+static void ota_reset( uint64_t t_us )
+{
+  otaReset_us = t_us;
+}
+
+static int ota_cmd_serve( int argc, char **argv )
+{
+  static uint8_t img[SIM_FLASH_SIZE];
+  static uint8_t old[SIM_FLASH_SIZE];
+  evseCfg_t cfg = evse_default_cfg;
+  uint32_t chargers = 1, len, newLen = 0, fullBlocks, blocks, pages, words;
+  uint64_t air, dlAir, fullAir, fixedAir;
+  double dlSecs, fullSecs;
+  FILE *f;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "cN:H:l:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'c': otaCorrupt = TRUE; break;
+      case 'N': chargers = (uint32_t)atoi( optarg ); break;
+      case 'H': otaHops = (uint8_t)atoi( optarg ); break;
+      case 'l': otaLossPct = atof( optarg ); break;
+      case 's': otaSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default: return 2;
+    }
+  }
+  if ( argc - optind < 2 || argc - optind > 3 || chargers == 0 || otaHops == 0 ||
+       otaLossPct < 0 || otaLossPct >= 100 )
+  {
+    fprintf( stderr, "usage: ota_tool serve [-c] [-N chargers] [-H hops] [-l loss_pct] [-s seed] "
+                     "OLD.hex FILE [NEW.hex]\n" );
+    return 2;
+  }
+  if ( ota_load_hex( argv[optind], sim_flash, &len ) )
+  {
+    return 1;
+  }
+  memcpy( old, sim_flash, ota_pages( len ) );
+  f = fopen( argv[optind + 1], "rb" );
+  if ( f == NULL )
+  {
+    perror( argv[optind + 1] );
+    return 1;
+  }
+  otaFile = malloc( SIM_FLASH_SIZE );
+  otaFileLen = (uint32_t)fread( otaFile, 1, SIM_FLASH_SIZE, f );
+  fclose( f );
+  if ( otaFileLen < OPENEVSE_OTA_HEADER_LEN + OPENEVSE_OTA_SUB_HEADER_LEN ||
+       ota_get32( otaFile ) != OPENEVSE_OTA_MAGIC )
+  {
+    fprintf( stderr, "%s: not an OTA file\n", argv[optind + 1] );
+    return 1;
+  }
+  otaFileVersion = ota_get32( &otaFile[14] );
+  if ( argc - optind == 3 && ota_load_hex( argv[optind + 2], img, &newLen ) )
+  {
+    return 1;
+  }
+
+  evse_init( &otaEvse, &cfg, sim_uart_evse_send, sim_now_us );
+  bench_evse = &otaEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_frame_hook = ota_server;
+  sim_reset_hook = ota_reset;
+  sim_osal_init();
+  sim_set_nwk_state( DEV_ROUTER );
+  sim_schedule( OTA_NOTIFY_US, ota_notify, NULL, 0 );
+  while ( otaReset_us == 0 && sim_now_us() < OTA_LIMIT_US &&
+          !(otaEndStatus != 0xFF && otaEndStatus != ZCL_STATUS_SUCCESS) )
+  {
+    sim_run_until( sim_now_us() + 1000000 );
+  }
+
+  blocks = otaBlocksServed;
+  air = otaQuery.air_us + otaBlocks.air_us + otaEnd.air_us;
+  dlAir = otaBlocks.air_us;
+  fixedAir = otaQuery.air_us + otaEnd.air_us;
+  dlSecs = otaDownloaded_us ? (otaDownloaded_us - otaStart_us) / 1e6 : 0;
+  printf( "OTA from a stand-in server, %u hop%s, %.1f%% loss each way, block period %u ms\n",
+          otaHops, otaHops > 1 ? "s" : "", otaLossPct, zclOpenEvse_otaBlockPeriod );
+  printf( "%-6s %9s %7s %7s %8s %8s %14s %12s\n", "image", "file B", "blocks", "frames", "lost", "retries",
+          "air ms/module", "air s/site" );
+  printf( "%-6s %9u %7u %7u %8u %8u %14.1f %12.2f\n",
+          otaFile[OPENEVSE_OTA_HEADER_LEN] == LO_UINT16( OPENEVSE_OTA_TAG_DELTA ) &&
+          otaFile[OPENEVSE_OTA_HEADER_LEN + 1] == HI_UINT16( OPENEVSE_OTA_TAG_DELTA ) ? "delta" : "image",
+          otaFileLen, blocks,
+          otaQuery.frames + otaBlocks.frames + otaEnd.frames, otaLost, zclOpenEvse_otaBlockRetries,
+          air / 1e3, air * chargers / 1e6 );
+
+  if ( newLen && blocks && otaBlockData )
+  {
+    // The whole image in the same blocks, at the same cost per block
+    fullBlocks = (OPENEVSE_OTA_HEADER_LEN + OPENEVSE_OTA_SUB_HEADER_LEN + newLen + otaBlockData - 1) / otaBlockData;
+    fullAir = fixedAir + dlAir * fullBlocks / blocks;
+    fullSecs = dlSecs * fullBlocks / blocks;
+    printf( "%-6s %9u %7u %7u %8s %8s %14.1f %12.2f  (estimated)\n", "full",
+            OPENEVSE_OTA_HEADER_LEN + OPENEVSE_OTA_SUB_HEADER_LEN + newLen, fullBlocks,
+            otaQuery.frames + otaEnd.frames + otaBlocks.frames * fullBlocks / blocks,
+            "-", "-", fullAir / 1e3, fullAir * chargers / 1e6 );
+    printf( "site of %u: download %.1f s per module (full %.1f s), airtime cut %.1fx\n", chargers, dlSecs,
+            fullSecs, (double)fullAir / air );
+  }
+  if ( otaReset_us == 0 )
+  {
+    printf( "upgrade: not applied, Upgrade End status 0x%02X", otaEndStatus );
+    if ( otaCorrupt && otaEndStatus == ZCL_STATUS_INVALID_IMAGE )
+    {
+      printf( ", %u flash erases", sim_flash_erases - otaErasesBefore );
+      if ( sim_flash_erases != otaErasesBefore || memcmp( sim_flash, old, ota_pages( len ) ) )
+      {
+        printf( ", flash does NOT match %s\n", argv[optind] );
+        return 1;
+      }
+      printf( ", flash matches %s\n", argv[optind] );
+      return 0;
+    }
+    printf( "\n" );
+    return 1;
+  }
+  printf( "upgrade: applied %.1f s after the notify, %u flash erases",
+          (otaReset_us - otaStart_us) / 1e6, sim_flash_erases - otaErasesBefore );
+  if ( newLen )
+  {
+    uint32_t from = ota_pages( newLen );
+
+    memset( &img[newLen], 0xFF, from - newLen );
+    if ( memcmp( sim_flash, img, from ) )
+    {
+      printf( ", flash does NOT match %s\n", argv[optind + 2] );
+      return 1;
+    }
+    printf( ", flash matches %s", argv[optind + 2] );
+  }
+  printf( "\n" );
+
+  // Each page rewritten is built in scratch first; the image is broken
+  // from the first page's erase on
+  pages = (sim_flash_erases - otaErasesBefore) / 2;
+  words = sim_flash_words - otaWordsBefore;
+  if ( pages )
+  {
+    printf( "brick window: %u pages rewritten, %.0f ms\n", pages,
+            ((2 * pages - 1) * OTA_ERASE_US + (double)(words - OTA_PAGE / HAL_FLASH_WORD_SIZE) * OTA_WORD_US) / 1e3 );
+  }
+  return 0;
+}
+
+int main( int argc, char **argv )
+{
+  if ( argc >= 2 )
+  {
+    // Each command's options and operands follow its name
+    if ( !strcmp( argv[1], "delta" ) )
+    {
+      return ota_cmd_delta( argc - 1, argv + 1 );
+    }
+    if ( !strcmp( argv[1], "full" ) )
+    {
+      return ota_cmd_full( argc - 1, argv + 1 );
+    }
+    if ( !strcmp( argv[1], "shift" ) )
+    {
+      return ota_cmd_shift( argc - 1, argv + 1 );
+    }
+    if ( !strcmp( argv[1], "serve" ) )
+    {
+      return ota_cmd_serve( argc - 1, argv + 1 );
+    }
+  }
+  fprintf( stderr, "usage: ota_tool delta|full|shift|serve ...\n" );
+  return 2;
+}
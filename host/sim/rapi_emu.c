@@ -0,0 +1,289 @@
+/*
+ * rapi_emu.c - OpenEVSE RAPI responder on a pseudo-terminal.
+ *
+ * Usage: rapi_emu [-l link] [-d reply_ms] [-b baud] [-c pct] [-x pct]
+ *                 [-k pct] [-a async_ms] [-r seed] [-v]
+ *
+ *   -l link      also make a symlink to the pty slave, e.g. /tmp/openevse
+ *   -d reply_ms  processing time before each reply (default 10)
+ *   -b baud      pace replies at this line rate, 0 for as fast as possible
+ *                (default 115200)
+ *   -c pct       chance a reply has one byte overwritten with garbage
+ *   -x pct       chance a reply loses one byte
+ *   -k pct       chance a reply carries a wrong checksum
+ *   -a async_ms  walk plug -> charge -> unplug every async_ms, which sends
+ *                an asynchronous $ST at each step (default off)
+ *   -r seed      random seed for the faults
+ *
+ * The slave path is printed on the first line of stdout. Anything that
+ * opens it (uart_bench, a real module through socat, a terminal) talks to
+ * the same evse_model the simulator uses. Faults are applied to the reply
+ * frames after the checksum is added, so they look like line noise.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "evse_model.h"
+
+#define EMU_MAX_QUEUE 32
+
+typedef struct
+{
+  uint64_t due_us;
+  uint16_t len;
+  char data[80];
+} emuFrame_t;
+
+static emuFrame_t emuQueue[EMU_MAX_QUEUE];
+static uint8_t emuQueued = 0;
+static uint64_t emuTxBusy_us = 0;
+static uint32_t emuByteUs = 87;
+static double emuCorruptPct = 0, emuDropPct = 0, emuChecksumPct = 0;
+static int emuVerbose = 0;
+static volatile sig_atomic_t emuStop = 0;
+static uint64_t emuStart_us;
+
+static uint32_t emuFramesOut = 0, emuCorrupted = 0, emuDropped = 0, emuBadChecksum = 0;
+
+static uint64_t emu_now_us( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 - emuStart_us;
+}
+
+static int emu_chance( double pct )
+{
+  return pct > 0 && rand() < pct / 100.0 * RAND_MAX;
+}
+
+// Queue a frame behind the ones already on the wire
+static void emu_send( evse_t *e, const char *frame, uint32_t delayMs )
+{
+  emuFrame_t *f;
+  uint64_t due = emu_now_us() + (uint64_t)delayMs * 1000;
+  uint16_t len = (uint16_t)strlen( frame );
+
+  (void)e;
+  if ( emuQueued == EMU_MAX_QUEUE )
+  {
+    return;
+  }
+  if ( due < emuTxBusy_us )
+  {
+    due = emuTxBusy_us;
+  }
+  due += (uint64_t)len * emuByteUs;
+  emuTxBusy_us = due;
+
+  f = &emuQueue[emuQueued++];
+  f->due_us = due;
+  f->len = len;
+  memcpy( f->data, frame, len );
+}
+
+// Damage a frame on its way out; the final '\r' is left alone so the
+// module still sees a frame boundary
+static void emu_fault( emuFrame_t *f )
+{
+  uint16_t body = f->len - 1;
+  uint16_t i;
+
+  if ( body > 3 && emu_chance( emuChecksumPct ) )
+  {
+    f->data[body - 1] = f->data[body - 1] == '0' ? '1' : '0';
+    emuBadChecksum++;
+  }
+  if ( body > 1 && emu_chance( emuCorruptPct ) )
+  {
+    i = 1 + rand() % (body - 1);
+    f->data[i] = (char)(0x21 + rand() % 0x5E);
+    emuCorrupted++;
+  }
+  if ( body > 1 && emu_chance( emuDropPct ) )
+  {
+    i = rand() % body;
+    memmove( &f->data[i], &f->data[i + 1], f->len - i - 1 );
+    f->len--;
+    emuDropped++;
+  }
+}
+
+static void emu_flush( int fd )
+{
+  uint64_t now = emu_now_us();
+
+  while ( emuQueued && emuQueue[0].due_us <= now )
+  {
+    emuFrame_t *f = &emuQueue[0];
+
+    emu_fault( f );
+    if ( emuVerbose )
+    {
+      fprintf( stderr, "%10.3f evse  %.*s\n", now / 1e6, f->len - 1, f->data );
+    }
+    if ( write( fd, f->data, f->len ) < 0 && errno != EAGAIN )
+    {
+      perror( "write" );
+    }
+    emuFramesOut++;
+    memmove( &emuQueue[0], &emuQueue[1], (emuQueued - 1) * sizeof( emuFrame_t ) );
+    emuQueued--;
+  }
+}
+
+// One step of a charge session, each of which changes the EVSE state
+static void emu_async_step( evse_t *e )
+{
+  if ( !e->plugged )
+  {
+    evse_plug( e, 1 );
+  }
+  else if ( !e->wantAmps )
+  {
+    evse_charge( e, 30 );
+  }
+  else
+  {
+    evse_plug( e, 0 );
+  }
+}
+
+static void emu_signal( int sig )
+{
+  (void)sig;
+  emuStop = 1;
+}
+
+int main( int argc, char **argv )
+{
+  evseCfg_t cfg = evse_default_cfg;
+  const char *link = NULL;
+  uint32_t asyncMs = 0;
+  uint64_t nextAsync_us = 0;
+  uint32_t baud = 115200;
+  struct termios tio;
+  evse_t evse;
+  int fd;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "l:d:b:c:x:k:a:r:v" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'l': link = optarg; break;
+      case 'd': cfg.respDelayMs = (uint32_t)atoi( optarg ); break;
+      case 'b': baud = (uint32_t)atoi( optarg ); break;
+      case 'c': emuCorruptPct = atof( optarg ); break;
+      case 'x': emuDropPct = atof( optarg ); break;
+      case 'k': emuChecksumPct = atof( optarg ); break;
+      case 'a': asyncMs = (uint32_t)atoi( optarg ); break;
+      case 'r': srand( (unsigned)atoi( optarg ) ); break;
+      case 'v': emuVerbose = 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-l link] [-d reply_ms] [-b baud] [-c pct] [-x pct] [-k pct] "
+                         "[-a async_ms] [-r seed] [-v]\n", argv[0] );
+        return 2;
+    }
+  }
+  emuByteUs = baud ? 10000000 / baud : 0; // 8N1
+
+  fd = posix_openpt( O_RDWR | O_NOCTTY );
+  if ( fd < 0 || grantpt( fd ) < 0 || unlockpt( fd ) < 0 )
+  {
+    perror( "posix_openpt" );
+    return 1;
+  }
+  tcgetattr( fd, &tio );
+  cfmakeraw( &tio );
+  tcsetattr( fd, TCSANOW, &tio );
+  fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK );
+
+  if ( link )
+  {
+    unlink( link );
+    if ( symlink( ptsname( fd ), link ) < 0 )
+    {
+      perror( link );
+      return 1;
+    }
+  }
+  printf( "%s\n", ptsname( fd ) );
+  fflush( stdout );
+
+  signal( SIGINT, emu_signal );
+  signal( SIGTERM, emu_signal );
+
+  emuStart_us = 0;
+  emuStart_us = emu_now_us();
+  evse_init( &evse, &cfg, emu_send, emu_now_us );
+  if ( asyncMs )
+  {
+    nextAsync_us = (uint64_t)asyncMs * 1000;
+  }
+
+  while ( !emuStop )
+  {
+    struct pollfd pfd;
+    uint64_t now = emu_now_us();
+    uint64_t wake = now + 100000;
+    uint8_t buf[256];
+    ssize_t n;
+
+    if ( emuQueued && emuQueue[0].due_us < wake )
+    {
+      wake = emuQueue[0].due_us;
+    }
+    if ( nextAsync_us && nextAsync_us < wake )
+    {
+      wake = nextAsync_us;
+    }
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    poll( &pfd, 1, wake > now ? (int)((wake - now + 999) / 1000) : 0 );
+
+    // POLLHUP just means nobody has the slave open yet
+    if ( pfd.revents & POLLIN )
+    {
+      n = read( fd, buf, sizeof( buf ) );
+      if ( n > 0 )
+      {
+        if ( emuVerbose )
+        {
+          fprintf( stderr, "%10.3f zb    %.*s\n", emu_now_us() / 1e6, (int)strcspn( (char *)buf, "\r" ), buf );
+        }
+        evse_rx( &evse, buf, (uint16_t)n );
+      }
+    }
+    else if ( pfd.revents & POLLHUP )
+    {
+      usleep( 10000 );
+    }
+    if ( nextAsync_us && emu_now_us() >= nextAsync_us )
+    {
+      emu_async_step( &evse );
+      nextAsync_us += (uint64_t)asyncMs * 1000;
+    }
+    emu_flush( fd );
+  }
+
+  fprintf( stderr, "rapi_emu: %u commands, %u frames out, %u bad checksum in, %u unknown; "
+                   "injected %u corrupt, %u dropped byte, %u bad checksum\n",
+           evse.cmds, emuFramesOut, evse.badChecksum, evse.unknown,
+           emuCorrupted, emuDropped, emuBadChecksum );
+  if ( link )
+  {
+    unlink( link );
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * sim.h - discrete-event core shared by the host stand-ins for OSAL, the
+ * HAL UART and the ZCL send layer.
+ *
+ * Time is kept in microseconds; the application only sees the millisecond
+ * OSAL clock. The simulator jumps it from event to event; uart_bench moves
+ * it along with the wall clock.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#include "host_stack.h"
+
+typedef void (*simFn_t)( void *arg, uint32_t argInt );
+
+/* Clock and scheduler (osal_host.c) */
+extern uint64_t sim_now_us( void );
+extern void sim_schedule( uint64_t at_us, simFn_t fn, void *arg, uint32_t argInt );
+extern void sim_run_until( uint64_t end_us );
+extern uint64_t sim_next_us( void );
+extern void sim_osal_init( void );
+extern uint32_t sim_heap_high_water( void );
+// Error of the module's UTC clock against simulated time
+extern double sim_clock_ppm;
+
+/* Power manager (osal_host.c), for builds with POWER_SAVING */
+// Keeps the MCU awake until until_us
+extern void sim_wake( uint64_t until_us );
+// Whether the MCU is awake now; always with no POWER_SAVING
+extern uint8 sim_awake( void );
+// Time the MCU has spent awake, and the times it woke
+extern uint64_t sim_awake_us( void );
+extern uint32_t sim_wakes;
+// Never sleeps and keeps the receiver on, as a router does
+extern uint8 sim_pwr_always_on;
+
+/* Network and ZCL injection (zcl_host.c) */
+extern void sim_set_nwk_state( devStates_t state );
+// Group the On/Off and Level commands below are addressed to, 0 for none
+extern uint16 sim_zcl_group;
+// Sent as a broadcast, to 0xFFFF or 0xFFFD
+extern uint8 sim_zcl_broadcast;
+extern void sim_zcl_onoff( uint8 endpoint, uint8 cmd );
+// Move to Level, transition time in tenths of a second
+extern void sim_zcl_level( uint8 endpoint, uint8 level, uint16 transitionTime );
+extern void sim_zcl_identify( uint8 endpoint, uint16 identifyTime );
+extern void sim_zcl_trigger_effect( uint8 endpoint, uint8 effectId, uint8 effectVariant );
+// Delivers a Write Attributes frame; the Write Response, once the
+// application sends it, goes to sim_write_rsp_hook. String values start
+// with their length byte.
+extern uint8 sim_zcl_write( uint8 endpoint, uint16 clusterId, uint16 attrId, const void *value );
+extern uint8 sim_zcl_read( uint8 endpoint, uint16 clusterId, uint16 attrId, void *value, uint8 len );
+// IEEE address the application sees, which seeds its jitter
+extern uint8 sim_ext_addr[Z_EXTADDR_LEN];
+// A ZCL frame, header and all, from srcAddr to the endpoint's task
+extern void sim_zcl_frame( uint8 endpoint, uint16 clusterId, uint16 srcAddr, uint8 srcEndpoint,
+                           const uint8 *buf, uint16 len );
+
+/* Flash (zcl_host.c), the CC2530's 256 KB. It starts out all zero; fill
+   it before the application reads it. Erases, and words written, are
+   counted. */
+#define SIM_FLASH_SIZE 0x40000
+extern uint8 sim_flash[SIM_FLASH_SIZE];
+extern uint32_t sim_flash_erases;
+extern uint32_t sim_flash_words;
+// Called instead of the message for Onboard_soft_reset()
+typedef void (*simResetHook_t)( uint64_t t_us );
+extern simResetHook_t sim_reset_hook;
+
+/* Called for every report that reaches the air */
+typedef void (*simReportHook_t)( uint64_t t_us, uint8 endpoint, uint16 clusterId,
+                                 uint16 attrId, uint32_t value );
+extern simReportHook_t sim_report_hook;
+
+/* Called for every Write Attributes Response record */
+typedef void (*simWriteRspHook_t)( uint64_t t_us, uint8 endpoint, uint16 clusterId,
+                                   uint16 attrId, uint8 status );
+extern simWriteRspHook_t sim_write_rsp_hook;
+
+/* Fate of a report frame in the network: the status of its AF data
+   confirm, ZSuccess or a MAC, NWK or APS failure. options carries
+   AF_ACK_REQUEST for frames sent with APS acks. */
+typedef uint8 (*simSendHook_t)( uint8 endpoint, uint16 clusterId, uint8 options );
+extern simSendHook_t sim_send_hook;
+/* The next frame sent with APS acks fails, confirmed confirmUs later as once
+   the APS retries are used up. The ZCL then answers reads from the same
+   endpoint until its counter reaches that transaction ID, and fn sends the
+   frame that takes it. */
+extern void sim_af_collide( uint64_t confirmUs, simFn_t fn, void *arg, uint32_t argInt );
+/* Bindings for frames sent with no address: those the SmartThings handler
+   makes on every charger endpoint, and any added here. Frames that find
+   none fail with ZApsNoBoundDevice; sim_unbound counts them. */
+extern void sim_bind( uint8 endpoint, uint16 clusterId );
+extern uint32_t sim_unbound;
+// Failing data confirms given for frames sent with no address, which are
+// the module's reports, alerts and events
+extern uint32_t sim_report_fails;
+/* Called for every frame the application sends, with its ZCL header */
+typedef void (*simFrameHook_t)( uint64_t t_us, uint8 endpoint, afAddrType_t *dstAddr,
+                                uint16 clusterId, const uint8 *buf, uint16 len );
+extern simFrameHook_t sim_frame_hook;
+// Link quality of the parent's association table entry
+extern uint8 sim_parent_lqi;
+
+/* The parent, for end devices. Frames for the module wait with the parent
+   until the module's next data poll, at the rate it last gave
+   NLME_SetPollRate(); with no polling (a router, or sim_pwr_always_on)
+   they go straight through. Radio time is counted for polls and sends. */
+extern void sim_parent_send( simFn_t fn, void *arg, uint32_t argInt );
+extern uint32 sim_poll_rate;
+extern uint32_t sim_polls;
+extern uint64_t sim_radio_rx_us;
+extern uint64_t sim_radio_tx_us;
+// Poll Control, to the endpoint's registered callbacks. For Check-in
+// Response, value is the fast poll timeout and 0 means no fast polling;
+// Fast Poll Stop takes none.
+extern void sim_zcl_poll_control( uint8 endpoint, uint8 cmd, uint32_t value );
+// Called for every Check-in the application sends
+typedef void (*simCheckInHook_t)( uint64_t t_us, uint8 endpoint );
+extern simCheckInHook_t sim_checkin_hook;
+
+/* UART link (hal_uart_host.c) */
+#define SIM_UART_PORTS 2
+
+// Time on the wire for one 8N1 byte at 115200 baud
+#define SIM_UART_BYTE_US 87
+
+typedef void (*simUartSink_t)( uint8 port, const uint8 *buf, uint16 len );
+
+// Receives the bytes the application writes, once they are off the wire
+extern simUartSink_t sim_uart_sink;
+// Bytes from the EVSE side; they arrive in the RX ring at wire speed.
+// Returns the time the last byte is in.
+extern uint64_t sim_uart_inject( uint8 port, const uint8 *buf, uint16 len );
+// Sender for an evse_model on port 0: the frame goes on the wire delayMs
+// from now
+struct evse;
+extern void sim_uart_evse_send( struct evse *e, const char *frame, uint32_t delayMs );
+extern uint64_t sim_uart_tx_bytes[SIM_UART_PORTS];
+extern uint64_t sim_uart_rx_bytes[SIM_UART_PORTS];
+extern uint64_t sim_uart_rx_overflow[SIM_UART_PORTS];
+// Bytes that arrived with the MCU asleep and the receiver off
+extern uint64_t sim_uart_rx_asleep[SIM_UART_PORTS];
+// Line noise, in percent per byte, applied in both directions
+extern double sim_uart_loss_pct;
+extern double sim_uart_garbage_pct;
+extern void sim_uart_seed( uint32_t seed );
+// Keeps the RX callback from running until until_us, as a long event does;
+// the ring goes on filling and overflows
+extern void sim_uart_stall( uint64_t until_us );
+
+#endif /* SIM_H */
@@ -0,0 +1,802 @@
+/*
+ * sim_main.c - run the OpenEVSE application against a scripted EVSE on a
+ * virtual clock and report latency, UART utilization and report rates.
+ *
+ * Usage: openevse_sim [-H hours] [-s script] [-d reply_ms] [-b boot_ms]
+ *                     [-t trace_file] [-v]
+ *
+ * The EVSE model powers up with the module and ignores RAPI for boot_ms
+ * (default 3000) while it runs its self test.
+ *
+ * -t collects the transaction trace over ZCL the way a field tool would,
+ * moving the trace cursor and reading chunks every 2 seconds, and writes
+ * each chunk to trace_file as a line of hex for host/trace_decode.py.
+ *
+ * A script is a list of "<seconds> <action> [arg]" lines. Lines after
+ * "repeat <seconds>" form a block that runs again every <seconds>, with
+ * times relative to the start of the block. Actions:
+ *
+ *   join | leave             network state change
+ *   plug | unplug            connect or disconnect the car
+ *   charge <amps>            car starts drawing current
+ *   state <hex>              force an EVSE state, e.g. a fault
+ *   temp <deg C>             EVSE temperature
+ *   zcl on | off | toggle    On/Off command to the charger endpoint
+ *   backlight on | off       On/Off command to the backlight endpoint
+ *   identify <seconds>       Identify command to the charger endpoint
+ *   effect <id>              Identify Trigger Effect, e.g. 1 for breathe
+ *   limit <kWh>              write CurrentDemandLimit (16777215 for none)
+ *   level <amps>[,<tenths>]  Move to Level, pilot current over a transition;
+ *                            the run fails unless a ramp's last $SC reaches
+ *                            the EVSE within SIM_RAMP_SLACK_MS of its end
+ *   group [bcast] on | off | <amps>[,<tenths>]
+ *                            On/Off or Move to Level sent to group 1, which
+ *                            holds every charger endpoint, or with bcast as a
+ *                            broadcast to every device
+ *   collide <kWh>            the next acknowledged report fails, and the
+ *                            ZCL answers reads until the Write Response to
+ *                            CurrentDemandLimit written to the first charger
+ *                            takes the report's transaction ID; the run
+ *                            fails unless the module counts the report as
+ *                            failed
+ *
+ * Reports, alerts and events go out to the hub's bindings, those the
+ * SmartThings handler makes, and the run fails if one finds none.
+ *
+ * openevse_sim_gw is the gateway build, two chargers on the two UARTs of
+ * one module. Each has its own EVSE model and every action applies to both.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define SIM_MAX_STEPS   256
+#define SIM_MAX_PENDING 64
+#define SIM_COLLIDE_CONFIRM_US 3000000 // a report's confirm once its APS retries are used up
+#define SIM_RAMP_SLACK_MS 2000         // a ramp's last $SC against its transition time
+
+typedef struct
+{
+  double t;
+  char action[16];
+  char arg[32];  // one word, or two with a space between
+  uint8_t repeat;
+} simStep_t;
+
+typedef struct
+{
+  uint64_t t_us;
+  uint8_t port;
+  char code[4];
+} simPending_t;
+
+static const char *simDefaultScript[] =
+{
+  "9 join",
+  "repeat 14400",
+  "300 plug",
+  "320 charge 30",
+  "3600 identify 60",
+  "3700 effect 1",
+  "4000 level 26,6000",
+  "4700 level 32,6000",
+  "7500 unplug",
+  "10800 zcl off",
+  "11400 zcl on",
+  "12000 plug",
+  "12010 charge 16",
+  "12590 collide 5",
+  "13000 unplug",
+  "13100 limit 16777215",
+  "13200 backlight off",
+  "13800 backlight on",
+  NULL
+};
+
+static simStep_t simSteps[SIM_MAX_STEPS];
+static uint16_t simNumSteps = 0;
+static double simRepeat = 0;
+static double simRepeatStart = 0;
+static int simVerbose = 0;
+
+static evse_t simEvse[OPENEVSE_NUM_EVSE];  // one per UART port
+
+// Commands waiting for the EVSE to acknowledge, and state changes waiting to be reported
+static simPending_t simCmds[SIM_MAX_PENDING];
+static uint8_t simNumCmds = 0;
+static simPending_t simStates[SIM_MAX_PENDING];
+static uint8_t simNumStates = 0;
+
+static benchSeries_t simStateLatency = { "state change -> report" };
+static benchSeries_t simCmdLatency = { "command -> EVSE ack" };
+static benchSeries_t simWriteLatency = { "limit write -> write rsp" };
+static benchSeries_t simPowerPoll = { "$GG to next $GG" };
+static benchSeries_t simRampEnd = { "ramp end - transition time" };
+static uint64_t simLastPowerPoll_us[OPENEVSE_NUM_EVSE];
+static uint32_t simLcdCmds[OPENEVSE_NUM_EVSE];
+static uint64_t simWrite_us[OPENEVSE_NUM_EVSE];
+static uint64_t simWritesFailed = 0;
+static uint64_t simReports = 0;
+static uint64_t simReportsByCluster[4];
+static uint64_t simFirstReport_us = 0;
+static uint64_t simStatesMissed = 0;
+static uint32_t simCollisions = 0;
+static uint64_t simRampDue_us[OPENEVSE_NUM_EVSE];  // when a ramp running should end, 0 for none
+static uint8_t simRampAmps[OPENEVSE_NUM_EVSE];
+static uint32_t simRampsLate = 0;
+
+/*********************************************************************
+ * EVSE side of the wire
+ */
+typedef struct
+{
+  int ack;          // index into simCmds + 1, 0 for none
+  uint8_t port;
+  char frame[];
+} simFrame_t;
+
+static int simNextAck = 0;
+
+static void sim_pending_drop( simPending_t *list, uint8_t *n, uint8_t i )
+{
+  memmove( &list[i], &list[i + 1], (*n - i - 1) * sizeof( simPending_t ) );
+  (*n)--;
+}
+
+static void sim_evse_inject( void *arg, uint32_t argInt )
+{
+  simFrame_t *f = arg;
+  uint64_t done = sim_uart_inject( f->port, (uint8 *)f->frame, (uint16)strlen( f->frame ) );
+
+  (void)argInt;
+  if ( f->ack )
+  {
+    bench_add( &simCmdLatency, (done - simCmds[f->ack - 1].t_us) / 1000.0 );
+    sim_pending_drop( simCmds, &simNumCmds, (uint8_t)(f->ack - 1) );
+  }
+  if ( simVerbose )
+  {
+    printf( "%10.3f evse%u %.*s\n", sim_now_us() / 1e6, f->port, (int)strcspn( f->frame, "\r" ), f->frame );
+  }
+  free( f );
+}
+
+static void sim_evse_send( evse_t *e, const char *frame, uint32_t delayMs )
+{
+  simFrame_t *f = malloc( sizeof( simFrame_t ) + strlen( frame ) + 1 );
+
+  strcpy( f->frame, frame );
+  f->port = (uint8_t)(e - simEvse);
+  f->ack = simNextAck;
+  simNextAck = 0;
+
+  if ( !strncmp( frame, "$ST ", 4 ) && simNumStates < SIM_MAX_PENDING )
+  {
+    simStates[simNumStates].t_us = sim_now_us();
+    simStates[simNumStates].port = f->port;
+    simStates[simNumStates].code[0] = (char)strtoul( frame + 4, NULL, 16 );
+    simNumStates++;
+  }
+  sim_schedule( sim_now_us() + (uint64_t)delayMs * 1000, sim_evse_inject, f, 0 );
+}
+
+static void sim_evse_reply( evse_t *e, const char *cmd, const char *reply, uint32_t delayMs )
+{
+  uint8_t i;
+
+  (void)delayMs;
+  if ( strncmp( reply, "$OK", 3 ) )
+  {
+    return;
+  }
+  for ( i = 0; i < simNumCmds; i++ )
+  {
+    if ( simCmds[i].port == e - simEvse && !strcmp( simCmds[i].code, cmd ) )
+    {
+      simNextAck = i + 1;
+      break;
+    }
+  }
+}
+
+static void sim_uart_to_evse( uint8 port, const uint8 *buf, uint16 len )
+{
+  if ( port >= OPENEVSE_NUM_EVSE )
+  {
+    return;
+  }
+  if ( simVerbose )
+  {
+    printf( "%10.3f zb%u   %.*s\n", sim_now_us() / 1e6, port, (int)strcspn( (const char *)buf, "\r" ), buf );
+  }
+  // How evenly the telemetry poll runs, identify or not
+  if ( len >= 3 && !memcmp( buf, "$GG", 3 ) )
+  {
+    if ( simLastPowerPoll_us[port] )
+    {
+      bench_add( &simPowerPoll, (sim_now_us() - simLastPowerPoll_us[port]) / 1000.0 );
+    }
+    simLastPowerPoll_us[port] = sim_now_us();
+  }
+  else if ( len >= 3 && !memcmp( buf, "$FB", 3 ) )
+  {
+    simLcdCmds[port]++;
+  }
+  else if ( len >= 4 && !memcmp( buf, "$SC ", 4 ) && simRampDue_us[port] && atoi( (const char *)buf + 4 ) == simRampAmps[port] )
+  {
+    double late = ((double)sim_now_us() - (double)simRampDue_us[port]) / 1000.0;
+
+    bench_add( &simRampEnd, late );
+    if ( late > SIM_RAMP_SLACK_MS || late < -SIM_RAMP_SLACK_MS )
+    {
+      simRampsLate++;
+    }
+    simRampDue_us[port] = 0;
+  }
+  evse_rx( &simEvse[port], buf, len );
+}
+
+static void sim_expect( uint8_t port, const char *code )
+{
+  if ( simNumCmds < SIM_MAX_PENDING )
+  {
+    simCmds[simNumCmds].t_us = sim_now_us();
+    simCmds[simNumCmds].port = port;
+    strncpy( simCmds[simNumCmds].code, code, sizeof( simCmds[0].code ) - 1 );
+    simNumCmds++;
+  }
+}
+
+/*********************************************************************
+ * Radio side
+ */
+static void sim_report( uint64_t t_us, uint8 endpoint, uint16 clusterId, uint16 attrId, uint32_t value )
+{
+  uint8_t port = (uint8_t)((endpoint - OPENEVSE_ENDPOINT) / 2);
+  int i, j;
+
+  simReports++;
+  if ( simFirstReport_us == 0 )
+  {
+    simFirstReport_us = t_us;
+  }
+  switch ( clusterId )
+  {
+    case ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC: simReportsByCluster[0]++; break;
+    case ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT:  simReportsByCluster[1]++; break;
+    case ZCL_CLUSTER_ID_SE_METERING:                simReportsByCluster[2]++; break;
+    default:                                        simReportsByCluster[3]++; break;
+  }
+  if ( simVerbose )
+  {
+    printf( "%10.3f report ep %u cluster 0x%04X attr 0x%04X = %u\n",
+            t_us / 1e6, endpoint, clusterId, attrId, value );
+  }
+
+  if ( clusterId == ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC && attrId == ATTRID_IOV_BASIC_PRESENT_VALUE )
+  {
+    for ( i = 0; i < simNumStates; i++ )
+    {
+      if ( simStates[i].port == port && (uint8_t)simStates[i].code[0] == (uint8_t)value )
+      {
+        bench_add( &simStateLatency, (t_us - simStates[i].t_us) / 1000.0 );
+        // Anything older from this charger was overtaken by this state without being reported
+        for ( j = 0; j <= i; )
+        {
+          if ( simStates[j].port != port )
+          {
+            j++;
+            continue;
+          }
+          if ( j < i )
+          {
+            simStatesMissed++;
+          }
+          sim_pending_drop( simStates, &simNumStates, (uint8_t)j );
+          i--;
+        }
+        break;
+      }
+    }
+  }
+}
+
+static void sim_write_rsp( uint64_t t_us, uint8 endpoint, uint16 clusterId, uint16 attrId, uint8 status )
+{
+  uint8_t port = (uint8_t)((endpoint - OPENEVSE_ENDPOINT) / 2);
+
+  if ( simVerbose )
+  {
+    printf( "%10.3f write rsp ep %u cluster 0x%04X attr 0x%04X status 0x%02X\n",
+            t_us / 1e6, endpoint, clusterId, attrId, status );
+  }
+  if ( port >= OPENEVSE_NUM_EVSE || simWrite_us[port] == 0 )
+  {
+    return;
+  }
+  if ( status == ZCL_STATUS_SUCCESS )
+  {
+    bench_add( &simWriteLatency, (t_us - simWrite_us[port]) / 1000.0 );
+  }
+  else
+  {
+    simWritesFailed++;
+  }
+  simWrite_us[port] = 0;
+}
+
+/*********************************************************************
+ * Script
+ */
+static void sim_parse_line( const char *line )
+{
+  simStep_t *s;
+  double t;
+  char action[16] = "", arg[16] = "", arg2[16] = "";
+
+  if ( line[0] == '#' || sscanf( line, "%lf %15s %15s %15s", &t, action, arg, arg2 ) < 2 )
+  {
+    if ( sscanf( line, "repeat %lf", &t ) == 1 )
+    {
+      simRepeat = t;
+    }
+    return;
+  }
+  if ( simNumSteps == SIM_MAX_STEPS )
+  {
+    return;
+  }
+  s = &simSteps[simNumSteps++];
+  s->t = t;
+  s->repeat = simRepeat > 0;
+  strcpy( s->action, action );
+  sprintf( s->arg, arg2[0] ? "%s %s" : "%s", arg, arg2 );
+}
+
+static void sim_limit_write( uint8_t n, const char *arg )
+{
+  uint32 limit = (uint32)strtoul( arg, NULL, 10 );
+
+  simWrite_us[n] = sim_now_us();
+  if ( sim_zcl_write( OPENEVSE_EVSE_ENDPOINT( n ), ZCL_CLUSTER_ID_SE_METERING,
+                      ATTRID_CURRENT_DEMAND_LIMIT, &limit ) == ZCL_STATUS_SUCCESS )
+  {
+    sim_expect( n, "SH" );
+  }
+}
+
+// The report the Write Response is to collide with has gone
+static void sim_collide_write( void *arg, uint32_t argInt )
+{
+  const simStep_t *s = arg;
+
+  simCollisions++;
+  sim_limit_write( (uint8_t)argInt, s->arg );
+}
+
+// Apply one script action to charger n
+static void sim_step_evse( const simStep_t *s, uint8_t n )
+{
+  evse_t *e = &simEvse[n];
+  uint8 endpoint = OPENEVSE_EVSE_ENDPOINT( n );
+
+  if ( !strcmp( s->action, "plug" ) )
+  {
+    evse_plug( e, 1 );
+  }
+  else if ( !strcmp( s->action, "unplug" ) )
+  {
+    evse_plug( e, 0 );
+  }
+  else if ( !strcmp( s->action, "charge" ) )
+  {
+    evse_charge( e, (uint8_t)atoi( s->arg ) );
+  }
+  else if ( !strcmp( s->action, "state" ) )
+  {
+    evse_set_state( e, (uint8_t)strtoul( s->arg, NULL, 16 ) );
+  }
+  else if ( !strcmp( s->action, "temp" ) )
+  {
+    evse_set_temp( e, (int16_t)(atof( s->arg ) * 10) );
+  }
+  else if ( !strcmp( s->action, "zcl" ) )
+  {
+    uint8 cmd = !strcmp( s->arg, "on" ) ? COMMAND_ON : !strcmp( s->arg, "off" ) ? COMMAND_OFF : COMMAND_TOGGLE;
+    uint8 on;
+
+    sim_zcl_onoff( endpoint, cmd );
+    sim_zcl_read( endpoint, ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, &on, 1 );
+    sim_expect( n, on ? "FE" : "FS" );
+  }
+  else if ( !strcmp( s->action, "backlight" ) )
+  {
+    sim_zcl_onoff( endpoint + 1, !strcmp( s->arg, "on" ) ? COMMAND_ON : COMMAND_OFF );
+    sim_expect( n, !strcmp( s->arg, "on" ) ? "S0" : "FB" );
+  }
+  else if ( !strcmp( s->action, "identify" ) )
+  {
+    sim_zcl_identify( endpoint, (uint16)atoi( s->arg ) );
+  }
+  else if ( !strcmp( s->action, "effect" ) )
+  {
+    sim_zcl_trigger_effect( endpoint, (uint8)strtoul( s->arg, NULL, 0 ), 0 );
+  }
+  else if ( !strcmp( s->action, "level" ) )
+  {
+    const char *comma = strchr( s->arg, ',' );
+    uint16 transitionTime = comma ? (uint16)atoi( comma + 1 ) : 0;
+
+    sim_zcl_level( endpoint, (uint8)atoi( s->arg ), transitionTime );
+    simRampDue_us[n] = 0;
+    if ( transitionTime == 0 )
+    {
+      sim_expect( n, "SC" );
+    }
+    else
+    {
+      simRampDue_us[n] = sim_now_us() + (uint64_t)transitionTime * 100000;
+      simRampAmps[n] = (uint8_t)atoi( s->arg );
+    }
+  }
+  else if ( !strcmp( s->action, "group" ) )
+  {
+    const char *arg = s->arg;
+    const char *comma = strchr( arg, ',' );
+
+    // A restore waits a random time, so there is no latency to expect
+    if ( !strncmp( arg, "bcast ", 6 ) )
+    {
+      sim_zcl_broadcast = TRUE;
+      arg += 6;
+    }
+    else
+    {
+      sim_zcl_group = 1;
+    }
+    if ( !strcmp( arg, "on" ) || !strcmp( arg, "off" ) )
+    {
+      sim_zcl_onoff( endpoint, !strcmp( arg, "on" ) ? COMMAND_ON : COMMAND_OFF );
+    }
+    else
+    {
+      sim_zcl_level( endpoint, (uint8)atoi( arg ), comma ? (uint16)atoi( comma + 1 ) : 0 );
+    }
+    sim_zcl_group = 0;
+    sim_zcl_broadcast = FALSE;
+  }
+  else if ( !strcmp( s->action, "limit" ) )
+  {
+    sim_limit_write( n, s->arg );
+  }
+  else if ( !strcmp( s->action, "collide" ) )
+  {
+    // The next acknowledged report may be either charger's
+    if ( n == 0 )
+    {
+      sim_af_collide( SIM_COLLIDE_CONFIRM_US, sim_collide_write, (void *)s, n );
+    }
+    else
+    {
+      sim_limit_write( n, s->arg );
+    }
+  }
+  else if ( n == 0 )
+  {
+    fprintf( stderr, "sim: unknown action '%s'\n", s->action );
+  }
+}
+
+static void sim_step( void *arg, uint32_t argInt )
+{
+  simStep_t *s = arg;
+  uint8_t n;
+
+  (void)argInt;
+  if ( simVerbose )
+  {
+    printf( "%10.3f script %s %s\n", sim_now_us() / 1e6, s->action, s->arg );
+  }
+  if ( !strcmp( s->action, "join" ) )
+  {
+    sim_set_nwk_state( DEV_ROUTER );
+  }
+  else if ( !strcmp( s->action, "leave" ) )
+  {
+    sim_set_nwk_state( DEV_NWK_ORPHAN );
+  }
+  else
+  {
+    for ( n = 0; n < OPENEVSE_NUM_EVSE; n++ )
+    {
+      sim_step_evse( s, n );
+    }
+  }
+}
+
+static void sim_schedule_script( uint64_t end_us )
+{
+  uint16_t i;
+  double base;
+
+  for ( i = 0; i < simNumSteps; i++ )
+  {
+    if ( !simSteps[i].repeat )
+    {
+      sim_schedule( (uint64_t)(simSteps[i].t * 1e6), sim_step, &simSteps[i], 0 );
+    }
+  }
+  if ( simRepeat <= 0 )
+  {
+    return;
+  }
+  for ( base = simRepeatStart; base * 1e6 < end_us; base += simRepeat )
+  {
+    for ( i = 0; i < simNumSteps; i++ )
+    {
+      if ( simSteps[i].repeat && (base + simSteps[i].t) * 1e6 < end_us )
+      {
+        sim_schedule( (uint64_t)((base + simSteps[i].t) * 1e6), sim_step, &simSteps[i], 0 );
+      }
+    }
+  }
+}
+
+// A link health attribute, read over ZCL the way a coordinator would
+static uint32_t sim_link_attr( uint8 endpoint, uint16 attrId )
+{
+  uint32_t value = 0;
+
+  sim_zcl_read( endpoint, ZCL_CLUSTER_ID_OPENEVSE_STATS, attrId, &value, sizeof( value ) );
+  return value;
+}
+
+#if OPENEVSE_TRACE_ENTRIES
+static FILE *simTraceFile = NULL;
+
+// Read the trace chunk at the cursor, then move the cursor past it
+static void sim_trace_collect( void *arg, uint32_t argInt )
+{
+  uint8 ep = OPENEVSE_EVSE_ENDPOINT( 0 );
+  uint8 chunk[1 + 2 + 10 * OPENEVSE_TRACE_CHUNK];
+  uint16 next;
+  uint8 count;
+  uint8 i;
+
+  (void)arg;
+  (void)argInt;
+  sim_zcl_read( ep, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_TRACE_CHUNK, chunk, sizeof( chunk ) );
+  count = (chunk[0] - 2) / 10;
+  if ( count )
+  {
+    for ( i = 0; i <= chunk[0]; i++ )
+    {
+      fprintf( simTraceFile, "%02x", chunk[i] );
+    }
+    fprintf( simTraceFile, "\n" );
+    next = BUILD_UINT16( chunk[1], chunk[2] ) + count;
+    sim_zcl_write( ep, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_TRACE_CURSOR, &next );
+  }
+  // A full chunk means there is probably more waiting
+  sim_schedule( sim_now_us() + (count == OPENEVSE_TRACE_CHUNK ? 50000 : 2000000), sim_trace_collect, NULL, 0 );
+}
+#endif
+
+#if defined OPENEVSE_PROFILE
+// Event loop profile, read over ZCL from the first charger endpoint
+static void sim_print_profile( void )
+{
+  uint8 ep = OPENEVSE_EVSE_ENDPOINT( 0 );
+  uint8 buf[1 + 2 * (1 + OPENEVSE_PROFILE_BUCKETS)];
+  uint8 queueMax = 0;
+  uint16 heapHigh = 0;
+  uint8 bit, b;
+
+  printf( "Event loop (sleep timer ticks of 30.5 us, on the host CPU)\n" );
+  printf( "  %-6s %8s %7s %7s %7s %7s %7s %7s %7s %7s\n", "event", "calls",
+          "<2", "2-3", "4-7", "8-15", "16-31", "32-63", "64-127", "128+" );
+  for ( bit = 0; bit < 16; bit++ )
+  {
+    sim_zcl_read( ep, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_PROFILE_EVENT + bit, buf, sizeof( buf ) );
+    if ( buf[1] == 0 && buf[2] == 0 )
+    {
+      continue;
+    }
+    printf( "  0x%04X %8u", 1 << bit, BUILD_UINT16( buf[1], buf[2] ) );
+    for ( b = 0; b < OPENEVSE_PROFILE_BUCKETS; b++ )
+    {
+      printf( " %7u", BUILD_UINT16( buf[3 + 2 * b], buf[4 + 2 * b] ) );
+    }
+    printf( "\n" );
+  }
+  sim_zcl_read( ep, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_PROFILE_QUEUE_MAX, &queueMax, 1 );
+  sim_zcl_read( ep, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_PROFILE_HEAP_HIGH, &heapHigh, 2 );
+  printf( "  message queue max %u, heap high-water %u bytes\n", queueMax, heapHigh );
+}
+#endif
+
+/*********************************************************************
+ * Main
+ */
+int main( int argc, char **argv )
+{
+  double hours = 24;
+  const char *script = NULL;
+  const char *trace = NULL;
+  evseCfg_t cfg = evse_default_cfg;
+  uint64_t end_us;
+  double secs, util;
+  uint32_t cmds = 0;
+  uint8 ep;
+  int opt, i;
+  int status = 0;
+
+  cfg.bootMs = 3000;
+  while ( (opt = getopt( argc, argv, "H:s:d:b:t:v" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'H': hours = atof( optarg ); break;
+      case 's': script = optarg; break;
+      case 'd': cfg.respDelayMs = (uint32_t)atoi( optarg ); break;
+      case 'b': cfg.bootMs = (uint32_t)atoi( optarg ); break;
+      case 't': trace = optarg; break;
+      case 'v': simVerbose = 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-H hours] [-s script] [-d reply_ms] [-b boot_ms] [-t trace_file] [-v]\n",
+                 argv[0] );
+        return 2;
+    }
+  }
+
+  if ( script )
+  {
+    char line[128];
+    FILE *f = fopen( script, "r" );
+
+    if ( f == NULL )
+    {
+      perror( script );
+      return 1;
+    }
+    while ( fgets( line, sizeof( line ), f ) )
+    {
+      sim_parse_line( line );
+    }
+    fclose( f );
+  }
+  else
+  {
+    for ( i = 0; simDefaultScript[i]; i++ )
+    {
+      sim_parse_line( simDefaultScript[i] );
+    }
+  }
+
+  end_us = (uint64_t)(hours * 3600e6);
+  for ( i = 0; i < OPENEVSE_NUM_EVSE; i++ )
+  {
+    evse_init( &simEvse[i], &cfg, sim_evse_send, sim_now_us );
+    simEvse[i].onReply = sim_evse_reply;
+  }
+  sim_uart_sink = sim_uart_to_evse;
+  sim_report_hook = sim_report;
+  sim_write_rsp_hook = sim_write_rsp;
+
+  sim_osal_init();
+  sim_schedule_script( end_us );
+  if ( trace )
+  {
+#if OPENEVSE_TRACE_ENTRIES
+    simTraceFile = fopen( trace, "w" );
+    if ( simTraceFile == NULL )
+    {
+      perror( trace );
+      return 1;
+    }
+    sim_schedule( 2000000, sim_trace_collect, NULL, 0 );
+#else
+    fprintf( stderr, "sim: built without the trace\n" );
+    return 2;
+#endif
+  }
+  sim_run_until( end_us );
+
+  secs = end_us / 1e6;
+
+  printf( "OpenEVSE host simulation: %.1f h, %u charger%s, EVSE reply delay %u ms, boot %u ms\n",
+          hours, OPENEVSE_NUM_EVSE, OPENEVSE_NUM_EVSE > 1 ? "s" : "", cfg.respDelayMs, cfg.bootMs );
+  printf( "Latency\n" );
+  bench_print( &simStateLatency );
+  bench_print( &simCmdLatency );
+  bench_print( &simWriteLatency );
+  bench_print( &simRampEnd );
+  if ( simRampsLate )
+  {
+    fprintf( stderr, "%s: %u ramps ended over %u ms from their transition time\n", argv[0], simRampsLate,
+             SIM_RAMP_SLACK_MS );
+    status = 1;
+  }
+  if ( simWritesFailed )
+  {
+    printf( "  %llu limit writes failed\n", (unsigned long long)simWritesFailed );
+  }
+  printf( "UART\n" );
+  for ( i = 0; i < OPENEVSE_NUM_EVSE; i++ )
+  {
+    util = (sim_uart_tx_bytes[i] + sim_uart_rx_bytes[i]) * 10.0 / (115200.0 * secs);
+    if ( OPENEVSE_NUM_EVSE > 1 )
+    {
+      printf( " port %d\n", i );
+    }
+    printf( "  module -> EVSE %10llu bytes   EVSE -> module %10llu bytes   utilization %.2f%%\n",
+            (unsigned long long)sim_uart_tx_bytes[i], (unsigned long long)sim_uart_rx_bytes[i], util * 100 );
+    printf( "  RAPI commands  %10u   bad checksum %u   unknown %u   RX overflow %llu bytes   $FB %u   "
+            "$SC saved %u\n", simEvse[i].cmds, simEvse[i].badChecksum, simEvse[i].unknown,
+            (unsigned long long)sim_uart_rx_overflow[i], simLcdCmds[i], simEvse[i].saves );
+    ep = OPENEVSE_EVSE_ENDPOINT( i );
+    printf( "  link stats     sent %u ok %u nk %u checksum %u resends %u abandoned %u rx overflow %u "
+            "rtt %u/%u/%u ms\n",
+            sim_link_attr( ep, ATTRID_OPENEVSE_LINK_SENT ), sim_link_attr( ep, ATTRID_OPENEVSE_LINK_OK ),
+            sim_link_attr( ep, ATTRID_OPENEVSE_LINK_NK ), sim_link_attr( ep, ATTRID_OPENEVSE_LINK_CHECKSUM ),
+            sim_link_attr( ep, ATTRID_OPENEVSE_LINK_RESENDS ), sim_link_attr( ep, ATTRID_OPENEVSE_LINK_ABANDONED ),
+            sim_link_attr( ep, ATTRID_OPENEVSE_LINK_RX_OVERFLOW ), sim_link_attr( ep, ATTRID_OPENEVSE_LINK_RTT_MIN ),
+            sim_link_attr( ep, ATTRID_OPENEVSE_LINK_RTT_AVG ), sim_link_attr( ep, ATTRID_OPENEVSE_LINK_RTT_MAX ) );
+    cmds += simEvse[i].cmds;
+  }
+  bench_print( &simPowerPoll );
+  if ( OPENEVSE_NUM_EVSE > 1 )
+  {
+    printf( "  RAPI commands over both ports %u, %.1f per second\n", cmds, cmds / secs );
+  }
+  printf( "Reports\n" );
+  printf( "  total %llu, %.1f per hour (state %.1f, power %.1f, energy %.1f, other %.1f)\n",
+          (unsigned long long)simReports, simReports / (secs / 3600),
+          simReportsByCluster[0] / (secs / 3600), simReportsByCluster[1] / (secs / 3600),
+          simReportsByCluster[2] / (secs / 3600), simReportsByCluster[3] / (secs / 3600) );
+  printf( "  first report %.3f s after power-up, state changes not reported %llu\n",
+          simFirstReport_us / 1e6, (unsigned long long)(simStatesMissed + simNumStates) );
+  printf( "  reports, alerts and events finding no binding %u\n", sim_unbound );
+  if ( sim_unbound )
+  {
+    fprintf( stderr, "%s: frames went out where the hub has no binding\n", argv[0] );
+    status = 1;
+  }
+  if ( simCollisions )
+  {
+    uint32_t failed = 0;
+    uint8_t c;
+
+    for ( i = 0; i < OPENEVSE_NUM_EVSE; i++ )
+    {
+      for ( c = 0; c < OPENEVSE_REPORT_CLASSES; c++ )
+      {
+        failed += sim_link_attr( OPENEVSE_EVSE_ENDPOINT( i ), ATTRID_OPENEVSE_DELIVERY_FAILED + (c << 4) );
+      }
+    }
+    printf( "  reports failing under a Write Response %u, failed reports %u, counted %u\n", simCollisions,
+            sim_report_fails, failed );
+    if ( failed < sim_report_fails )
+    {
+      fprintf( stderr, "%s: a Write Response's confirm was taken for a failed report\n", argv[0] );
+      status = 1;
+    }
+  }
+  printf( "  heap high-water %u bytes\n", sim_heap_high_water() );
+#if OPENEVSE_TRACE_ENTRIES
+  if ( simTraceFile )
+  {
+    fclose( simTraceFile );
+  }
+#endif
+#if defined OPENEVSE_PROFILE
+  sim_print_profile();
+#endif
+  return status;
+}
@@ -0,0 +1,29 @@
+/*
+ * sim_pty.h - HAL UART over a real file descriptor (hal_uart_pty.c).
+ */
+#ifndef SIM_PTY_H
+#define SIM_PTY_H
+
+#include <stdint.h>
+
+typedef struct
+{
+  uint64_t txBytes;
+  uint64_t txFrames;     // "$..." writes, first sends and resends
+  uint64_t txFlush;      // lone "\r" written ahead of a resend
+  uint64_t rxBytes;
+  uint64_t rxFrames;
+  uint64_t rxBadFrames;  // checksum missing or wrong
+  uint64_t rxOk;
+  uint64_t rxNk;
+  uint64_t rxAsync;      // $ST
+} simPtyStats_t;
+
+extern simPtyStats_t sim_pty_stats;
+
+extern void sim_pty_attach( int fd );
+// Wait up to timeoutMs for input, move it into the RX ring and run the
+// UART callback. Returns bytes read, or -1 once the other side is gone.
+extern int sim_pty_poll( int timeoutMs );
+
+#endif /* SIM_PTY_H */
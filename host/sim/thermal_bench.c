@@ -0,0 +1,270 @@
+/*
+ * thermal_bench.c - thermal throttling on the module against the hub.
+ *
+ * Usage: thermal_bench [-H hours] [-a ambient_C] [-t tau_s] [-s seed]
+ *
+ * The car asks for 32 A throughout. The hottest point of the EVSE, the
+ * TMP007 over the relay, heats by 40 C at 32 A over ambient, going as the
+ * square of the current, with a first order lag of tau (900 s by default).
+ * Ambient starts at 25 C and climbs to the given peak (45 C by default)
+ * between the first half hour and an hour and a half. Runs:
+ *
+ *   none      no throttling
+ *   hub       the hub applies the module's default thresholds to the
+ *             temperature reports, every 2 minutes, and sends Move to Level
+ *   module    the module's own loop, on every $GP
+ *
+ * Hub frames take 1 to 3 hops of 5 to 25 ms and are lost 5% of the time,
+ * with up to 4 APS attempts 1.5 s apart. For each run it reports the
+ * hottest reading, the minutes over 70 C (two steps into throttling), the
+ * time from first reaching 60 C to the first lower $SC, the $SC sent, those
+ * the EVSE saved to its EEPROM, and the energy delivered.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define THERMAL_TICK_US 1000000
+#define THERMAL_RISE_C 40.0         // over ambient at 32 A
+#define THERMAL_AMBIENT_C 25.0
+#define THERMAL_CLIMB_US 1800000000ULL  // ambient climbs from here
+#define THERMAL_CLIMB_LEN_US 3600000000ULL
+#define THERMAL_START_C 60.0        // module defaults, which the hub uses too
+#define THERMAL_BAND_C 5.0
+#define THERMAL_HYSTERESIS_C 3.0
+#define THERMAL_STEP_AMPS 6
+#define THERMAL_OVER_C 70.0
+#define THERMAL_CAR_AMPS 32
+#define THERMAL_APS_ATTEMPTS 4
+#define THERMAL_APS_WAIT_US 1500000
+#define THERMAL_LOSS_PCT 5.0
+
+enum { THERMAL_NONE, THERMAL_HUB, THERMAL_MODULE, THERMAL_RUNS };
+
+static const char *thermalRunNames[THERMAL_RUNS] = { "none", "hub", "module" };
+
+typedef struct
+{
+  double peak;
+  double overSecs;
+  double reaction;    // -1 when nothing came down
+  uint32_t setCurrent;
+  uint32_t saves;     // $SC without V
+  double kWh;
+} thermalResult_t;
+
+static evse_t thermalEvse;
+static thermalResult_t thermalResult;
+static double thermalTemp;          // hottest point, C
+static double thermalPeakAmbient = 45.0;
+static double thermalTau = 900.0;
+static double thermalHours = 4;
+static uint64_t thermalCrossed_us;  // first reading at THERMAL_START_C, 0 before
+static uint8_t thermalHubStep;
+static uint32_t thermalSeed = 1;
+
+static void thermal_evse_reply( evse_t *e, const char *cmd, const char *reply, uint32_t delayMs )
+{
+  (void)reply;
+  (void)delayMs;
+  if ( strcmp( cmd, "SC" ) )
+  {
+    return;
+  }
+  thermalResult.setCurrent++;
+  if ( thermalResult.reaction < 0 && thermalCrossed_us != 0 && e->cfg.pilotAmps < THERMAL_CAR_AMPS )
+  {
+    thermalResult.reaction = (sim_now_us() - thermalCrossed_us) / 1e6;
+  }
+}
+
+static double thermal_ambient( uint64_t t_us )
+{
+  if ( t_us < THERMAL_CLIMB_US )
+  {
+    return THERMAL_AMBIENT_C;
+  }
+  if ( t_us >= THERMAL_CLIMB_US + THERMAL_CLIMB_LEN_US )
+  {
+    return thermalPeakAmbient;
+  }
+  return THERMAL_AMBIENT_C + (thermalPeakAmbient - THERMAL_AMBIENT_C) *
+         (double)(t_us - THERMAL_CLIMB_US) / THERMAL_CLIMB_LEN_US;
+}
+
+// The EVSE heats with the current it passes; the GP reply puts the
+// hottest sensor half a degree over the reading given here
+static void thermal_tick( void *arg, uint32_t argInt )
+{
+  double amps = evse_amps_ma( &thermalEvse ) / 1000.0;
+  double target = thermal_ambient( sim_now_us() ) +
+                  THERMAL_RISE_C * (amps / THERMAL_CAR_AMPS) * (amps / THERMAL_CAR_AMPS);
+
+  (void)arg;
+  (void)argInt;
+  thermalTemp += (target - thermalTemp) * (THERMAL_TICK_US / 1e6) / thermalTau;
+  evse_set_temp( &thermalEvse, (int16_t)(thermalTemp * 10 - 5) );
+  if ( thermalTemp > thermalResult.peak )
+  {
+    thermalResult.peak = thermalTemp;
+  }
+  if ( thermalTemp > THERMAL_OVER_C )
+  {
+    thermalResult.overSecs += THERMAL_TICK_US / 1e6;
+  }
+  if ( thermalCrossed_us == 0 && thermalTemp >= THERMAL_START_C )
+  {
+    thermalCrossed_us = sim_now_us();
+  }
+  sim_schedule( sim_now_us() + THERMAL_TICK_US, thermal_tick, NULL, 0 );
+}
+
+static void thermal_level( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  sim_zcl_level( OPENEVSE_ENDPOINT, (uint8)argInt, 0 );
+}
+
+// Move to Level from the hub, with APS retries until one gets through
+static void thermal_hub_send( uint8_t amps )
+{
+  uint64_t at_us = sim_now_us();
+  uint8_t attempt;
+  uint8_t hops;
+
+  for ( attempt = 0; attempt < THERMAL_APS_ATTEMPTS; attempt++ )
+  {
+    if ( bench_rand( &thermalSeed ) * 100 >= THERMAL_LOSS_PCT )
+    {
+      for ( hops = 1 + (uint8_t)(bench_rand( &thermalSeed ) * 3); hops; hops-- )
+      {
+        at_us += 5000 + (uint64_t)(bench_rand( &thermalSeed ) * 20000);
+      }
+      sim_schedule( at_us, thermal_level, NULL, amps );
+      return;
+    }
+    at_us += THERMAL_APS_WAIT_US;
+  }
+}
+
+// The hub's loop runs on the temperature reports, in whole degrees
+static void thermal_hub_report( uint64_t t_us, uint8 endpoint, uint16 clusterId,
+                                uint16 attrId, uint32_t value )
+{
+  double over = (int16_t)value - THERMAL_START_C;
+  uint8_t step = thermalHubStep;
+  int amps;
+
+  (void)t_us;
+  (void)endpoint;
+  if ( clusterId != ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG || attrId != ATTRID_DEV_TEMP_CURRENT )
+  {
+    return;
+  }
+  if ( over >= 0 && (uint8_t)(over / THERMAL_BAND_C) >= step )
+  {
+    step = (uint8_t)(over / THERMAL_BAND_C) + 1;
+  }
+  else if ( step > 0 && over + THERMAL_HYSTERESIS_C < (step - 1) * THERMAL_BAND_C )
+  {
+    step--;
+  }
+  if ( step == thermalHubStep )
+  {
+    return;
+  }
+  thermalHubStep = step;
+  amps = THERMAL_CAR_AMPS - step * THERMAL_STEP_AMPS;
+  thermal_hub_send( (uint8_t)(amps < 6 ? 6 : amps) );
+}
+
+// One run, by bench_run_child
+static void thermal_run( void *arg, void *result )
+{
+  uint8_t run = *(const uint8_t *)arg;
+  evseCfg_t cfg = evse_default_cfg;
+  uint8 off = 0;
+
+  thermalResult.reaction = -1;
+  thermalTemp = THERMAL_AMBIENT_C;
+  evse_init( &thermalEvse, &cfg, sim_uart_evse_send, sim_now_us );
+  thermalEvse.onReply = thermal_evse_reply;
+  bench_evse = &thermalEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  if ( run == THERMAL_HUB )
+  {
+    sim_report_hook = thermal_hub_report;
+  }
+  sim_osal_init();
+  sim_set_nwk_state( DEV_ROUTER );
+  if ( run != THERMAL_MODULE )
+  {
+    sim_zcl_write( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_THERMAL_AMPS, &off );
+  }
+  evse_plug( &thermalEvse, 1 );
+  evse_charge( &thermalEvse, THERMAL_CAR_AMPS );
+  sim_schedule( THERMAL_TICK_US, thermal_tick, NULL, 0 );
+  sim_run_until( (uint64_t)(thermalHours * 3600e6) );
+
+  evse_charge( &thermalEvse, THERMAL_CAR_AMPS ); // Brings the energy up to date
+  thermalResult.kWh = thermalEvse.wattHours / 1000.0;
+  thermalResult.saves = thermalEvse.saves;
+  *(thermalResult_t *)result = thermalResult;
+}
+
+int main( int argc, char **argv )
+{
+  uint8_t run;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "H:a:t:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'H': thermalHours = atof( optarg ); break;
+      case 'a': thermalPeakAmbient = atof( optarg ); break;
+      case 't': thermalTau = atof( optarg ); break;
+      case 's': thermalSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-H hours] [-a ambient_C] [-t tau_s] [-s seed]\n", argv[0] );
+        return 2;
+    }
+  }
+  if ( thermalHours <= 0 || thermalTau < 1 )
+  {
+    fprintf( stderr, "%s: hours and tau must be positive\n", argv[0] );
+    return 2;
+  }
+
+  printf( "Thermal throttling over %.1f hours, ambient 25 to %.0f C, tau %.0f s, car at %d A\n",
+          thermalHours, thermalPeakAmbient, thermalTau, THERMAL_CAR_AMPS );
+  printf( "%-8s %8s %10s %11s %5s %6s %7s\n", "run", "peak C", "min >70 C", "reaction s", "$SC", "saved", "kWh" );
+  for ( run = 0; run < THERMAL_RUNS; run++ )
+  {
+    thermalResult_t r;
+
+    if ( bench_run_child( thermal_run, &run, &r, sizeof( r ) ) < 0 )
+    {
+      fprintf( stderr, "%s: run failed\n", thermalRunNames[run] );
+      return 1;
+    }
+
+    if ( r.reaction < 0 )
+    {
+      printf( "%-8s %8.1f %10.1f %11s %5u %6u %7.2f\n", thermalRunNames[run], r.peak, r.overSecs / 60,
+              "-", r.setCurrent, r.saves, r.kWh );
+    }
+    else
+    {
+      printf( "%-8s %8.1f %10.1f %11.1f %5u %6u %7.2f\n", thermalRunNames[run], r.peak, r.overSecs / 60,
+              r.reaction, r.setCurrent, r.saves, r.kWh );
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * tou_bench.c - charging schedule edges, on the module and from the hub.
+ *
+ * Usage: tou_bench [-D days] [-N chargers] [-p ppm] [-s seed]
+ *
+ * A week of a two window schedule: weeknights 23:00 to 07:00 at the EVSE's
+ * own current, weekends 10:00 to 15:00 at 16 A. The module's UTC clock
+ * runs fast by the given error (40 ppm by default, a 32 kHz crystal at the
+ * edge of its tolerance); the DS3231 is taken as true time. Runs:
+ *
+ *   zcl            schedule on the module, hub writes Time once a day
+ *   zcl, hub gone  the same, the hub is gone after the first hour
+ *   zcl+rtc, gone  as above with an RTC in the EVSE to hold the clock
+ *   rtc            no hub at all, time from the RTC
+ *   hub on/off     no schedule on the module; the hub sends On/Off at each
+ *                  edge, to the whole site, with an outage of 18 hours
+ *
+ * Hub frames take 1 to 3 hops of 5 to 25 ms and are lost 5% of the time,
+ * with up to 4 APS attempts 1.5 s apart; at an edge the hub sends to the
+ * chargers of the site one after another, 60 ms apart. For each run it
+ * reports the edges the EVSE saw ($FE or $FS), how many came within a
+ * second, the ones missed, the lag from the boundary (negative is early)
+ * and the hub's frames per week for a site of N chargers.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "bench.h"
+#include "evse_model.h"
+#include "zcl_openevse.h"
+
+#define TOU_START_LOCAL 845640000UL  // Sunday 2026-10-18 12:00, seconds since 2000
+#define TOU_DAY_US 86400000000ULL
+#define TOU_HUB_SPACING_US 60000     // between chargers when the hub sends to a site
+#define TOU_APS_ATTEMPTS 4
+#define TOU_APS_WAIT_US 1500000
+#define TOU_LOSS_PCT 5.0
+#define TOU_OUTAGE_US (TOU_DAY_US * 5 / 2)
+#define TOU_OUTAGE_LEN_US (18 * 3600000000ULL)
+#define TOU_MAX_EDGES 64
+#define TOU_MAX_CMDS 256
+
+enum { TOU_ZCL, TOU_ZCL_GONE, TOU_RTC_GONE, TOU_RTC, TOU_HUB, TOU_RUNS };
+
+static const char *touRunNames[TOU_RUNS] =
+  { "zcl", "zcl, hub gone", "zcl+rtc, gone", "rtc", "hub on/off" };
+
+// The schedule, as written to attribute 0x0500: days, start, stop, amps
+static const uint8 touSchedule[] =
+{
+  12,
+  0x3E, LO_UINT16( 1380 ), HI_UINT16( 1380 ), LO_UINT16( 420 ), HI_UINT16( 420 ), 0,
+  0x41, LO_UINT16( 600 ), HI_UINT16( 600 ), LO_UINT16( 900 ), HI_UINT16( 900 ), 16,
+};
+
+typedef struct
+{
+  uint64_t t_us;
+  uint8_t on;
+} touEdge_t;
+
+typedef struct
+{
+  uint32_t edges;
+  uint32_t onTime;    // within a second of the boundary
+  uint32_t missed;
+  uint32_t setCurrent;
+  double lagSum;
+  double lagMin;
+  double lagMax;
+  uint32_t hubFrames; // for one charger
+} touResult_t;
+
+static evse_t touEvse;
+typedef struct
+{
+  uint8_t run;
+  uint32_t days;
+  double ppm;
+} touRun_t;
+
+static touResult_t touResult;
+static touEdge_t touCmds[TOU_MAX_CMDS];
+static uint32_t touNumCmds;
+static uint32_t touChargers = 20;
+static uint32_t touSeed = 1;
+
+static void tou_evse_reply( evse_t *e, const char *cmd, const char *reply, uint32_t delayMs )
+{
+  (void)e;
+  (void)reply;
+  (void)delayMs;
+  if ( !strcmp( cmd, "SC" ) )
+  {
+    touResult.setCurrent++;
+  }
+  if ( (!strcmp( cmd, "FE" ) || !strcmp( cmd, "FS" )) && touNumCmds < TOU_MAX_CMDS )
+  {
+    touCmds[touNumCmds].t_us = sim_now_us();
+    touCmds[touNumCmds].on = cmd[1] == 'E';
+    touNumCmds++;
+  }
+}
+
+// The schedule on its own terms, minute by minute
+static uint8_t tou_in_window( uint32_t local )
+{
+  uint32_t minute = (local % 86400) / 60;
+  uint8_t day = (local / 86400 + 6) % 7;
+  uint8_t yesterday = (day + 6) % 7;
+  const uint8 *w;
+
+  for ( w = &touSchedule[1]; w < &touSchedule[1 + touSchedule[0]]; w += 6 )
+  {
+    uint16_t start = BUILD_UINT16( w[1], w[2] );
+    uint16_t stop = BUILD_UINT16( w[3], w[4] );
+
+    if ( start < stop ? ((w[0] & (1 << day)) && minute >= start && minute < stop)
+                      : (((w[0] & (1 << day)) && minute >= start) ||
+                         ((w[0] & (1 << yesterday)) && minute < stop)) )
+    {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static uint32_t tou_edges( touEdge_t *edges, uint32_t days )
+{
+  uint32_t n = 0;
+  uint32_t m;
+  uint8_t in = tou_in_window( TOU_START_LOCAL );
+
+  for ( m = 1; m < days * 1440 && n < TOU_MAX_EDGES; m++ )
+  {
+    if ( tou_in_window( TOU_START_LOCAL + m * 60 ) != in )
+    {
+      in = !in;
+      edges[n].t_us = (uint64_t)m * 60000000;
+      edges[n].on = in;
+      n++;
+    }
+  }
+  return n;
+}
+
+// One trip over the mesh from the hub; 0 if the frame was lost
+static uint64_t tou_mesh_latency( void )
+{
+  uint8_t hops = 1 + (uint8_t)(bench_rand( &touSeed ) * 3);
+  uint64_t us = 0;
+
+  touResult.hubFrames++;
+  if ( bench_rand( &touSeed ) * 100 < TOU_LOSS_PCT )
+  {
+    return 0;
+  }
+  while ( hops-- )
+  {
+    us += 5000 + (uint64_t)(bench_rand( &touSeed ) * 20000);
+  }
+  return us;
+}
+
+static void tou_write_time( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  sim_zcl_write( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_GEN_TIME, ATTRID_TIME_TIME, &argInt );
+}
+
+static void tou_write_schedule( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  (void)argInt;
+  sim_zcl_write( OPENEVSE_ENDPOINT, ZCL_CLUSTER_ID_OPENEVSE_STATS, ATTRID_OPENEVSE_TOU_SCHEDULE, touSchedule );
+}
+
+static void tou_onoff( void *arg, uint32_t argInt )
+{
+  (void)arg;
+  sim_zcl_onoff( OPENEVSE_ENDPOINT, (uint8)argInt );
+}
+
+// A hub frame stamped and sent now, with APS retries until one gets through
+static void tou_hub_send( simFn_t fn, uint64_t at_us, uint32_t argInt, uint8_t isTime )
+{
+  uint64_t latency = 0;
+  uint8_t attempt;
+
+  for ( attempt = 0; attempt < TOU_APS_ATTEMPTS && latency == 0; attempt++ )
+  {
+    latency = tou_mesh_latency();
+    if ( latency == 0 )
+    {
+      at_us += TOU_APS_WAIT_US;
+    }
+  }
+  if ( latency == 0 )
+  {
+    return;
+  }
+  if ( isTime )
+  {
+    argInt = TOU_START_LOCAL + (uint32_t)(at_us / 1000000);
+  }
+  sim_schedule( at_us + latency, fn, NULL, argInt );
+}
+
+static void tou_match( const touEdge_t *edges, uint32_t numEdges, uint32_t days )
+{
+  uint32_t e, c;
+
+  for ( e = 0; e < numEdges; e++ )
+  {
+    uint64_t from = edges[e].t_us - 60000000;
+    uint64_t to = e + 1 < numEdges ? edges[e + 1].t_us : (uint64_t)days * TOU_DAY_US;
+    double lag;
+
+    touResult.edges++;
+    for ( c = 0; c < touNumCmds; c++ )
+    {
+      if ( touCmds[c].on == edges[e].on && touCmds[c].t_us >= from && touCmds[c].t_us < to )
+      {
+        break;
+      }
+    }
+    if ( c == touNumCmds )
+    {
+      touResult.missed++;
+      continue;
+    }
+    lag = ((double)touCmds[c].t_us - (double)edges[e].t_us) / 1e6;
+    if ( lag >= -1.0 && lag <= 1.0 )
+    {
+      touResult.onTime++;
+    }
+    touResult.lagSum += lag;
+    if ( touResult.edges - touResult.missed == 1 || lag < touResult.lagMin )
+    {
+      touResult.lagMin = lag;
+    }
+    if ( touResult.edges - touResult.missed == 1 || lag > touResult.lagMax )
+    {
+      touResult.lagMax = lag;
+    }
+  }
+}
+
+// One run, by bench_run_child
+static void tou_run( void *arg, void *result )
+{
+  const touRun_t *r = arg;
+  uint8_t run = r->run;
+  uint32_t days = r->days;
+  evseCfg_t cfg = evse_default_cfg;
+  touEdge_t edges[TOU_MAX_EDGES];
+  uint32_t numEdges = tou_edges( edges, days );
+  uint32_t e, d;
+
+  sim_clock_ppm = r->ppm;
+  if ( run == TOU_RTC_GONE || run == TOU_RTC )
+  {
+    cfg.rtcLocal = TOU_START_LOCAL;
+  }
+  evse_init( &touEvse, &cfg, sim_uart_evse_send, sim_now_us );
+  touEvse.onReply = tou_evse_reply;
+  bench_evse = &touEvse;
+  sim_uart_sink = bench_uart_to_evse;
+  sim_osal_init();
+  sim_set_nwk_state( DEV_ROUTER );
+
+  if ( run == TOU_HUB )
+  {
+    for ( e = 0; e < numEdges; e++ )
+    {
+      uint64_t at = edges[e].t_us + (uint64_t)(bench_rand( &touSeed ) * touChargers) * TOU_HUB_SPACING_US;
+
+      if ( at < TOU_OUTAGE_US || at >= TOU_OUTAGE_US + TOU_OUTAGE_LEN_US )
+      {
+        tou_hub_send( tou_onoff, at, edges[e].on ? COMMAND_ON : COMMAND_OFF, FALSE );
+      }
+    }
+  }
+  else
+  {
+    tou_hub_send( tou_write_schedule, 10000000, 0, FALSE );
+    if ( run != TOU_RTC )
+    {
+      tou_hub_send( tou_write_time, 10000000, 0, TRUE );
+    }
+    for ( d = 1; run == TOU_ZCL && d < days; d++ )
+    {
+      tou_hub_send( tou_write_time, d * TOU_DAY_US, 0, TRUE );
+    }
+  }
+  sim_run_until( (uint64_t)days * TOU_DAY_US );
+
+  tou_match( edges, numEdges, days );
+  *(touResult_t *)result = touResult;
+}
+
+int main( int argc, char **argv )
+{
+  uint32_t days = 7;
+  double ppm = 40;
+  uint8_t run;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "D:N:p:s:" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'D': days = (uint32_t)atoi( optarg ); break;
+      case 'N': touChargers = (uint32_t)atoi( optarg ); break;
+      case 'p': ppm = atof( optarg ); break;
+      case 's': touSeed = (uint32_t)atoi( optarg ) | 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-D days] [-N chargers] [-p ppm] [-s seed]\n", argv[0] );
+        return 2;
+    }
+  }
+  if ( days < 1 || days > 14 || touChargers < 1 )
+  {
+    fprintf( stderr, "%s: 1 to 14 days and at least one charger\n", argv[0] );
+    return 2;
+  }
+
+  printf( "Charging schedule edges over %u days, module clock %+.0f ppm, site of %u chargers\n",
+          days, ppm, touChargers );
+  printf( "%-14s %6s %8s %7s %4s  %-24s %s\n", "run", "edges", "in 1 s", "missed", "$SC",
+          "lag mean/min/max s", "hub frames per week" );
+  for ( run = 0; run < TOU_RUNS; run++ )
+  {
+    touRun_t settings = { run, days, ppm };
+    touResult_t r;
+    uint32_t seen;
+
+    if ( bench_run_child( tou_run, &settings, &r, sizeof( r ) ) < 0 )
+    {
+      fprintf( stderr, "%s: run failed\n", touRunNames[run] );
+      return 1;
+    }
+
+    seen = r.edges - r.missed;
+    printf( "%-14s %6u %8u %7u %4u  %7.2f %7.2f %7.2f  %10.0f\n", touRunNames[run], r.edges, r.onTime,
+            r.missed, r.setCurrent, seen ? r.lagSum / seen : 0, r.lagMin, r.lagMax,
+            (double)r.hubFrames * touChargers * 7 / days );
+  }
+  return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * uart_bench.c - RAPI throughput over a real tty.
+ *
+ * Usage: uart_bench [-n commands] [-v] <tty>
+ *
+ * Runs the application's own RAPI writer, UART callback, parser and resend
+ * path in real time against whatever answers on <tty>, normally rapi_emu.
+ * The OSAL clock follows the wall clock and the regular poll loop is kept
+ * stopped, so the only traffic is a fixed mix of commands sent back to back.
+ * Each one is timed from the write until the parser releases the command
+ * slot. Reports commands per second, retry rate and round-trip times.
+ *
+ * zcl_openevse.c is compiled into this file so its static writer and
+ * command slot can be driven directly.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "sim_pty.h"
+#include "bench.h"
+
+#include "zcl_openevse.c"
+
+#define BENCH_CMD_DEADLINE_US 30000000
+
+typedef struct
+{
+  uint8 cmd;
+  uint8 numArgs;
+  int32 arg;
+} benchCmd_t;
+
+// Roughly the mix the poll loop sends, plus the setters and $FS/$FE,
+// which are answered with an $OK and an asynchronous $ST
+static const benchCmd_t benchMix[] =
+{
+  { EVSE_CMD_GETPOWER, 0, 0 },
+  { EVSE_CMD_GETSTATE, 0, 0 },
+  { EVSE_CMD_GETPOWER, 0, 0 },
+  { EVSE_CMD_GETTEMP, 0, 0 },
+  { EVSE_CMD_GETPOWER, 0, 0 },
+  { EVSE_CMD_GETENERGY, 0, 0 },
+  { EVSE_CMD_GETSETTINGS, 0, 0 },
+  { EVSE_CMD_SETLIMIT, 1, 0 },
+  { EVSE_CMD_SETCURRENT, 1, 16 },
+  { EVSE_CMD_LCDTEAL, 0, 0 },
+  { EVSE_CMD_SLEEP, 0, 0 },
+  { EVSE_CMD_ENABLE, 0, 0 },
+};
+
+static uint64_t benchStart_us;
+static int benchVerbose = 0;
+
+static uint64_t bench_wall_us( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 - benchStart_us;
+}
+
+// Let OSAL catch up with the wall clock, then wait for input or the next timer
+static int bench_step( void )
+{
+  uint64_t now = bench_wall_us();
+  uint64_t next;
+  int waitMs = 10;
+  int n;
+
+  sim_run_until( now );
+  next = sim_next_us();
+  if ( next != UINT64_MAX && next < now + waitMs * 1000 )
+  {
+    waitMs = next > now ? (int)((next - now + 999) / 1000) : 0;
+  }
+  n = sim_pty_poll( waitMs );
+  sim_run_until( bench_wall_us() );
+  return n;
+}
+
+int main( int argc, char **argv )
+{
+  benchSeries_t rtt = { "command round trip" };
+  uint32_t count = 1000;
+  uint32_t sent = 0, ok = 0, lost = 0;
+  uint64_t end_us;
+  struct termios tio;
+  int fd;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "n:v" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'n': count = (uint32_t)atoi( optarg ); break;
+      case 'v': benchVerbose = 1; break;
+      default:
+        fprintf( stderr, "usage: %s [-n commands] [-v] <tty>\n", argv[0] );
+        return 2;
+    }
+  }
+  if ( optind >= argc )
+  {
+    fprintf( stderr, "usage: %s [-n commands] [-v] <tty>\n", argv[0] );
+    return 2;
+  }
+
+  fd = open( argv[optind], O_RDWR | O_NOCTTY | O_NONBLOCK );
+  if ( fd < 0 )
+  {
+    perror( argv[optind] );
+    return 1;
+  }
+  if ( tcgetattr( fd, &tio ) == 0 )
+  {
+    cfmakeraw( &tio );
+    cfsetspeed( &tio, B115200 );
+    tcsetattr( fd, TCSANOW, &tio );
+  }
+  sim_pty_attach( fd );
+
+  benchStart_us = 0;
+  benchStart_us = bench_wall_us();
+  sim_osal_init();
+  osal_stop_timerEx( zclOpenEvse_TaskID, OPENEVSE_POLL_EVSE_EVT );
+  zclOpenEvse_evse[0].ready = TRUE; // No readiness probe, so full reply timeouts and resends
+
+  while ( sent < count )
+  {
+    const benchCmd_t *c = &benchMix[sent % (sizeof( benchMix ) / sizeof( benchMix[0] ))];
+    uint64_t start = bench_wall_us();
+    uint64_t okBefore = sim_pty_stats.rxOk;
+
+    zclOpenEvse_EVSEWriteCmd( &zclOpenEvse_evse[0], c->cmd, c->numArgs, c->arg );
+    sent++;
+    while ( zclOpenEvse_evse[0].cmd != EVSE_CMD_NONE && bench_wall_us() - start < BENCH_CMD_DEADLINE_US )
+    {
+      if ( bench_step() < 0 )
+      {
+        fprintf( stderr, "%s: hung up\n", argv[optind] );
+        return 1;
+      }
+    }
+    // The parser only frees the slot without a good $OK when it gives up
+    if ( zclOpenEvse_evse[0].cmd == EVSE_CMD_NONE && sim_pty_stats.rxOk > okBefore )
+    {
+      ok++;
+      bench_add( &rtt, (bench_wall_us() - start) / 1000.0 );
+    }
+    else
+    {
+      lost++;
+      zclOpenEvse_evse[0].cmd = EVSE_CMD_NONE;
+    }
+    if ( benchVerbose )
+    {
+      printf( "%10.3f $%s %s %.1f ms\n", bench_wall_us() / 1e6, evseCode[c->cmd],
+              sim_pty_stats.rxOk > okBefore ? "ok" : "lost", (bench_wall_us() - start) / 1000.0 );
+    }
+  }
+  end_us = bench_wall_us();
+
+  printf( "RAPI over %s: %u commands in %.2f s\n", argv[optind], sent, end_us / 1e6 );
+  printf( "  throughput   %8.1f commands/s\n", ok / (end_us / 1e6) );
+  printf( "  completed    %8u   lost %u (%.2f%%)\n", ok, lost, sent ? 100.0 * lost / sent : 0 );
+  printf( "  retries      %8llu   %.3f per command\n",
+          (unsigned long long)sim_pty_stats.txFlush, sent ? (double)sim_pty_stats.txFlush / sent : 0 );
+  bench_print( &rtt );
+  printf( "  link         %8llu bytes out, %llu bytes in, %llu frames in "
+          "(%llu bad, %llu $NK, %llu $ST)\n",
+          (unsigned long long)sim_pty_stats.txBytes, (unsigned long long)sim_pty_stats.rxBytes,
+          (unsigned long long)sim_pty_stats.rxFrames, (unsigned long long)sim_pty_stats.rxBadFrames,
+          (unsigned long long)sim_pty_stats.rxNk, (unsigned long long)sim_pty_stats.rxAsync );
+  close( fd );
+  return 0;
+}
@@ -0,0 +1,996 @@
+/*
+ * zcl_host.c - ZCL, AF and network stand-ins.
+ *
+ * Registrations made by the application are kept so the simulation can
+ * deliver On/Off commands and attribute writes to it the way the ZCL
+ * would. Writes arrive as encoded Write Attributes frames, through the
+ * application task when it has taken over the endpoint, and their
+ * responses are passed to sim_write_rsp_hook. Reports the application
+ * sends with AF_DataRequest are decoded and each attribute is passed to
+ * sim_report_hook as it would leave the radio. sim_send_hook, when set,
+ * decides what the network makes of each frame; its status, ZSuccess
+ * otherwise, comes back to the sending endpoint's task as an AF data
+ * confirm with the frame's transaction ID.
+ *
+ * For an end device the parent holds frames for the module until its next
+ * data poll, which runs at the rate the application sets with
+ * NLME_SetPollRate(); each poll and each send is charged its time on the
+ * radio.
+ *
+ * Flash is a plain array, written and erased with the CC2530's rules:
+ * writes can only clear bits, erases set a whole page.
+ */
+#include <stdio.h>
+
+#include "sim.h"
+#include "zcl_openevse.h"
+
+#define SIM_MAX_EP 8
+#define SIM_MAX_ATTR_LEN 80 // longest attribute a read callback may return
+#define SIM_CONFIRM_US 10000 // report frame to its AF data confirm
+#define SIM_POLL_RADIO_US 3000 // data request, its ack and the wait for a frame
+#define SIM_RX_FRAME_US 2000 // a frame from the parent
+#define SIM_TX_RADIO_US 2000 // CSMA, the frame and its MAC ack
+#define SIM_APS_ACK_POLL_MS 100 // end devices poll for the APS ack at this rate
+#define SIM_MAX_PARENT_Q 16
+#define SIM_AF_MTU 80 // APS payload of a unicast with network security only
+#define SIM_MAX_BINDS 16
+#define SIM_SWEEP_US 8000 // between the reads the ZCL answers in sim_collide_sweep
+
+typedef struct
+{
+  uint8 endpoint;
+  uint8 numAttr;
+  CONST zclAttrRec_t *attrs;
+  zclGeneral_AppCallbacks_t *callbacks;
+  zclReadWriteCB_t readWriteCB;
+  zclPollControl_AppCallbacks_t *pollControl;
+  endPointDesc_t desc;
+} simEndpoint_t;
+
+typedef struct
+{
+  simFn_t fn;
+  void *arg;
+  uint32_t argInt;
+} simParentFrame_t;
+
+static simEndpoint_t simEps[SIM_MAX_EP];
+static uint8 simAppTask = 0;
+static uint8 simZclTask = 0xFF; // Endpoints start out delivering to the ZCL
+static uint8 simZclSeq = 0;
+static uint8 simZclTransID = 0;
+static uint64_t simCollideUs = 0;   // armed by sim_af_collide
+static uint8 simCollideTransID;
+static simFn_t simCollideFn = NULL;
+static void *simCollideArg = NULL;
+static uint32_t simCollideArgInt = 0;
+static afIncomingMSGPacket_t simRawMsg;
+static simParentFrame_t simParentQ[SIM_MAX_PARENT_Q];
+static uint8 simParentQLen = 0;
+static uint32_t simPollGen = 0; // restarts the poll loop
+
+simReportHook_t sim_report_hook = NULL;
+simWriteRspHook_t sim_write_rsp_hook = NULL;
+simSendHook_t sim_send_hook = NULL;
+simFrameHook_t sim_frame_hook = NULL;
+simResetHook_t sim_reset_hook = NULL;
+uint8 sim_parent_lqi = 0xFF;
+uint32 sim_poll_rate = 0;
+uint32_t sim_polls = 0;
+uint64_t sim_radio_rx_us = 0;
+uint64_t sim_radio_tx_us = 0;
+simCheckInHook_t sim_checkin_hook = NULL;
+uint16 sim_zcl_group = 0;
+uint8 sim_zcl_broadcast = FALSE;
+uint8 sim_ext_addr[Z_EXTADDR_LEN] = { 0x01, 0x02, 0x03, 0x04, 0x00, 0x4B, 0x12, 0x00 };
+uint8 sim_flash[SIM_FLASH_SIZE];
+uint32_t sim_flash_erases = 0;
+uint32_t sim_flash_words = 0;
+uint32_t sim_unbound = 0;
+uint32_t sim_report_fails = 0;
+
+// The hub's bindings, from every charger endpoint: the clusters the
+// SmartThings handler's configure() binds, and any a bench adds
+static struct
+{
+  uint8 endpoint;   // 0 for every charger endpoint
+  uint16 clusterId;
+} simBinds[SIM_MAX_BINDS] =
+{
+  { 0, ZCL_CLUSTER_ID_GEN_DEVICE_TEMP_CONFIG },
+  { 0, ZCL_CLUSTER_ID_GEN_MULTISTATE_INPUT_BASIC },
+  { 0, ZCL_CLUSTER_ID_SE_METERING },
+  { 0, ZCL_CLUSTER_ID_HA_ELECTRICAL_MEASUREMENT },
+  { 0, ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL },
+  { 0, ZCL_CLUSTER_ID_HA_APPLIANCE_EVENTS_ALERTS }
+};
+static uint8 simNumBinds = 6;
+
+static simEndpoint_t *sim_ep( uint8 endpoint, uint8 create )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_EP; i++ )
+  {
+    if ( simEps[i].endpoint == endpoint )
+    {
+      return &simEps[i];
+    }
+  }
+  if ( create )
+  {
+    for ( i = 0; i < SIM_MAX_EP; i++ )
+    {
+      if ( simEps[i].endpoint == 0 )
+      {
+        simEps[i].endpoint = endpoint;
+        return &simEps[i];
+      }
+    }
+  }
+  return NULL;
+}
+
+static CONST zclAttrRec_t *sim_find_attr( uint8 endpoint, uint16 clusterId, uint16 attrId )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  uint8 i;
+
+  if ( ep == NULL )
+  {
+    return NULL;
+  }
+  for ( i = 0; i < ep->numAttr; i++ )
+  {
+    if ( ep->attrs[i].clusterID == clusterId && ep->attrs[i].attr.attrId == attrId )
+    {
+      return &ep->attrs[i];
+    }
+  }
+  return NULL;
+}
+
+/*********************************************************************
+ * Registration
+ */
+void zclHA_Init( SimpleDescriptionFormat_t *simpleDesc )
+{
+  simEndpoint_t *ep = sim_ep( simpleDesc->EndPoint, TRUE );
+
+  ep->desc.endPoint = simpleDesc->EndPoint;
+  ep->desc.task_id = &simZclTask;
+  ep->desc.simpleDesc = simpleDesc;
+}
+
+afStatus_t afRegister( endPointDesc_t *epDesc )
+{
+  simEndpoint_t *ep = sim_ep( epDesc->endPoint, TRUE );
+
+  if ( ep == NULL )
+  {
+    return ZMemError;
+  }
+  ep->desc = *epDesc;
+  return ZSuccess;
+}
+
+endPointDesc_t *afFindEndPointDesc( uint8 EndPoint )
+{
+  simEndpoint_t *ep = sim_ep( EndPoint, FALSE );
+
+  return ep != NULL && ep->desc.task_id != NULL ? &ep->desc : NULL;
+}
+
+ZStatus_t zclGeneral_RegisterCmdCallbacks( uint8 endpoint, zclGeneral_AppCallbacks_t *callbacks )
+{
+  sim_ep( endpoint, TRUE )->callbacks = callbacks;
+  return ZSuccess;
+}
+
+ZStatus_t zcl_registerAttrList( uint8 endpoint, uint8 numAttr, CONST zclAttrRec_t attrList[] )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, TRUE );
+
+  ep->numAttr = numAttr;
+  ep->attrs = attrList;
+  return ZSuccess;
+}
+
+ZStatus_t zcl_registerCmdList( uint8 endpoint, CONST uint8 cmdListSize, CONST zclCommandRec_t newCmdList[] )
+{
+  (void)endpoint;
+  (void)cmdListSize;
+  (void)newCmdList;
+  return ZSuccess;
+}
+
+ZStatus_t zcl_registerReadWriteCB( uint8 endpoint, zclReadWriteCB_t pfnReadWriteCB,
+                                   zclAuthorizeCB_t pfnAuthorizeCB )
+{
+  (void)pfnAuthorizeCB;
+  sim_ep( endpoint, TRUE )->readWriteCB = pfnReadWriteCB;
+  return ZSuccess;
+}
+
+ZStatus_t zclPollControl_RegisterCmdCallbacks( uint8 endpoint, zclPollControl_AppCallbacks_t *callbacks )
+{
+  sim_ep( endpoint, TRUE )->pollControl = callbacks;
+  return ZSuccess;
+}
+
+uint8 zcl_registerForMsg( uint8 taskId )
+{
+  simAppTask = taskId;
+  return ZSuccess;
+}
+
+afIncomingMSGPacket_t *zcl_getRawAFMsg( void )
+{
+  return &simRawMsg;
+}
+
+uint8 zclGetDataTypeLength( uint8 dataType )
+{
+  switch ( dataType )
+  {
+    case ZCL_DATATYPE_BOOLEAN:
+    case ZCL_DATATYPE_BITMAP8:
+    case ZCL_DATATYPE_UINT8:
+    case ZCL_DATATYPE_INT8:
+    case ZCL_DATATYPE_ENUM8:
+      return 1;
+    case ZCL_DATATYPE_BITMAP16:
+    case ZCL_DATATYPE_UINT16:
+    case ZCL_DATATYPE_INT16:
+      return 2;
+    case ZCL_DATATYPE_UINT24:
+      return 3;
+    case ZCL_DATATYPE_BITMAP32:
+    case ZCL_DATATYPE_UINT32:
+    case ZCL_DATATYPE_INT32:
+    case ZCL_DATATYPE_UTC:
+      return 4;
+    case ZCL_DATATYPE_UINT48:
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+/*********************************************************************
+ * Data polls
+ */
+// One data poll; the parent hands over whatever it holds for the module.
+// Frames queued on the way wait for the next one.
+static void sim_poll( void *arg, uint32_t argInt )
+{
+  simParentFrame_t q[SIM_MAX_PARENT_Q];
+  uint8 n = simParentQLen;
+  uint8 i;
+
+  (void)arg;
+  (void)argInt;
+  sim_polls++;
+  sim_radio_rx_us += SIM_POLL_RADIO_US + n * SIM_RX_FRAME_US;
+  sim_wake( sim_now_us() + SIM_POLL_RADIO_US + n * SIM_RX_FRAME_US );
+  memcpy( q, simParentQ, n * sizeof( simParentFrame_t ) );
+  simParentQLen = 0;
+  for ( i = 0; i < n; i++ )
+  {
+    q[i].fn( q[i].arg, q[i].argInt );
+  }
+}
+
+static void sim_poll_loop( void *arg, uint32_t gen )
+{
+  if ( gen != simPollGen || sim_poll_rate == 0 )
+  {
+    return; // Superseded by a new rate
+  }
+  sim_poll( arg, 0 );
+  sim_schedule( sim_now_us() + sim_poll_rate * 1000ULL, sim_poll_loop, NULL, gen );
+}
+
+// Z-Stack restarts the poll timer with the new rate
+void NLME_SetPollRate( uint32 newRate )
+{
+  sim_poll_rate = newRate;
+  simPollGen++;
+  if ( newRate != 0 && !sim_pwr_always_on )
+  {
+    sim_schedule( sim_now_us() + newRate * 1000ULL, sim_poll_loop, NULL, simPollGen );
+  }
+}
+
+void sim_parent_send( simFn_t fn, void *arg, uint32_t argInt )
+{
+  if ( sim_poll_rate == 0 || sim_pwr_always_on || simParentQLen == SIM_MAX_PARENT_Q )
+  {
+    sim_schedule( sim_now_us(), fn, arg, argInt );
+    return;
+  }
+  simParentQ[simParentQLen].fn = fn;
+  simParentQ[simParentQLen].arg = arg;
+  simParentQ[simParentQLen].argInt = argInt;
+  simParentQLen++;
+}
+
+/*********************************************************************
+ * Sending
+ */
+static void sim_data_confirm( void *arg, uint32_t argInt )
+{
+  simEndpoint_t *ep = arg;
+  afDataConfirm_t *msg;
+
+  if ( ep->desc.task_id == &simZclTask )
+  {
+    return; // The ZCL has no use for it
+  }
+  msg = (afDataConfirm_t *)osal_msg_allocate( sizeof( afDataConfirm_t ) );
+  msg->hdr.event = AF_DATA_CONFIRM_CMD;
+  msg->hdr.status = (uint8)argInt;
+  msg->endpoint = ep->endpoint;
+  msg->transID = (uint8)(argInt >> 8);
+  osal_msg_send( *ep->desc.task_id, (uint8 *)msg );
+}
+
+void sim_bind( uint8 endpoint, uint16 clusterId )
+{
+  if ( simNumBinds < SIM_MAX_BINDS )
+  {
+    simBinds[simNumBinds].endpoint = endpoint;
+    simBinds[simNumBinds].clusterId = clusterId;
+    simNumBinds++;
+  }
+}
+
+// Whether an indirect frame from the endpoint finds a binding
+static uint8 sim_bound( uint8 endpoint, uint16 clusterId )
+{
+  uint8 i, n;
+
+  for ( i = 0; i < simNumBinds; i++ )
+  {
+    if ( simBinds[i].clusterId != clusterId )
+    {
+      continue;
+    }
+    if ( simBinds[i].endpoint == endpoint )
+    {
+      return TRUE;
+    }
+    for ( n = 0; simBinds[i].endpoint == 0 && n < OPENEVSE_NUM_EVSE; n++ )
+    {
+      if ( endpoint == OPENEVSE_EVSE_ENDPOINT( n ) )
+      {
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
+
+// The ZCL answers a read from the endpoint, and goes on until its next
+// frame takes the colliding report's transaction ID; fn sends that frame
+static void sim_collide_sweep( void *arg, uint32_t argInt )
+{
+  afAddrType_t hub;
+  uint8 rsp[3] = { 0x00, 0x00, ZCL_STATUS_UNSUPPORTED_ATTRIBUTE };
+
+  (void)arg;
+  if ( simZclTransID == simCollideTransID )
+  {
+    simCollideFn( simCollideArg, simCollideArgInt );
+    return;
+  }
+  hub.addrMode = (afAddrMode_t)Addr16Bit;
+  hub.addr.shortAddr = 0x0000;
+  hub.endPoint = 1;
+  zcl_SendCommand( (uint8)argInt, &hub, ZCL_CLUSTER_ID_GEN_BASIC, ZCL_CMD_READ_RSP, FALSE,
+                   ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, 0, simZclSeq++, sizeof( rsp ), rsp );
+  sim_schedule( sim_now_us() + SIM_SWEEP_US, sim_collide_sweep, NULL, argInt );
+}
+
+static uint8 sim_is_report( const uint8 *buf, uint16 len )
+{
+  return len >= 3 && !(buf[0] & ZCL_FRAME_CONTROL_MANU_SPECIFIC) && buf[2] == ZCL_CMD_REPORT;
+}
+
+void sim_af_collide( uint64_t confirmUs, simFn_t fn, void *arg, uint32_t argInt )
+{
+  simCollideUs = confirmUs;
+  simCollideFn = fn;
+  simCollideArg = arg;
+  simCollideArgInt = argInt;
+}
+
+afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                           uint16 cID, uint16 len, uint8 *buf, uint8 *transID,
+                           uint8 options, uint8 radius )
+{
+  simEndpoint_t *ep;
+  uint8 status = ZSuccess;
+  uint16 pos, attrLen;
+  uint8 j;
+  uint32_t value;
+
+  (void)dstAddr;
+  (void)radius;
+
+  if ( srcEP == NULL || (ep = sim_ep( srcEP->endPoint, FALSE )) == NULL )
+  {
+    return ZInvalidParameter;
+  }
+  if ( dstAddr->addrMode == (afAddrMode_t)AddrNotPresent && !sim_bound( srcEP->endPoint, cID ) )
+  {
+    // Nowhere to go; the stack says so in the confirm
+    sim_unbound++;
+    sim_report_fails++;
+    sim_schedule( sim_now_us() + SIM_CONFIRM_US, sim_data_confirm, ep,
+                  ZApsNoBoundDevice | ((uint32_t)*transID << 8) );
+    (*transID)++;
+    return ZSuccess;
+  }
+  if ( sim_send_hook )
+  {
+    status = sim_send_hook( srcEP->endPoint, cID, options );
+  }
+  sim_radio_tx_us += SIM_TX_RADIO_US;
+  sim_wake( sim_now_us() + SIM_TX_RADIO_US );
+  if ( (options & AF_ACK_REQUEST) && sim_poll_rate > SIM_APS_ACK_POLL_MS && !sim_pwr_always_on )
+  {
+    sim_schedule( sim_now_us() + SIM_APS_ACK_POLL_MS * 1000ULL, sim_poll, NULL, 0 );
+  }
+  if ( simCollideUs && (options & AF_ACK_REQUEST) )
+  {
+    // No APS ack, and the ZCL's counter comes round to the same transaction ID
+    sim_schedule( sim_now_us() + simCollideUs, sim_data_confirm, ep,
+                  ZApsNoAck | ((uint32_t)*transID << 8) );
+    simCollideTransID = *transID;
+    sim_schedule( sim_now_us(), sim_collide_sweep, NULL, srcEP->endPoint );
+    simCollideUs = 0;
+    status = ZApsNoAck;
+  }
+  else
+  {
+    sim_schedule( sim_now_us() + SIM_CONFIRM_US, sim_data_confirm, ep,
+                  status | ((uint32_t)*transID << 8) );
+  }
+  if ( status != ZSuccess && dstAddr->addrMode == (afAddrMode_t)AddrNotPresent )
+  {
+    sim_report_fails++;
+  }
+  (*transID)++;
+  if ( sim_frame_hook )
+  {
+    sim_frame_hook( sim_now_us(), srcEP->endPoint, dstAddr, cID, buf, len );
+  }
+
+  // Only reports, one or more attribute records after the 3 byte header
+  if ( !sim_is_report( buf, len ) )
+  {
+    return ZSuccess;
+  }
+  for ( pos = 3; pos + 3 <= len; pos += 3 + attrLen )
+  {
+    attrLen = zclGetDataTypeLength( buf[pos + 2] );
+    value = 0;
+    for ( j = 0; j < attrLen && j < 4 && pos + 3 + j < len; j++ )
+    {
+      value |= (uint32_t)buf[pos + 3 + j] << (8 * j);
+    }
+    if ( sim_report_hook )
+    {
+      sim_report_hook( sim_now_us(), srcEP->endPoint, cID, BUILD_UINT16( buf[pos], buf[pos + 1] ), value );
+    }
+  }
+  return ZSuccess;
+}
+
+uint8 afDataReqMTU( afDataReqMTU_t *fields )
+{
+  (void)fields;
+  return SIM_AF_MTU;
+}
+
+// The ZCL header, then out through AF_DataRequest like everything else
+ZStatus_t zcl_SendCommand( uint8 srcEP, afAddrType_t *dstAddr,
+                           uint16 clusterID, uint8 cmd, uint8 specific, uint8 direction,
+                           uint8 disableDefaultRsp, uint16 manuCode, uint8 seqNum,
+                           uint16 cmdFormatLen, uint8 *cmdFormat )
+{
+  uint8 buf[5 + SIM_AF_MTU];
+  uint8 len = 0;
+
+  if ( cmdFormatLen > SIM_AF_MTU )
+  {
+    return ZInvalidParameter;
+  }
+  buf[len++] = (specific ? ZCL_FRAME_TYPE_SPECIFIC_CMD : ZCL_FRAME_TYPE_PROFILE_CMD) |
+               (manuCode ? ZCL_FRAME_CONTROL_MANU_SPECIFIC : 0) |
+               (direction ? ZCL_FRAME_CONTROL_DIRECTION : 0) |
+               (disableDefaultRsp ? ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP : 0);
+  if ( manuCode )
+  {
+    buf[len++] = LO_UINT16( manuCode );
+    buf[len++] = HI_UINT16( manuCode );
+  }
+  buf[len++] = seqNum;
+  buf[len++] = cmd;
+  memcpy( &buf[len], cmdFormat, cmdFormatLen );
+  return AF_DataRequest( dstAddr, afFindEndPointDesc( srcEP ), clusterID, len + cmdFormatLen,
+                         buf, &simZclTransID, AF_TX_OPTIONS_NONE, AF_DEFAULT_RADIUS );
+}
+
+ZStatus_t zcl_SendWriteRspCmd( uint8 srcEP, afAddrType_t *dstAddr,
+                               uint16 clusterID, zclWriteRspCmd_t *writeRspCmd, uint8 cmd,
+                               uint8 direction, uint8 disableDefaultRsp, uint8 seqNum )
+{
+  uint8 buf[SIM_AF_MTU];
+  uint8 len = 0;
+  uint8 i;
+
+  // A status, then the attribute ID for each record that isn't a success
+  for ( i = 0; i < writeRspCmd->numAttr && len + 3 <= sizeof( buf ); i++ )
+  {
+    buf[len++] = writeRspCmd->attrList[i].status;
+    if ( writeRspCmd->attrList[i].status != ZCL_STATUS_SUCCESS )
+    {
+      buf[len++] = LO_UINT16( writeRspCmd->attrList[i].attrID );
+      buf[len++] = HI_UINT16( writeRspCmd->attrList[i].attrID );
+    }
+    if ( sim_write_rsp_hook )
+    {
+      sim_write_rsp_hook( sim_now_us(), srcEP, clusterID, writeRspCmd->attrList[i].attrID,
+                          writeRspCmd->attrList[i].status );
+    }
+  }
+  return zcl_SendCommand( srcEP, dstAddr, clusterID, cmd, FALSE, direction,
+                          disableDefaultRsp, 0, seqNum, len, buf );
+}
+
+ZStatus_t zclPollControl_Send_CheckIn( uint8 srcEP, afAddrType_t *dstAddr,
+                                      uint8 disableDefaultRsp, uint8 seqNum )
+{
+  (void)dstAddr;
+  (void)disableDefaultRsp;
+  (void)seqNum;
+  sim_radio_tx_us += SIM_TX_RADIO_US;
+  sim_wake( sim_now_us() + SIM_TX_RADIO_US );
+  if ( sim_checkin_hook )
+  {
+    sim_checkin_hook( sim_now_us(), srcEP );
+  }
+  return ZSuccess;
+}
+
+/*********************************************************************
+ * Incoming frames
+ */
+
+// Length of an attribute value on the air; strings carry theirs in front
+static uint8 sim_attr_len( uint8 dataType, const uint8 *value )
+{
+  if ( dataType == ZCL_DATATYPE_OCTET_STR || dataType == ZCL_DATATYPE_CHAR_STR )
+  {
+    return 1 + value[0];
+  }
+  return zclGetDataTypeLength( dataType );
+}
+
+// Write one attribute record the way zcl.c does: through the data pointer,
+// or the endpoint's read/write callback when there isn't one
+static uint8 sim_write_attr( simEndpoint_t *ep, uint16 clusterId, uint16 attrId,
+                             uint8 dataType, uint8 *value )
+{
+  CONST zclAttrRec_t *rec = sim_find_attr( ep->endpoint, clusterId, attrId );
+
+  if ( rec == NULL )
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+  if ( !(rec->attr.accessControl & ACCESS_CONTROL_WRITE) )
+  {
+    return ZCL_STATUS_READ_ONLY;
+  }
+  if ( rec->attr.dataType != dataType )
+  {
+    return ZCL_STATUS_INVALID_DATA_TYPE;
+  }
+  if ( rec->attr.dataPtr != NULL )
+  {
+    memcpy( rec->attr.dataPtr, value, zclGetDataTypeLength( dataType ) );
+    return ZCL_STATUS_SUCCESS;
+  }
+  if ( ep->readWriteCB == NULL )
+  {
+    return ZCL_STATUS_FAILURE;
+  }
+  return ep->readWriteCB( clusterId, attrId, ZCL_OPER_WRITE, value, NULL );
+}
+
+// Only the write commands are decoded; a write answers with the records
+// that failed, or a single success, as in zcl.c. Write Undivided is
+// treated as a plain write.
+zclProcMsgStatus_t zcl_ProcessMessageMSG( afIncomingMSGPacket_t *pkt )
+{
+  simEndpoint_t *ep = sim_ep( pkt->endPoint, FALSE );
+  uint8 *pData = pkt->cmd.Data;
+  uint8 *pEnd = pData + pkt->cmd.DataLength;
+  zclWriteRspCmd_t *rsp;
+  uint8 cmd, seq, len, status;
+  uint16 attrId;
+
+  if ( ep == NULL )
+  {
+    return ZCL_PROC_EP_NOT_FOUND;
+  }
+  if ( pkt->cmd.DataLength < 3 || (pData[0] & ZCL_FRAME_CONTROL_MANU_SPECIFIC) )
+  {
+    return ZCL_PROC_NOT_HANDLED;
+  }
+  seq = pData[1];
+  cmd = pData[2];
+  if ( cmd != ZCL_CMD_WRITE && cmd != ZCL_CMD_WRITE_UNDIVIDED && cmd != ZCL_CMD_WRITE_NO_RSP )
+  {
+    return ZCL_PROC_NOT_HANDLED;
+  }
+
+  simRawMsg = *pkt;
+  rsp = (zclWriteRspCmd_t *)osal_mem_alloc( sizeof( zclWriteRspCmd_t ) +
+                                            (pkt->cmd.DataLength / 4 + 1) * sizeof( zclWriteRspStatus_t ) );
+  rsp->numAttr = 0;
+  for ( pData += 3; pData + 3 <= pEnd; pData += 3 + len )
+  {
+    attrId = BUILD_UINT16( pData[0], pData[1] );
+    len = ( pData + 3 < pEnd ) ? sim_attr_len( pData[2], pData + 3 ) : 0;
+    if ( len == 0 || pData + 3 + len > pEnd )
+    {
+      break;
+    }
+    status = sim_write_attr( ep, pkt->clusterId, attrId, pData[2], pData + 3 );
+    if ( status != ZCL_STATUS_SUCCESS )
+    {
+      rsp->attrList[rsp->numAttr].status = status;
+      rsp->attrList[rsp->numAttr].attrID = attrId;
+      rsp->numAttr++;
+    }
+  }
+  if ( rsp->numAttr == 0 )
+  {
+    rsp->attrList[0].status = ZCL_STATUS_SUCCESS;
+    rsp->attrList[0].attrID = 0;
+    rsp->numAttr = 1;
+  }
+  if ( cmd != ZCL_CMD_WRITE_NO_RSP )
+  {
+    zcl_SendWriteRsp( pkt->endPoint, &pkt->srcAddr, pkt->clusterId, rsp,
+                      ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, seq );
+  }
+  osal_mem_free( rsp );
+  return ZCL_PROC_SUCCESS;
+}
+
+/*********************************************************************
+ * Injection from the simulation
+ */
+// ZDApp tells every endpoint's task; the ZCL passes its copies on to the
+// task registered for messages
+void sim_set_nwk_state( devStates_t state )
+{
+  osal_event_hdr_t *msg;
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_EP; i++ )
+  {
+    if ( simEps[i].desc.task_id == NULL )
+    {
+      continue;
+    }
+    msg = (osal_event_hdr_t *)osal_msg_allocate( sizeof( osal_event_hdr_t ) );
+    msg->event = ZDO_STATE_CHANGE;
+    msg->status = (uint8)state;
+    osal_msg_send( simEps[i].desc.task_id == &simZclTask ? simAppTask : *simEps[i].desc.task_id,
+                   (uint8 *)msg );
+  }
+}
+
+void sim_zcl_onoff( uint8 endpoint, uint8 cmd )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+
+  if ( ep == NULL || ep->callbacks == NULL || ep->callbacks->pfnOnOff == NULL )
+  {
+    return;
+  }
+  memset( &simRawMsg, 0, sizeof( simRawMsg ) );
+  simRawMsg.endPoint = endpoint;
+  simRawMsg.groupId = sim_zcl_group;
+  simRawMsg.wasBroadcast = sim_zcl_broadcast;
+  simRawMsg.clusterId = ZCL_CLUSTER_ID_GEN_ON_OFF;
+  ep->callbacks->pfnOnOff( cmd );
+}
+
+void sim_zcl_level( uint8 endpoint, uint8 level, uint16 transitionTime )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  zclLCMoveToLevel_t cmd;
+
+  if ( ep == NULL || ep->callbacks == NULL || ep->callbacks->pfnLevelControlMoveToLevel == NULL )
+  {
+    return;
+  }
+  memset( &simRawMsg, 0, sizeof( simRawMsg ) );
+  simRawMsg.endPoint = endpoint;
+  simRawMsg.groupId = sim_zcl_group;
+  simRawMsg.wasBroadcast = sim_zcl_broadcast;
+  simRawMsg.clusterId = ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL;
+  cmd.level = level;
+  cmd.transitionTime = transitionTime;
+  cmd.withOnOff = FALSE;
+  ep->callbacks->pfnLevelControlMoveToLevel( &cmd );
+}
+
+void sim_zcl_identify( uint8 endpoint, uint16 identifyTime )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  zclIdentify_t cmd;
+
+  if ( ep == NULL || ep->callbacks == NULL || ep->callbacks->pfnIdentify == NULL )
+  {
+    return;
+  }
+  memset( &simRawMsg, 0, sizeof( simRawMsg ) );
+  simRawMsg.endPoint = endpoint;
+  simRawMsg.clusterId = ZCL_CLUSTER_ID_GEN_IDENTIFY;
+  cmd.srcAddr = &simRawMsg.srcAddr;
+  cmd.identifyTime = identifyTime;
+  ep->callbacks->pfnIdentify( &cmd );
+}
+
+void sim_zcl_trigger_effect( uint8 endpoint, uint8 effectId, uint8 effectVariant )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  zclIdentifyTriggerEffect_t cmd;
+
+  if ( ep == NULL || ep->callbacks == NULL || ep->callbacks->pfnIdentifyTriggerEffect == NULL )
+  {
+    return;
+  }
+  memset( &simRawMsg, 0, sizeof( simRawMsg ) );
+  simRawMsg.endPoint = endpoint;
+  simRawMsg.clusterId = ZCL_CLUSTER_ID_GEN_IDENTIFY;
+  cmd.srcAddr = &simRawMsg.srcAddr;
+  cmd.effectId = effectId;
+  cmd.effectVariant = effectVariant;
+  ep->callbacks->pfnIdentifyTriggerEffect( &cmd );
+}
+
+void sim_zcl_poll_control( uint8 endpoint, uint8 cmd, uint32_t value )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  zclPollControl_AppCallbacks_t *cb;
+
+  if ( ep == NULL || (cb = ep->pollControl) == NULL )
+  {
+    return;
+  }
+  memset( &simRawMsg, 0, sizeof( simRawMsg ) );
+  simRawMsg.endPoint = endpoint;
+  simRawMsg.clusterId = ZCL_CLUSTER_ID_GEN_POLL_CONTROL;
+  if ( cmd == COMMAND_POLL_CONTROL_CHECK_IN_RSP && cb->pfnPollControlCheckInRsp )
+  {
+    zclPollControlCheckInRsp_t rsp;
+
+    rsp.srcAddr = &simRawMsg.srcAddr;
+    rsp.seqNum = simZclSeq++;
+    rsp.startFastPolling = value != 0;
+    rsp.fastPollTimeOut = (uint16)value;
+    cb->pfnPollControlCheckInRsp( &rsp );
+  }
+  else if ( cmd == COMMAND_POLL_CONTROL_FAST_POLL_STOP && cb->pfnPollControlFastPollStop )
+  {
+    zclPollControlFastPollStop_t stop;
+
+    stop.srcAddr = &simRawMsg.srcAddr;
+    cb->pfnPollControlFastPollStop( &stop );
+  }
+  else if ( cmd == COMMAND_POLL_CONTROL_SET_LONG_POLL_INTERVAL && cb->pfnPollControlSetLongPollInterval )
+  {
+    zclPollControlSetLongPollInterval_t set;
+
+    set.srcAddr = &simRawMsg.srcAddr;
+    set.newLongPollInterval = value;
+    cb->pfnPollControlSetLongPollInterval( &set );
+  }
+  else if ( cmd == COMMAND_POLL_CONTROL_SET_SHORT_POLL_INTERVAL && cb->pfnPollControlSetShortPollInterval )
+  {
+    zclPollControlSetShortPollInterval_t set;
+
+    set.srcAddr = &simRawMsg.srcAddr;
+    set.newShortPollInterval = (uint16)value;
+    cb->pfnPollControlSetShortPollInterval( &set );
+  }
+}
+
+uint8 sim_zcl_write( uint8 endpoint, uint16 clusterId, uint16 attrId, const void *value )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  CONST zclAttrRec_t *rec = sim_find_attr( endpoint, clusterId, attrId );
+  afIncomingMSGPacket_t *pkt;
+  uint8 len;
+
+  if ( ep == NULL || rec == NULL )
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+  len = sim_attr_len( rec->attr.dataType, value );
+
+  // Write Attributes from a controller at 0x0000, one record
+  pkt = (afIncomingMSGPacket_t *)osal_msg_allocate( sizeof( afIncomingMSGPacket_t ) + 6 + len );
+  memset( pkt, 0, sizeof( afIncomingMSGPacket_t ) );
+  pkt->hdr.event = AF_INCOMING_MSG_CMD;
+  pkt->clusterId = clusterId;
+  pkt->srcAddr.addrMode = (afAddrMode_t)Addr16Bit;
+  pkt->srcAddr.addr.shortAddr = 0x0000;
+  pkt->srcAddr.endPoint = 1;
+  pkt->endPoint = endpoint;
+  pkt->cmd.Data = (uint8 *)(pkt + 1);
+  pkt->cmd.DataLength = 6 + len;
+  pkt->cmd.Data[0] = 0; // Profile wide, client to server
+  pkt->cmd.Data[1] = simZclSeq++;
+  pkt->cmd.Data[2] = ZCL_CMD_WRITE;
+  pkt->cmd.Data[3] = LO_UINT16( attrId );
+  pkt->cmd.Data[4] = HI_UINT16( attrId );
+  pkt->cmd.Data[5] = rec->attr.dataType;
+  memcpy( &pkt->cmd.Data[6], value, len );
+
+  if ( ep->desc.task_id != &simZclTask )
+  {
+    osal_msg_send( *ep->desc.task_id, (uint8 *)pkt );
+  }
+  else
+  {
+    zcl_ProcessMessageMSG( pkt );
+    osal_msg_deallocate( (uint8 *)pkt );
+  }
+  return ZCL_STATUS_SUCCESS;
+}
+
+void sim_zcl_frame( uint8 endpoint, uint16 clusterId, uint16 srcAddr, uint8 srcEndpoint,
+                    const uint8 *buf, uint16 len )
+{
+  simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+  afIncomingMSGPacket_t *pkt;
+
+  if ( ep == NULL || ep->desc.task_id == &simZclTask )
+  {
+    return;
+  }
+  pkt = (afIncomingMSGPacket_t *)osal_msg_allocate( sizeof( afIncomingMSGPacket_t ) + len );
+  memset( pkt, 0, sizeof( afIncomingMSGPacket_t ) );
+  pkt->hdr.event = AF_INCOMING_MSG_CMD;
+  pkt->clusterId = clusterId;
+  pkt->srcAddr.addrMode = (afAddrMode_t)Addr16Bit;
+  pkt->srcAddr.addr.shortAddr = srcAddr;
+  pkt->srcAddr.endPoint = srcEndpoint;
+  pkt->endPoint = endpoint;
+  pkt->cmd.Data = (uint8 *)(pkt + 1);
+  pkt->cmd.DataLength = len;
+  memcpy( pkt->cmd.Data, buf, len );
+  osal_msg_send( *ep->desc.task_id, (uint8 *)pkt );
+}
+
+uint8 sim_zcl_read( uint8 endpoint, uint16 clusterId, uint16 attrId, void *value, uint8 len )
+{
+  CONST zclAttrRec_t *rec = sim_find_attr( endpoint, clusterId, attrId );
+  uint8 size;
+
+  if ( rec == NULL )
+  {
+    return ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+  }
+  size = zclGetDataTypeLength( rec->attr.dataType );
+  memset( value, 0, len );
+  if ( rec->attr.dataPtr == NULL )
+  {
+    simEndpoint_t *ep = sim_ep( endpoint, FALSE );
+    uint8 buf[SIM_MAX_ATTR_LEN];
+    uint16 cbLen = 0;
+
+    simRawMsg.endPoint = endpoint;
+    simRawMsg.clusterId = clusterId;
+    if ( ep->readWriteCB == NULL || ep->readWriteCB( clusterId, attrId, ZCL_OPER_READ, buf, &cbLen ) != ZCL_STATUS_SUCCESS )
+    {
+      return ZCL_STATUS_FAILURE;
+    }
+    if ( size == 0 )
+    {
+      size = (uint8)cbLen; // Strings: the length byte and what follows
+    }
+    memcpy( value, buf, size < len ? size : len );
+    return ZCL_STATUS_SUCCESS;
+  }
+  if ( size == 0 )
+  {
+    size = *(uint8 *)rec->attr.dataPtr + 1;
+  }
+  memcpy( value, rec->attr.dataPtr, size < len ? size : len );
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * Network and board
+ */
+uint8 *NLME_GetExtAddr( void )
+{
+  return sim_ext_addr;
+}
+
+uint16 NLME_GetCoordShortAddr( void )
+{
+  return 0x0000;
+}
+
+// The parent's entry, with the link quality the simulation sets
+associated_devices_t *AssocGetWithShort( uint16 shortAddr )
+{
+  static associated_devices_t parent;
+
+  parent.shortAddr = shortAddr;
+  parent.linkInfo.rxLqi = sim_parent_lqi;
+  return &parent;
+}
+
+ZStatus_t NLME_LeaveReq( NLME_LeaveReq_t *req )
+{
+  (void)req;
+  return ZSuccess;
+}
+
+uint8 zgWriteStartupOptions( uint8 action, uint8 bitOptions )
+{
+  (void)action;
+  (void)bitOptions;
+  return ZSuccess;
+}
+
+void ZDApp_LeaveReset( uint8 ra )
+{
+  (void)ra;
+}
+
+void HalFlashRead( uint8 pg, uint16 offset, uint8 *buf, uint16 cnt )
+{
+  memcpy( buf, &sim_flash[(uint32_t)pg * HAL_FLASH_PAGE_SIZE + offset], cnt );
+}
+
+// addr and cnt in flash words
+void HalFlashWrite( uint16 addr, uint8 *buf, uint16 cnt )
+{
+  uint32_t i;
+
+  for ( i = 0; i < (uint32_t)cnt * HAL_FLASH_WORD_SIZE; i++ )
+  {
+    sim_flash[(uint32_t)addr * HAL_FLASH_WORD_SIZE + i] &= buf[i];
+  }
+  sim_flash_words += cnt;
+}
+
+void HalFlashErase( uint8 pg )
+{
+  memset( &sim_flash[(uint32_t)pg * HAL_FLASH_PAGE_SIZE], 0xFF, HAL_FLASH_PAGE_SIZE );
+  sim_flash_erases++;
+}
+
+void Onboard_soft_reset( void )
+{
+  if ( sim_reset_hook )
+  {
+    sim_reset_hook( sim_now_us() );
+    return;
+  }
+  fprintf( stderr, "sim: soft reset requested at %.3f s\n", sim_now_us() / 1e6 );
+}
@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+#
+# size_report.py - flash, XDATA, IDATA and stack use of the firmware by
+# module, checked against a baseline.
+#
+# Reads either the XLINK map of the RouterEB build (XList and SegmentMap
+# are on in OpenEVSE.ewp, so IAR writes RouterEB/List/OpenEVSE.map next
+# to OpenEVSE.hex) or a set of host-compiled objects. Segments are sorted
+# into memories by the IAR 8051 naming: *_ID initializers, constants and
+# code are flash, XDATA_ and PDATA_ segments are XDATA, IDATA_, DATA_,
+# BDATA_ and BIT_ segments are internal RAM, and ISTACK, PSTACK and
+# XSTACK are the reserved stacks. For objects, `size -A` gives .text and
+# .rodata as flash and .data and .bss as XDATA (.data is counted in
+# flash too, for its initializer), and stack is the deepest frame in each
+# object from the .su files gcc writes with -fstack-usage.
+#
+# Host objects only show which way the application is going: gcc for
+# x86 doesn't lay code out as IAR does for the 8051, and the ZCL, HAL and
+# stack aren't in them. Only the map gives the CC2530 budget.
+#
+# Modules are grouped into application, ZCL, HAL UART and stack. With
+# --baseline every group and module is compared against the checked-in
+# numbers; growth beyond --tolerance bytes is flagged and the exit
+# status is 1. --update rewrites the baseline instead. A baseline records
+# the compiler its numbers came from (--cc and --cflags for objects, the
+# linker named in the map), and one from another compiler or version is
+# refused with exit status 2.
+#
+# Usage: size_report.py (--map FILE | --objects OBJ... --cc CC [--cflags FLAGS])
+#                       [--baseline FILE] [--update] [--tolerance BYTES]
+#                       [--modules]
+#
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+MEMORIES = ['flash', 'xdata', 'idata', 'stack']
+
+# CC2530F256
+CAPACITY = {'flash': 256 * 1024, 'xdata': 8 * 1024}
+
+APP_MODULES = ('zcl_openevse', 'zcl_openevse_data', 'OSAL_openevse')
+
+
+def group_of(module):
+    if module in APP_MODULES:
+        return 'application'
+    if re.match(r'_?hal_uart', module):
+        return 'HAL UART'
+    if module.startswith('zcl'):
+        return 'ZCL'
+    return 'stack'
+
+
+def memory_of(segment):
+    if segment in ('ISTACK', 'PSTACK', 'XSTACK', 'EXT_STACK'):
+        return 'stack'
+    if segment.endswith('_ID'):
+        return 'flash'  # Initializers of XDATA_I and friends
+    if re.match(r'(XDATA|PDATA)_', segment):
+        return 'xdata'
+    if re.match(r'(IDATA|DATA|BDATA|BIT)_', segment):
+        return 'idata'
+    return 'flash'
+
+
+def parse_map(path):
+    sizes = {}
+    module = None
+    segment = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            if 'SEGMENTS IN ADDRESS ORDER' in line:
+                break  # Per-module part is over, the rest repeats it
+            m = re.search(r'(?:PROGRAM|LIBRARY) MODULE, NAME : (\S+)', line)
+            if m:
+                module = m.group(1)
+                segment = None
+                continue
+            m = re.match(r'^([A-Z][A-Z0-9_]*)\s*$', line)
+            if m and module:
+                segment = m.group(1)
+                continue
+            m = re.search(r'(?:Relative|Common) segment, address: .*\((0x[0-9A-Fa-f]+) bytes\)', line)
+            if m and module and segment:
+                mem = memory_of(segment)
+                sizes.setdefault(module, dict.fromkeys(MEMORIES, 0))[mem] += int(m.group(1), 16)
+    return sizes
+
+
+def parse_objects(paths):
+    sizes = {}
+    for path in paths:
+        module = os.path.splitext(os.path.basename(path))[0]
+        s = sizes.setdefault(module, dict.fromkeys(MEMORIES, 0))
+        out = subprocess.run(['size', '-A', path], capture_output=True, text=True, check=True).stdout
+        for line in out.splitlines():
+            fields = line.split()
+            if len(fields) < 2 or not fields[1].isdigit():
+                continue
+            name, size = fields[0], int(fields[1])
+            if name == '.text' or name.startswith('.text.') or name.startswith('.rodata'):
+                s['flash'] += size
+            elif name == '.data' or name.startswith('.data.'):
+                s['flash'] += size
+                s['xdata'] += size
+            elif name == '.bss' or name.startswith('.bss.') or name == 'COMMON':
+                s['xdata'] += size
+        su = os.path.splitext(path)[0] + '.su'
+        if os.path.exists(su):
+            with open(su) as f:
+                for line in f:
+                    fields = line.split('\t')
+                    if len(fields) >= 2 and fields[1].isdigit():
+                        s['stack'] = max(s['stack'], int(fields[1]))
+    return sizes
+
+
+def map_compiler(path):
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = re.search(r'IAR Universal Linker V\S+', line)
+            if m:
+                return m.group(0)
+    return 'unknown linker'
+
+
+def host_compiler(cc, cflags):
+    # The version line of -v names the compiler whatever it was run as (cc, gcc, ...)
+    out = subprocess.run([cc, '-v'], capture_output=True, text=True, check=True).stderr
+    version = next((line.strip() for line in out.splitlines()
+                    if re.match(r'(.* )?(gcc|clang) version ', line)), cc)
+    machine = subprocess.run([cc, '-dumpmachine'], capture_output=True, text=True, check=True).stdout
+    return ', '.join(x for x in (version, machine.strip(), cflags) if x)
+
+
+def totals(sizes, stacks_add):
+    # Reserved stack segments add up, deepest frames of separate objects do not
+    groups = {}
+    for module, s in sizes.items():
+        g = groups.setdefault(group_of(module), dict.fromkeys(MEMORIES, 0))
+        for mem in MEMORIES:
+            if mem == 'stack' and not stacks_add:
+                g[mem] = max(g[mem], s[mem])
+            else:
+                g[mem] += s[mem]
+    return groups
+
+
+def read_baseline(path):
+    base = {}
+    compiler = None
+    with open(path) as f:
+        for line in f:
+            if line.startswith('# compiler: '):
+                compiler = line[len('# compiler: '):].strip()
+            line = line.split('#')[0].strip()
+            if not line:
+                continue
+            name, *values = line.rsplit(None, len(MEMORIES))
+            base[name] = dict(zip(MEMORIES, (int(v) for v in values)))
+    return base, compiler
+
+
+def write_baseline(path, source, compiler, groups, sizes):
+    with open(path, 'w') as f:
+        f.write('# size_report.py baseline from %s: name flash xdata idata stack\n' % source)
+        if source == 'host objects':
+            f.write('# A trend indicator for the application, not the CC2530 budget\n')
+        f.write('# compiler: %s\n' % compiler)
+        for name in sorted(groups):
+            f.write('%-24s %s\n' % ('[%s]' % name, ' '.join('%7d' % groups[name][m] for m in MEMORIES)))
+        for name in sorted(sizes):
+            f.write('%-24s %s\n' % (name, ' '.join('%7d' % sizes[name][m] for m in MEMORIES)))
+
+
+def print_row(name, s, base=None):
+    cells = []
+    for mem in MEMORIES:
+        cell = '%7d' % s[mem]
+        if base is not None:
+            delta = s[mem] - base.get(mem, 0)
+            cell += ' %+6d' % delta if delta else '       '
+        cells.append(cell)
+    print('  %-22s %s' % (name, '  '.join(cells)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='OpenEVSE flash/RAM size report')
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--map', help='XLINK map of the firmware build')
+    src.add_argument('--objects', nargs='+', help='host-compiled objects')
+    parser.add_argument('--cc', help='compiler of the objects')
+    parser.add_argument('--cflags', default='', help='size options the objects were compiled with')
+    parser.add_argument('--baseline', help='checked-in numbers to compare against')
+    parser.add_argument('--update', action='store_true', help='rewrite the baseline with these numbers')
+    parser.add_argument('--tolerance', type=int, default=0, help='bytes of growth allowed before flagging')
+    parser.add_argument('--modules', action='store_true', help='list every module, not only the groups')
+    args = parser.parse_args()
+
+    if args.map:
+        sizes = parse_map(args.map)
+        source = os.path.basename(args.map)
+        compiler = map_compiler(args.map)
+    else:
+        if not args.cc:
+            parser.error('--objects needs --cc')
+        sizes = parse_objects(args.objects)
+        source = 'host objects'
+        compiler = host_compiler(args.cc, args.cflags)
+    if not sizes:
+        print('%s: no modules found' % source, file=sys.stderr)
+        return 2
+    groups = totals(sizes, bool(args.map))
+
+    if args.update:
+        write_baseline(args.baseline, source, compiler, groups, sizes)
+        print('baseline %s updated' % args.baseline)
+        return 0
+    base = None
+    if args.baseline:
+        base, base_compiler = read_baseline(args.baseline)
+        if base_compiler != compiler:
+            print('%s is from %s, these numbers from %s; make a baseline with the same compiler and options to compare'
+                  % (args.baseline, base_compiler or 'an unknown compiler', compiler), file=sys.stderr)
+            return 2
+
+    print('Size report from %s%s' % (source, ', change against %s' % args.baseline if base else ''))
+    print('  %s' % compiler)
+    if not args.map:
+        print('  A trend indicator for the application only, not the CC2530 budget; MAP= reads that')
+    width = 14 if base else 7
+    print('  %-22s %s' % ('', '  '.join('%-*s' % (width, m) for m in MEMORIES)))
+    for name in ('application', 'ZCL', 'HAL UART', 'stack'):
+        if name in groups:
+            print_row(name, groups[name], base.get('[%s]' % name, {}) if base else None)
+    all_groups = totals(dict(('[%s]' % g, v) for g, v in groups.items()), bool(args.map))['stack']
+    all_base = None
+    if base:
+        all_base = totals(dict((n, v) for n, v in base.items() if n.startswith('[')), bool(args.map)).get('stack', {})
+    print_row('total', all_groups, all_base)
+    if args.map:
+        print('  %s' % '  '.join('%s %.1f%% of %d KB' % (m, 100.0 * all_groups[m] / CAPACITY[m], CAPACITY[m] // 1024)
+                                  for m in ('flash', 'xdata')))
+
+    if args.modules:
+        print('Modules')
+        for name in sorted(sizes, key=lambda n: -sizes[n]['flash']):
+            print_row(name, sizes[name], base.get(name, {}) if base else None)
+
+    if base is None:
+        return 0
+    flagged = []
+    for name, s in list(('[%s]' % g, v) for g, v in groups.items()) + list(sizes.items()):
+        for mem in MEMORIES:
+            grown = s[mem] - base.get(name, {}).get(mem, 0)
+            if grown > args.tolerance:
+                flagged.append('%s %s +%d' % (name, mem, grown))
+    if flagged:
+        print('Regressions beyond %d bytes: %s' % (args.tolerance, ', '.join(flagged)))
+        return 1
+    print('No regressions beyond %d bytes' % args.tolerance)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# trace_decode.py - rebuild a timeline and latency distributions from a
+# dump of the transaction trace in manufacturer cluster 0xFC00.
+#
+# A dump is the TRACE_CHUNK attribute values as read, length byte first,
+# either one chunk per line in hex (what openevse_sim -t writes) or the
+# raw bytes back to back. Chunks may overlap or repeat; entries are kept
+# once per sequence number, which is extended past its 16 bits as it
+# wraps. A sequence number going backwards by more than the ring size
+# starts a new boot.
+#
+# The entry layout and codes mirror zcl_openevse.h: time (uint32 ms),
+# id, length, result, charger << 4 | resends and latency (uint16 ms).
+#
+# Usage: trace_decode.py [--timeline] [dump]
+#
+
+import argparse
+import struct
+import sys
+
+TRACE_ENTRIES = 32
+TRACE_REPORT = 0x80
+ENTRY = struct.Struct('<IBBBBH')
+
+# evseCode[] in zcl_openevse.c
+RAPI = ['', 'ST', 'WF', 'FS', 'FE', 'FB 0', 'S0 1', 'FB 6', 'GG',
+        'GP', 'GU', 'GS', 'GE', 'SH', 'SC', 'FB 2', 'GT']
+REPORTS = ['state', 'power', 'energy', 'temp', 'level', 'thermal', 'alert', 'event']
+RESULTS = ['ok', 'failed', 'dropped', 'async', 'superseded']
+
+
+def entry_name(ident):
+    if ident & TRACE_REPORT:
+        cls = ident & ~TRACE_REPORT
+        return 'report ' + (REPORTS[cls] if cls < len(REPORTS) else str(cls))
+    return '$' + (RAPI[ident] if ident < len(RAPI) else '?%d' % ident)
+
+
+def read_chunks(data):
+    text = data.strip()
+    try:
+        lines = text.decode('ascii').split()
+        return [bytes.fromhex(line) for line in lines]
+    except ValueError:
+        pass
+    chunks = []
+    i = 0
+    while i < len(data):
+        n = data[i]
+        chunks.append(data[i:i + 1 + n])
+        i += 1 + n
+    return chunks
+
+
+def decode(chunks):
+    boots = [{}]
+    last = None
+    for chunk in chunks:
+        if len(chunk) < 3 or chunk[0] != len(chunk) - 1:
+            print('skipping malformed chunk %s' % chunk.hex(), file=sys.stderr)
+            continue
+        first = chunk[1] | chunk[2] << 8
+        body = chunk[3:]
+        for k in range(len(body) // ENTRY.size):
+            seq = (first + k) & 0xFFFF
+            if last is None:
+                ext = seq
+            else:
+                delta = (seq - last) & 0xFFFF
+                if delta >= 0x8000:
+                    delta -= 0x10000
+                if delta < -TRACE_ENTRIES:
+                    boots.append({})  # Counting again from zero
+                    ext = seq
+                else:
+                    ext = last_ext + delta
+            boots[-1][ext] = ENTRY.unpack_from(body, k * ENTRY.size)
+            last, last_ext = seq, ext
+    return [b for b in boots if b]
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def report(boot, n, timeline):
+    entries = sorted(boot.items())
+    seqs = [s for s, _ in entries]
+    missing = sum(b - a - 1 for a, b in zip(seqs, seqs[1:]))
+    t0 = entries[0][1][0]
+    t1 = entries[-1][1][0]
+    print('Boot %d: %d entries, seq %d-%d, %d missing, %.1f-%.1f s' %
+          (n, len(entries), seqs[0], seqs[-1], missing, t0 / 1000, t1 / 1000))
+
+    if timeline:
+        for seq, (time, ident, length, result, info, latency) in entries:
+            print('  %5d %10.3f  ch%d %-14s %3d B  %-10s resends %d  %5d ms' %
+                  (seq, time / 1000, info >> 4, entry_name(ident), length,
+                   RESULTS[result] if result < len(RESULTS) else str(result),
+                   info & 0x0F, latency))
+
+    stats = {}
+    for _, (time, ident, length, result, info, latency) in entries:
+        s = stats.setdefault(ident, {'results': {}, 'latency': [], 'resends': 0})
+        name = RESULTS[result] if result < len(RESULTS) else str(result)
+        s['results'][name] = s['results'].get(name, 0) + 1
+        s['resends'] += info & 0x0F
+        if result != 3:
+            s['latency'].append(latency)
+
+    print('  %-14s %6s %8s %8s %8s %8s  %s' % ('', 'n', 'p50 ms', 'p90 ms', 'p99 ms', 'max ms', 'results'))
+    for ident in sorted(stats):
+        s = stats[ident]
+        lat = s['latency']
+        results = ' '.join('%s %d' % kv for kv in sorted(s['results'].items()))
+        if s['resends']:
+            results += ', %d resends' % s['resends']
+        if lat:
+            print('  %-14s %6d %8d %8d %8d %8d  %s' %
+                  (entry_name(ident), sum(s['results'].values()), percentile(lat, 50),
+                   percentile(lat, 90), percentile(lat, 99), max(lat), results))
+        else:
+            print('  %-14s %6d %8s %8s %8s %8s  %s' %
+                  (entry_name(ident), sum(s['results'].values()), '-', '-', '-', '-', results))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='OpenEVSE transaction trace decoder')
+    parser.add_argument('dump', nargs='?', help='trace dump, hex lines or raw chunks (default stdin)')
+    parser.add_argument('--timeline', action='store_true', help='print every entry in order')
+    args = parser.parse_args()
+
+    if args.dump:
+        with open(args.dump, 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    boots = decode(read_chunks(data))
+    if not boots:
+        print('no trace entries')
+        return 1
+    for n, boot in enumerate(boots):
+        report(boot, n, args.timeline)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())